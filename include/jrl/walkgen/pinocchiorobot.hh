@@ -49,6 +49,72 @@ struct PinocchioRobotFoot_t {
 };
 typedef PinocchioRobotFoot_t PRFoot;
 
+/// Poses and solutions of a batch of leg inverse kinematics,
+/// e.g. a whole preview window.
+/// The data are stored by components: each column holds one component
+/// for all the samples, so that consecutive samples are solved together.
+struct PinocchioRobotLegIKBatch_t {
+  /// Rotation (row-major, columns 0 to 8) and position (columns 9 to 11)
+  /// of the waist and of the ankle, one row per sample.
+  Eigen::Matrix<double, Eigen::Dynamic, 12> waist, ankle;
+  /// Joint angles of the leg, one row per sample.
+  Eigen::Matrix<double, Eigen::Dynamic, 6> q;
+  /// False if the ankle is out of reach of the waist,
+  /// the angles are then saturated as for a single pose.
+  Eigen::Matrix<bool, Eigen::Dynamic, 1> reachable;
+
+  inline Eigen::Index size() const { return waist.rows(); }
+
+  inline void resize(Eigen::Index nbSamples) {
+    waist.resize(nbSamples, 12);
+    ankle.resize(nbSamples, 12);
+    q.resize(nbSamples, 6);
+    reachable.resize(nbSamples);
+  }
+
+  inline void setWaist(Eigen::Index sample, const Eigen::Matrix4d &pose) {
+    setPose(waist, sample, pose);
+  }
+
+  inline void setAnkle(Eigen::Index sample, const Eigen::Matrix4d &pose) {
+    setPose(ankle, sample, pose);
+  }
+
+private:
+  inline static void setPose(Eigen::Matrix<double, Eigen::Dynamic, 12> &poses,
+                             Eigen::Index sample,
+                             const Eigen::Matrix4d &pose) {
+    for (unsigned int i = 0; i < 3; i++) {
+      for (unsigned int j = 0; j < 3; j++)
+        poses(sample, 3 * i + j) = pose(i, j);
+      poses(sample, 9 + i) = pose(i, 3);
+    }
+  }
+};
+typedef PinocchioRobotLegIKBatch_t PRLegIKBatch;
+
+/// Buffers of one kinematics or dynamics query of a PinocchioRobot.
+/// Each workspace has its own pinocchio::Data: queries on different
+/// workspaces share the model only and can run concurrently.
+struct PinocchioRobotWorkspace_t {
+  /// Owned by the workspace.
+  pinocchio::Data *data;
+  /// Configuration SE(3) position + quaternion + NbDofs
+  Eigen::VectorXd qpino;
+  /// Velocity, acceleration and torques, SE(3) + NbDofs
+  Eigen::VectorXd vpino, apino, tau;
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  inline PinocchioRobotWorkspace_t() : data(0) {}
+  inline ~PinocchioRobotWorkspace_t() { delete data; }
+
+private:
+  // The workspace owns its data, it is not copyable.
+  PinocchioRobotWorkspace_t(const PinocchioRobotWorkspace_t &);
+  PinocchioRobotWorkspace_t &operator=(const PinocchioRobotWorkspace_t &);
+};
+typedef PinocchioRobotWorkspace_t PRWorkspace;
+
 namespace pinocchio_robot {
 const int RPY_SIZE = 6;
 const int QUATERNION_SIZE = 7;
@@ -78,6 +144,47 @@ public:
   /// Compute the geometry of the robot.
   void computeForwardKinematics();
 
+  /// Compute the geometry of the legs and the CoM of the robot, the other
+  /// joints keeping the configuration of the previous call.
+  /// The placements of the free flyer and of the legs, and the CoM of the
+  /// whole robot are updated in Data(). The mass and CoM of the other
+  /// branches are cached in the waist frame: they are computed again by a
+  /// full computeForwardKinematics() when their configuration changes.
+  /// The placements of these branches and the CoMs of the subtrees are
+  /// the ones of the last full update.
+  void computeLegsForwardKinematics();
+
+  /// \brief Const queries : the same computations in the buffers of a
+  /// workspace, the robot is not modified. The configurations are given
+  /// with the free flyer orientation in RPY format as above.
+  /// The workspace has to be initialized by initializeWorkspace or
+  /// taken from a PinocchioDataPool.
+  /// @{
+  void computeForwardKinematics(const Eigen::VectorXd &q,
+                                PRWorkspace &workspace) const;
+  void computeInverseDynamics(const Eigen::VectorXd &q,
+                              const Eigen::VectorXd &v,
+                              const Eigen::VectorXd &a,
+                              PRWorkspace &workspace) const;
+  void zeroMomentumPoint(const PRWorkspace &workspace,
+                         Eigen::Vector3d &zmp) const;
+  void positionCenterOfMass(const PRWorkspace &workspace,
+                            Eigen::Vector3d &com) const;
+  void CenterOfMass(const PRWorkspace &workspace, Eigen::Vector3d &com,
+                    Eigen::Vector3d &dcom, Eigen::Vector3d &ddcom) const;
+  /// @}
+
+  /// Allocate the buffers of a workspace for the model of the robot.
+  /// The pinocchio::Data of a previous initialization is released.
+  void initializeWorkspace(PRWorkspace &workspace) const;
+
+  /// Pinocchio configuration of a configuration given with the free
+  /// flyer orientation in RPY format. The quaternion is not normalized
+  /// if normalize is false, as in computeInverseDynamics().
+  void RPYToPinocchioConfiguration(const Eigen::VectorXd &qrpy,
+                                   Eigen::VectorXd &qpino,
+                                   bool normalize = true) const;
+
   void RPYToSpatialFreeFlyer(Eigen::Vector3d &rpy, Eigen::Vector3d &drpy,
                              Eigen::Vector3d &ddrpy, Eigen::Quaterniond &quat,
                              Eigen::Vector3d &omega, Eigen::Vector3d &domega);
@@ -105,6 +212,51 @@ public:
                                       const Eigen::Matrix4d &jointEndPosition,
                                       Eigen::VectorXd &q);
 
+  /// \brief ComputeLegInverseKinematicsBatch :
+  /// same analytical inverse kinematics for a batch of waist and ankle
+  /// poses of one leg. The samples are solved by packets of 4 with the
+  /// vector instructions the library is compiled for, the angles are the
+  /// ones of ComputeSpecializedInverseKinematics up to the rounding.
+  /// param end joint index, i.e. the left or right ankle
+  /// param batch of poses, filled with the joint angles and their
+  /// reachability
+  /// return false if the robot is not compatible or if the joint is not
+  /// an ankle
+  ///
+  bool ComputeLegInverseKinematicsBatch(const pinocchio::JointIndex &jointEnd,
+                                        PRLegIKBatch &batch) const;
+
+  /// \brief ComputeLegJacobian :
+  /// analytical jacobian of the ankle with respect to the 6 joints of the
+  /// leg, relatively to the waist and expressed in the waist frame.
+  /// The 3 first rows are the linear velocity of the ankle, the 3 last
+  /// ones its angular velocity.
+  /// param end joint index, i.e. the left or right ankle
+  /// param angles of the leg, as given by the inverse kinematics
+  /// param 6x6 jacobian output
+  /// return false if the robot is not compatible or if the joint is not
+  /// an ankle
+  ///
+  bool ComputeLegJacobian(const pinocchio::JointIndex &jointEnd,
+                          const Eigen::VectorXd &q,
+                          Eigen::Matrix<double, 6, 6> &J) const;
+
+  /// \brief ComputeLegJacobianTimeVariation :
+  /// product of the time derivative of the leg jacobian by the joint
+  /// velocities, i.e. the acceleration of the ankle relatively to the
+  /// waist when the joint accelerations are zero.
+  /// param end joint index, i.e. the left or right ankle
+  /// param angles of the leg
+  /// param velocities of the leg
+  /// param 6D vector output, linear part first
+  /// return false if the robot is not compatible or if the joint is not
+  /// an ankle
+  ///
+  bool ComputeLegJacobianTimeVariation(const pinocchio::JointIndex &jointEnd,
+                                       const Eigen::VectorXd &q,
+                                       const Eigen::Matrix<double, 6, 1> &dq,
+                                       Eigen::Matrix<double, 6, 1> &dJdq) const;
+
   ///
   /// \brief testArmsInverseKinematics :
   /// test if the robot arms has the good joint
@@ -155,7 +307,17 @@ private:
   void getWaistFootKinematics(const Eigen::Matrix4d &jointRootPosition,
                               const Eigen::Matrix4d &jointEndPosition,
                               Eigen::VectorXd &q, Eigen::Vector3d &Dt) const;
+  // needed for the leg jacobian: axes and positions of the leg joints
+  // and position of the ankle, in the waist frame.
+  bool getLegChainKinematics(const pinocchio::JointIndex &jointEnd,
+                             const Eigen::VectorXd &q,
+                             Eigen::Matrix<double, 3, 6> &axes,
+                             Eigen::Matrix<double, 3, 6> &positions,
+                             Eigen::Vector3d &end) const;
   double ComputeXmax(double &Z);
+  // needed for computeLegsForwardKinematics
+  bool legsForwardKinematicsIsPossible() const;
+  void updateFrozenBranches();
   void getShoulderWristKinematics(const Eigen::Matrix4d &jointRootPosition,
                                   const Eigen::Matrix4d &jointEndPosition,
                                   Eigen::VectorXd &q, int side);
@@ -311,6 +473,19 @@ private:
 
   // length between the waist and the hip
   Eigen::Vector3d m_leftDt, m_rightDt;
+  // joints of the legs from the hip to the ankle and their axes
+  pinocchio::JointIndex m_leftLeg[6], m_rightLeg[6];
+  Eigen::Matrix<double, 3, 6> m_leftLegAxes, m_rightLegAxes;
+
+  // Cache of computeLegsForwardKinematics: configuration, mass and
+  // first moment (in the waist frame) of the branches other than the
+  // legs, and indexes of the legs in the configuration.
+  bool m_legsFKInitialized;
+  Eigen::VectorXd m_frozenConfiguration;
+  std::vector<bool> m_isFrozenConfiguration;
+  double m_frozenMass;
+  Eigen::Vector3d m_frozenMoment;
+  int m_leftLegIdxQ[6], m_rightLegIdxQ[6];
   double m_femurLength;
   double m_tibiaLengthZ;
   double m_tibiaLengthY;
@@ -327,5 +502,30 @@ private:
   pinocchio::JointIndex m_PinoFreeFlyerVelSize;
 
 }; // PinocchioRobot
+/// A pool of workspaces sharing the model of one PinocchioRobot,
+/// e.g. one per thread. The workspaces are allocated once: a thread
+/// uses the workspace of its index without any synchronization.
+class PinocchioDataPool {
+public:
+  PinocchioDataPool();
+  ~PinocchioDataPool();
+
+  /// Allocate nbWorkspaces workspaces for the model of aPR.
+  void resize(const PinocchioRobot &aPR, std::size_t nbWorkspaces);
+
+  inline std::size_t size() const { return m_workspaces.size(); }
+
+  inline PRWorkspace &workspace(std::size_t i) { return *m_workspaces[i]; }
+
+private:
+  void clear();
+
+  // The pool owns its workspaces, it is not copyable.
+  PinocchioDataPool(const PinocchioDataPool &);
+  PinocchioDataPool &operator=(const PinocchioDataPool &);
+
+  std::vector<PRWorkspace *> m_workspaces;
+};
+
 } // namespace PatternGeneratorJRL
 #endif // PinocchioRobot_HH
@@ -529,24 +529,21 @@ int FootTrajectoryGenerationStandard::GetParametersWithInitPosInitSpeed(
 double FootTrajectoryGenerationStandard::ComputeAllWithPolynom(
     FootAbsolutePosition &aFootAbsolutePosition, double Time) {
 
-  aFootAbsolutePosition.x = m_PolynomeX->Compute(Time);
-  aFootAbsolutePosition.dx = m_PolynomeX->ComputeDerivative(Time);
-  aFootAbsolutePosition.ddx = m_PolynomeX->ComputeSecDerivative(Time);
+  m_PolynomeX->ComputeAll(Time, aFootAbsolutePosition.x,
+                          aFootAbsolutePosition.dx, aFootAbsolutePosition.ddx);
   ODEBUG2("t: " << Time << " : " << aFootAbsolutePosition.x);
 
-  aFootAbsolutePosition.y = m_PolynomeY->Compute(Time);
-  aFootAbsolutePosition.dy = m_PolynomeY->ComputeDerivative(Time);
-  aFootAbsolutePosition.ddy = m_PolynomeY->ComputeSecDerivative(Time);
+  m_PolynomeY->ComputeAll(Time, aFootAbsolutePosition.y,
+                          aFootAbsolutePosition.dy, aFootAbsolutePosition.ddy);
   ODEBUG2("t: " << Time << " : " << aFootAbsolutePosition.y);
 
-  aFootAbsolutePosition.z = m_PolynomeZ->Compute(Time);
-  aFootAbsolutePosition.dz = m_PolynomeZ->ComputeDerivative(Time);
-  aFootAbsolutePosition.ddz = m_PolynomeZ->ComputeSecDerivative(Time);
+  m_PolynomeZ->ComputeAll(Time, aFootAbsolutePosition.z,
+                          aFootAbsolutePosition.dz, aFootAbsolutePosition.ddz);
   ODEBUG2("t: " << Time << " : " << aFootAbsolutePosition.z);
 
-  aFootAbsolutePosition.theta = m_PolynomeTheta->Compute(Time);
-  aFootAbsolutePosition.dtheta = m_PolynomeTheta->ComputeDerivative(Time);
-  aFootAbsolutePosition.ddtheta = m_PolynomeTheta->ComputeSecDerivative(Time);
+  m_PolynomeTheta->ComputeAll(Time, aFootAbsolutePosition.theta,
+                              aFootAbsolutePosition.dtheta,
+                              aFootAbsolutePosition.ddtheta);
   ODEBUG2("t: " << Time << " : " << aFootAbsolutePosition.theta);
 
   aFootAbsolutePosition.omega = m_PolynomeOmega->Compute(Time);
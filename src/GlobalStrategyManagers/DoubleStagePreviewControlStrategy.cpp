@@ -77,13 +77,27 @@ int DoubleStagePreviewControlStrategy::OneGlobalStepOfControl(
     COMState &finalCOMState, Eigen::VectorXd &CurrentConfiguration,
     Eigen::VectorXd &CurrentVelocity, Eigen::VectorXd &CurrentAcceleration) {
   // New scheme:
-  // Update the queue of ZMP ref
-  m_ZMPpcwmbz->UpdateTheZMPRefQueue((*m_ZMPPositions)[2 * m_NL]);
-  if ((m_StepStackHandler->GetWalkMode() == 0) ||
-      (m_StepStackHandler->GetWalkMode() == 4)) {
+  // The queue of ZMP ref is updated by m_ZMPpcwmbz.
+  bool YawFromZMP = (m_StepStackHandler->GetWalkMode() == 0) ||
+                    (m_StepStackHandler->GetWalkMode() == 4);
+  if (YawFromZMP) {
     (*m_COMBuffer)[m_NL].yaw[0] = (*m_ZMPPositions)[m_NL].theta;
   }
 
+  // With pipelined stages, the inputs of the next call are given
+  // when they are already in the buffers.
+  bool NextIsKnown = m_ZMPpcwmbz->GetPipelinedStages() &&
+                     (m_ZMPPositions->size() > 2 * m_NL + 1) &&
+                     (m_LeftFootPositions->size() > 2 * m_NL + 1) &&
+                     (m_RightFootPositions->size() > 2 * m_NL + 1) &&
+                     (m_COMBuffer->size() > m_NL + 1);
+  COMState NextCOMState;
+  if (NextIsKnown) {
+    NextCOMState = (*m_COMBuffer)[m_NL + 1];
+    if (YawFromZMP)
+      NextCOMState.yaw[0] = (*m_ZMPPositions)[m_NL + 1].theta;
+  }
+
   //    COMStateFromPC1 = m_COMBuffer[m_NL];
   finalCOMState = (*m_COMBuffer)[m_NL];
 
@@ -101,7 +115,11 @@ int DoubleStagePreviewControlStrategy::OneGlobalStepOfControl(
   m_ZMPpcwmbz->OneGlobalStepOfControl(
       (*m_LeftFootPositions)[2 * m_NL], (*m_RightFootPositions)[2 * m_NL],
       (*m_ZMPPositions)[2 * m_NL], finalCOMState, CurrentConfiguration,
-      CurrentVelocity, CurrentAcceleration);
+      CurrentVelocity, CurrentAcceleration,
+      NextIsKnown ? &(*m_ZMPPositions)[2 * m_NL + 1] : 0,
+      NextIsKnown ? &(*m_LeftFootPositions)[2 * m_NL + 1] : 0,
+      NextIsKnown ? &(*m_RightFootPositions)[2 * m_NL + 1] : 0,
+      NextIsKnown ? &NextCOMState : 0);
   ODEBUG4("finalCOMState:" << finalCOMState.x[0] << " " << finalCOMState.y[0],
           "DebugData.txt");
 
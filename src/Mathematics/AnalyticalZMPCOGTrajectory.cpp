@@ -38,6 +38,9 @@ AnalyticalZMPCOGTrajectory::AnalyticalZMPCOGTrajectory(int lNbOfIntervals) {
   SetNumberOfIntervals(lNbOfIntervals);
   m_AbsoluteTimeReference = 0.0;
   m_Sensitivity = 0.0;
+  m_SamplingPeriod = 0.0;
+  m_SeedInterval = -1;
+  m_SeedDeltaj = 0.0;
 }
 
 AnalyticalZMPCOGTrajectory::~AnalyticalZMPCOGTrajectory() { FreePolynomes(); }
@@ -60,6 +63,7 @@ void AnalyticalZMPCOGTrajectory::FreePolynomes() {
 void AnalyticalZMPCOGTrajectory::SetNumberOfIntervals(
     unsigned int lNbOfIntervals) {
   m_NbOfIntervals = lNbOfIntervals;
+  m_SeedInterval = -1;
 
   m_V.resize(m_NbOfIntervals);
   m_W.resize(m_NbOfIntervals);
@@ -151,10 +155,55 @@ bool AnalyticalZMPCOGTrajectory::ComputeCOMSpeed(double t, double &r) {
   return false;
 }
 
+void AnalyticalZMPCOGTrajectory::SetSamplingPeriod(double aSamplingPeriod) {
+  if (m_SamplingPeriod != aSamplingPeriod)
+    m_SeedInterval = -1;
+  m_SamplingPeriod = aSamplingPeriod;
+}
+
+void AnalyticalZMPCOGTrajectory::ComputeHyperbolicPart(double t, int j,
+                                                       Eigen::Vector3d &h) {
+  double deltaj = t - m_AbsoluteTimeReference - m_RefTime[j];
+
+  if (m_SamplingPeriod > 0.0) {
+    // Is t on the time grid starting at the last exact evaluation ?
+    if (j == m_SeedInterval) {
+      double dk = floor((deltaj - m_SeedDeltaj) / m_SamplingPeriod + 0.5);
+      if ((dk >= 0.0) && (dk <= (double)m_Propagator.NbOfMultiples()) &&
+          (fabs(deltaj - m_SeedDeltaj - dk * m_SamplingPeriod) < 1e-10)) {
+        m_Propagator.Propagate((unsigned int)dk, m_SeedState, 0.0, h);
+        return;
+      }
+    }
+  }
+
+  double omegaj = m_omegaj[j];
+  double c = cosh(omegaj * deltaj), s = sinh(omegaj * deltaj);
+  h(0) = c * m_V[j] + s * m_W[j];
+  h(1) = omegaj * s * m_V[j] + omegaj * c * m_W[j];
+  h(2) = omegaj * omegaj * h(0);
+
+  if (m_SamplingPeriod > 0.0) {
+    // The tables cover the remaining part of the interval.
+    double remaining = m_DeltaTj[j] - deltaj;
+    unsigned int NbOfMultiples =
+        (remaining > 0.0 ? (unsigned int)(remaining / m_SamplingPeriod) : 0) +
+        2;
+    if (NbOfMultiples < m_Propagator.NbOfMultiples())
+      NbOfMultiples = m_Propagator.NbOfMultiples();
+    m_Propagator.InitializeHyperbolic(omegaj, m_SamplingPeriod, NbOfMultiples);
+    m_SeedInterval = j;
+    m_SeedDeltaj = deltaj;
+    m_SeedState = h;
+  }
+}
+
 bool AnalyticalZMPCOGTrajectory::ComputeCOM(double t, double &r, int j) {
   double deltaj = 0.0;
   deltaj = t - m_AbsoluteTimeReference - m_RefTime[j];
-  r = cosh(m_omegaj[j] * deltaj) * m_V[j] + sinh(m_omegaj[j] * deltaj) * m_W[j];
+  Eigen::Vector3d h;
+  ComputeHyperbolicPart(t, j, h);
+  r = h(0);
   r += m_ListOfCOGPolynomials[j]->Compute(deltaj);
   return true;
 }
@@ -163,8 +212,9 @@ bool AnalyticalZMPCOGTrajectory::ComputeCOMSpeed(double t, double &r, int j) {
   double deltaj = 0.0;
   deltaj = t - m_AbsoluteTimeReference - m_RefTime[j];
 
-  r = m_omegaj[j] * sinh(m_omegaj[j] * deltaj) * m_V[j] +
-      m_omegaj[j] * cosh(m_omegaj[j] * deltaj) * m_W[j];
+  Eigen::Vector3d h;
+  ComputeHyperbolicPart(t, j, h);
+  r = h(1);
   r += m_ListOfCOGPolynomials[j]->ComputeDerivative(deltaj);
   ODEBUG("ComputeCOMSpeed: " << r);
   return true;
@@ -175,8 +225,9 @@ bool AnalyticalZMPCOGTrajectory::ComputeCOMAcceleration(double t, double &r,
   double deltaj = 0.0;
   deltaj = t - m_AbsoluteTimeReference - m_RefTime[j];
 
-  r = m_omegaj[j] * m_omegaj[j] * cosh(m_omegaj[j] * deltaj) * m_V[j] +
-      m_omegaj[j] * m_omegaj[j] * sinh(m_omegaj[j] * deltaj) * m_W[j];
+  Eigen::Vector3d h;
+  ComputeHyperbolicPart(t, j, h);
+  r = h(2);
   r += m_ListOfCOGPolynomials[j]->ComputeSecDerivative(deltaj);
   ODEBUG("ComputeCOMAcceleration: " << r);
   return true;
@@ -264,10 +315,12 @@ void AnalyticalZMPCOGTrajectory::SetCoGHyperbolicCoefficients(
     m_V = lV;
   if ((int)lW.size() == m_NbOfIntervals)
     m_W = lW;
+  m_SeedInterval = -1;
 }
 
 void AnalyticalZMPCOGTrajectory::SetStartingTimeIntervalsAndHeightVariation(
     vector<double> &lTj, vector<double> &lomegaj) {
+  m_SeedInterval = -1;
   if ((int)lTj.size() == m_NbOfIntervals) {
     m_DeltaTj = lTj;
     m_RefTime.resize(lTj.size());
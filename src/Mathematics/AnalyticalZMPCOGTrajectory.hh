@@ -31,6 +31,7 @@
 #include <iostream>
 #include <vector>
 
+#include <Mathematics/LIPMPropagator.hh>
 #include <Mathematics/Polynome.hh>
 
 namespace PatternGeneratorJRL {
@@ -221,6 +222,14 @@ public:
     m_AbsoluteTimeReference = anAbsoluteTimeReference;
   }
 
+  /*! \brief Set the period of the time grid on which the CoM is evaluated
+    with the interval index (ComputeCOM(t,r,j), ComputeCOMSpeed(t,r,j) and
+    ComputeCOMAcceleration(t,r,j)). When it is positive, the hyperbolic part
+    is propagated from one sample to another with precomputed transition
+    matrices instead of being evaluated with cosh and sinh.
+    A null period (the default) keeps the direct evaluation. */
+  void SetSamplingPeriod(double aSamplingPeriod);
+
   /*! \brief Get the index of the interval according to the time. */
   bool GetIntervalIndexFromTime(double t, unsigned int &j);
 
@@ -268,6 +277,28 @@ protected:
 
   /* \brien Sensitivity to numerical noise. */
   double m_Sensitivity;
+
+  /*! \name Propagation of the hyperbolic part on the time grid.
+    @{ */
+  /*! \brief Compute the hyperbolic part of the CoM (position, speed and
+    acceleration) on the interval j at time t. */
+  void ComputeHyperbolicPart(double t, int j, Eigen::Vector3d &h);
+
+  /*! \brief Period of the time grid, 0 if the propagation is not used. */
+  double m_SamplingPeriod;
+
+  /*! \brief Transition matrices for the current omega. */
+  LIPMPropagator m_Propagator;
+
+  /*! \brief Interval of the last exact evaluation, -1 if none. */
+  int m_SeedInterval;
+
+  /*! \brief Time in the interval of the last exact evaluation. */
+  double m_SeedDeltaj;
+
+  /*! \brief Hyperbolic part at the last exact evaluation. */
+  Eigen::Vector3d m_SeedState;
+  /*! @} */
 };
 
 std::ostream &operator<<(std::ostream &os,
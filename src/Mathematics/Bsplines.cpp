@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <assert.h>
 #include <iostream>
 #include <vector>
@@ -12,6 +13,7 @@ Bsplines::Bsplines(long int degree) {
   m_degree = degree;
   m_control_points.clear();
   m_knot.clear();
+  m_LastKnotSpan = -1;
 }
 
 Bsplines::~Bsplines() {}
@@ -23,6 +25,7 @@ void Bsplines::GenerateDegree() {
               << " Carefull !! degree is smaller than 0 " << endl;
   }
   m_degree = (unsigned)degree;
+  m_LastKnotSpan = -1;
 }
 
 int Bsplines::ComputeBasisFunctions(double t) {
@@ -180,17 +183,142 @@ double Bsplines::Nij_t(int i, int j, double t, deque<double> &m_knot) {
   return Nij_t;
 }
 
+long int Bsplines::FindKnotSpan(double t) {
+  long int lastspan = (long int)m_knot.size() - 2;
+  if (lastspan < 0)
+    return -1;
+
+  // Same convention than ComputeBasisFunctions for the end point.
+  bool atend = (t == 1);
+  long int i = m_LastKnotSpan;
+  for (long int k = 0; k < 2; k++, i++) {
+    if ((i < 0) || (i > lastspan))
+      break;
+    if (atend ? ((m_knot[i] < t) && (t <= m_knot[i + 1]))
+              : ((m_knot[i] <= t) && (t < m_knot[i + 1]))) {
+      m_LastKnotSpan = i;
+      return i;
+    }
+  }
+
+  // The time jumped: binary search in the knot vector.
+  std::deque<double>::const_iterator it =
+      atend ? std::lower_bound(m_knot.begin(), m_knot.end(), t)
+            : std::upper_bound(m_knot.begin(), m_knot.end(), t);
+  i = (long int)(it - m_knot.begin()) - 1;
+  if ((i < 0) || (i > lastspan))
+    return -1;
+  m_LastKnotSpan = i;
+  return i;
+}
+
+void Bsplines::ComputeNonZeroBasisFunctions(
+    double t, long int span, double ders[3][MAX_FAST_DEGREE + 1]) const {
+  const long int p = m_degree;
+  double ndu[MAX_FAST_DEGREE + 1][MAX_FAST_DEGREE + 1];
+  double a[2][MAX_FAST_DEGREE + 1];
+  double left[MAX_FAST_DEGREE + 1], right[MAX_FAST_DEGREE + 1];
+
+  // Triangular table of the basis functions (upper part)
+  // and of the knot differences (lower part).
+  ndu[0][0] = 1.0;
+  for (long int j = 1; j <= p; j++) {
+    left[j] = t - m_knot[span + 1 - j];
+    right[j] = m_knot[span + j] - t;
+    double saved = 0.0;
+    for (long int r = 0; r < j; r++) {
+      ndu[j][r] = right[r + 1] + left[j - r];
+      double temp = ndu[r][j - 1] / ndu[j][r];
+      ndu[r][j] = saved + right[r + 1] * temp;
+      saved = left[j - r] * temp;
+    }
+    ndu[j][j] = saved;
+  }
+
+  for (long int j = 0; j <= p; j++) {
+    ders[0][j] = ndu[j][p];
+    ders[1][j] = 0.0;
+    ders[2][j] = 0.0;
+  }
+
+  // Derivatives up to the second order.
+  long int n = p < 2 ? p : 2;
+  for (long int r = 0; r <= p; r++) {
+    long int s1 = 0, s2 = 1;
+    a[0][0] = 1.0;
+    for (long int k = 1; k <= n; k++) {
+      double d = 0.0;
+      long int rk = r - k, pk = p - k;
+      if (r >= k) {
+        a[s2][0] = a[s1][0] / ndu[pk + 1][rk];
+        d = a[s2][0] * ndu[rk][pk];
+      }
+      long int j1 = rk >= -1 ? 1 : -rk;
+      long int j2 = (r - 1 <= pk) ? k - 1 : p - r;
+      for (long int j = j1; j <= j2; j++) {
+        a[s2][j] = (a[s1][j] - a[s1][j - 1]) / ndu[pk + 1][rk + j];
+        d += a[s2][j] * ndu[rk + j][pk];
+      }
+      if (r <= pk) {
+        a[s2][k] = -a[s1][k - 1] / ndu[pk + 1][r];
+        d += a[s2][k] * ndu[r][pk];
+      }
+      ders[k][r] = d;
+      long int tmp = s1;
+      s1 = s2;
+      s2 = tmp;
+    }
+  }
+
+  double factor = (double)p;
+  for (long int k = 1; k <= n; k++) {
+    for (long int j = 0; j <= p; j++)
+      ders[k][j] *= factor;
+    factor *= (double)(p - k);
+  }
+}
+
+void Bsplines::Evaluate(double t, double &x, double &dx, double &ddx) {
+  x = 0.0;
+  dx = 0.0;
+  ddx = 0.0;
+
+  long int span = -1;
+  if ((m_degree >= 0) && (m_degree <= MAX_FAST_DEGREE))
+    span = FindKnotSpan(t);
+
+  // The local evaluation needs the m_degree knots on both sides of the
+  // span and the m_degree+1 control points acting on it.
+  if ((span < m_degree) || (span + m_degree >= (long int)m_knot.size()) ||
+      (span >= (long int)m_control_points.size())) {
+    ComputeBasisFunctions(t);
+    for (unsigned int i = 0; i < m_control_points.size(); i++) {
+      x += m_basis_functions[m_degree][i] * m_control_points[i];
+      dx += m_basis_functions_derivative[i] * m_control_points[i];
+      ddx += m_basis_functions_sec_derivative[i] * m_control_points[i];
+    }
+    return;
+  }
+
+  double ders[3][MAX_FAST_DEGREE + 1];
+  ComputeNonZeroBasisFunctions(t, span, ders);
+  const double *lcp = &m_control_points[span - m_degree];
+  for (long int j = 0; j <= m_degree; j++) {
+    x += ders[0][j] * lcp[j];
+    dx += ders[1][j] * lcp[j];
+    ddx += ders[2][j] * lcp[j];
+  }
+}
+
 double Bsplines::ComputeBsplines(double t) {
-  ComputeBasisFunctions(t);
   double result = 0.0;
   if (m_degree !=
       (long int)m_knot.size() - (long int)m_control_points.size() - 1) {
     cerr << "The parameters are not compatibles. Please recheck " << endl;
     return result;
   }
-  for (unsigned int i = 0; i < m_control_points.size(); i++) {
-    result += m_basis_functions[m_degree][i] * m_control_points[i];
-  }
+  double dresult, ddresult;
+  Evaluate(t, result, dresult, ddresult);
   return result;
 }
 
@@ -224,7 +352,10 @@ Bsplines Bsplines::DerivativeBsplines() {
   }
 }
 
-void Bsplines::SetDegree(long int degree) { m_degree = degree; }
+void Bsplines::SetDegree(long int degree) {
+  m_degree = degree;
+  m_LastKnotSpan = -1;
+}
 
 void Bsplines::SetControlPoints(std::vector<double> &control_points) {
   if (control_points.size() >= 2) {
@@ -236,6 +367,7 @@ void Bsplines::SetControlPoints(std::vector<double> &control_points) {
 
 void Bsplines::SetKnotVector(std::deque<double> &knot_vector) {
   m_knot = knot_vector;
+  m_LastKnotSpan = -1;
 }
 
 long int Bsplines::GetDegree() const { return m_degree; }
@@ -285,14 +417,27 @@ int BSplinesFoot::Compute(double t, double &x, double &dx, double &ddx) {
   if (time >= 1.0)
     time = 1.0;
 
-  ComputeBasisFunctions(time);
-  x = 0.0;
-  dx = 0.0;
-  ddx = 0.0;
-  for (unsigned int i = 0; i < m_control_points.size(); i++) {
-    x += m_basis_functions[m_degree][i] * m_control_points[i];
-    dx += m_basis_functions_derivative[i] * m_control_points[i];
-    ddx += m_basis_functions_sec_derivative[i] * m_control_points[i];
+  Evaluate(time, x, dx, ddx);
+  return 1;
+}
+
+int BSplinesFoot::Compute(double StartTime, double SamplingPeriod,
+                          unsigned int NbOfSamples, std::vector<double> &x,
+                          std::vector<double> &dx, std::vector<double> &ddx) {
+  if (x.size() < NbOfSamples)
+    x.resize(NbOfSamples);
+  if (dx.size() < NbOfSamples)
+    dx.resize(NbOfSamples);
+  if (ddx.size() < NbOfSamples)
+    ddx.resize(NbOfSamples);
+
+  for (unsigned int k = 0; k < NbOfSamples; k++) {
+    double time = (StartTime + k * SamplingPeriod) / m_FT;
+    if (time <= 0.0)
+      time = 0.0;
+    if (time >= 1.0)
+      time = 1.0;
+    Evaluate(time, x[k], dx[k], ddx[k]);
   }
   return 1;
 }
@@ -21,6 +21,10 @@ namespace PatternGeneratorJRL {
 class Bsplines {
 
 public:
+  /*! Maximal degree handled by the non-recursive evaluator,
+    higher degrees fall back on ComputeBasisFunctions. */
+  enum { MAX_FAST_DEGREE = 7 };
+
   /*! Constructor */
   Bsplines(long int degree);
 
@@ -45,6 +49,22 @@ public:
                                        unsigned int degree);
   double Nij_t(int i, int j, double t, std::deque<double> &knot);
 
+  /*! Find the knot span i such that knot[i] <= t < knot[i+1]
+    (knot[i] < t <= knot[i+1] for t = 1), starting the search from the
+    span found at the previous call. Returns -1 if there is none. */
+  long int FindKnotSpan(double t);
+
+  /*! Non-recursive (de Boor) evaluation of the m_degree+1 basis functions
+    which are non zero on the knot span \a span, and of their first and
+    second derivatives: ders[k][j] is the derivative of order k of the
+    basis function span-m_degree+j. */
+  void ComputeNonZeroBasisFunctions(double t, long int span,
+                                    double ders[3][MAX_FAST_DEGREE + 1]) const;
+
+  /*! Compute the value of the Bsplines and its first and second
+    derivatives at t. Uses the non-recursive evaluator whenever possible. */
+  void Evaluate(double t, double &x, double &dx, double &ddx);
+
   /*!Compute Bsplines */
   double ComputeBsplines(double t);
 
@@ -84,6 +104,9 @@ protected:
   std::vector<double> m_basis_functions_sec_derivative;
 
   std::deque<double> m_knot;
+
+  /*! Knot span found at the last evaluation. */
+  long int m_LastKnotSpan;
 };
 
 /// Bsplines used for Z trajectory of stair steps
@@ -119,6 +142,14 @@ public:
   /*!Compute Position at time t */
   int Compute(double t, double &x, double &dx, double &ddx);
 
+  /*! Compute the position, speed and acceleration over the time grid
+    t_k = StartTime + k * SamplingPeriod, for k < NbOfSamples.
+    The knot span is tracked along the grid instead of being searched
+    again for each sample. */
+  int Compute(double StartTime, double SamplingPeriod,
+              unsigned int NbOfSamples, std::vector<double> &x,
+              std::vector<double> &dx, std::vector<double> &ddx);
+
   /*! Compute the control point position for an order 5
    * Bsplines. It also computes the control point of the derivative
    * and the second derivatice of the BSplines.
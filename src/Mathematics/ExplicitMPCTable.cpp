@@ -0,0 +1,325 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** \file ExplicitMPCTable.cpp
+    \brief Table of the affine control laws of an explicit MPC. */
+
+#include <math.h>
+#include <string.h>
+
+#include <fstream>
+#include <iostream>
+
+#include <Debug.hh>
+#include <Mathematics/ExplicitMPCTable.hh>
+
+using namespace PatternGeneratorJRL;
+
+namespace {
+const char EMPC_MAGIC[8] = {'J', 'R', 'L', 'E', 'M', 'P', 'C', '\0'};
+const unsigned int EMPC_VERSION = 1;
+
+/* A constraint is considered active below this value. */
+const double EMPC_ACTIVE_TOLERANCE = 1e-7;
+
+template <typename T> void WriteValue(std::ofstream &aof, const T &aValue) {
+  aof.write((const char *)&aValue, sizeof(T));
+}
+
+template <typename T> bool ReadValue(std::ifstream &aif, T &aValue) {
+  aif.read((char *)&aValue, sizeof(T));
+  return aif.good();
+}
+} // namespace
+
+ExplicitMPCTable::ExplicitMPCTable() {
+  m_Tolerance = 1e-8;
+  m_MaxNbOfCandidates = 8;
+  m_NbOfHits = 0;
+  m_NbOfMisses = 0;
+}
+
+void ExplicitMPCTable::HashPattern(unsigned long long &Key,
+                                   const double *Values,
+                                   unsigned int NbOfValues) {
+  // FNV-1a on the bytes of the values.
+  if (Key == 0)
+    Key = 14695981039346656037ULL;
+  const unsigned char *lBytes = (const unsigned char *)Values;
+  for (unsigned int i = 0; i < NbOfValues * sizeof(double); i++) {
+    Key ^= lBytes[i];
+    Key *= 1099511628211ULL;
+  }
+}
+
+void ExplicitMPCTable::SetMaxNbOfCandidates(unsigned int aNb) {
+  m_MaxNbOfCandidates = aNb;
+}
+
+void ExplicitMPCTable::Clear() {
+  m_Patterns.clear();
+  m_NbOfHits = 0;
+  m_NbOfMisses = 0;
+}
+
+unsigned int ExplicitMPCTable::NbOfPatterns() const {
+  return (unsigned int)m_Patterns.size();
+}
+
+unsigned int ExplicitMPCTable::NbOfRegions() const {
+  unsigned int r = 0;
+  std::map<unsigned long long, Pattern>::const_iterator it;
+  for (it = m_Patterns.begin(); it != m_Patterns.end(); it++)
+    r += (unsigned int)it->second.Regions.size();
+  return r;
+}
+
+bool ExplicitMPCTable::Learn(unsigned long long Key, const double *G,
+                             const double *h, unsigned int m, unsigned int n,
+                             const double *D, const double *V) {
+  unsigned int ld = m + 1;
+
+  // Keep the active constraints which are linearly independent.
+  Region aRegion;
+  aRegion.NbOfHits = 0;
+  Eigen::MatrixXd S;
+  for (unsigned int i = 0; i < m; i++) {
+    double r = h[i];
+    for (unsigned int k = 0; k < n; k++)
+      r += G[i + k * ld] * V[k];
+    if (fabs(r) > EMPC_ACTIVE_TOLERANCE)
+      continue;
+
+    std::size_t lSize = aRegion.ActiveSet.size();
+    Eigen::MatrixXd lS(lSize + 1, lSize + 1);
+    lS.topLeftCorner(lSize, lSize) = S;
+    for (std::size_t j = 0; j <= lSize; j++) {
+      unsigned int lj = j < lSize ? aRegion.ActiveSet[j] : i;
+      double Sij = 0.0;
+      for (unsigned int k = 0; k < n; k++)
+        Sij += G[i + k * ld] * G[lj + k * ld];
+      lS(lSize, j) = lS(j, lSize) = Sij;
+    }
+    Eigen::LLT<Eigen::MatrixXd> lLLT(lS);
+    if ((lLLT.info() != Eigen::Success) ||
+        (lLLT.matrixLLT()(lSize, lSize) < 1e-6 * sqrt(lS(lSize, lSize))))
+      continue;
+    aRegion.ActiveSet.push_back(i);
+    S = lS;
+  }
+
+  std::size_t lSize = aRegion.ActiveSet.size();
+  if (lSize > 0)
+    aRegion.iS = S.inverse();
+  else
+    aRegion.iS.resize(0, 0);
+
+  Pattern &aPattern = m_Patterns[Key];
+  if (aPattern.Regions.size() == 0) {
+    aPattern.NbOfConstraints = m;
+    aPattern.NbOfVariables = n;
+  } else if ((aPattern.NbOfConstraints != m) || (aPattern.NbOfVariables != n))
+    return false;
+
+  for (std::size_t r = 0; r < aPattern.Regions.size(); r++)
+    if (aPattern.Regions[r].ActiveSet == aRegion.ActiveSet)
+      return true;
+
+  // The law has to give back the solution with positive multipliers.
+  std::vector<double> lV(n);
+  if (!EvaluateRegion(aRegion, G, h, m, n, D, &lV[0]))
+    return false;
+  for (unsigned int k = 0; k < n; k++)
+    if (fabs(lV[k] - V[k]) > 1e-6 * (1.0 + fabs(V[k])))
+      return false;
+
+  aPattern.Regions.push_back(aRegion);
+  return true;
+}
+
+bool ExplicitMPCTable::EvaluateRegion(const Region &aRegion, const double *G,
+                                      const double *h, unsigned int m,
+                                      unsigned int n, const double *D,
+                                      double *V) {
+  unsigned int ld = m + 1;
+  std::size_t lSize = aRegion.ActiveSet.size();
+
+  for (unsigned int k = 0; k < n; k++)
+    V[k] = -D[k];
+
+  if (lSize > 0) {
+    m_y.resize(lSize);
+    for (std::size_t j = 0; j < lSize; j++) {
+      const double *Gj = G + aRegion.ActiveSet[j];
+      double r = -h[aRegion.ActiveSet[j]];
+      for (unsigned int k = 0; k < n; k++)
+        r += Gj[k * ld] * D[k];
+      m_y(j) = r;
+    }
+    m_Lambda.noalias() = aRegion.iS * m_y;
+
+    for (std::size_t j = 0; j < lSize; j++) {
+      if (m_Lambda(j) < -m_Tolerance)
+        return false;
+      const double *Gj = G + aRegion.ActiveSet[j];
+      for (unsigned int k = 0; k < n; k++)
+        V[k] += m_Lambda(j) * Gj[k * ld];
+    }
+  }
+
+  // The active constraints have to be tight, otherwise the law does
+  // not belong to this constraint matrix.
+  std::size_t lActive = 0;
+  for (unsigned int i = 0; i < m; i++) {
+    double r = h[i];
+    for (unsigned int k = 0; k < n; k++)
+      r += G[i + k * ld] * V[k];
+    if (r < -m_Tolerance)
+      return false;
+    if ((lActive < lSize) && (aRegion.ActiveSet[lActive] == i)) {
+      if (fabs(r) > EMPC_ACTIVE_TOLERANCE * (1.0 + fabs(h[i])))
+        return false;
+      lActive++;
+    }
+  }
+  return true;
+}
+
+bool ExplicitMPCTable::Solve(unsigned long long Key, const double *G,
+                             const double *h, unsigned int m, unsigned int n,
+                             const double *D, double *V) {
+  std::map<unsigned long long, Pattern>::iterator it = m_Patterns.find(Key);
+  if ((it == m_Patterns.end()) || (it->second.NbOfConstraints != m) ||
+      (it->second.NbOfVariables != n)) {
+    m_NbOfMisses++;
+    return false;
+  }
+
+  std::vector<Region> &lRegions = it->second.Regions;
+  std::size_t lNbOfCandidates = lRegions.size();
+  if (lNbOfCandidates > m_MaxNbOfCandidates)
+    lNbOfCandidates = m_MaxNbOfCandidates;
+
+  for (std::size_t r = 0; r < lNbOfCandidates; r++) {
+    if (EvaluateRegion(lRegions[r], G, h, m, n, D, V)) {
+      // Keep the regions sorted by number of uses.
+      lRegions[r].NbOfHits++;
+      while ((r > 0) && (lRegions[r].NbOfHits > lRegions[r - 1].NbOfHits)) {
+        std::swap(lRegions[r], lRegions[r - 1]);
+        r--;
+      }
+      m_NbOfHits++;
+      return true;
+    }
+  }
+  m_NbOfMisses++;
+  return false;
+}
+
+bool ExplicitMPCTable::Save(const std::string &aFileName) const {
+  std::ofstream aof(aFileName.c_str(), std::ofstream::out |
+                                           std::ofstream::binary |
+                                           std::ofstream::trunc);
+  if (!aof.is_open()) {
+    std::cerr << "ExplicitMPCTable - Unable to write " << aFileName
+              << std::endl;
+    return false;
+  }
+
+  aof.write(EMPC_MAGIC, sizeof(EMPC_MAGIC));
+  WriteValue(aof, EMPC_VERSION);
+  WriteValue(aof, NbOfPatterns());
+
+  std::map<unsigned long long, Pattern>::const_iterator it;
+  for (it = m_Patterns.begin(); it != m_Patterns.end(); it++) {
+    WriteValue(aof, it->first);
+    WriteValue(aof, it->second.NbOfConstraints);
+    WriteValue(aof, it->second.NbOfVariables);
+    WriteValue(aof, (unsigned int)it->second.Regions.size());
+    for (std::size_t r = 0; r < it->second.Regions.size(); r++) {
+      const Region &aRegion = it->second.Regions[r];
+      WriteValue(aof, (unsigned int)aRegion.ActiveSet.size());
+      WriteValue(aof, aRegion.NbOfHits);
+      for (std::size_t j = 0; j < aRegion.ActiveSet.size(); j++)
+        WriteValue(aof, aRegion.ActiveSet[j]);
+      if (aRegion.iS.size() > 0)
+        aof.write((const char *)aRegion.iS.data(),
+                  aRegion.iS.size() * sizeof(double));
+    }
+  }
+  return aof.good();
+}
+
+bool ExplicitMPCTable::Load(const std::string &aFileName) {
+  std::ifstream aif(aFileName.c_str(),
+                    std::ifstream::in | std::ifstream::binary);
+  if (!aif.is_open()) {
+    std::cerr << "ExplicitMPCTable - Unable to read " << aFileName
+              << std::endl;
+    return false;
+  }
+
+  char lMagic[8];
+  unsigned int lVersion = 0, lNbOfPatterns = 0;
+  aif.read(lMagic, sizeof(lMagic));
+  if ((!aif.good()) || (memcmp(lMagic, EMPC_MAGIC, sizeof(lMagic)) != 0) ||
+      (!ReadValue(aif, lVersion)) || (lVersion != EMPC_VERSION) ||
+      (!ReadValue(aif, lNbOfPatterns))) {
+    std::cerr << "ExplicitMPCTable - " << aFileName << " is not a valid table"
+              << std::endl;
+    return false;
+  }
+
+  std::map<unsigned long long, Pattern> lPatterns;
+  for (unsigned int p = 0; p < lNbOfPatterns; p++) {
+    unsigned long long lKey = 0;
+    unsigned int lNbOfRegions = 0;
+    Pattern aPattern;
+    if ((!ReadValue(aif, lKey)) ||
+        (!ReadValue(aif, aPattern.NbOfConstraints)) ||
+        (!ReadValue(aif, aPattern.NbOfVariables)) ||
+        (!ReadValue(aif, lNbOfRegions)))
+      return false;
+
+    aPattern.Regions.resize(lNbOfRegions);
+    for (unsigned int r = 0; r < lNbOfRegions; r++) {
+      Region &aRegion = aPattern.Regions[r];
+      unsigned int lSize = 0;
+      if ((!ReadValue(aif, lSize)) || (!ReadValue(aif, aRegion.NbOfHits)) ||
+          (lSize > aPattern.NbOfConstraints))
+        return false;
+      aRegion.ActiveSet.resize(lSize);
+      for (unsigned int j = 0; j < lSize; j++) {
+        if ((!ReadValue(aif, aRegion.ActiveSet[j])) ||
+            (aRegion.ActiveSet[j] >= aPattern.NbOfConstraints))
+          return false;
+      }
+      aRegion.iS.resize(lSize, lSize);
+      if (lSize > 0) {
+        aif.read((char *)aRegion.iS.data(), lSize * lSize * sizeof(double));
+        if (!aif.good())
+          return false;
+      }
+    }
+    lPatterns[lKey] = aPattern;
+  }
+
+  m_Patterns.swap(lPatterns);
+  ODEBUG("Loaded " << NbOfRegions() << " regions from " << aFileName);
+  return true;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** \file ExplicitMPCTable.hh
+    \brief Table of the affine control laws of an explicit MPC. */
+
+#ifndef _EXPLICIT_MPC_TABLE_H_
+#define _EXPLICIT_MPC_TABLE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace PatternGeneratorJRL {
+
+/*! \brief Critical regions of the QP
+  \f[ \min_{V} \frac{1}{2} V^{\top} V + D^{\top} V \;\; s.t. \;\;
+  G V + h \geq 0 \f]
+  as solved by the fast formulation of the ZMP constrained QP,
+  where the hessian is the identity in the variables
+  \f$ V = L_Q^{\top} U \f$.
+
+  A constraint pattern is a matrix \f$ G \f$, it depends on the
+  sequence of support polygons over the preview window and on the
+  model of the QP (horizon, sampling period, height of the CoM and
+  weights), and is identified by a key. For a pattern and an active
+  set \f$ W \f$, the solution is affine in the parameters \f$ (D, h) \f$:
+  \f[ \lambda_W = (G_W G_W^{\top})^{-1} (G_W D - h_W), \;\;
+  V = G_W^{\top} \lambda_W - D \f]
+  and this law is the optimum as long as \f$ \lambda_W \geq 0 \f$
+  and \f$ G V + h \geq 0 \f$, which defines the critical region.
+  The law is also checked to give \f$ G_W V + h_W = 0 \f$, which fails
+  if the stored region was learned for another matrix G.
+
+  The regions are learned offline from the solutions of a QP solver
+  (Learn), stored in a binary file, and evaluated online instead of
+  the solver (Solve). The patterns are found through a search tree
+  on their key, then the regions of the pattern are tested starting
+  with the most frequently used ones, up to a maximal number of
+  candidates to bound the computation time.
+*/
+class ExplicitMPCTable {
+public:
+  /*! \brief Constructor */
+  ExplicitMPCTable();
+
+  /*! \brief Mix the values of a constraint matrix in a pattern key,
+    starting from 0. */
+  static void HashPattern(unsigned long long &Key, const double *Values,
+                          unsigned int NbOfValues);
+
+  /*! \brief Add the critical region of the optimal solution V.
+    G is stored by columns with a leading dimension m+1.
+    \return false if the solution does not define a valid region. */
+  bool Learn(unsigned long long Key, const double *G, const double *h,
+             unsigned int m, unsigned int n, const double *D,
+             const double *V);
+
+  /*! \brief Evaluate the stored laws of the pattern Key.
+    \return true if V is the optimal solution. */
+  bool Solve(unsigned long long Key, const double *G, const double *h,
+             unsigned int m, unsigned int n, const double *D, double *V);
+
+  /*! \brief Save the table in a binary file. */
+  bool Save(const std::string &aFileName) const;
+
+  /*! \brief Load the table from a binary file. */
+  bool Load(const std::string &aFileName);
+
+  /*! \brief Remove all the regions. */
+  void Clear();
+
+  /*! \brief Maximal number of regions evaluated by Solve. */
+  void SetMaxNbOfCandidates(unsigned int aNb);
+
+  /*! \name Statistics
+    @{ */
+  /*! \brief Number of patterns. */
+  unsigned int NbOfPatterns() const;
+
+  /*! \brief Number of regions for all the patterns. */
+  unsigned int NbOfRegions() const;
+
+  /*! \brief Number of successful calls to Solve. */
+  unsigned int NbOfHits() const { return m_NbOfHits; }
+
+  /*! \brief Number of failed calls to Solve. */
+  unsigned int NbOfMisses() const { return m_NbOfMisses; }
+  /*! @} */
+
+protected:
+  /*! \brief A critical region. */
+  struct Region {
+    /*! Active constraints. */
+    std::vector<unsigned int> ActiveSet;
+    /*! \f$ (G_W G_W^{\top})^{-1} \f$ */
+    Eigen::MatrixXd iS;
+    /*! Number of times this law has been used. */
+    unsigned int NbOfHits;
+  };
+
+  /*! \brief Regions of a constraint pattern. */
+  struct Pattern {
+    unsigned int NbOfConstraints;
+    unsigned int NbOfVariables;
+    std::vector<Region> Regions;
+  };
+
+  /*! \brief Evaluate the law of a region.
+    \return true if it is optimal and its active constraints are tight. */
+  bool EvaluateRegion(const Region &aRegion, const double *G, const double *h,
+                      unsigned int m, unsigned int n, const double *D,
+                      double *V);
+
+  /*! \brief Patterns sorted by key. */
+  std::map<unsigned long long, Pattern> m_Patterns;
+
+  /*! \brief Tolerance on the constraints and the multipliers. */
+  double m_Tolerance;
+
+  /*! \brief Maximal number of regions evaluated by Solve. */
+  unsigned int m_MaxNbOfCandidates;
+
+  unsigned int m_NbOfHits;
+  unsigned int m_NbOfMisses;
+
+  /*! \brief Working vectors. */
+  Eigen::VectorXd m_Lambda, m_y;
+};
+
+} // namespace PatternGeneratorJRL
+#endif /* _EXPLICIT_MPC_TABLE_H_ */
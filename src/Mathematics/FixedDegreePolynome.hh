@@ -0,0 +1,155 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** \file FixedDegreePolynome.hh
+    \brief Polynomes whose degree is known at compile time.
+
+    The coefficients are stored inside the object and the Horner
+    schemes are unrolled by the compiler, so that evaluating a foot
+    or a waist trajectory does not involve any loop nor any heap access. */
+
+#ifndef _FIXED_DEGREE_POLYNOME_H_
+#define _FIXED_DEGREE_POLYNOME_H_
+
+#include <iostream>
+#include <vector>
+
+namespace PatternGeneratorJRL {
+
+/*! \brief Compile-time value of K!/(K-N)!, i.e. the factor appearing
+  in front of the coefficient K for the derivative of order N. */
+template <int K, int N> struct PolynomeDerivativeFactor {
+  enum { value = K * PolynomeDerivativeFactor<K - 1, N - 1>::value };
+};
+
+template <int K> struct PolynomeDerivativeFactor<K, 0> {
+  enum { value = 1 };
+};
+
+/*! \brief Unrolled Horner scheme for the derivative of order N,
+  starting at the coefficient K. */
+template <int Degree, int N, int K> struct PolynomeHorner {
+  static inline double Compute(const double *c, double t) {
+    return PolynomeDerivativeFactor<K, N>::value * c[K] +
+           t * PolynomeHorner<Degree, N, K + 1>::Compute(c, t);
+  }
+};
+
+template <int Degree, int N> struct PolynomeHorner<Degree, N, Degree> {
+  static inline double Compute(const double *c, double) {
+    return PolynomeDerivativeFactor<Degree, N>::value * c[Degree];
+  }
+};
+
+/*! \brief Unrolled Horner scheme computing together the value,
+  the first and the second derivatives. */
+template <int K> struct PolynomeFusedHorner {
+  static inline void Compute(const double *c, double t, double &p, double &dp,
+                             double &ddp) {
+    ddp = ddp * t + 2.0 * dp;
+    dp = dp * t + p;
+    p = p * t + c[K];
+    PolynomeFusedHorner<K - 1>::Compute(c, t, p, dp, ddp);
+  }
+};
+
+template <> struct PolynomeFusedHorner<-1> {
+  static inline void Compute(const double *, double, double &, double &,
+                             double &) {}
+};
+
+/** Polynome whose degree is a template parameter.
+    It provides the same interface than Polynome. */
+template <int PolynomeDegree> class FixedDegreePolynome {
+public:
+  /*! Constructor */
+  FixedDegreePolynome() {
+    for (int i = 0; i <= PolynomeDegree; i++)
+      m_Coefficients[i] = 0.0;
+  }
+
+  /*! Compute the value. */
+  inline double Compute(double t) const {
+    return PolynomeHorner<PolynomeDegree, 0, 0>::Compute(m_Coefficients, t);
+  }
+
+  /*! Compute the value of the derivative. */
+  inline double ComputeDerivative(double t) const {
+    return ComputeNthDerivative<1>(t);
+  }
+
+  /*! Compute the value of the second derivative. */
+  inline double ComputeSecDerivative(double t) const {
+    return ComputeNthDerivative<2>(t);
+  }
+
+  /*! Compute the value of the third derivative (jerk). */
+  inline double ComputeJerk(double t) const {
+    return ComputeNthDerivative<3>(t);
+  }
+
+  /*! Compute in one pass the value, the derivative
+    and the second derivative. */
+  inline void ComputeAll(double t, double &p, double &dp, double &ddp) const {
+    p = m_Coefficients[PolynomeDegree];
+    dp = 0.0;
+    ddp = 0.0;
+    PolynomeFusedHorner<PolynomeDegree - 1>::Compute(m_Coefficients, t, p, dp,
+                                                     ddp);
+  }
+
+  /*! Get the coefficients. */
+  void GetCoefficients(std::vector<double> &lCoefficients) const {
+    lCoefficients.resize(PolynomeDegree + 1);
+    for (int i = 0; i <= PolynomeDegree; i++)
+      lCoefficients[i] = m_Coefficients[i];
+  }
+
+  /*! Set the coefficients. */
+  void SetCoefficients(const std::vector<double> &lCoefficients) {
+    for (int i = 0; i <= PolynomeDegree; i++)
+      m_Coefficients[i] =
+          i < (int)lCoefficients.size() ? lCoefficients[i] : 0.0;
+  }
+
+  inline int Degree() const { return PolynomeDegree; };
+
+  /*! Print the coefficient. */
+  void print() const {
+    for (int i = 0; i <= PolynomeDegree; i++)
+      std::cout << m_Coefficients[i] << " ";
+    std::cout << std::endl;
+  }
+
+protected:
+  /*! Derivatives of order higher than the degree are null. */
+  template <int N> inline double ComputeNthDerivative(double t) const {
+    if (N > PolynomeDegree)
+      return 0.0;
+    // Order is only used to instantiate a valid Horner scheme.
+    enum { Order = N > PolynomeDegree ? 0 : N };
+    return PolynomeHorner<PolynomeDegree, Order, Order>::Compute(
+        m_Coefficients, t);
+  }
+
+  /// Coefficients.
+  double m_Coefficients[PolynomeDegree + 1];
+};
+
+} // namespace PatternGeneratorJRL
+#endif /* _FIXED_DEGREE_POLYNOME_H_ */
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** \file LIPMPropagator.cpp
+    \brief Precomputed state transitions of the linear inverted pendulum. */
+
+#include <math.h>
+
+#include <Mathematics/LIPMPropagator.hh>
+
+using namespace PatternGeneratorJRL;
+
+LIPMPropagator::LIPMPropagator() {
+  m_Type = NONE;
+  m_Omega = 0.0;
+  m_T = 0.0;
+}
+
+void LIPMPropagator::InitializeHyperbolic(double omega, double T,
+                                          unsigned int NbOfMultiples) {
+  if ((m_Type == HYPERBOLIC) && (m_Omega == omega) && (m_T == T) &&
+      (m_A.size() == NbOfMultiples + 1))
+    return;
+
+  m_Type = HYPERBOLIC;
+  m_Omega = omega;
+  m_T = T;
+  m_A.resize(NbOfMultiples + 1);
+  m_B.resize(NbOfMultiples + 1);
+
+  double omega2 = omega * omega;
+  for (unsigned int k = 0; k <= NbOfMultiples; k++) {
+    double c = cosh(omega * k * T), s = sinh(omega * k * T);
+    Eigen::Matrix3d &A = m_A[k];
+    A(0, 0) = c;
+    A(0, 1) = omega == 0.0 ? k * T : s / omega;
+    A(0, 2) = 0.0;
+    A(1, 0) = omega * s;
+    A(1, 1) = c;
+    A(1, 2) = 0.0;
+    // The acceleration is given by the dynamics.
+    A(2, 0) = omega2 * c;
+    A(2, 1) = omega * s;
+    A(2, 2) = 0.0;
+    m_B[k].setZero();
+  }
+}
+
+void LIPMPropagator::InitializeJerkIntegrator(double T,
+                                              unsigned int NbOfMultiples) {
+  if ((m_Type == JERK_INTEGRATOR) && (m_T == T) &&
+      (m_A.size() == NbOfMultiples + 1))
+    return;
+
+  m_Type = JERK_INTEGRATOR;
+  m_Omega = 0.0;
+  m_T = T;
+  m_A.resize(NbOfMultiples + 1);
+  m_B.resize(NbOfMultiples + 1);
+
+  for (unsigned int k = 0; k <= NbOfMultiples; k++) {
+    double kT = k * T;
+    Eigen::Matrix3d &A = m_A[k];
+    A(0, 0) = 1.0;
+    A(0, 1) = kT;
+    A(0, 2) = 0.5 * kT * kT;
+    A(1, 0) = 0.0;
+    A(1, 1) = 1.0;
+    A(1, 2) = kT;
+    A(2, 0) = 0.0;
+    A(2, 1) = 0.0;
+    A(2, 2) = 1.0;
+
+    m_B[k](0) = kT * kT * kT / 6.0;
+    m_B[k](1) = 0.5 * kT * kT;
+    m_B[k](2) = kT;
+  }
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** \file LIPMPropagator.hh
+    \brief Precomputed state transitions of the linear inverted pendulum.
+
+    The closed forms of the LIPM are evaluated on a regular time grid.
+    Instead of calling cosh and sinh for each sample, the transition
+    matrices over k control periods are computed once, and a state is
+    propagated by a matrix product. */
+
+#ifndef _LIPM_PROPAGATOR_H_
+#define _LIPM_PROPAGATOR_H_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace PatternGeneratorJRL {
+
+/*! \brief Transition matrices of a one dimensional LIPM state
+  \f$ x = [c \; \dot{c} \; \ddot{c}]^T \f$ over multiples of a period:
+  \f$ x_{k} = A_k x_0 + B_k u \f$.
+
+  Two dynamics are handled:
+  - the free pendulum \f$ \ddot{c} = \omega^2 c \f$ (hyperbolic part
+  of the analytical trajectories), for which \f$ B_k = 0 \f$,
+  - the triple integrator controlled by a constant jerk \f$ u \f$
+  used by the linearized inverted pendulum.
+*/
+class LIPMPropagator {
+public:
+  /*! Constructor */
+  LIPMPropagator();
+
+  /*! \brief Precompute \f$ A_k \f$ for the free pendulum,
+    with \f$ k \in [0, NbOfMultiples] \f$.
+    Nothing is done if the tables already match the parameters. */
+  void InitializeHyperbolic(double omega, double T, unsigned int NbOfMultiples);
+
+  /*! \brief Precompute \f$ A_k, B_k \f$ for the triple integrator,
+    with \f$ k \in [0, NbOfMultiples] \f$.
+    Nothing is done if the tables already match the parameters. */
+  void InitializeJerkIntegrator(double T, unsigned int NbOfMultiples);
+
+  /*! \brief Number of periods covered by the tables
+    (0 if not initialized). */
+  inline unsigned int NbOfMultiples() const {
+    return m_A.size() == 0 ? 0 : (unsigned int)m_A.size() - 1;
+  }
+
+  /*! \brief Period of the tables. */
+  inline double Period() const { return m_T; }
+
+  /*! \brief Propagate one axis over k periods. */
+  inline void Propagate(unsigned int k, const Eigen::Vector3d &x0, double u,
+                        Eigen::Vector3d &xk) const {
+    xk.noalias() = m_A[k] * x0;
+    if (u != 0.0)
+      xk += u * m_B[k];
+  }
+
+  /*! \brief Propagate the x and y axes together over k periods.
+    Each column of \a xy0 is the state of one axis, and each column
+    of \a u its control. */
+  inline void Propagate(unsigned int k, const Eigen::Matrix<double, 3, 2> &xy0,
+                        const Eigen::Matrix<double, 1, 2> &u,
+                        Eigen::Matrix<double, 3, 2> &xyk) const {
+    xyk.noalias() = m_A[k] * xy0;
+    xyk.noalias() += m_B[k] * u;
+  }
+
+protected:
+  /*! \brief Kind of dynamics stored in the tables. */
+  enum DynamicsType { NONE, HYPERBOLIC, JERK_INTEGRATOR };
+
+  DynamicsType m_Type;
+
+  /*! \brief Natural frequency \f$ \omega = \sqrt{g/z_c} \f$. */
+  double m_Omega;
+
+  /*! \brief Period. */
+  double m_T;
+
+  /*! \brief Transition matrices \f$ A_k \f$. */
+  std::vector<Eigen::Matrix3d> m_A;
+
+  /*! \brief Control vectors \f$ B_k \f$. */
+  std::vector<Eigen::Vector3d> m_B;
+};
+
+} // namespace PatternGeneratorJRL
+#endif /* _LIPM_PROPAGATOR_H_ */
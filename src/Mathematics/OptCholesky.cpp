@@ -28,8 +28,104 @@
 #include <Mathematics/OptCholesky.hh>
 #include <math.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OPTCHOLESKY_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
 using namespace PatternGeneratorJRL;
 
+namespace {
+/* Kernels used by the updates: a dot product and an axpy on
+   contiguous arrays. The AVX2 versions are compiled for their own
+   target and selected at runtime, the scalar ones are the fallback. */
+typedef double (*DotProductKernel)(const double *, const double *,
+                                   unsigned int);
+typedef void (*AxpyKernel)(double, const double *, double *, unsigned int);
+
+double DotProductScalar(const double *x, const double *y, unsigned int n) {
+  double r0 = 0.0, r1 = 0.0;
+  unsigned int i = 0;
+  for (; i + 1 < n; i += 2) {
+    r0 += x[i] * y[i];
+    r1 += x[i + 1] * y[i + 1];
+  }
+  if (i < n)
+    r0 += x[i] * y[i];
+  return r0 + r1;
+}
+
+void AxpyScalar(double a, const double *x, double *y, unsigned int n) {
+  for (unsigned int i = 0; i < n; i++)
+    y[i] += a * x[i];
+}
+
+#ifdef OPTCHOLESKY_X86_DISPATCH
+__attribute__((target("avx2,fma"))) double
+DotProductAVX2(const double *x, const double *y, unsigned int n) {
+  __m256d r0 = _mm256_setzero_pd(), r1 = _mm256_setzero_pd();
+  unsigned int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    r0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), r0);
+    r1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4),
+                         r1);
+  }
+  if (i + 4 <= n) {
+    r0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), r0);
+    i += 4;
+  }
+  r0 = _mm256_add_pd(r0, r1);
+  __m128d h = _mm_add_pd(_mm256_castpd256_pd128(r0),
+                         _mm256_extractf128_pd(r0, 1));
+  double r = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+  for (; i < n; i++)
+    r += x[i] * y[i];
+  return r;
+}
+
+__attribute__((target("avx2,fma"))) void
+AxpyAVX2(double a, const double *x, double *y, unsigned int n) {
+  __m256d va = _mm256_set1_pd(a);
+  unsigned int i = 0;
+  for (; i + 4 <= n; i += 4)
+    _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i),
+                                            _mm256_loadu_pd(y + i)));
+  for (; i < n; i++)
+    y[i] += a * x[i];
+}
+
+bool CPUHasAVX2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+#else
+bool CPUHasAVX2() { return false; }
+#endif /* OPTCHOLESKY_X86_DISPATCH */
+
+DotProductKernel OptCholeskyDotProduct = DotProductScalar;
+AxpyKernel OptCholeskyAxpy = AxpyScalar;
+
+/* Select the kernels when the library is loaded. */
+struct KernelSelection {
+  KernelSelection() { OptCholesky::SetSIMDKernels(true); }
+} aKernelSelection;
+} // namespace
+
+bool OptCholesky::SetSIMDKernels(bool UseSIMD) {
+#ifdef OPTCHOLESKY_X86_DISPATCH
+  if (UseSIMD && CPUHasAVX2()) {
+    OptCholeskyDotProduct = DotProductAVX2;
+    OptCholeskyAxpy = AxpyAVX2;
+    return true;
+  }
+#else
+  (void)UseSIMD;
+#endif /* OPTCHOLESKY_X86_DISPATCH */
+  OptCholeskyDotProduct = DotProductScalar;
+  OptCholeskyAxpy = AxpyScalar;
+  return false;
+}
+
 OptCholesky::OptCholesky(unsigned int lNbMaxOfConstraints, unsigned int lCardU,
                          unsigned int lUpdateMode)
     : m_NbMaxOfConstraints(lNbMaxOfConstraints), m_CardU(lCardU), m_A(0),
@@ -63,26 +159,63 @@ void OptCholesky::SetA(double *aA, unsigned int lNbOfConstraints) {
 }
 
 int OptCholesky::AddActiveConstraints(vector<unsigned int> &lConstraints) {
-  int r = 0;
-  for (unsigned int li = 0; li < lConstraints.size(); li++) {
-    r = AddActiveConstraint(lConstraints[li]);
-    if (r < 0)
-      return -((int)(li));
-  }
-  return r;
+  if (lConstraints.size() == 0)
+    return 0;
+
+  /* The rows are appended together: the matrix A is read once
+     for the whole block. */
+  std::size_t FirstNewRow = m_SetActiveConstraints.size();
+  for (unsigned int li = 0; li < lConstraints.size(); li++)
+    m_SetActiveConstraints.push_back(lConstraints[li]);
+
+  int r = UpdateCholeskyMatrixBlock(FirstNewRow);
+  if (r < 0)
+    return -((int)(-r - 1 - FirstNewRow));
+  return 0;
 }
 
 int OptCholesky::AddActiveConstraint(unsigned int aConstraint) {
   /* Update set of active constraints */
   m_SetActiveConstraints.push_back(aConstraint);
 
-  int r = 0;
-  if (m_UpdateMode == MODE_NORMAL)
-    UpdateCholeskyMatrixNormal();
-  else if (m_UpdateMode == MODE_FORTRAN)
-    UpdateCholeskyMatrixFortran();
+  UpdateCholeskyMatrixBlock(m_SetActiveConstraints.size() - 1);
+  return 0;
+}
 
-  return r;
+int OptCholesky::RemoveActiveConstraint(std::size_t lRow) {
+  std::size_t n = m_SetActiveConstraints.size();
+  if ((m_L == 0) || (lRow >= n))
+    return -1;
+
+  /* Remove the row lRow of L: the rows below are moved up,
+     and have one element above the diagonal. */
+  for (std::size_t li = lRow; li + 1 < n; li++) {
+    double *ptLi = m_L + li * m_NbMaxOfConstraints;
+    double *ptLi1 = ptLi + m_NbMaxOfConstraints;
+    for (std::size_t lj = 0; lj <= li + 1; lj++)
+      ptLi[lj] = ptLi1[lj];
+  }
+  m_SetActiveConstraints.erase(m_SetActiveConstraints.begin() + lRow);
+  n--;
+
+  /* Givens rotations on the columns (lj,lj+1) restore
+     the triangular shape. */
+  for (std::size_t lj = lRow; lj < n; lj++) {
+    double a = m_L[lj * m_NbMaxOfConstraints + lj];
+    double b = m_L[lj * m_NbMaxOfConstraints + lj + 1];
+    double h = sqrt(a * a + b * b);
+    if (h == 0.0)
+      return -1;
+    double c = a / h, s = b / h;
+    for (std::size_t li = lj; li < n; li++) {
+      double *ptL = m_L + li * m_NbMaxOfConstraints + lj;
+      double x = ptL[0], y = ptL[1];
+      ptL[0] = c * x + s * y;
+      ptL[1] = -s * x + c * y;
+    }
+    m_L[lj * m_NbMaxOfConstraints + lj + 1] = 0.0;
+  }
+  return 0;
 }
 
 std::size_t OptCholesky::CurrentNumberOfRows() {
@@ -97,96 +230,77 @@ void OptCholesky::SetiL(double *aiL) {
   m_iL = aiL;
 }
 
-int OptCholesky::UpdateCholeskyMatrixNormal() {
-
-  if ((m_A == 0) | (m_L == 0))
-    return -1;
-
-  double Mij = 0.0;
-  std::size_t IndexNewRowAKAi = 0;
-  if (m_SetActiveConstraints.size() > 0)
-    IndexNewRowAKAi = m_SetActiveConstraints.size() - 1;
-
-  double *PointerArow_i =
-      m_A + m_CardU * m_SetActiveConstraints[IndexNewRowAKAi];
-
-  /* Compute Li,j */
-  for (int lj = 0; lj < (int)m_SetActiveConstraints.size(); lj++) {
-
-    /* A value M(i,j) is computed once,
-       directly from the matrix A */
-    double *Arow_i = PointerArow_i;
-    double *Arow_j = m_A + m_CardU * m_SetActiveConstraints[lj];
-    Mij = 0.0;
-    for (int lk = 0; lk < (int)m_CardU; lk++) {
-      Mij += (*Arow_i++) * (*Arow_j++);
+int OptCholesky::ComputeGramRowsNormal(std::size_t FirstNewRow) {
+  std::size_t n = m_SetActiveConstraints.size();
+  for (std::size_t li = FirstNewRow; li < n; li++) {
+    const double *Arow_i = m_A + m_CardU * m_SetActiveConstraints[li];
+    double *ptLi = m_L + li * m_NbMaxOfConstraints;
+    for (std::size_t lj = 0; lj <= li; lj++) {
+      const double *Arow_j = m_A + m_CardU * m_SetActiveConstraints[lj];
+      ptLi[lj] = OptCholeskyDotProduct(Arow_i, Arow_j, m_CardU);
     }
+  }
+  return 0;
+}
 
-    /* */
-    double r = Mij;
-    double *ptLik = m_L + IndexNewRowAKAi * m_NbMaxOfConstraints;
-    double *ptLjk = m_L + lj * m_NbMaxOfConstraints;
-
-    for (int lk = 0; lk < lj; lk++) {
-      r = r - (*ptLik++) * (*ptLjk++);
-    }
-    if (lj != (int)m_SetActiveConstraints.size() - 1)
-      m_L[IndexNewRowAKAi * m_NbMaxOfConstraints + lj] =
-          r / m_L[lj * m_NbMaxOfConstraints + lj];
-    else
-      m_L[IndexNewRowAKAi * m_NbMaxOfConstraints + lj] = sqrt(r);
+int OptCholesky::ComputeGramRowsFortran(std::size_t FirstNewRow) {
+  std::size_t n = m_SetActiveConstraints.size();
+  for (std::size_t li = FirstNewRow; li < n; li++) {
+    double *ptLi = m_L + li * m_NbMaxOfConstraints;
+    for (std::size_t lj = 0; lj <= li; lj++)
+      ptLi[lj] = 0.0;
   }
 
+  /* A is stored by columns: each column is read once,
+     and its values for the active constraints are gathered
+     in a contiguous buffer. */
+  if (m_Gather.size() < n)
+    m_Gather.resize(n);
+  double *lGather = &m_Gather[0];
+  for (unsigned int lk = 0; lk < m_CardU; lk++) {
+    const double *Acol = m_A + lk * (m_NbOfConstraints + 1);
+    for (std::size_t lj = 0; lj < n; lj++)
+      lGather[lj] = Acol[m_SetActiveConstraints[lj]];
+
+    for (std::size_t li = FirstNewRow; li < n; li++)
+      OptCholeskyAxpy(lGather[li], lGather, m_L + li * m_NbMaxOfConstraints,
+                      (unsigned int)li + 1);
+  }
   return 0;
 }
 
-int OptCholesky::UpdateCholeskyMatrixFortran() {
-
+int OptCholesky::UpdateCholeskyMatrixBlock(std::size_t FirstNewRow) {
   if ((m_A == 0) | (m_L == 0))
     return -1;
 
-  double Mij = 0.0;
-  std::size_t IndexNewRowAKAi = 0;
-  if (m_SetActiveConstraints.size() > 0)
-    IndexNewRowAKAi = m_SetActiveConstraints.size() - 1;
-
-  double *PointerArow_i = m_A + m_SetActiveConstraints[IndexNewRowAKAi];
-
-  /* Compute Li,j */
-  for (int lj = 0; lj < (int)m_SetActiveConstraints.size(); lj++) {
-
-    /* A value M(i,j) is computed once,
-       directly from the matrix A */
-    double *Arow_i = PointerArow_i;
-    double *Arow_j = m_A + m_SetActiveConstraints[lj];
-    Mij = 0.0;
-    for (int lk = 0; lk < (int)m_CardU; lk++) {
-      Mij += (*Arow_i) * (*Arow_j);
-      Arow_i += m_NbOfConstraints + 1;
-      Arow_j += m_NbOfConstraints + 1;
-    }
-
-    /* */
-    double r = Mij;
-    ODEBUG("r: M(" << m_SetActiveConstraints[IndexNewRowAKAi] << ","
-                   << m_SetActiveConstraints[lj] << ")=" << r);
-    double *ptLik = m_L + IndexNewRowAKAi * m_NbMaxOfConstraints;
-    double *ptLjk = m_L + lj * m_NbMaxOfConstraints;
+  /* Stage 1: the new rows of M = E E^t are computed in place in L. */
+  if (m_UpdateMode == MODE_NORMAL)
+    ComputeGramRowsNormal(FirstNewRow);
+  else if (m_UpdateMode == MODE_FORTRAN)
+    ComputeGramRowsFortran(FirstNewRow);
+  else
+    return -1;
 
-    for (int lk = 0; lk < lj; lk++) {
-      r = r - (*ptLik++) * (*ptLjk++);
+  /* Stage 2: forward substitution with the rows already computed,
+     the inner products are done on contiguous rows of L. */
+  int r = 0;
+  std::size_t n = m_SetActiveConstraints.size();
+  for (std::size_t li = FirstNewRow; li < n; li++) {
+    double *ptLi = m_L + li * m_NbMaxOfConstraints;
+    for (std::size_t lj = 0; lj <= li; lj++) {
+      double *ptLj = m_L + lj * m_NbMaxOfConstraints;
+      double Mij =
+          ptLi[lj] - OptCholeskyDotProduct(ptLi, ptLj, (unsigned int)lj);
+      if (lj != li)
+        ptLi[lj] = Mij / ptLj[lj];
+      else {
+        if ((Mij <= 0.0) && (r == 0))
+          r = -(int)li - 1;
+        ptLi[lj] = sqrt(Mij);
+      }
     }
-    if (lj != (int)m_SetActiveConstraints.size() - 1)
-      m_L[IndexNewRowAKAi * m_NbMaxOfConstraints + lj] =
-          r / m_L[lj * m_NbMaxOfConstraints + lj];
-    else
-      m_L[IndexNewRowAKAi * m_NbMaxOfConstraints + lj] = sqrt(r);
-
-    ODEBUG("m_L(" << IndexNewRowAKAi << "," << lj
-                  << ")=" << m_L[IndexNewRowAKAi * m_NbMaxOfConstraints + lj]);
   }
-
-  return 0;
+  return r;
 }
 
 int OptCholesky::ComputeNormalCholeskyOnANormal() {
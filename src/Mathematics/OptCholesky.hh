@@ -63,6 +63,9 @@ public:
   void SetA(double *aA, unsigned int lNbOfConstraints);
 
   /*! \brief Add a list of active constraints
+    The rows are appended as one block: the new rows of
+    \f$ E E^{\top} \f$ are computed in one pass over \f$ {\bf A} \f$
+    before the factorization.
     @param[in] lConstraints: row indexes of constraints in \f${\bf A} \f$.
     @return \f$ -i \f$ where \f$ i \f$ is the constraint for
     which there is a problem.
@@ -75,6 +78,15 @@ public:
   */
   int AddActiveConstraint(unsigned int aConstraint);
 
+  /*! \brief Remove one active constraint without refactoring:
+    the row is removed from \f$ {\bf L} \f$ which is made triangular
+    again by Givens rotations.
+    @param[in] lRow: position of the constraint in the active set,
+    i.e. its row in \f$ {\bf L} \f$.
+    @return -1 if the row does not exist, 0 otherwise.
+  */
+  int RemoveActiveConstraint(std::size_t lRow);
+
   /*! \brief Returns the current number of rows
     or the current number of active constraints on \f$ {\bf A} \f$.*/
   std::size_t CurrentNumberOfRows();
@@ -97,6 +109,11 @@ public:
   /*! \brief Set Mode to update the cholesky matrix */
   void SetMode(unsigned int mode);
 
+  /*! \brief Use the AVX2 kernels if the processor supports them,
+    otherwise the scalar ones. This is selected at load time.
+    @return true if the AVX2 kernels are used. */
+  static bool SetSIMDKernels(bool UseSIMD);
+
   /*! \brief Various mode to compute cholesky matrix. */
   static const unsigned int MODE_NORMAL = 0;
   static const unsigned int MODE_FORTRAN = 1;
@@ -132,11 +149,21 @@ private:
     Its size gives the size of \f$ {\bf L} \f$, and \f$ {\bf E} \f$ */
   vector<unsigned int> m_SetActiveConstraints;
 
-  /*! \brief Update Cholesky computation */
-  int UpdateCholeskyMatrixFortran();
+  /*! \brief Buffer for the values of one column of \f$ {\bf A} \f$
+    on the active constraints. */
+  vector<double> m_Gather;
+
+  /*! \brief Update Cholesky computation for the rows starting at
+    FirstNewRow.
+    @return \f$ -i-1 \f$ if the row \f$ i \f$ is not positive. */
+  int UpdateCholeskyMatrixBlock(std::size_t FirstNewRow);
+
+  /*! \brief Rows of \f$ E E^{\top} \f$ when A is stored by rows. */
+  int ComputeGramRowsNormal(std::size_t FirstNewRow);
 
-  /*! \brief Update Cholesky computation */
-  int UpdateCholeskyMatrixNormal();
+  /*! \brief Rows of \f$ E E^{\top} \f$ when A is stored by columns
+    with a leading dimension \f$ m+1 \f$. */
+  int ComputeGramRowsFortran(std::size_t FirstNewRow);
 
   /*! \brief  Free memory. */
   void FreeMemory();
@@ -66,6 +66,8 @@ PLDPSolver::PLDPSolver(unsigned int CardU, double *iPu, double *Px, double *Pu,
   m_tol = 1e-8;
   m_LimitedComputationTime = true;
   m_AmountOfLimitedComputationTime = 0.0013;
+  m_Monitor = 0;
+  memset(&m_LastTickReport, 0, sizeof(m_LastTickReport));
   /* Initialize pointers */
   m_CardV = CardU;
 
@@ -150,6 +152,11 @@ void PLDPSolver::InitializeSolver() {
   memset(m_d,0,2*m_CardV*sizeof(double));
 #endif
   m_ActivatedConstraints.clear();
+
+  // The values cached by ComputeAlpha depend on the descent direction
+  // and on the constraints of the tick: they are never carried.
+  memset(m_ConstraintsValueComputed, 0,
+         m_NbMaxOfConstraints * 2 * sizeof(bool));
 }
 
 PLDPSolver::~PLDPSolver() {
@@ -196,6 +203,74 @@ PLDPSolver::~PLDPSolver() {
     delete[] m_ConstraintsValueComputed;
 }
 
+void PLDPSolver::SetLimitedComputationTime(bool LimitedComputationTime,
+                                           double aBudget) {
+  m_LimitedComputationTime = LimitedComputationTime;
+  m_AmountOfLimitedComputationTime = aBudget;
+}
+
+bool PLDPSolver::GetLimitedComputationTime() const {
+  return m_LimitedComputationTime;
+}
+
+double PLDPSolver::GetAmountOfLimitedComputationTime() const {
+  return m_AmountOfLimitedComputationTime;
+}
+
+void PLDPSolver::SetHotStart(bool HotStart) {
+  m_HotStart = HotStart;
+  if (!m_HotStart)
+    m_PreviouslyActivatedConstraints.clear();
+}
+
+void PLDPSolver::SetMonitor(PLDPSolverMonitor *aMonitor) {
+  m_Monitor = aMonitor;
+}
+
+const PLDPSolverTickReport &PLDPSolver::GetLastTickReport() const {
+  return m_LastTickReport;
+}
+
+double PLDPSolver::CurrentTime() {
+  struct timeval current;
+  gettimeofday(&current, 0);
+  return (double)current.tv_sec + 0.000001 * (double)current.tv_usec;
+}
+
+bool PLDPSolver::IsCurrentSolutionFeasible() {
+  for (unsigned int li = 0; li < m_NbOfConstraints; li++) {
+    double r = m_b[li];
+    double *ptA = m_A + li;
+    for (unsigned int lj = 0; lj < 2 * m_CardV; lj++) {
+      r += *ptA * m_Vk[lj];
+      ptA += (m_NbOfConstraints + 1);
+    }
+    if (r < -m_tol)
+      return false;
+  }
+  return true;
+}
+
+int PLDPSolver::ConstraintToRelease() {
+  // The multipliers of the active constraints are -v2.
+  int lRow = -1;
+  double MaxMultiplier = m_tol;
+  for (unsigned int i = 0; i < m_ActivatedConstraints.size(); i++) {
+    if (m_v2[i] > MaxMultiplier) {
+      MaxMultiplier = m_v2[i];
+      lRow = (int)i;
+    }
+  }
+  return lRow;
+}
+
+double PLDPSolver::CurrentCost() {
+  double r = 0.0;
+  for (unsigned int i = 0; i < 2 * m_CardV; i++)
+    r += (0.5 * m_Vk[i] + m_CstPartOfCostFunction[i]) * m_Vk[i];
+  return r;
+}
+
 int PLDPSolver::PrecomputeiPuPx() {
   m_iPuPx = new double[2 * m_CardV * 6];
 
@@ -597,6 +672,9 @@ int PLDPSolver::SolveProblem(
   if (StartingSequence)
     m_InternalTime = 0.0;
 
+  // The deadline includes the initialization and the hot start.
+  double begin = CurrentTime();
+
   InitializeSolver();
 
   m_A = LinearPartOfConstraints;
@@ -611,6 +689,18 @@ int PLDPSolver::SolveProblem(
 
   ComputeInitialSolution(ZMPRef, XkYk, StartingSequence);
 
+  // The shifted solution of the previous tick is only a valid
+  // starting point if it is feasible for the new constraints:
+  // otherwise the iterates would not be feasible either.
+  // Then start from the ZMP reference which is always feasible.
+  bool HotStartRejected = false;
+  if ((m_HotStart) && (!StartingSequence) && (!IsCurrentSolutionFeasible())) {
+    ODEBUG("Hot start rejected at time " << m_InternalTime);
+    ComputeInitialSolution(ZMPRef, XkYk, true);
+    m_PreviouslyActivatedConstraints.clear();
+    HotStartRejected = true;
+  }
+
   ODEBUG("DebugMode:" << m_DebugMode);
 
   if (m_DebugMode > 1) {
@@ -691,11 +781,8 @@ int PLDPSolver::SolveProblem(
   m_OptCholesky->SetA(LinearPartOfConstraints, m_NbOfConstraints);
   m_OptCholesky->SetToZero();
 
-  struct timeval begin;
-
-  gettimeofday(&begin, 0);
-
-  // Hot Start
+  // Hot Start: the active set of the previous tick is carried,
+  // the indexes are shifted by the constraints of the removed sample.
   if (m_HotStart) {
     for (unsigned int i = 0; i < m_PreviouslyActivatedConstraints.size(); i++) {
       int lindex =
@@ -709,8 +796,10 @@ int PLDPSolver::SolveProblem(
   }
 
   m_PreviouslyActivatedConstraints.clear();
+  std::size_t NbOfCarriedConstraints = m_ActivatedConstraints.size();
 
-  double alpha = 0.0;
+  double alpha = 0.0, NormOfd2 = 0.0;
+  bool DeadlineReached = false;
   m_ItNb = 0;
   while (ContinueAlgo) {
     ODEBUG("Iteration Number:" << m_ItNb);
@@ -737,8 +826,10 @@ int PLDPSolver::SolveProblem(
     }
 
     /*! Compute new solution. */
+    NormOfd2 = 0.0;
     for (unsigned int i = 0; i < 2 * m_CardV; i++) {
       m_Vk[i] = m_Vk[i] + alpha * m_d[i];
+      NormOfd2 += m_d[i] * m_d[i];
     }
 
     if (m_DebugMode > 1) {
@@ -787,14 +878,25 @@ int PLDPSolver::SolveProblem(
       }
     }
 
+    // At the minimum on the active constraints, a constraint with a
+    // negative multiplier is released and the descent goes on.
+    if (!ContinueAlgo) {
+      int lRow = ConstraintToRelease();
+      if (lRow >= 0) {
+        m_OptCholesky->RemoveActiveConstraint(lRow);
+        m_ActivatedConstraints.erase(m_ActivatedConstraints.begin() + lRow);
+        for (std::size_t i = lRow; i < m_ActivatedConstraints.size(); i++)
+          m_v2[i] = m_v2[i + 1];
+        ContinueAlgo = true;
+      }
+    }
+
     // If limited computation time stop the algorithm.
-    if (m_LimitedComputationTime) {
-      struct timeval current;
-      gettimeofday(&current, 0);
-      double r = (double)(current.tv_sec - begin.tv_sec) +
-                 0.000001 * (double)(current.tv_usec - begin.tv_usec);
-      if (r > m_AmountOfLimitedComputationTime) {
+    // The current iterate is feasible and the best one so far.
+    if ((m_LimitedComputationTime) && (ContinueAlgo)) {
+      if (CurrentTime() - begin > m_AmountOfLimitedComputationTime) {
         ContinueAlgo = false;
+        DeadlineReached = true;
       }
     }
 
@@ -884,6 +986,23 @@ int PLDPSolver::SolveProblem(
               << " " << m_ItNb,
           (char *)Buffer.c_str());
 
+  m_LastTickReport.Time = m_InternalTime;
+  m_LastTickReport.NbOfIterations = m_ItNb;
+  m_LastTickReport.NbOfActivatedConstraints =
+      (unsigned int)m_ActivatedConstraints.size();
+  m_LastTickReport.NbOfCarriedConstraints =
+      (unsigned int)NbOfCarriedConstraints;
+  m_LastTickReport.Cost = CurrentCost();
+  // With an identity hessian, the full step along d decreases
+  // the cost by |d|^2/2, only the step alpha has been done.
+  m_LastTickReport.Suboptimality =
+      0.5 * (1.0 - alpha) * (1.0 - alpha) * NormOfd2;
+  m_LastTickReport.ComputationTime = CurrentTime() - begin;
+  m_LastTickReport.DeadlineReached = DeadlineReached;
+  m_LastTickReport.HotStartRejected = HotStartRejected;
+  if (m_Monitor != 0)
+    m_Monitor->TickSolved(m_LastTickReport);
+
   m_InternalTime += 0.02;
   return 0;
 }
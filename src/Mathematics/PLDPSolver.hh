@@ -37,6 +37,49 @@
 
 namespace Optimization {
 namespace Solver {
+
+/*! \brief Summary of one call to PLDPSolver::SolveProblem. */
+struct PLDPSolverTickReport {
+  /*! Internal time of the solver. */
+  double Time;
+
+  /*! Number of iterations performed. */
+  int NbOfIterations;
+
+  /*! Number of constraints activated at the end of the tick. */
+  unsigned int NbOfActivatedConstraints;
+
+  /*! Number of constraints carried from the previous tick. */
+  unsigned int NbOfCarriedConstraints;
+
+  /*! Value of the cost function for the returned iterate. */
+  double Cost;
+
+  /*! Estimated suboptimality of the returned iterate:
+    the decrease of the cost which was still possible along the
+    last projected descent direction. Zero when the solver converged. */
+  double Suboptimality;
+
+  /*! Wall-clock time spent in the tick (s). */
+  double ComputationTime;
+
+  /*! True if the solver has been stopped by its deadline. */
+  bool DeadlineReached;
+
+  /*! True if the shifted solution of the previous tick was not feasible
+    and the solver started from the ZMP reference instead. */
+  bool HotStartRejected;
+};
+
+/*! \brief Instrumentation hook called at the end of each tick. */
+class PLDPSolverMonitor {
+public:
+  virtual ~PLDPSolverMonitor() {}
+
+  /*! \brief Called once per call to PLDPSolver::SolveProblem. */
+  virtual void TickSolved(const PLDPSolverTickReport &aReport) = 0;
+};
+
 /*! This class implements a two stage strategy to solve the
   following optimal problem:
  */
@@ -59,6 +102,35 @@ public:
                    unsigned int NumberOfRemovedConstraints,
                    bool StartingSequence);
 
+  /*! \name Anytime mode
+    When the computation time is limited, the solver stops at the
+    deadline and returns its current iterate. All the iterates are
+    feasible and the cost decreases along them, so this is the best
+    feasible iterate found so far.
+    @{
+  */
+  /*! \brief Limit the wall-clock time of each call to SolveProblem
+    to \a aBudget seconds, including the hot start. */
+  void SetLimitedComputationTime(bool LimitedComputationTime,
+                                 double aBudget);
+
+  /*! \brief Returns true if the computation time is limited. */
+  bool GetLimitedComputationTime() const;
+
+  /*! \brief Returns the time budget of one tick (s). */
+  double GetAmountOfLimitedComputationTime() const;
+
+  /*! \brief Reuse the solution and the active set of the previous tick. */
+  void SetHotStart(bool HotStart);
+
+  /*! \brief Specify the object notified after each tick
+    (not owned, 0 to remove it). */
+  void SetMonitor(PLDPSolverMonitor *aMonitor);
+
+  /*! \brief Returns the report of the last tick. */
+  const PLDPSolverTickReport &GetLastTickReport() const;
+  /*! @} */
+
 protected:
   /*! \name Initial solution methods related
     @{
@@ -103,6 +175,12 @@ protected:
 
   /*! @} */
 
+  /*! \brief Returns the row of the active constraint with the most
+    negative multiplier, -1 if all the multipliers are positive.
+    The multipliers are the ones of the last projected descent
+    direction. */
+  int ConstraintToRelease();
+
   /*! Detecting violated constraints */
   double ComputeAlpha(vector<unsigned int> &NewActivatedConstraints,
                       vector<int> &SimilarConstraint);
@@ -116,6 +194,17 @@ protected:
 
   /*! \name Methods related to a limited amount of computational time
     @{ */
+  /*! \brief Returns true if \f$ A V_k + b \geq 0 \f$
+    up to the tolerance. */
+  bool IsCurrentSolutionFeasible();
+
+  /*! \brief Returns the value of the cost function
+    \f$ \frac{1}{2} V_k^{\top} V_k + c^{\top} V_k \f$. */
+  double CurrentCost();
+
+  /*! \brief Current wall-clock time (s). */
+  double CurrentTime();
+  /*! @} */
 
 private:
   /*! \brief Store Pu */
@@ -218,6 +307,12 @@ private:
   /*! Amount of limited */
   double m_AmountOfLimitedComputationTime;
 
+  /*! Object notified after each tick. */
+  PLDPSolverMonitor *m_Monitor;
+
+  /*! Report of the last tick. */
+  PLDPSolverTickReport m_LastTickReport;
+
   /*! @} */
 };
 } // namespace Solver
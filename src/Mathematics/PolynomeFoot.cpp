@@ -31,48 +31,12 @@
 using namespace ::std;
 using namespace ::PatternGeneratorJRL;
 
-double PolynomeFoot::Compute(double t) {
-  if (t >= FT_)
-    return Polynome::Compute(FT_);
-  else if (t <= 0.0)
-    return Polynome::Compute(0.0);
-  else
-    return Polynome::Compute(t);
-}
-
-double PolynomeFoot::ComputeDerivative(double t) {
-  if (t >= FT_)
-    return Polynome::ComputeDerivative(FT_);
-  else if (t <= 0.0)
-    return Polynome::ComputeDerivative(0.0);
-  else
-    return Polynome::ComputeDerivative(t);
-}
-
-double PolynomeFoot::ComputeSecDerivative(double t) {
-  if (t >= FT_)
-    return Polynome::ComputeSecDerivative(FT_);
-  else if (t <= 0.0)
-    return Polynome::ComputeSecDerivative(0.0);
-  else
-    return Polynome::ComputeSecDerivative(t);
-}
-
-double PolynomeFoot::ComputeJerk(double t) {
-  if (t >= FT_)
-    return Polynome::ComputeJerk(FT_);
-  else if (t <= 0.0)
-    return Polynome::ComputeJerk(0.0);
-  else
-    return Polynome::ComputeJerk(t);
-}
-
-Polynome3::Polynome3(double FT, double FP) : PolynomeFoot(3, FT) {
+Polynome3::Polynome3(double FT, double FP) : PolynomeFoot<3>(FT) {
   SetParameters(FT, FP);
 }
 
 Polynome3::Polynome3(double FT, double IP, double IS, double FP, double FS)
-    : PolynomeFoot(3, FT) {
+    : PolynomeFoot<3>(FT) {
   SetParameters(FT, IP, IS, FP, FS);
 }
 
@@ -130,7 +94,7 @@ void Polynome3::GetParametersWithInitPosInitSpeed(double &FT, double &FP,
 
 Polynome3::~Polynome3() {}
 
-Polynome4::Polynome4(double FT, double MP, double FP) : PolynomeFoot(4, FT) {
+Polynome4::Polynome4(double FT, double MP, double FP) : PolynomeFoot<4>(FT) {
   SetParameters(FT, MP, FP);
 }
 
@@ -205,7 +169,7 @@ void Polynome4::GetParametersWithInitPosInitSpeed(double &FT, double &MP,
 Polynome4::~Polynome4() {}
 
 Polynome5::Polynome5(double FT, double FP)
-    : PolynomeFoot(5, FT), InitPos_(0.0), InitSpeed_(0.0), InitAcc_(0.0),
+    : PolynomeFoot<5>(FT), InitPos_(0.0), InitSpeed_(0.0), InitAcc_(0.0),
       FinalPos_(0.0), FinalSpeed_(0.0), FinalAcc_(0.0)
 
 {
@@ -295,7 +259,7 @@ void Polynome5::SetParameters(double FT, double InitPos, double InitSpeed,
   }
 }
 
-Polynome6::Polynome6(double FT, double MP, double FP) : PolynomeFoot(6, FT) {
+Polynome6::Polynome6(double FT, double MP, double FP) : PolynomeFoot<6>(FT) {
   SetParameters(FT, MP, FP);
 }
 
@@ -357,7 +321,7 @@ void Polynome6::GetParametersWithInitPosInitSpeed(double &TimeInterval,
 Polynome6::~Polynome6() {}
 
 Polynome7::Polynome7(double FT, double FP)
-    : PolynomeFoot(7, FT), FP_(FP), InitPos_(0.0), InitSpeed_(0.0),
+    : PolynomeFoot<7>(FT), FP_(FP), InitPos_(0.0), InitSpeed_(0.0),
       InitAcc_(0.0)
 
 {
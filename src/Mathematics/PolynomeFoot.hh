@@ -38,32 +38,59 @@
 
 #include <vector>
 
+#include <Mathematics/FixedDegreePolynome.hh>
 #include <Mathematics/Polynome.hh>
 
 namespace PatternGeneratorJRL {
-class PolynomeFoot : public Polynome {
+/*! Polynome whose evaluation is saturated on the interval [0,FT]. */
+template <int PolynomeDegree>
+class PolynomeFoot : public FixedDegreePolynome<PolynomeDegree> {
 protected:
   /*! Store final time */
   double FT_;
 
+  typedef FixedDegreePolynome<PolynomeDegree> parent_t;
+
+  inline double SaturateTime(double t) const {
+    if (t >= FT_)
+      return FT_;
+    else if (t <= 0.0)
+      return 0.0;
+    return t;
+  }
+
 public:
-  PolynomeFoot(int degree = 0.0, double FT = 0.0) : Polynome(degree), FT_(FT){};
+  PolynomeFoot(double FT = 0.0) : FT_(FT){};
 
   /*! Compute the value. */
-  double Compute(double t);
+  inline double Compute(double t) const {
+    return parent_t::Compute(SaturateTime(t));
+  }
 
   /*! Compute the value of the derivative. */
-  double ComputeDerivative(double t);
+  inline double ComputeDerivative(double t) const {
+    return parent_t::ComputeDerivative(SaturateTime(t));
+  }
 
   /*! Compute the value of the second derivative. */
-  double ComputeSecDerivative(double t);
+  inline double ComputeSecDerivative(double t) const {
+    return parent_t::ComputeSecDerivative(SaturateTime(t));
+  }
 
   /*! Compute the value of the third derivative (jerk). */
-  double ComputeJerk(double t);
+  inline double ComputeJerk(double t) const {
+    return parent_t::ComputeJerk(SaturateTime(t));
+  }
+
+  /*! Compute in one pass the value, the derivative
+    and the second derivative. */
+  inline void ComputeAll(double t, double &p, double &dp, double &ddp) const {
+    parent_t::ComputeAll(SaturateTime(t), p, dp, ddp);
+  }
 };
 
 /// Polynome used for X,Y and Theta trajectories.
-class Polynome3 : public PolynomeFoot {
+class Polynome3 : public PolynomeFoot<3> {
 public:
   /** Constructor:
       FT: Final time
@@ -103,7 +130,7 @@ private:
 };
 
 /// Polynome used for Z trajectory.
-class Polynome4 : public PolynomeFoot {
+class Polynome4 : public PolynomeFoot<4> {
 public:
   /** Constructor:
       FT: Final time
@@ -147,7 +174,7 @@ private:
 };
 
 /// Polynome used for X,Y and Theta trajectories.
-class Polynome5 : public PolynomeFoot {
+class Polynome5 : public PolynomeFoot<5> {
 private:
   double InitPos_, InitSpeed_, InitAcc_, FinalPos_, FinalSpeed_, FinalAcc_;
 
@@ -190,7 +217,7 @@ public:
 };
 
 /// Polynome used for Z trajectory.
-class Polynome6 : public PolynomeFoot {
+class Polynome6 : public PolynomeFoot<6> {
 private:
   double MP_, FP_, InitPos_, InitSpeed_, InitAcc_;
 
@@ -218,7 +245,7 @@ public:
 };
 
 /// Polynome used for X,Y and Theta trajectories.
-class Polynome7 : public PolynomeFoot {
+class Polynome7 : public PolynomeFoot<7> {
 private:
   double FP_, InitPos_, InitSpeed_, InitAcc_, InitJerk_;
 
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/* \doc QLD solver with a preallocated workspace. */
+
+#include <iostream>
+
+#include <Debug.hh>
+#include <Mathematics/QLDSolver.hh>
+#include <Mathematics/qld.hh>
+
+using namespace PatternGeneratorJRL;
+
+QLDSolver::QLDSolver(unsigned int MaxNbOfConstraints,
+                     unsigned int MaxNbOfVariables) {
+  m_MaxNbOfConstraints = 0;
+  m_MaxNbOfVariables = 0;
+  m_NbOfMultipliers = 0;
+  m_NbOfActiveConstraints = 0;
+  m_NbOfActiveLinearConstraints = 0;
+  m_UserFactorization = true;
+  m_PrintLevel = 1;
+  m_Eps = 1e-8;
+  m_Fail = 0;
+  Reserve(MaxNbOfConstraints, MaxNbOfVariables);
+}
+
+void QLDSolver::Reserve(unsigned int MaxNbOfConstraints,
+                        unsigned int MaxNbOfVariables) {
+  if ((MaxNbOfConstraints <= m_MaxNbOfConstraints) &&
+      (MaxNbOfVariables <= m_MaxNbOfVariables) && (m_War.size() > 0))
+    return;
+
+  if (MaxNbOfConstraints > m_MaxNbOfConstraints)
+    m_MaxNbOfConstraints = MaxNbOfConstraints;
+  if (MaxNbOfVariables > m_MaxNbOfVariables)
+    m_MaxNbOfVariables = MaxNbOfVariables;
+
+  // Length given by the documentation of QL0001 for the maximal
+  // leading dimensions, with the margin used by the callers.
+  unsigned int nmax = m_MaxNbOfVariables;
+  unsigned int mmax = m_MaxNbOfConstraints + 1;
+  unsigned int mnn = m_MaxNbOfConstraints + 2 * m_MaxNbOfVariables;
+  m_War.resize(3 * nmax * nmax / 2 + 10 * nmax + 2 * mmax + 20000);
+  m_IWar.resize(nmax > 0 ? nmax : 1);
+  m_XL.setConstant(nmax, -1e8);
+  m_XU.setConstant(nmax, 1e8);
+  m_U.setZero(mnn);
+  m_ActiveSet.resize(mnn);
+  m_NbOfMultipliers = 0;
+  m_NbOfActiveConstraints = 0;
+  m_NbOfActiveLinearConstraints = 0;
+}
+
+int QLDSolver::Solve(unsigned int m, unsigned int me, unsigned int n,
+                     double *Q, unsigned int LeadingDimQ, double *D, double *A,
+                     unsigned int LeadingDimA, double *B, double *X,
+                     double *XL, double *XU) {
+  m_NbOfMultipliers = 0;
+  m_NbOfActiveConstraints = 0;
+  m_NbOfActiveLinearConstraints = 0;
+
+  if ((m > m_MaxNbOfConstraints) || (n > m_MaxNbOfVariables) ||
+      (LeadingDimQ < n) || (LeadingDimA <= m)) {
+    std::cerr << "QLDSolver - The problem (" << m << " constraints, " << n
+              << " variables) does not fit in the workspace." << std::endl;
+    m_Fail = 5;
+    return m_Fail;
+  }
+
+  int lm = (int)m, lme = (int)me, lmmax = (int)LeadingDimA, ln = (int)n,
+      lnmax = (int)LeadingDimQ, lmnn = (int)(m + 2 * n);
+  int iout = 0, iprint = m_PrintLevel;
+  int lwar = (int)m_War.size(), liwar = (int)m_IWar.size();
+  double lEps = m_Eps;
+
+  m_IWar[0] = m_UserFactorization ? 1 : 0;
+  if (XL == 0)
+    XL = m_XL.data();
+  if (XU == 0)
+    XU = m_XU.data();
+
+  m_NbOfMultipliers = (unsigned int)lmnn;
+  ql0001_(&lm, &lme, &lmmax, &ln, &lnmax, &lmnn, Q, D, A, B, XL, XU, X,
+          m_U.data(), &iout, &m_Fail, &iprint, m_War.data(), &lwar,
+          m_IWar.data(), &liwar, &lEps);
+
+  if (m_Fail != 0)
+    return m_Fail;
+
+  // QL0001 sets to zero the multipliers of the inactive constraints.
+  for (unsigned int j = 0; j < m_NbOfMultipliers; j++) {
+    if ((m_U[j] != 0.0) || (j < me)) {
+      m_ActiveSet[m_NbOfActiveConstraints++] = (int)j;
+      if (j < m)
+        m_NbOfActiveLinearConstraints++;
+    }
+  }
+  ODEBUG("Active constraints: " << m_NbOfActiveLinearConstraints);
+  return 0;
+}
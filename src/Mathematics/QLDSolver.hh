@@ -0,0 +1,149 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** \file QLDSolver.hh
+    \brief QLD solver with a preallocated workspace. */
+
+#ifndef _QLD_SOLVER_H_
+#define _QLD_SOLVER_H_
+
+#include <Eigen/Dense>
+
+namespace PatternGeneratorJRL {
+
+/*! \brief Solve the quadratic problem
+  \f[ \min_{X} \frac{1}{2} X^{\top} Q X + D^{\top} X \f]
+  \f[ s.t. \;\; A_j X + B_j = 0, \;\; j < m_e \f]
+  \f[ A_j X + B_j \geq 0, \;\; m_e \leq j < m \f]
+  \f[ X_L \leq X \leq X_U \f]
+  with the QL0001 algorithm of Powell as implemented in qld.cpp.
+
+  The working arrays are sized once for the maximal problem given
+  to the constructor or to Reserve, so that Solve never allocates.
+  The arithmetic is the one of ql0001_ for the same leading
+  dimensions, hence the solutions are identical to a direct call.
+
+  After a successful call, the Lagrange multipliers and the
+  active set can be read to warm start another solver.
+
+  ql0001_ keeps no state between calls: distinct instances can solve
+  concurrently, a given instance must not be shared between threads.
+*/
+class QLDSolver {
+public:
+  /*! \brief Constructor
+    \param MaxNbOfConstraints Maximal number of linear constraints.
+    \param MaxNbOfVariables Maximal number of variables. */
+  QLDSolver(unsigned int MaxNbOfConstraints = 0,
+            unsigned int MaxNbOfVariables = 0);
+
+  /*! \brief Size the workspace for a larger problem.
+    Nothing is allocated if the current workspace is large enough. */
+  void Reserve(unsigned int MaxNbOfConstraints, unsigned int MaxNbOfVariables);
+
+  /*! \brief Solve the problem.
+    \param m Number of linear constraints.
+    \param me Number of equality constraints, stored first.
+    \param n Number of variables.
+    \param Q Hessian stored by columns, modified by QL0001.
+    \param LeadingDimQ Leading dimension of Q, at least n.
+    \param D Linear part of the cost.
+    \param A Constraint matrix stored by columns.
+    \param LeadingDimA Leading dimension of A, greater than m.
+    \param B Constant part of the constraints.
+    \param X Solution of size n.
+    \param XL, XU Bounds of size n, \f$ \mp 10^8 \f$ if null.
+    \return 0 on success, otherwise the IFAIL code of QL0001. */
+  int Solve(unsigned int m, unsigned int me, unsigned int n, double *Q,
+            unsigned int LeadingDimQ, double *D, double *A,
+            unsigned int LeadingDimA, double *B, double *X, double *XL = 0,
+            double *XU = 0);
+
+  /*! \name Parameters of QL0001
+    @{ */
+  /*! \brief Value of IWAR(1): if true the initial factorization of
+    the hessian is not computed by QL0001 (default: true). */
+  void SetUserFactorization(bool UserFactorization) {
+    m_UserFactorization = UserFactorization;
+  }
+
+  /*! \brief IPRINT, brief output in error cases if positive. */
+  void SetPrintLevel(int PrintLevel) { m_PrintLevel = PrintLevel; }
+
+  /*! \brief Guess of the machine precision (default: 1e-8). */
+  void SetEps(double Eps) { m_Eps = Eps; }
+  /*! @} */
+
+  /*! \name Results of the last call to Solve.
+    @{ */
+  /*! \brief IFAIL code of QL0001. */
+  int Fail() const { return m_Fail; }
+
+  /*! \brief Lagrange multipliers: the m constraints, then the n lower
+    and the n upper bounds. They are only reset by a successful call. */
+  Eigen::Map<const Eigen::VectorXd> Multipliers() const {
+    return Eigen::Map<const Eigen::VectorXd>(m_U.data(), m_NbOfMultipliers);
+  }
+
+  /*! \brief Indexes in Multipliers of the active constraints and bounds,
+    in increasing order. */
+  Eigen::Map<const Eigen::VectorXi> ActiveSet() const {
+    return Eigen::Map<const Eigen::VectorXi>(m_ActiveSet.data(),
+                                             m_NbOfActiveConstraints);
+  }
+
+  /*! \brief Number of active linear constraints, bounds excluded. */
+  unsigned int NbOfActiveLinearConstraints() const {
+    return m_NbOfActiveLinearConstraints;
+  }
+  /*! @} */
+
+  /*! \name Size of the workspace
+    @{ */
+  unsigned int MaxNbOfConstraints() const { return m_MaxNbOfConstraints; }
+  unsigned int MaxNbOfVariables() const { return m_MaxNbOfVariables; }
+  /*! @} */
+
+protected:
+  unsigned int m_MaxNbOfConstraints;
+  unsigned int m_MaxNbOfVariables;
+
+  /*! \brief Real and integer working arrays of QL0001. */
+  Eigen::VectorXd m_War;
+  Eigen::VectorXi m_IWar;
+
+  /*! \brief Default bounds. */
+  Eigen::VectorXd m_XL, m_XU;
+
+  /*! \brief Lagrange multipliers. */
+  Eigen::VectorXd m_U;
+  unsigned int m_NbOfMultipliers;
+
+  /*! \brief Active set of the last solution. */
+  Eigen::VectorXi m_ActiveSet;
+  unsigned int m_NbOfActiveConstraints;
+  unsigned int m_NbOfActiveLinearConstraints;
+
+  bool m_UserFactorization;
+  int m_PrintLevel;
+  double m_Eps;
+  int m_Fail;
+};
+
+} // namespace PatternGeneratorJRL
+#endif /* _QLD_SOLVER_H_ */
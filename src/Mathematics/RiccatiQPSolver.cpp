@@ -0,0 +1,382 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/* \doc Interior point solver of quadratic problems with a stage
+   structure, based on a Riccati recursion. */
+
+#include <math.h>
+
+#include <iostream>
+
+#include <Debug.hh>
+#include <Mathematics/RiccatiQPSolver.hh>
+
+using namespace PatternGeneratorJRL;
+
+RiccatiQPSolver::RiccatiQPSolver() {
+  m_NbStages = 0;
+  m_NbStates = 0;
+  m_NbConstraints = 0;
+  m_MaxIterations = 50;
+  m_NbIterations = 0;
+  m_Tolerance = 1e-9;
+}
+
+void RiccatiQPSolver::Resize(unsigned int NbStages, unsigned int NbStates) {
+  m_NbStages = NbStages;
+  m_NbStates = NbStates;
+  m_Stages.resize(NbStages + 1);
+  m_Work.resize(NbStages + 1);
+  for (unsigned int k = 0; k <= NbStages; k++)
+    ResizeStage(k, 0, 0);
+}
+
+void RiccatiQPSolver::ResizeStage(unsigned int k, unsigned int NbControls,
+                                  unsigned int NbConstraints) {
+  unsigned int nx = m_NbStates, nc = NbConstraints;
+  // The terminal stage has no control and no dynamics.
+  unsigned int nu = (k < m_NbStages) ? NbControls : 0;
+  unsigned int nxn = (k < m_NbStages) ? nx : 0;
+
+  stage_t &aStage = m_Stages[k];
+  aStage.A.setZero(nxn, nx);
+  aStage.B.setZero(nxn, nu);
+  aStage.b.setZero(nxn);
+  aStage.Q.setZero(nx, nx);
+  aStage.R.setZero(nu, nu);
+  aStage.S.setZero(nu, nx);
+  aStage.q.setZero(nx);
+  aStage.r.setZero(nu);
+  aStage.C.setZero(nc, nx);
+  aStage.D.setZero(nc, nu);
+  aStage.d.setZero(nc);
+
+  work_t &w = m_Work[k];
+  w.x.setZero(nx);
+  w.u.setZero(nu);
+  w.pi.setZero(nxn);
+  w.lambda.setZero(nc);
+  w.t.setZero(nc);
+  w.dx.setZero(nx);
+  w.du.setZero(nu);
+  w.dpi.setZero(nxn);
+  w.dlambda.setZero(nc);
+  w.dt.setZero(nc);
+  w.rx.setZero(nx);
+  w.ru.setZero(nu);
+  w.rpi.setZero(nxn);
+  w.rineq.setZero(nc);
+  w.rc.setZero(nc);
+  w.g.setZero(nc);
+  w.P.setZero(nx, nx);
+  w.p.setZero(nx);
+  w.K.setZero(nu, nx);
+  w.G.setZero(nu, nx);
+  w.H.setZero(nu, nu);
+  w.kff.setZero(nu);
+  w.v.setZero(nx);
+  w.Sigma.setZero(nc);
+  w.SigmaC.setZero(nc, nx);
+  w.SigmaD.setZero(nc, nu);
+}
+
+double RiccatiQPSolver::ComputeResiduals() {
+  double Norm = 0.0;
+  for (unsigned int k = 0; k <= m_NbStages; k++) {
+    const stage_t &s = m_Stages[k];
+    work_t &w = m_Work[k];
+
+    // C x + D u + t - d
+    w.rineq.noalias() = s.C * w.x;
+    w.rineq.noalias() += s.D * w.u;
+    w.rineq += w.t - s.d;
+
+    if (k < m_NbStages) {
+      // R u + S x + r + B' pi + D' lambda
+      w.ru.noalias() = s.R * w.u;
+      w.ru.noalias() += s.S * w.x;
+      w.ru.noalias() += s.B.transpose() * w.pi;
+      w.ru.noalias() += s.D.transpose() * w.lambda;
+      w.ru += s.r;
+      // A x + B u + b - x_{k+1}
+      w.rpi.noalias() = s.A * w.x;
+      w.rpi.noalias() += s.B * w.u;
+      w.rpi += s.b - m_Work[k + 1].x;
+    }
+
+    // Q x + S' u + q + A' pi - pi_{k-1} + C' lambda, x_0 is given.
+    if (k > 0) {
+      w.rx.noalias() = s.Q * w.x;
+      w.rx.noalias() += s.S.transpose() * w.u;
+      w.rx.noalias() += s.C.transpose() * w.lambda;
+      if (k < m_NbStages)
+        w.rx.noalias() += s.A.transpose() * w.pi;
+      w.rx += s.q - m_Work[k - 1].pi;
+    } else
+      w.rx.setZero();
+
+    double lNorm = 0.0;
+    if (w.rx.size() > 0)
+      lNorm = w.rx.lpNorm<Eigen::Infinity>();
+    if (w.ru.size() > 0)
+      lNorm = std::max(lNorm, w.ru.lpNorm<Eigen::Infinity>());
+    if (w.rpi.size() > 0)
+      lNorm = std::max(lNorm, w.rpi.lpNorm<Eigen::Infinity>());
+    if (w.rineq.size() > 0)
+      lNorm = std::max(lNorm, w.rineq.lpNorm<Eigen::Infinity>());
+    Norm = std::max(Norm, lNorm);
+  }
+  return Norm;
+}
+
+bool RiccatiQPSolver::Factorize() {
+  for (int k = (int)m_NbStages; k >= 0; k--) {
+    const stage_t &s = m_Stages[k];
+    work_t &w = m_Work[k];
+
+    // The inequalities weight the stage by diag(lambda/t).
+    w.Sigma = w.lambda.cwiseQuotient(w.t);
+    w.SigmaC.noalias() = w.Sigma.asDiagonal() * s.C;
+    w.SigmaD.noalias() = w.Sigma.asDiagonal() * s.D;
+
+    if (k == (int)m_NbStages) {
+      w.P = s.Q;
+      w.P.noalias() += s.C.transpose() * w.SigmaC;
+      continue;
+    }
+
+    const Eigen::MatrixXd &Pn = m_Work[k + 1].P;
+    // H = R + D' Sigma D + B' P B
+    w.H = s.R;
+    w.H.noalias() += s.D.transpose() * w.SigmaD;
+    w.H.noalias() += s.B.transpose() * (Pn * s.B);
+    // G = S + D' Sigma C + B' P A
+    w.G = s.S;
+    w.G.noalias() += s.D.transpose() * w.SigmaC;
+    w.G.noalias() += s.B.transpose() * (Pn * s.A);
+
+    if (w.H.rows() > 0) {
+      // Large weights of active constraints cancel in P: the loss of
+      // definiteness by rounding is corrected by a regularization.
+      w.HLLT.compute(w.H);
+      double Scale = 1.0 + w.H.diagonal().maxCoeff();
+      double Regularization = 1e-12 * Scale;
+      while ((w.HLLT.info() != Eigen::Success) &&
+             (Regularization < 1e-4 * Scale)) {
+        w.H.diagonal().array() += Regularization;
+        w.HLLT.compute(w.H);
+        Regularization *= 100.0;
+      }
+      if (w.HLLT.info() != Eigen::Success) {
+        std::cerr << "RiccatiQPSolver - The Newton matrix of stage " << k
+                  << " is not positive definite." << std::endl;
+        return false;
+      }
+      w.K = w.G;
+      w.HLLT.solveInPlace(w.K);
+      w.K = -w.K;
+    }
+
+    // P = Q + C' Sigma C + A' P A + G' K, the first one is not used.
+    if (k > 0) {
+      w.P = s.Q;
+      w.P.noalias() += s.C.transpose() * w.SigmaC;
+      w.P.noalias() += s.A.transpose() * (Pn * s.A);
+      if (w.H.rows() > 0)
+        w.P.noalias() += w.G.transpose() * w.K;
+      w.P = 0.5 * (w.P + w.P.transpose()).eval();
+    }
+  }
+  return true;
+}
+
+void RiccatiQPSolver::ComputeDirection() {
+  // The slacks and multipliers are eliminated with
+  // g = (lambda.rineq - rc)/t.
+  for (unsigned int k = 0; k <= m_NbStages; k++) {
+    work_t &w = m_Work[k];
+    w.g = (w.lambda.cwiseProduct(w.rineq) - w.rc).cwiseQuotient(w.t);
+  }
+
+  // Backward recursion.
+  {
+    const stage_t &s = m_Stages[m_NbStages];
+    work_t &w = m_Work[m_NbStages];
+    w.p = w.rx;
+    w.p.noalias() += s.C.transpose() * w.g;
+  }
+  for (int k = (int)m_NbStages - 1; k >= 0; k--) {
+    const stage_t &s = m_Stages[k];
+    work_t &w = m_Work[k];
+    const work_t &n = m_Work[k + 1];
+
+    // v = P_{k+1} rpi + p_{k+1}
+    w.v = n.p;
+    w.v.noalias() += n.P * w.rpi;
+    // kff = -H^{-1} (ru + D' g + B' v)
+    if (w.kff.size() > 0) {
+      w.kff = w.ru;
+      w.kff.noalias() += s.D.transpose() * w.g;
+      w.kff.noalias() += s.B.transpose() * w.v;
+      w.HLLT.solveInPlace(w.kff);
+      w.kff = -w.kff;
+    }
+    // p = rx + C' g + A' v + G' kff
+    if (k > 0) {
+      w.p = w.rx;
+      w.p.noalias() += s.C.transpose() * w.g;
+      w.p.noalias() += s.A.transpose() * w.v;
+      w.p.noalias() += w.G.transpose() * w.kff;
+    }
+  }
+
+  // Forward substitution.
+  m_Work[0].dx.setZero();
+  for (unsigned int k = 0; k < m_NbStages; k++) {
+    const stage_t &s = m_Stages[k];
+    work_t &w = m_Work[k];
+    work_t &n = m_Work[k + 1];
+
+    w.du = w.kff;
+    w.du.noalias() += w.K * w.dx;
+    n.dx = w.rpi;
+    n.dx.noalias() += s.A * w.dx;
+    n.dx.noalias() += s.B * w.du;
+    w.dpi = n.p;
+    w.dpi.noalias() += n.P * n.dx;
+  }
+
+  // Slacks and multipliers.
+  for (unsigned int k = 0; k <= m_NbStages; k++) {
+    const stage_t &s = m_Stages[k];
+    work_t &w = m_Work[k];
+    w.dt = -w.rineq;
+    w.dt.noalias() -= s.C * w.dx;
+    w.dt.noalias() -= s.D * w.du;
+    w.dlambda = -(w.rc + w.lambda.cwiseProduct(w.dt)).cwiseQuotient(w.t);
+  }
+}
+
+double RiccatiQPSolver::MaxStep() const {
+  double Step = HUGE_VAL;
+  for (unsigned int k = 0; k <= m_NbStages; k++) {
+    const work_t &w = m_Work[k];
+    for (int i = 0; i < w.t.size(); i++) {
+      if (w.dt[i] < 0.0)
+        Step = std::min(Step, -w.t[i] / w.dt[i]);
+      if (w.dlambda[i] < 0.0)
+        Step = std::min(Step, -w.lambda[i] / w.dlambda[i]);
+    }
+  }
+  return Step;
+}
+
+int RiccatiQPSolver::Solve(const Eigen::VectorXd &x0) {
+  m_NbIterations = 0;
+  if ((m_Stages.size() == 0) || (x0.size() != (int)m_NbStates)) {
+    std::cerr << "RiccatiQPSolver - The initial state does not match the "
+              << "problem." << std::endl;
+    return 2;
+  }
+
+  // INITIAL POINT:
+  // --------------
+  // Rollout of null controls, the slacks and multipliers are positive.
+  m_NbConstraints = 0;
+  m_Work[0].x = x0;
+  for (unsigned int k = 0; k <= m_NbStages; k++) {
+    const stage_t &s = m_Stages[k];
+    work_t &w = m_Work[k];
+    w.u.setZero();
+    if (k < m_NbStages) {
+      w.pi.setZero();
+      m_Work[k + 1].x = s.b;
+      m_Work[k + 1].x.noalias() += s.A * w.x;
+    }
+    w.t = s.d;
+    w.t.noalias() -= s.C * w.x;
+    w.t = w.t.cwiseMax(1.0);
+    w.lambda.setOnes();
+    m_NbConstraints += (unsigned int)s.d.size();
+  }
+
+  for (m_NbIterations = 0; m_NbIterations < m_MaxIterations;
+       m_NbIterations++) {
+    double Residuals = ComputeResiduals();
+    double Mu = 0.0;
+    for (unsigned int k = 0; k <= m_NbStages; k++)
+      Mu += m_Work[k].lambda.dot(m_Work[k].t);
+    if (m_NbConstraints > 0)
+      Mu /= (double)m_NbConstraints;
+    ODEBUG("Iteration " << m_NbIterations << " residuals " << Residuals
+                        << " mu " << Mu);
+    if ((Residuals < m_Tolerance) && (Mu < m_Tolerance))
+      return 0;
+
+    if (!Factorize())
+      return 2;
+
+    // Predictor.
+    for (unsigned int k = 0; k <= m_NbStages; k++)
+      m_Work[k].rc = m_Work[k].lambda.cwiseProduct(m_Work[k].t);
+    ComputeDirection();
+    double Step = std::min(1.0, MaxStep());
+
+    // Corrector, centered with the duality gap reached by the predictor.
+    double MuAffine = 0.0;
+    for (unsigned int k = 0; k <= m_NbStages; k++) {
+      const work_t &w = m_Work[k];
+      MuAffine +=
+          (w.t + Step * w.dt).dot(w.lambda + Step * w.dlambda);
+    }
+    double Sigma = 0.0;
+    if (m_NbConstraints > 0) {
+      MuAffine /= (double)m_NbConstraints;
+      Sigma = pow(MuAffine / Mu, 3);
+    }
+    for (unsigned int k = 0; k <= m_NbStages; k++) {
+      work_t &w = m_Work[k];
+      w.rc += w.dt.cwiseProduct(w.dlambda);
+      w.rc.array() -= Sigma * Mu;
+    }
+    ComputeDirection();
+    Step = std::min(1.0, 0.995 * MaxStep());
+
+    for (unsigned int k = 0; k <= m_NbStages; k++) {
+      work_t &w = m_Work[k];
+      w.x += Step * w.dx;
+      w.u += Step * w.du;
+      w.pi += Step * w.dpi;
+      w.lambda += Step * w.dlambda;
+      w.t += Step * w.dt;
+    }
+  }
+  return 1;
+}
+
+double RiccatiQPSolver::Cost() const {
+  double Cost = 0.0;
+  for (unsigned int k = 0; k <= m_NbStages; k++) {
+    const stage_t &s = m_Stages[k];
+    const work_t &w = m_Work[k];
+    Cost += 0.5 * w.x.dot(s.Q * w.x) + s.q.dot(w.x);
+    if (w.u.size() > 0)
+      Cost += 0.5 * w.u.dot(s.R * w.u) + w.u.dot(s.S * w.x) + s.r.dot(w.u);
+  }
+  return Cost;
+}
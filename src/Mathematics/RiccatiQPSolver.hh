@@ -0,0 +1,150 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** \file RiccatiQPSolver.hh
+    \brief Interior point solver of quadratic problems with a stage
+    structure, based on a Riccati recursion. */
+
+#ifndef _RICCATI_QP_SOLVER_H_
+#define _RICCATI_QP_SOLVER_H_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace PatternGeneratorJRL {
+
+/*! \brief Solve the optimal control problem
+  \f[ \min_{x,u} \sum_{k=0}^{N} \frac{1}{2} x_k^{\top} Q_k x_k
+  + \frac{1}{2} u_k^{\top} R_k u_k + u_k^{\top} S_k x_k
+  + q_k^{\top} x_k + r_k^{\top} u_k \f]
+  \f[ s.t. \;\; x_{k+1} = A_k x_k + B_k u_k + b_k, \;\; x_0 \; given \f]
+  \f[ C_k x_k + D_k u_k \leq d_k \f]
+  where the terminal stage \f$ N \f$ has no control.
+
+  The states are kept as variables: the KKT system of each Newton
+  step is block banded and is solved by a Riccati recursion, in a
+  time linear with \f$ N \f$. The inequalities are handled by a
+  primal-dual interior point method with the predictor-corrector
+  steps of Mehrotra.
+
+  The stages are sized once by Resize and ResizeStage, Solve then
+  reuses the iterates and the factorization of each stage.
+*/
+class RiccatiQPSolver {
+public:
+  /*! \brief Data of one stage. */
+  struct stage_t {
+    /*! \brief Dynamics towards the next stage. */
+    Eigen::MatrixXd A, B;
+    Eigen::VectorXd b;
+    /*! \brief Cost. */
+    Eigen::MatrixXd Q, R, S;
+    Eigen::VectorXd q, r;
+    /*! \brief Inequalities. */
+    Eigen::MatrixXd C, D;
+    Eigen::VectorXd d;
+  };
+
+  RiccatiQPSolver();
+
+  /*! \brief Set the number of stages with controls and the number of
+    states. The stages are reset to no control and no constraint. */
+  void Resize(unsigned int NbStages, unsigned int NbStates);
+
+  /*! \brief Set the number of controls and constraints of stage k and
+    its data to zero. The terminal stage has no control. */
+  void ResizeStage(unsigned int k, unsigned int NbControls,
+                   unsigned int NbConstraints);
+
+  /*! \brief Data of stage k, from 0 to NbStages(). */
+  stage_t &Stage(unsigned int k) { return m_Stages[k]; }
+  const stage_t &Stage(unsigned int k) const { return m_Stages[k]; }
+
+  /*! \brief Solve the problem from the initial state x0.
+    \return 0 on success, 1 if the maximal number of iterations is
+    reached, 2 if a Newton matrix is not positive definite. */
+  int Solve(const Eigen::VectorXd &x0);
+
+  /*! \name Results of the last call to Solve.
+    @{ */
+  const Eigen::VectorXd &State(unsigned int k) const { return m_Work[k].x; }
+  const Eigen::VectorXd &Control(unsigned int k) const { return m_Work[k].u; }
+  /*! \brief Multipliers of the inequalities of stage k. */
+  const Eigen::VectorXd &Multipliers(unsigned int k) const {
+    return m_Work[k].lambda;
+  }
+  /*! \brief Value of the cost. */
+  double Cost() const;
+  unsigned int NbIterations() const { return m_NbIterations; }
+  /*! @} */
+
+  /*! \name Parameters
+    @{ */
+  void SetMaxIterations(unsigned int MaxIterations) {
+    m_MaxIterations = MaxIterations;
+  }
+  /*! \brief Bound on the residuals and the duality gap (default: 1e-9). */
+  void SetTolerance(double Tolerance) { m_Tolerance = Tolerance; }
+  /*! @} */
+
+  unsigned int NbStages() const { return m_NbStages; }
+  unsigned int NbStates() const { return m_NbStates; }
+
+protected:
+  /*! \brief Iterates, residuals and factorization of one stage. */
+  struct work_t {
+    Eigen::VectorXd x, u, pi, lambda, t;
+    Eigen::VectorXd dx, du, dpi, dlambda, dt;
+    Eigen::VectorXd rx, ru, rpi, rineq, rc, g;
+    /*! \brief Cost to go dpi_{k-1} = P dx_k + p. */
+    Eigen::MatrixXd P;
+    Eigen::VectorXd p;
+    /*! \brief Feedback du_k = K dx_k + kff. */
+    Eigen::MatrixXd K, G, H;
+    Eigen::VectorXd kff, v;
+    Eigen::LLT<Eigen::MatrixXd> HLLT;
+    /*! \brief Weights of the inequalities and scratch products. */
+    Eigen::VectorXd Sigma;
+    Eigen::MatrixXd SigmaC, SigmaD;
+  };
+
+  /*! \brief Residuals of the KKT conditions, returns their norm. */
+  double ComputeResiduals();
+
+  /*! \brief Riccati factorization of the Newton matrix. */
+  bool Factorize();
+
+  /*! \brief Newton direction for the complementarity residuals rc. */
+  void ComputeDirection();
+
+  /*! \brief Largest step keeping the slacks and multipliers positive. */
+  double MaxStep() const;
+
+  std::vector<stage_t> m_Stages;
+  std::vector<work_t> m_Work;
+  unsigned int m_NbStages;
+  unsigned int m_NbStates;
+  unsigned int m_NbConstraints;
+  unsigned int m_MaxIterations;
+  unsigned int m_NbIterations;
+  double m_Tolerance;
+};
+
+} // namespace PatternGeneratorJRL
+#endif /* _RICCATI_QP_SOLVER_H_ */
@@ -35,7 +35,7 @@ while stepping over. */
 using namespace ::std;
 using namespace ::PatternGeneratorJRL;
 
-StepOverPolynomeFoot::StepOverPolynomeFoot() : Polynome(8) {
+StepOverPolynomeFoot::StepOverPolynomeFoot() : FixedDegreePolynome<8>() {
   // SetParameters(boundCond,timeDistr);
 }
 
@@ -158,7 +158,8 @@ void StepOverPolynomeFoot::SetParameters(Eigen::VectorXd boundCond,
 StepOverPolynomeFoot::~StepOverPolynomeFoot() {}
 
 ///////////////////////////////////////////////////////////
-StepOverPolynomeFootZtoX::StepOverPolynomeFootZtoX() : Polynome(3) {
+StepOverPolynomeFootZtoX::StepOverPolynomeFootZtoX()
+    : FixedDegreePolynome<3>() {
   // SetParameters(boundCond,timeDistr);
 }
 
@@ -216,7 +217,8 @@ StepOverPolynomeFootZtoX::~StepOverPolynomeFootZtoX() {}
 
 /////////////////////////////////////////////////////////////////////////
 
-StepOverPolynomeFootXtoTime::StepOverPolynomeFootXtoTime() : Polynome(4) {
+StepOverPolynomeFootXtoTime::StepOverPolynomeFootXtoTime()
+    : FixedDegreePolynome<4>() {
   // SetParameters(boundCond,timeDistr);
 }
 
@@ -292,7 +294,7 @@ StepOverPolynomeFootXtoTime::~StepOverPolynomeFootXtoTime() {}
 //////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 
-StepOverPolynomeHip4::StepOverPolynomeHip4() : Polynome(4) {
+StepOverPolynomeHip4::StepOverPolynomeHip4() : FixedDegreePolynome<4>() {
   // SetParameters(boundCond,timeDistr);
 }
 
@@ -34,12 +34,13 @@
 #include <vector>
 
 #include <Eigen/Dense>
+#include <Mathematics/FixedDegreePolynome.hh>
 #include <Mathematics/Polynome.hh>
 
 namespace PatternGeneratorJRL {
 /*! @ingroup steppingover
   @brief Polynome used for Z trajectory during stepover. */
-class StepOverPolynomeFoot : public Polynome {
+class StepOverPolynomeFoot : public FixedDegreePolynome<8> {
 public:
   /*! Constructor:
     boundCond: the different boundary conditions begin,
@@ -57,7 +58,7 @@ public:
 
 /*! @ingroup steppingover
   @brief Polynome used for Z trajectory during stepover. */
-class StepOverPolynomeFootZtoX : public Polynome {
+class StepOverPolynomeFootZtoX : public FixedDegreePolynome<3> {
 public:
   /*! Constructor:
     Zpos: vector with Zpos
@@ -74,7 +75,7 @@ public:
 /*! @ingroup stepping over
   @brief Polynome used for X trajectory in function of time
   to combine with StepOverPolynomeFootZtoX.*/
-class StepOverPolynomeFootXtoTime : public Polynome {
+class StepOverPolynomeFootXtoTime : public FixedDegreePolynome<4> {
 public:
   /*! Constructor:
     Zpos: vector with Zpos */
@@ -90,7 +91,7 @@ public:
 /*! @ingroup steppingover
   @brief Polynome for the hip trajectory.
 */
-class StepOverPolynomeHip4 : public Polynome {
+class StepOverPolynomeHip4 : public FixedDegreePolynome<4> {
 public:
   /*! Constructor:
     boundCond: the different boundary conditions begin,
@@ -335,15 +335,6 @@ typedef doublereal E_f; /* real function with -R not specified */
 #endif
 #endif
 
-/* Common Block Declarations */
-
-typedef struct {
-  doublereal eps;
-} t_cmache_;
-t_cmache_ cmache_;
-
-#define cmache_1 cmache_
-
 /* Table of constant values */
 
 /* umd */
@@ -368,6 +359,11 @@ int ql0002_();
   blocks was no longer available. Thus an additional variable, eps1,
   was added to the parameter list to account for this.
 */
+/*
+  The local variables of ql0001_ and ql0002_ are automatic instead of
+  static as f2c generated them: none of them is read before being set
+  in a call, so that both routines are reentrant.
+*/
 /* umd */
 /*
   Two alternative definitions are provided in order to give ANSI
@@ -395,15 +391,15 @@ doublereal *eps1;
   integer c_dim1, c_offset, a_dim1, a_offset, i__1;
 
   /* Local variables */
-  static doublereal diag;
+  doublereal diag;
   /* extern int ql0002_(); */
-  static integer nact, info;
-  static doublereal zero;
-  static integer i, j, maxit;
-  static doublereal qpeps;
-  static integer in, mn, lw;
-  static logical lql;
-  static integer inw1, inw2;
+  integer nact, info;
+  doublereal zero;
+  integer i, j, maxit;
+  doublereal qpeps;
+  integer in, mn, lw;
+  logical lql;
+  integer inw1, inw2;
 
   /*     INTRINSIC FUNCTIONS:  DSQRT */
 
@@ -424,14 +420,12 @@ doublereal *eps1;
   c -= c_offset;
 
   /* Function Body */
-  cmache_1.eps = *eps1;
-
   /*     CONSTANT DATA */
 
   /* ################################################################# */
 
   if (fabs(c[*nmax + *nmax * c_dim1]) == 0.e0) {
-    c[*nmax + *nmax * c_dim1] = cmache_1.eps;
+    c[*nmax + *nmax * c_dim1] = *eps1;
   }
 
   /* umd */
@@ -447,7 +441,7 @@ doublereal *eps1;
   }
   zero = 0.;
   maxit = (*m + *n) * 40;
-  qpeps = cmache_1.eps;
+  qpeps = *eps1;
   inw1 = 1;
   inw2 = inw1 + *mmax;
 
@@ -624,35 +618,35 @@ integer *lw;
   /* double sqrt();    */
 
   /* Local variables */
-  static doublereal onha, xmag, suma, sumb, sumc, temp, step, zero;
-  static integer iwwn;
-  static doublereal sumx, sumy;
-  static integer i, j, k;
-  static doublereal fdiff;
-  static integer iflag, jflag, kflag, lflag;
-  static doublereal diagr;
-  static integer ifinc, kfinc, jfinc, mflag, nflag;
-  static doublereal vfact, tempa;
-  static integer iterc, itref;
-  static doublereal cvmax, ratio, xmagr;
-  static integer kdrop;
-  static logical lower;
-  static integer knext, k1;
-  static doublereal ga, gb;
-  static integer ia, id;
-  static doublereal fdiffa;
-  static integer ii, il, kk, jl, ir, nm, is, iu, iw, ju, ix, iz, nu, iy;
-
-  static doublereal parinc, parnew;
-  static integer ira, irb, iwa;
-  static doublereal one;
-  static integer iwd, iza;
-  static doublereal res;
-  static integer iwr, iws;
-  static doublereal sum;
-  static integer iww, iwx, iwy;
-  static doublereal two;
-  static integer iwz;
+  doublereal onha, xmag, suma, sumb, sumc, temp, step, zero;
+  integer iwwn;
+  doublereal sumx, sumy;
+  integer i, j, k;
+  doublereal fdiff;
+  integer iflag, jflag, kflag, lflag;
+  doublereal diagr;
+  integer ifinc, kfinc, jfinc, mflag, nflag;
+  doublereal vfact, tempa;
+  integer iterc, itref;
+  doublereal cvmax, ratio, xmagr;
+  integer kdrop;
+  logical lower;
+  integer knext, k1;
+  doublereal ga, gb;
+  integer ia, id;
+  doublereal fdiffa;
+  integer ii, il, kk, jl, ir, nm, is, iu, iw, ju, ix, iz, nu, iy;
+
+  doublereal parinc, parnew;
+  integer ira, irb, iwa;
+  doublereal one;
+  integer iwd, iza;
+  doublereal res;
+  integer iwr, iws;
+  doublereal sum;
+  integer iww, iwx, iwy;
+  doublereal two;
+  integer iwz;
 
   /*       WHETHER THE CONSTRAINT IS ACTIVE. */
 
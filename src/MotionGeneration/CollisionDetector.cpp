@@ -31,6 +31,7 @@
 
 #define _DEBUG_
 #include <MotionGeneration/CollisionDetector.hh>
+#include <algorithm>
 #include <fstream>
 
 using namespace ::PatternGeneratorJRL;
@@ -139,12 +140,10 @@ void CollisionDetector::WorldFrameToObstacleFrame(
   */
 }
 
-void CollisionDetector::CalcCoordShankLowerLegPoint(Eigen::Vector3d RelCoord,
-                                                    Eigen::Vector3d &AbsCoord,
-                                                    Eigen::VectorXd LegAngles,
-                                                    Eigen::Matrix3d WaistRot,
-                                                    Eigen::Vector3d WaistPos,
-                                                    int WhichLeg) {
+void CollisionDetector::CalcCoordShankLowerLegPoint(
+    const Eigen::Vector3d &RelCoord, Eigen::Vector3d &AbsCoord,
+    const Eigen::VectorXd &LegAngles, const Eigen::Matrix3d &WaistRot,
+    const Eigen::Vector3d &WaistPos, int WhichLeg) {
   Eigen::Matrix3d Rotation;
   Eigen::Vector3d TempCoord;
   Eigen::Vector3d Translation;
@@ -263,9 +262,10 @@ void CollisionDetector::CalcCoordShankLowerLegPoint(Eigen::Vector3d RelCoord,
   */
 }
 
-bool CollisionDetector::CollisionTwoLines(vector<double> p1, vector<double> p2,
-                                          vector<double> v1,
-                                          vector<double> v2) {
+bool CollisionDetector::CollisionTwoLines(const vector<double> &p1,
+                                          const vector<double> &p2,
+                                          const vector<double> &v1,
+                                          const vector<double> &v2) {
   // this function checks for intersection of two line segments p1p2 and v1v2.
   // since this is a 2D problem the coordinates are the respective
   // planar coordinates
@@ -429,3 +429,158 @@ bool CollisionDetector::CollisionLineObstacleComplete(Eigen::Vector3d &Point1,
     return 0;
   }
 }
+
+namespace {
+/* Segments checked together. */
+const Eigen::Index PacketSize = 8;
+typedef Eigen::Array<double, PacketSize, 1> Packet;
+typedef Eigen::Array<bool, PacketSize, 1> PacketMask;
+
+/* One coordinate of the segments [i, i+n) in a packet, completed with
+   the last segment. */
+void LoadPacket(const CollisionDetector::Points &P, Eigen::Index Coordinate,
+                Eigen::Index i, Eigen::Index n, Packet &aPacket) {
+  if (n == PacketSize) {
+    aPacket = P.col(Coordinate).segment<PacketSize>(i).array();
+    return;
+  }
+  for (Eigen::Index j = 0; j < PacketSize; j++)
+    aPacket(j) = P(i + std::min(j, n - 1), Coordinate);
+}
+
+/* CollisionTwoLines for a packet of segments p1p2, with the same
+   operations: true where the segments are not collision free. */
+PacketMask PacketCollisionTwoLines(const Packet &p1x, const Packet &p1y,
+                                   const Packet &p2x, const Packet &p2y,
+                                   double v1x, double v1y, double v2x,
+                                   double v2y) {
+  Packet Ap1p2v1 = p1x * (p2y - v1y) + p2x * (v1y - p1y) + v1x * (p1y - p2y);
+  Packet Ap1p2v2 = p1x * (p2y - v2y) + p2x * (v2y - p1y) + v2x * (p1y - p2y);
+  Packet Av1v2p1 = v1x * (v2y - p1y) + v2x * (p1y - v1y) + p1x * (v1y - v2y);
+  Packet Av1v2p2 = v1x * (v2y - p2y) + v2x * (p2y - v1y) + p2x * (v1y - v2y);
+  return ((Ap1p2v1 * Ap1p2v2 > 0.0) || (Av1v2p1 * Av1v2p2 > 0.0)) == false;
+}
+
+/* CollisionSegmentsObstacle for the NbSegments first segments, with the
+   corner points O of the obstacle. */
+int FirstSegmentInCollision(const Eigen::MatrixXd &O,
+                            const CollisionDetector::Points &Starts,
+                            const CollisionDetector::Points &Ends,
+                            Eigen::Index NbSegments) {
+  const double d = O(0, 3), w = O(1, 3), h = O(2, 2);
+  Packet p1x, p1y, p1z, p2x, p2y, p2z;
+
+  for (Eigen::Index i = 0; i < NbSegments; i += PacketSize) {
+    Eigen::Index n = std::min(PacketSize, NbSegments - i);
+    LoadPacket(Starts, 0, i, n, p1x);
+    LoadPacket(Starts, 1, i, n, p1y);
+    LoadPacket(Starts, 2, i, n, p1z);
+    LoadPacket(Ends, 0, i, n, p2x);
+    LoadPacket(Ends, 1, i, n, p2y);
+    LoadPacket(Ends, 2, i, n, p2z);
+
+    // Segments completely inside the obstacle.
+    PacketMask Collision = (p1x > 0.0) && (p1x < d) && (p1y > -w) &&
+                           (p1y < w) && (p1z > 0.0) && (p1z < h) &&
+                           (p2x > 0.0) && (p2x < d) && (p2y > -w) &&
+                           (p2y < w) && (p2z > 0.0) && (p2z < h);
+
+    // Front, top and rear planes.
+    for (int k = 0; k < 3; k++)
+      Collision = Collision ||
+                  (PacketCollisionTwoLines(p1x, p1z, p2x, p2z, O(0, k),
+                                           O(2, k), O(0, k + 1), O(2, k + 1)) &&
+                   PacketCollisionTwoLines(p1x, p1y, p2x, p2y, O(0, k),
+                                           O(1, k), O(0, k), -O(1, k)));
+
+    // Side planes.
+    for (int k = 3; k < 5; k++) {
+      double Side = (k == 3) ? 1.0 : -1.0;
+      Collision = Collision ||
+                  (PacketCollisionTwoLines(p1y, p1z, p2y, p2z, Side * O(1, 0),
+                                           O(2, 0), Side * O(1, 1), O(2, 1)) &&
+                   PacketCollisionTwoLines(p1x, p1y, p2x, p2y, O(0, 0),
+                                           Side * O(1, 0), O(0, 3),
+                                           Side * O(1, 3)));
+    }
+
+    if (Collision.any())
+      for (Eigen::Index j = 0; j < n; j++)
+        if (Collision(j))
+          return (int)(i + j);
+  }
+  return -1;
+}
+} // namespace
+
+int CollisionDetector::CollisionSegmentsObstacle(const Points &Starts,
+                                                 const Points &Ends) {
+  return FirstSegmentInCollision(m_ObstaclePoints, Starts, Ends,
+                                 Starts.rows());
+}
+
+void CollisionDetector::LowerLegToObstacleFrame(
+    const Eigen::Matrix<double, 1, 6> &LegAngles,
+    const Eigen::Matrix<double, 1, 12> &Waist, int WhichLeg,
+    Eigen::Matrix3d &Rotation, Eigen::Vector3d &Translation) {
+  Eigen::Matrix3d WaistRot;
+  Eigen::Vector3d WaistPos;
+  for (unsigned int i = 0; i < 3; i++) {
+    for (unsigned int j = 0; j < 3; j++)
+      WaistRot(i, j) = Waist(3 * i + j);
+    WaistPos(i) = Waist(9 + i);
+  }
+
+  // The frames of CalcCoordShankLowerLegPoint, from the waist to the
+  // upper leg, then the knee.
+  Eigen::Matrix3d ToUpperLeg =
+      WaistRot *
+      (Eigen::AngleAxisd(LegAngles(0), Eigen::Vector3d::UnitZ()) *
+       Eigen::AngleAxisd(LegAngles(1), Eigen::Vector3d::UnitX()) *
+       Eigen::AngleAxisd(LegAngles(2), Eigen::Vector3d::UnitY()))
+          .toRotationMatrix();
+  Eigen::Vector3d ToTheHip(0.0, (WhichLeg > 0) ? 0.09 : -0.09, 0.0);
+  Eigen::Vector3d ToTheKnee(0.0, 0.0, -0.35);
+
+  Rotation = m_ObstacleRotInv * ToUpperLeg *
+             Eigen::AngleAxisd(LegAngles(3), Eigen::Vector3d::UnitY())
+                 .toRotationMatrix();
+  Translation = m_ObstacleRotInv * (ToUpperLeg * ToTheKnee +
+                                    WaistRot * ToTheHip + WaistPos -
+                                    m_ObstaclePosition);
+}
+
+int CollisionDetector::CollisionLegSwingObstacle(
+    const Eigen::Matrix<double, Eigen::Dynamic, 6> &LegAngles,
+    const Eigen::Matrix<double, Eigen::Dynamic, 12> &Waist, int WhichLeg,
+    const Eigen::Matrix3Xd &LegStarts, const Eigen::Matrix3Xd &LegEnds) {
+  Eigen::Index NbSegments = LegStarts.cols();
+  if (NbSegments == 0)
+    return -1;
+
+  // The segments of several samples fill the packets.
+  Eigen::Index NbSamplesPerCheck =
+      std::max((Eigen::Index)1, 4 * PacketSize / NbSegments);
+  m_SwingStarts.resize(NbSamplesPerCheck * NbSegments, 3);
+  m_SwingEnds.resize(NbSamplesPerCheck * NbSegments, 3);
+
+  Eigen::Matrix3d Rotation;
+  Eigen::Vector3d Translation;
+  for (Eigen::Index k = 0; k < LegAngles.rows(); k += NbSamplesPerCheck) {
+    Eigen::Index n = std::min(NbSamplesPerCheck, LegAngles.rows() - k);
+    for (Eigen::Index s = 0; s < n; s++) {
+      LowerLegToObstacleFrame(LegAngles.row(k + s), Waist.row(k + s),
+                              WhichLeg, Rotation, Translation);
+      m_SwingStarts.middleRows(s * NbSegments, NbSegments) =
+          ((Rotation * LegStarts).colwise() + Translation).transpose();
+      m_SwingEnds.middleRows(s * NbSegments, NbSegments) =
+          ((Rotation * LegEnds).colwise() + Translation).transpose();
+    }
+
+    int Segment = FirstSegmentInCollision(m_ObstaclePoints, m_SwingStarts,
+                                          m_SwingEnds, n * NbSegments);
+    if (Segment >= 0)
+      return (int)(k + Segment / NbSegments);
+  }
+  return -1;
+}
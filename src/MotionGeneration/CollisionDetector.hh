@@ -61,11 +61,12 @@ public:
      (whichLeg positive for left leg and negative for right leg).
      This function might be replaced by functions from DynamicMultibody
   */
-  void CalcCoordShankLowerLegPoint(Eigen::Vector3d RelCoord,
+  void CalcCoordShankLowerLegPoint(const Eigen::Vector3d &RelCoord,
                                    Eigen::Vector3d &AbsCoord,
-                                   Eigen::VectorXd LegAngles,
-                                   Eigen::Matrix3d WaistRot,
-                                   Eigen::Vector3d WaistPos, int WhichLeg);
+                                   const Eigen::VectorXd &LegAngles,
+                                   const Eigen::Matrix3d &WaistRot,
+                                   const Eigen::Vector3d &WaistPos,
+                                   int WhichLeg);
 
   /*! Set opstacle position in worldframe and
     the obstacle points in local obstacle frame */
@@ -80,8 +81,10 @@ public:
   /*! This function checks for intersection of two line segments
     p1p2 and v1v2. It returns true if a collision occurs, else false
   */
-  bool CollisionTwoLines(std::vector<double> p1, std::vector<double> p2,
-                         std::vector<double> v1, std::vector<double> v2);
+  bool CollisionTwoLines(const std::vector<double> &p1,
+                         const std::vector<double> &p2,
+                         const std::vector<double> &v1,
+                         const std::vector<double> &v2);
 
   /*! This function checks for intersection of a linesegment p1p2
     of the robot, expressed in the obstacle frame, with one of the
@@ -98,7 +101,46 @@ public:
   bool CollisionLineObstacleComplete(Eigen::Vector3d &Point1,
                                      Eigen::Vector3d &Point2);
 
+  /*! \name Batch checks.
+    The points are stored by components: each column holds one
+    coordinate of all the points, so that the checks of consecutive
+    segments are computed together with the vector instructions.
+    @{ */
+  typedef Eigen::Matrix<double, Eigen::Dynamic, 3> Points;
+
+  /*! Same check as CollisionLineObstacleComplete for the segments
+    [Starts.row(i), Ends.row(i)] expressed in the obstacle frame.
+    \return the index of the first segment in collision, -1 if there
+    is none. The segments after it are not checked. */
+  int CollisionSegmentsObstacle(const Points &Starts, const Points &Ends);
+
+  /*! Check the segments of a leg along a swing.
+    The segments [LegStarts.col(j), LegEnds.col(j)] are given in the
+    frame of the lower leg as for CalcCoordShankLowerLegPoint.
+    The posture of each sample is a row of LegAngles and of Waist, the
+    orientation (row-major, columns 0 to 8) and position (columns 9 to
+    11) of the waist in the world frame, as in PRLegIKBatch.
+    \return the first sample where a segment is in collision, -1 if
+    there is none. The samples after it are not checked. */
+  int CollisionLegSwingObstacle(
+      const Eigen::Matrix<double, Eigen::Dynamic, 6> &LegAngles,
+      const Eigen::Matrix<double, Eigen::Dynamic, 12> &Waist, int WhichLeg,
+      const Eigen::Matrix3Xd &LegStarts, const Eigen::Matrix3Xd &LegEnds);
+  /*! @} */
+
 protected:
+  /*! Rotation and translation from the frame of the lower leg to the
+    obstacle frame: the transformations of CalcCoordShankLowerLegPoint
+    and WorldFrameToObstacleFrame composed. */
+  void LowerLegToObstacleFrame(const Eigen::Matrix<double, 1, 6> &LegAngles,
+                               const Eigen::Matrix<double, 1, 12> &Waist,
+                               int WhichLeg, Eigen::Matrix3d &Rotation,
+                               Eigen::Vector3d &Translation);
+
+  /*! Segments of the samples checked together by
+    CollisionLegSwingObstacle. */
+  Points m_SwingStarts, m_SwingEnds;
+
   /*! x, y, z position of obstacle in worldframe
     (point taken on the front plan of the obstacle
     on the floor and in the middel of the width) */
@@ -37,6 +37,22 @@
 
 using namespace PatternGeneratorJRL;
 
+namespace {
+/*! Number of starting states kept by the cache. */
+const std::size_t NbStartingStates = 8;
+
+/*! FNV-1a hash of the bytes of a configuration. */
+std::size_t ConfigurationHash(const Eigen::VectorXd &q) {
+  const unsigned char *bytes = (const unsigned char *)q.data();
+  unsigned long long h = 14695981039346656037ULL;
+  for (std::size_t i = 0; i < q.size() * sizeof(double); i++) {
+    h ^= bytes[i];
+    h *= 1099511628211ULL;
+  }
+  return (std::size_t)h;
+}
+} // namespace
+
 ComAndFootRealizationByGeometry::ComAndFootRealizationByGeometry(
     PatternGeneratorInterfacePrivate *aPGI)
     : ComAndFootRealization(aPGI) {
@@ -47,11 +63,21 @@ ComAndFootRealizationByGeometry::ComAndFootRealizationByGeometry(
   m_LeftShoulder = 0;
   m_RightShoulder = 0;
   ShiftFoot_ = true;
+  m_AnalyticalDerivatives = false;
+  m_StartingStateCache = true;
   RegisterMethods();
 
   for (unsigned int i = 0; i < 3; i++)
     m_DiffBetweenComAndWaist[i] = 0.0;
 
+  m_lqr.setZero(6);
+  m_lql.setZero(6);
+  m_qArmr.setZero(6);
+  m_qArml.setZero(6);
+  m_qArmp.setZero(6);
+  m_qArmm.setZero(6);
+  m_AbsoluteWaistPose.setZero(6);
+
   // By assumption on this implementation
   // the humanoid is assume to have 6 DOFs per leg.
   {
@@ -114,9 +140,10 @@ ComAndFootRealizationByGeometry::ComAndFootRealizationByGeometry(
 }
 
 void ComAndFootRealizationByGeometry::RegisterMethods() {
-  string aMethodName[3] = {":armparameters", ":UpperBodyMotionParameters",
-                           ":samplingperiod"};
-  for (int i = 0; i < 3; i++) {
+  string aMethodName[5] = {":armparameters", ":UpperBodyMotionParameters",
+                           ":samplingperiod", ":analyticalderivatives",
+                           ":startingstatecache"};
+  for (int i = 0; i < 5; i++) {
     if (!RegisterMethod(aMethodName[i])) {
       std::cerr << "Unable to register " << aMethodName << std::endl;
     }
@@ -194,6 +221,9 @@ void ComAndFootRealizationByGeometry::Initialization() {
   if (m_UpBody == 0)
     m_UpBody = new UpperBodyMotion();
 
+  // The starting states depend on the model of the robot.
+  m_StartingStates.clear();
+
   // Take the right ankle position (should be equivalent)
   Eigen::Vector3d lAnklePositionRight, lAnklePositionLeft;
   PRFoot *LeftFoot, *RightFoot;
@@ -335,7 +365,9 @@ bool ComAndFootRealizationByGeometry::InitializationHumanoid(
 
   // Compensate for the static translation, not the WAIST position
   // but it is the body position which start on the ground.
-  aPR->computeForwardKinematics();
+  // Only the ankles and the CoM are read from the model: the upper body
+  // is updated when it differs from the previous initialization.
+  aPR->computeLegsForwardKinematics();
 
   CurrentConfig = aPR->currentRPYConfiguration();
 
@@ -405,20 +437,29 @@ bool ComAndFootRealizationByGeometry::InitializationCoM(
   lStartingCOMPosition.setZero();
   lStartingWaistPose.setZero();
 
-  // Compute the forward dynamics from the configuration vector
-  // provided by the user.
-  // Initialize waist pose.
-  InitializationHumanoid(BodyAnglesIni, lStartingWaistPose);
+  if (!FindStartingState(BodyAnglesIni, lStartingWaistPose,
+                         lStartingCOMPosition, InitLeftFootPosition,
+                         InitRightFootPosition)) {
+    // Compute the forward dynamics from the configuration vector
+    // provided by the user.
+    // Initialize waist pose.
+    InitializationHumanoid(BodyAnglesIni, lStartingWaistPose);
 
-  // Initialise the right foot position.
-  PinocchioRobot *aPR = getPinocchioRobot();
-  PRFoot *RightFoot = aPR->rightFoot();
-  PRFoot *LeftFoot = aPR->leftFoot();
+    // Initialise the right foot position.
+    PinocchioRobot *aPR = getPinocchioRobot();
+    PRFoot *RightFoot = aPR->rightFoot();
+    PRFoot *LeftFoot = aPR->leftFoot();
+
+    // Initialize Feet.
+    InitializationFoot(RightFoot, m_AnklePositionRight, InitRightFootPosition);
 
-  // Initialize Feet.
-  InitializationFoot(RightFoot, m_AnklePositionRight, InitRightFootPosition);
+    InitializationFoot(LeftFoot, m_AnklePositionLeft, InitLeftFootPosition);
 
-  InitializationFoot(LeftFoot, m_AnklePositionLeft, InitLeftFootPosition);
+    // CoM position
+    getPinocchioRobot()->positionCenterOfMass(lStartingCOMPosition);
+    StoreStartingState(BodyAnglesIni, lStartingWaistPose, lStartingCOMPosition,
+                       InitLeftFootPosition, InitRightFootPosition);
+  }
 
   // Compute the center of gravity between the ankles.
   m_COGInitialAnkles[0] =
@@ -431,8 +472,6 @@ bool ComAndFootRealizationByGeometry::InitializationCoM(
   // Translate lStartingWaist Pose from ( 0.0 0.0 -lFootPosition[2])
   lStartingWaistPose(2) -= InitRightFootPosition.z;
 
-  // CoM position
-  getPinocchioRobot()->positionCenterOfMass(lStartingCOMPosition);
   ODEBUG4("COM positions: " << lStartingCOMPosition(0) << " "
                             << lStartingCOMPosition(1) << " "
                             << lStartingCOMPosition(2),
@@ -487,6 +526,63 @@ bool ComAndFootRealizationByGeometry::InitializationCoM(
   return true;
 }
 
+bool ComAndFootRealizationByGeometry::FindStartingState(
+    Eigen::VectorXd &BodyAnglesIni,
+    Eigen::Matrix<double, 6, 1> &lStartingWaistPose,
+    Eigen::Vector3d &lStartingCOMPosition,
+    FootAbsolutePosition &InitLeftFootPosition,
+    FootAbsolutePosition &InitRightFootPosition) {
+  if (!m_StartingStateCache)
+    return false;
+
+  // The hash is checked first, then the configuration itself.
+  std::size_t lHash = ConfigurationHash(BodyAnglesIni);
+  for (unsigned int i = 0; i < m_StartingStates.size(); i++) {
+    const StartingState_t &aState = m_StartingStates[i];
+    if ((aState.Hash != lHash) ||
+        (aState.BodyAngles.size() != BodyAnglesIni.size()) ||
+        (aState.BodyAngles != BodyAnglesIni))
+      continue;
+
+    // The configuration of the robot is set as by InitializationHumanoid.
+    PinocchioRobot *aPR = getPinocchioRobot();
+    Eigen::VectorXd CurrentConfig = aPR->currentRPYConfiguration();
+    for (unsigned int j = 0; j < 6; j++)
+      CurrentConfig[j] = aState.WaistPose(j);
+    for (unsigned int j = 0; j < BodyAnglesIni.size(); ++j)
+      CurrentConfig[j + pinocchio_robot::RPY_SIZE] = BodyAnglesIni[j];
+    aPR->currentRPYConfiguration(CurrentConfig);
+
+    lStartingWaistPose = aState.WaistPose;
+    lStartingCOMPosition = aState.CoMPosition;
+    InitLeftFootPosition = aState.LeftFoot;
+    InitRightFootPosition = aState.RightFoot;
+    return true;
+  }
+  return false;
+}
+
+void ComAndFootRealizationByGeometry::StoreStartingState(
+    Eigen::VectorXd &BodyAnglesIni,
+    Eigen::Matrix<double, 6, 1> &lStartingWaistPose,
+    Eigen::Vector3d &lStartingCOMPosition,
+    FootAbsolutePosition &InitLeftFootPosition,
+    FootAbsolutePosition &InitRightFootPosition) {
+  if (!m_StartingStateCache)
+    return;
+
+  if (m_StartingStates.size() >= NbStartingStates)
+    m_StartingStates.erase(m_StartingStates.begin());
+  StartingState_t aState;
+  aState.Hash = ConfigurationHash(BodyAnglesIni);
+  aState.BodyAngles = BodyAnglesIni;
+  aState.WaistPose = lStartingWaistPose;
+  aState.CoMPosition = lStartingCOMPosition;
+  aState.LeftFoot = InitLeftFootPosition;
+  aState.RightFoot = InitRightFootPosition;
+  m_StartingStates.push_back(aState);
+}
+
 bool ComAndFootRealizationByGeometry::InitializationUpperBody(
     deque<ZMPPosition> &inZMPPositions, deque<COMPosition> &inCOMBuffer,
     deque<RelativeFootPosition> lRelativeFootPositions) {
@@ -772,6 +868,100 @@ bool ComAndFootRealizationByGeometry::KinematicsForTheLegs(
   return true;
 }
 
+bool ComAndFootRealizationByGeometry::DerivativesForOneLeg(
+    Eigen::VectorXd &aCoMPosition, Eigen::VectorXd &aCoMSpeed,
+    Eigen::VectorXd &aCoMAcc, Eigen::VectorXd &aFoot, int LeftOrRight,
+    Eigen::VectorXd &lq, Eigen::Matrix<double, 6, 1> &ldq,
+    Eigen::Matrix<double, 6, 1> &lddq) {
+  // Waist attitude, as in KinematicsForTheLegs.
+  double CosTheta = cos(aCoMPosition(5) * M_PI / 180.0);
+  double SinTheta = sin(aCoMPosition(5) * M_PI / 180.0);
+  double CosOmega = cos(aCoMPosition(4) * M_PI / 180.0);
+  double SinOmega = sin(aCoMPosition(4) * M_PI / 180.0);
+  Eigen::Matrix3d Body_R;
+  Body_R << CosTheta * CosOmega, -SinTheta, CosTheta * SinOmega,
+      SinTheta * CosOmega, CosTheta, SinTheta * SinOmega, -SinOmega, 0.0,
+      CosOmega;
+
+  Eigen::Vector3d ToTheHip;
+  Eigen::Vector3d AnklePosition;
+  pinocchio::JointIndex Ankle = 0;
+  if (LeftOrRight == -1) {
+    ToTheHip = Body_R * m_TranslationToTheRightHip;
+    AnklePosition = m_AnklePositionRight;
+    Ankle = getPinocchioRobot()->rightFoot()->associatedAnkle;
+  } else {
+    ToTheHip = Body_R * m_TranslationToTheLeftHip;
+    AnklePosition = m_AnklePositionLeft;
+    Ankle = getPinocchioRobot()->leftFoot()->associatedAnkle;
+  }
+
+  // Motion of the waist: v_waist = v_com + omega x (waist - com)
+  Eigen::Vector3d Body_P, Body_V, Body_A, Omega, dOmega;
+  for (unsigned int i = 0; i < 3; i++) {
+    Body_P(i) = aCoMPosition(i) + ToTheHip(i);
+    Omega(i) = aCoMSpeed(i + 3);
+    dOmega(i) = aCoMAcc(i + 3);
+  }
+  Body_V = aCoMSpeed.head<3>() + Omega.cross(ToTheHip);
+  Body_A = aCoMAcc.head<3>() + dOmega.cross(ToTheHip) +
+           Omega.cross(Omega.cross(ToTheHip));
+
+  // Motion of the ankle, the foot orientation being Rz(theta) Ry(omega).
+  double c = cos(aFoot(3) * M_PI / 180.0);
+  double s = sin(aFoot(3) * M_PI / 180.0);
+  double co = cos(aFoot(4) * M_PI / 180.0);
+  double so = sin(aFoot(4) * M_PI / 180.0);
+  double dtheta = aFoot(8) * M_PI / 180.0, ddtheta = aFoot(13) * M_PI / 180.0;
+  double domega = aFoot(9) * M_PI / 180.0, ddomega = aFoot(14) * M_PI / 180.0;
+  Eigen::Matrix3d Foot_R;
+  Foot_R << c * co, -s, c * so, s * co, c, s * so, -so, 0.0, co;
+  Eigen::Vector3d Foot_Omega(-s * domega, c * domega, dtheta);
+  Eigen::Vector3d Foot_dOmega(-c * dtheta * domega - s * ddomega,
+                              -s * dtheta * domega + c * ddomega, ddtheta);
+
+  Eigen::Vector3d Foot_P = aFoot.head<3>(), Foot_V = aFoot.segment<3>(5),
+                  Foot_A = aFoot.segment<3>(10);
+  if (ShiftFoot_) {
+    Eigen::Vector3d Foot_Shift = Foot_R * AnklePosition;
+    Foot_P += Foot_Shift;
+    Foot_V += Foot_Omega.cross(Foot_Shift);
+    Foot_A += Foot_dOmega.cross(Foot_Shift) +
+              Foot_Omega.cross(Foot_Omega.cross(Foot_Shift));
+  }
+
+  // Motion of the ankle relatively to the waist, in the waist frame.
+  Eigen::Vector3d d = Foot_P - Body_P, dd = Foot_V - Body_V,
+                  ddd = Foot_A - Body_A, dW = Foot_Omega - Omega;
+  Eigen::Matrix<double, 6, 1> V, A;
+  V.head<3>() = Body_R.transpose() * (dd - Omega.cross(d));
+  V.tail<3>() = Body_R.transpose() * dW;
+  A.head<3>() = Body_R.transpose() *
+                (ddd - dOmega.cross(d) - 2.0 * Omega.cross(dd) +
+                 Omega.cross(Omega.cross(d)));
+  A.tail<3>() =
+      Body_R.transpose() * (Foot_dOmega - dOmega - Omega.cross(dW));
+
+  Eigen::Matrix<double, 6, 6> J;
+  if (!getPinocchioRobot()->ComputeLegJacobian(Ankle, lq, J)) {
+    ldq.setZero();
+    lddq.setZero();
+    return false;
+  }
+
+  // A slight damping keeps the velocities bounded when the leg
+  // is stretched.
+  Eigen::Matrix<double, 6, 6> JJt = J * J.transpose();
+  JJt.diagonal().array() += 1e-12;
+  Eigen::LDLT<Eigen::Matrix<double, 6, 6> > lLDLT(JJt);
+  ldq = J.transpose() * lLDLT.solve(V);
+
+  Eigen::Matrix<double, 6, 1> dJdq;
+  getPinocchioRobot()->ComputeLegJacobianTimeVariation(Ankle, lq, ldq, dJdq);
+  lddq = J.transpose() * lLDLT.solve(A - dJdq);
+  return true;
+}
+
 bool ComAndFootRealizationByGeometry::ComputePostureForGivenCoMAndFeetPosture(
     Eigen::VectorXd &aCoMPosition, Eigen::VectorXd &aCoMSpeed,
     Eigen::VectorXd &aCoMAcc, Eigen::VectorXd &aLeftFoot,
@@ -779,15 +969,16 @@ bool ComAndFootRealizationByGeometry::ComputePostureForGivenCoMAndFeetPosture(
     Eigen::VectorXd &CurrentVelocity, Eigen::VectorXd &CurrentAcceleration,
     unsigned long int IterationNumber, int Stage) {
   Eigen::Vector3d AbsoluteWaistPosition;
-  Eigen::VectorXd lqr(6);
-  Eigen::VectorXd lql(6);
+  // The angles are computed in the workspaces allocated by the constructor.
+  Eigen::VectorXd &lqr = m_lqr;
+  Eigen::VectorXd &lql = m_lql;
 
   // Kinematics for the legs.
   KinematicsForTheLegs(aCoMPosition, aLeftFoot, aRightFoot, Stage, lql, lqr,
                        AbsoluteWaistPosition);
   /// NOW IT IS ABOUT THE UPPER BODY... ////
-  Eigen::VectorXd qArmr(6);
-  Eigen::VectorXd qArml(6);
+  Eigen::VectorXd &qArmr = m_qArmr;
+  Eigen::VectorXd &qArml = m_qArml;
 
   for (unsigned int i = 0; i < qArmr.size(); i++) {
     qArmr[i] = 0.0;
@@ -795,7 +986,7 @@ bool ComAndFootRealizationByGeometry::ComputePostureForGivenCoMAndFeetPosture(
   }
 
   if (GetStepStackHandler()->GetWalkMode() < 3) {
-    Eigen::VectorXd lAbsoluteWaistPosition(6);
+    Eigen::VectorXd &lAbsoluteWaistPosition = m_AbsoluteWaistPose;
     for (unsigned int i = 0; i < 3; i++) {
       lAbsoluteWaistPosition(i) = AbsoluteWaistPosition[i];
       lAbsoluteWaistPosition(i + 3) = aCoMPosition(i + 3);
@@ -1003,6 +1194,33 @@ bool ComAndFootRealizationByGeometry::ComputePostureForGivenCoMAndFeetPosture(
     CurrentAcceleration[i] = aCoMAcc(i);
   } // cout << endl ;
 
+  if (m_AnalyticalDerivatives && (aLeftFoot.size() >= 15) &&
+      (aRightFoot.size() >= 15)) {
+    /* The legs velocities and accelerations are given by their jacobian,
+       and the ones of the arms by the derivatives of their heuristic.
+       The other joints keep the finite differences above. */
+    Eigen::Matrix<double, 6, 1> ldq, lddq;
+    DerivativesForOneLeg(aCoMPosition, aCoMSpeed, aCoMAcc, aLeftFoot, 1, lql,
+                         ldq, lddq);
+    for (unsigned int i = 0; i < 6; i++) {
+      CurrentVelocity[m_LeftLegIndexinVelocity[i]] = ldq(i);
+      CurrentAcceleration[m_LeftLegIndexinVelocity[i]] = lddq(i);
+    }
+    DerivativesForOneLeg(aCoMPosition, aCoMSpeed, aCoMAcc, aRightFoot, -1,
+                         lqr, ldq, lddq);
+    for (unsigned int i = 0; i < 6; i++) {
+      CurrentVelocity[m_RightLegIndexinVelocity[i]] = ldq(i);
+      CurrentAcceleration[m_RightLegIndexinVelocity[i]] = lddq(i);
+    }
+
+    // When stepping over, the arms depend on the previous posture.
+    int WalkMode = GetStepStackHandler()->GetWalkMode();
+    if ((WalkMode < 3) && (WalkMode != 2))
+      DerivativesOfTheArms(aCoMPosition, aCoMSpeed, aCoMAcc, aRightFoot,
+                           aLeftFoot, qArmr, qArml, CurrentVelocity,
+                           CurrentAcceleration);
+  }
+
   ODEBUG("CurrentVelocity :" << endl << CurrentVelocity);
   ODEBUG4("SamplingPeriod " << getSamplingPeriod(), "LegsSpeed.dat");
 
@@ -1112,29 +1330,14 @@ void ComAndFootRealizationByGeometry::ComputeUpperBodyHeuristicForNormalWalking(
   ODEBUG("Values: TL " << TempALeft << " TR " << TempARight << " " << m_ZARM
                        << " " << m_Xmax);
   // Compute angles using inverse kinematics and the computed hand position.
-
-  Eigen::Matrix4d jointRootPosition, jointEndPosition;
-  jointRootPosition.setIdentity();
-  jointEndPosition.setIdentity();
-
-  jointEndPosition(0, 3) = TempALeft * m_GainFactor / 0.2;
-  jointEndPosition(2, 3) = m_ZARM;
-
-  getPinocchioRobot()->ComputeSpecializedInverseKinematics(
-      m_LeftShoulder, getPinocchioRobot()->leftWrist(), jointRootPosition,
-      jointEndPosition, qArml);
+  ArmForHandPosition(1, TempALeft * m_GainFactor / 0.2, qArml);
   ODEBUG4("ComputeHeuristicArm: Step 2 ", "DebugDataIKArms.txt");
   ODEBUG4("IK Left arm p:" << qArml(0) << " " << qArml(1) << " " << qArml(2)
                            << " " << qArml(3) << "  " << qArml(4) << " "
                            << qArml(5),
           "DebugDataIKArms.txt");
 
-  jointEndPosition(0, 3) = TempARight;
-  jointEndPosition(2, 3) = m_ZARM;
-
-  getPinocchioRobot()->ComputeSpecializedInverseKinematics(
-      m_RightShoulder, getPinocchioRobot()->rightWrist(), jointRootPosition,
-      jointEndPosition, qArmr);
+  ArmForHandPosition(-1, TempARight, qArmr);
   ODEBUG4("IK Right arm p:" << qArmr(0) << " " << qArmr(1) << " " << qArmr(2)
                             << " " << qArmr(3) << "  " << qArmr(4) << " "
                             << qArmr(5),
@@ -1147,6 +1350,109 @@ void ComAndFootRealizationByGeometry::ComputeUpperBodyHeuristicForNormalWalking(
           "DebugDataqArmsHeuristic.txt");
 }
 
+void ComAndFootRealizationByGeometry::ArmForHandPosition(
+    int LeftOrRight, double HandPosition, Eigen::VectorXd &qArm) {
+  Eigen::Matrix4d jointRootPosition, jointEndPosition;
+  jointRootPosition.setIdentity();
+  jointEndPosition.setIdentity();
+  jointEndPosition(0, 3) = HandPosition;
+  jointEndPosition(2, 3) = m_ZARM;
+
+  PinocchioRobot *aPR = getPinocchioRobot();
+  if (LeftOrRight == 1)
+    aPR->ComputeSpecializedInverseKinematics(m_LeftShoulder, aPR->leftWrist(),
+                                             jointRootPosition,
+                                             jointEndPosition, qArm);
+  else
+    aPR->ComputeSpecializedInverseKinematics(
+        m_RightShoulder, aPR->rightWrist(), jointRootPosition,
+        jointEndPosition, qArm);
+}
+
+namespace {
+/*! First and second time derivatives of
+  s = -(cos(theta) x + sin(theta) y). */
+void DerivativesOfRotatedCoordinate(double theta, double dtheta,
+                                    double ddtheta, double x, double dx,
+                                    double ddx, double y, double dy,
+                                    double ddy, double &ds, double &dds) {
+  double c = cos(theta), s = sin(theta);
+  double u = c * x + s * y, v = -s * x + c * y;
+  double du = -s * dx + c * dy;
+  ds = -(c * dx + s * dy + dtheta * v);
+  dds = -(c * ddx + s * ddy + 2.0 * dtheta * du + ddtheta * v -
+          dtheta * dtheta * u);
+}
+} // namespace
+
+void ComAndFootRealizationByGeometry::DerivativesOfTheArms(
+    Eigen::VectorXd &aCoMPosition, Eigen::VectorXd &aCoMSpeed,
+    Eigen::VectorXd &aCoMAcc, Eigen::VectorXd &RFP, Eigen::VectorXd &LFP,
+    Eigen::VectorXd &qArmr, Eigen::VectorXd &qArml,
+    Eigen::VectorXd &CurrentVelocity, Eigen::VectorXd &CurrentAcceleration) {
+  // Motion of the waist, as in DerivativesForOneLeg.
+  double CosTheta = cos(aCoMPosition(5) * M_PI / 180.0);
+  double SinTheta = sin(aCoMPosition(5) * M_PI / 180.0);
+  double CosOmega = cos(aCoMPosition(4) * M_PI / 180.0);
+  double SinOmega = sin(aCoMPosition(4) * M_PI / 180.0);
+  Eigen::Matrix3d Body_R;
+  Body_R << CosTheta * CosOmega, -SinTheta, CosTheta * SinOmega,
+      SinTheta * CosOmega, CosTheta, SinTheta * SinOmega, -SinOmega, 0.0,
+      CosOmega;
+  Eigen::Vector3d ToTheWaist = Body_R * m_DiffBetweenComAndWaist;
+  Eigen::Vector3d Omega = aCoMSpeed.segment<3>(3),
+                  dOmega = aCoMAcc.segment<3>(3);
+  Eigen::Vector3d aWaistSpeed =
+      aCoMSpeed.head<3>() + Omega.cross(ToTheWaist);
+  Eigen::Vector3d aWaistAcc = aCoMAcc.head<3>() + dOmega.cross(ToTheWaist) +
+                              Omega.cross(Omega.cross(ToTheWaist));
+
+  // The hand positions are given by ComputeUpperBodyHeuristicForNormalWalking
+  // from the waist and the feet in the frame of the waist yaw. The
+  // orientation of the waist is in degrees, its velocity in rad/s.
+  const Eigen::VectorXd &aWaistPose = m_AbsoluteWaistPose;
+  double theta = aWaistPose(5) * M_PI / 180.0;
+  const double Gains[2] = {1.0, m_GainFactor / 0.2};
+  Eigen::VectorXd *Feet[2] = {&RFP, &LFP};
+  Eigen::VectorXd *qArms[2] = {&qArmr, &qArml};
+  const std::vector<int> *Indexes[2] = {&m_RightArmIndexinVelocity,
+                                        &m_LeftArmIndexinVelocity};
+  for (unsigned int Side = 0; Side < 2; Side++) {
+    Eigen::VectorXd &aFoot = *Feet[Side];
+    double ds, dds;
+    DerivativesOfRotatedCoordinate(
+        theta, Omega(2), dOmega(2),
+        aFoot(0) + m_AnklePositionRight[0] - aWaistPose(0) -
+            m_COGInitialAnkles(0),
+        aFoot(5) - aWaistSpeed(0), aFoot(10) - aWaistAcc(0),
+        aFoot(1) + m_AnklePositionRight[1] - aWaistPose(1) -
+            m_COGInitialAnkles(1),
+        aFoot(6) - aWaistSpeed(1), aFoot(11) - aWaistAcc(1), ds, dds);
+    ds *= Gains[Side];
+    dds *= Gains[Side];
+
+    // The derivatives of the inverse kinematics of the arm along the
+    // hand position are central differences.
+    const double h = 1e-4;
+    double HandPosition =
+        Gains[Side] *
+        -(cos(theta) * (aFoot(0) + m_AnklePositionRight[0] - aWaistPose(0) -
+                        m_COGInitialAnkles(0)) +
+          sin(theta) * (aFoot(1) + m_AnklePositionRight[1] - aWaistPose(1) -
+                        m_COGInitialAnkles(1)));
+    int LeftOrRight = (Side == 0) ? -1 : 1;
+    ArmForHandPosition(LeftOrRight, HandPosition + h, m_qArmp);
+    ArmForHandPosition(LeftOrRight, HandPosition - h, m_qArmm);
+    const Eigen::VectorXd &qArm = *qArms[Side];
+    for (unsigned int i = 0; i < qArm.size(); i++) {
+      double dq = (m_qArmp(i) - m_qArmm(i)) / (2.0 * h);
+      double ddq = (m_qArmp(i) - 2.0 * qArm(i) + m_qArmm(i)) / (h * h);
+      CurrentVelocity[(*Indexes[Side])[i]] = dq * ds;
+      CurrentAcceleration[(*Indexes[Side])[i]] = ddq * ds * ds + dq * dds;
+    }
+  }
+}
+
 bool ComAndFootRealizationByGeometry::setPinocchioRobot(
     PinocchioRobot *aPinocchioRobot) {
   ComAndFootRealization::setPinocchioRobot(aPinocchioRobot);
@@ -1181,6 +1487,14 @@ void ComAndFootRealizationByGeometry::CallMethod(string &Method,
     double ldt;
     istrm >> ldt;
     setSamplingPeriod(ldt);
+  } else if (Method == ":analyticalderivatives") {
+    string lAnalyticalDerivatives;
+    istrm >> lAnalyticalDerivatives;
+    m_AnalyticalDerivatives = (lAnalyticalDerivatives == "true");
+  } else if (Method == ":startingstatecache") {
+    string lStartingStateCache;
+    istrm >> lStartingStateCache;
+    StartingStateCache(lStartingStateCache == "true");
   }
 }
 
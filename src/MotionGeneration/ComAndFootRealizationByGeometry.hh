@@ -85,6 +85,9 @@ public:
     @param[in] LeftFoot a 6 dimensional following the same convention than
     for \a CoMPosition.
     @param[in] RightFoot idem.
+    With the analytical derivatives, the feet vectors have 15 dimensions:
+    the 5 of the position, followed by their 5 velocities and their 5
+    accelerations, as in FootAbsolutePosition.
     @param[out] CurrentConfiguration The result is a state vector containing
     the position which are put inside this parameter.
     @param[out] CurrentVelocity The result is a state vector containing
@@ -183,6 +186,27 @@ public:
                                                  Eigen::VectorXd &RFP,
                                                  Eigen::VectorXd &LFP);
 
+  /*! Angles of an arm for a position of the hand along the x axis of
+    the shoulder, as in ComputeUpperBodyHeuristicForNormalWalking.
+    @param[in] LeftOrRight: -1 for the right arm, 1 for the left. */
+  void ArmForHandPosition(int LeftOrRight, double HandPosition,
+                          Eigen::VectorXd &qArm);
+
+  /*! Velocities and accelerations of the arms moved by
+    ComputeUpperBodyHeuristicForNormalWalking, from the ones of the CoM
+    and of the feet. The waist pose is the last one given to the
+    heuristic.
+    @param[in] RFP, LFP: Feet followed by their velocities and
+    accelerations (15 dimensions).
+    @param[in] qArmr, qArml: Angles given by the heuristic. */
+  void DerivativesOfTheArms(Eigen::VectorXd &aCoMPosition,
+                            Eigen::VectorXd &aCoMSpeed,
+                            Eigen::VectorXd &aCoMAcc, Eigen::VectorXd &RFP,
+                            Eigen::VectorXd &LFP,
+                            Eigen::VectorXd &qArmr, Eigen::VectorXd &qArml,
+                            Eigen::VectorXd &CurrentVelocity,
+                            Eigen::VectorXd &CurrentAcceleration);
+
   /*! This method returns the final COM pose matrix
     after the second stage of control. */
   Eigen::MatrixXd GetFinalDesiredCOMPose();
@@ -230,6 +254,26 @@ public:
                             Eigen::VectorXd &ql, Eigen::VectorXd &qr,
                             Eigen::Vector3d &AbsoluteWaistPosition);
 
+  /*! Compute the velocities and accelerations of the joints of one leg
+    from the analytical jacobian of the leg, the velocities and
+    accelerations of the CoM and the ones of the foot.
+    @param[in] aCoMPosition: Position of the CoM (x,y,z,theta, omega, phi).
+    @param[in] aCoMSpeed: Velocity of the CoM.
+    @param[in] aCoMAcc: Acceleration of the CoM.
+    @param[in] aFoot: Position of the foot followed by its velocity and
+    its acceleration (15 dimensions).
+    @param[in] LeftOrRight: -1 for the right leg, 1 for the left.
+    @param[in] lq: Angles of the leg given by KinematicsForOneLeg.
+    @param[out] ldq: Velocities of the joints of the leg.
+    @param[out] lddq: Accelerations of the joints of the leg.
+  */
+  bool DerivativesForOneLeg(Eigen::VectorXd &aCoMPosition,
+                            Eigen::VectorXd &aCoMSpeed,
+                            Eigen::VectorXd &aCoMAcc, Eigen::VectorXd &aFoot,
+                            int LeftOrRight, Eigen::VectorXd &lq,
+                            Eigen::Matrix<double, 6, 1> &ldq,
+                            Eigen::Matrix<double, 6, 1> &lddq);
+
   /*! \brief Implement the Plugin part to receive information from
     PatternGeneratorInterface.
   */
@@ -348,12 +392,59 @@ public:
   inline bool ShiftFoot() { return ShiftFoot_; }
   inline void ShiftFoot(bool ShiftFoot) { ShiftFoot_ = ShiftFoot; }
 
+  /*! \brief Compute the velocities and accelerations of the legs from the
+    analytical jacobian of the legs, and the ones of the arms from the
+    derivatives of their heuristic, instead of finite differences between
+    the successive postures of a stage. The feet must be given with their
+    velocities and accelerations. The other joints, and the arms when
+    stepping over, keep the finite differences, and the previous
+    postures are updated as without this option. */
+  inline bool AnalyticalDerivatives() { return m_AnalyticalDerivatives; }
+  inline void AnalyticalDerivatives(bool AnalyticalDerivatives) {
+    m_AnalyticalDerivatives = AnalyticalDerivatives;
+  }
+
+  /*! \brief Gain factor of the arm motion heuristic. */
+  inline double GainFactor() const { return m_GainFactor; }
+
+  /*! \brief Parameters of the upper body motion. */
+  inline const std::vector<double> &UpperBodyMotionParameters() const {
+    return m_UpperBodyMotion;
+  }
+
+  /*! \brief Keep the starting states computed by InitializationCoM
+    for the last configurations of the joints, so that walking again
+    from one of them does not compute the forward kinematics.
+    The data of the robot model are then not updated. */
+  inline bool StartingStateCache() { return m_StartingStateCache; }
+  inline void StartingStateCache(bool StartingStateCache) {
+    m_StartingStateCache = StartingStateCache;
+    m_StartingStates.clear();
+  }
+
   /*! \brief Get the COG of the ankles at the starting position. */
   virtual Eigen::Vector3d GetCOGInitialAnkles();
 
   friend ostream &operator<<(ostream &os, const ComAndFootRealization &obj);
 
 protected:
+  /*! \brief Find the starting state of a configuration of the joints
+    in the cache and set the configuration of the robot model.
+    \return false if the configuration is not in the cache. */
+  bool FindStartingState(Eigen::VectorXd &BodyAnglesIni,
+                         Eigen::Matrix<double, 6, 1> &lStartingWaistPose,
+                         Eigen::Vector3d &lStartingCOMPosition,
+                         FootAbsolutePosition &InitLeftFootPosition,
+                         FootAbsolutePosition &InitRightFootPosition);
+
+  /*! \brief Store the starting state of a configuration of the joints,
+    the oldest one is removed when the cache is full. */
+  void StoreStartingState(Eigen::VectorXd &BodyAnglesIni,
+                          Eigen::Matrix<double, 6, 1> &lStartingWaistPose,
+                          Eigen::Vector3d &lStartingCOMPosition,
+                          FootAbsolutePosition &InitLeftFootPosition,
+                          FootAbsolutePosition &InitRightFootPosition);
+
   /*! \brief Initialization of internal maps of indexes */
   void InitializationMaps(std::vector<pinocchio::JointIndex> &FromRootToFoot,
                           pinocchio::JointModelVector &ActuatedJoints,
@@ -437,6 +528,24 @@ private:
 
   //@}
 
+  /*! \name Workspaces of ComputePostureForGivenCoMAndFeetPosture,
+    allocated once so that the realization does not allocate. */
+  //@{
+  /*! \brief Angles of the right and left legs. */
+  Eigen::VectorXd m_lqr, m_lql;
+
+  /*! \brief Angles of the right and left arms. */
+  Eigen::VectorXd m_qArmr, m_qArml;
+
+  /*! \brief Angles of an arm around its hand position, for the
+    derivatives of the heuristic. */
+  Eigen::VectorXd m_qArmp, m_qArmm;
+
+  /*! \brief Waist position and CoM attitude given to the arms heuristic. */
+  Eigen::VectorXd m_AbsoluteWaistPose;
+
+  //@}
+
   /*! COM Starting position. */
   Eigen::Vector3d m_StartingCOMPosition;
 
@@ -514,6 +623,27 @@ private:
   pinocchio::JointIndex m_LeftShoulder, m_RightShoulder;
 
   bool ShiftFoot_;
+
+  /*! Velocities and accelerations from the analytical jacobian
+    of the legs. */
+  bool m_AnalyticalDerivatives;
+
+  /*! Starting state given by the forward kinematics for a configuration
+    of the joints, before the feet are put on the ground. */
+  struct StartingState_t {
+    /*! Hash of the configuration of the joints. */
+    std::size_t Hash;
+    Eigen::VectorXd BodyAngles;
+    Eigen::Matrix<double, 6, 1> WaistPose;
+    Eigen::Vector3d CoMPosition;
+    FootAbsolutePosition LeftFoot, RightFoot;
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  /*! Cache of the starting states, from the oldest to the newest. */
+  bool m_StartingStateCache;
+  std::vector<StartingState_t, Eigen::aligned_allocator<StartingState_t> >
+      m_StartingStates;
 };
 
 ostream &operator<<(ostream &os, const ComAndFootRealization &obj);
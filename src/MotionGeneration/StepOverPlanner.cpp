@@ -28,16 +28,56 @@
     to step over obstacles.
 */
 
+#include <algorithm>
 #include <fstream>
 
 #include "Debug.hh"
+#include "portability/gettimeofday.hh"
 
 #include <MotionGeneration/StepOverPlanner.hh>
 
 using namespace ::PatternGeneratorJRL;
 
+namespace {
+/*! Candidates checked together by the inverse kinematics. */
+const unsigned int CandidateBlockSize = 16;
+
+/*! Position of the COM over the double support, as in
+  DoubleSupportFeasibility: the planner places it there. */
+const double DoubleSupportCOMPosFactor = 0.5;
+
+double Now() {
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return (double)t.tv_sec + 1e-6 * (double)t.tv_usec;
+}
+
+inline int loadRank(const int *Rank) {
+#ifdef HAVE_PTHREAD_H
+  return __atomic_load_n(Rank, __ATOMIC_RELAXED);
+#else
+  return *Rank;
+#endif // HAVE_PTHREAD_H
+}
+
+/*! Keep the lowest of the ranks. */
+inline void lowerRank(int *Rank, int Candidate) {
+#ifdef HAVE_PTHREAD_H
+  int Current = loadRank(Rank);
+  while ((Candidate < Current) &&
+         !__atomic_compare_exchange_n(Rank, &Current, Candidate, false,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+#else
+  if (Candidate < *Rank)
+    *Rank = Candidate;
+#endif // HAVE_PTHREAD_H
+}
+} // namespace
+
 StepOverPlanner::StepOverPlanner(ObstaclePar &ObstacleParameters,
-                                 PinocchioRobot *aPR) {
+                                 PinocchioRobot *aPR)
+    : m_CallerSearch(this), m_WorkerSearch(this) {
 
   m_PR = aPR;
   // Get information specific to the humanoid.
@@ -168,6 +208,29 @@ StepOverPlanner::StepOverPlanner(ObstaclePar &ObstacleParameters,
   m_LegLayoutPoint(1, 6) = 0.0;
   m_LegLayoutPoint(2, 6) = -0.0183;
 
+  // lines on the shin (point1 to point4) and on the calf
+  // (point5 to point7) checked for collision
+  m_LegLinesStarts.resize(3, 5);
+  m_LegLinesEnds.resize(3, 5);
+  m_LegLinesStarts << m_LegLayoutPoint.block<3, 3>(0, 0),
+      m_LegLayoutPoint.block<3, 2>(0, 4);
+  m_LegLinesEnds << m_LegLayoutPoint.block<3, 3>(0, 1),
+      m_LegLayoutPoint.block<3, 2>(0, 5);
+  m_SwingCheck = false;
+  m_SwingCollision = -1;
+
+  m_StepOverStepLenght = 0.0;
+  m_StepOverHipHeight = 0.0;
+  m_CandidateSearch = false;
+  m_ParallelCandidateSearch = true;
+  m_CandidateResolution = 10;
+  m_CandidateTimeBudget = 0.0;
+  m_NbCandidates = 0;
+  m_NbCheckedCandidates = 0;
+  m_CandidateSearchTimedOut = false;
+  m_BestCandidate = -1;
+  m_CandidateDeadline = 0.0;
+
   m_TimeDistrFactor.resize(4);
 
   m_TimeDistrFactor[0] = 2.0;
@@ -203,6 +266,12 @@ StepOverPlanner::~StepOverPlanner() {
 
   if (m_CollDet != 0)
     delete m_CollDet;
+
+  if (m_CallerSearch.m_CollDet != 0)
+    delete m_CallerSearch.m_CollDet;
+
+  if (m_WorkerSearch.m_CollDet != 0)
+    delete m_WorkerSearch.m_CollDet;
 }
 
 void StepOverPlanner::CalculateFootHolds(
@@ -216,7 +285,10 @@ void StepOverPlanner::CalculateFootHolds(
   /// Returns the double support time.
   float GetTDoubleSupport();
 
-  DoubleSupportFeasibility();
+  if (m_CandidateSearch)
+    SearchCandidates();
+  else
+    DoubleSupportFeasibility();
   // perform this function to set m_StepOverStepLenght and  m_StepOverHipHeight;
 
   double ankleDistToObstacle;
@@ -372,8 +444,6 @@ void StepOverPlanner::DoubleSupportFeasibility() {
 
   COMState aCOMState;
 
-  Eigen::Vector3d PointOnLeg;
-  Eigen::Vector3d AbsCoord;
   Eigen::Vector3d AbsCoord1;
   Eigen::Vector3d AbsCoord2;
   Eigen::Matrix<double, 6, 1> LegAngles;
@@ -381,10 +451,10 @@ void StepOverPlanner::DoubleSupportFeasibility() {
   Eigen::Matrix3d WaistRot;
   Eigen::Vector3d WaistPos;
   Eigen::Vector3d ObstFrameCoord;
-  Eigen::Vector3d ObstFrameCoord1;
-  Eigen::Vector3d ObstFrameCoord2;
+  Eigen::Matrix<double, Eigen::Dynamic, 6> LegAnglesInSwing(1, 6);
+  Eigen::Matrix<double, Eigen::Dynamic, 12> LegWaist(1, 12);
 
-  bool CollisionStatus, FinalCollisionStatus;
+  bool FinalCollisionStatus;
 
   StepOverStepLenghtMin = m_ObstacleParameters.d + m_heelToAnkle +
                           m_tipToAnkle + m_heelDistAfter + m_tipDistBefore;
@@ -411,7 +481,6 @@ void StepOverPlanner::DoubleSupportFeasibility() {
     from a table containing these values for different step situations ...
     for which a first round of preview control has been performed */
   DoubleSupportCOMPosFactor = 0.50;
-  CollisionStatus = 1;
   FinalCollisionStatus = 1;
 
   /*! we suppose that both feet have the same orentation with respect
@@ -570,66 +639,16 @@ void StepOverPlanner::DoubleSupportFeasibility() {
         // only lines (points 1, 2, 3, 4) on the shin
         // for the leg behind the obstacle only lines
         // (point 5, 6, 7) on the calf
-        CollisionStatus = 0;
-        FinalCollisionStatus = 0;
-
         // leg in front of the obstacle (for now always left leg)
-        for (unsigned int k = 0; k < 3; k++) {
-          // PointOnLeg = m_LegLayoutPoint.GetNColumns(k,1);
-          PointOnLeg[0] = m_LegLayoutPoint(0, k);
-          PointOnLeg[1] = m_LegLayoutPoint(1, k);
-          PointOnLeg[2] = m_LegLayoutPoint(2, k);
-          //            MAL_MATRIX_C_eq_EXTRACT_A(PointOnLeg,
-          // m_LegLayoutPoint,double,0,k,3,1);
-          ODEBUG("PointOnLeg : " << k << endl << PointOnLeg << endl);
-          m_CollDet->CalcCoordShankLowerLegPoint(
-              PointOnLeg, AbsCoord, LeftLegAngles, WaistRot, WaistPos, 1);
-          m_CollDet->WorldFrameToObstacleFrame(AbsCoord, ObstFrameCoord1);
-          // PointOnLeg = m_LegLayoutPoint.GetNColumns(k+1,1);
-          PointOnLeg[0] = m_LegLayoutPoint(0, k + 1);
-          PointOnLeg[1] = m_LegLayoutPoint(1, k + 1);
-          PointOnLeg[2] = m_LegLayoutPoint(2, k + 1);
-
-          //            MAL_MATRIX_C_eq_EXTRACT_A(PointOnLeg,
-          // m_LegLayoutPoint,double,0,k+1,3,1);
-          ODEBUG("PointOnLeg : " << k + 1 << endl << PointOnLeg << endl);
-          m_CollDet->CalcCoordShankLowerLegPoint(
-              PointOnLeg, AbsCoord, LeftLegAngles, WaistRot, WaistPos, 1);
-          m_CollDet->WorldFrameToObstacleFrame(AbsCoord, ObstFrameCoord2);
-          CollisionStatus = m_CollDet->CollisionLineObstacleComplete(
-              ObstFrameCoord1, ObstFrameCoord2);
-          // cout << "collision status for line with starting point "
-          // << k+1 << " is : " << CollisionStatus << endl;
-          FinalCollisionStatus = FinalCollisionStatus || CollisionStatus;
-        }
-        for (unsigned int k = 4; k < 6; k++) {
-          ODEBUG("PointOnLeg : " << k << endl << PointOnLeg << endl);
-          // PointOnLeg = m_LegLayoutPoint.GetNColumns(k,1);
-          PointOnLeg[0] = m_LegLayoutPoint(0, k);
-          PointOnLeg[1] = m_LegLayoutPoint(1, k);
-          PointOnLeg[2] = m_LegLayoutPoint(2, k);
-          // MAL_MATRIX_C_eq_EXTRACT_A(PointOnLeg,
-          //                  m_LegLayoutPoint,double,0,k,3,1);
-          m_CollDet->CalcCoordShankLowerLegPoint(
-              PointOnLeg, AbsCoord, LeftLegAngles, WaistRot, WaistPos, 1);
-          m_CollDet->WorldFrameToObstacleFrame(AbsCoord, ObstFrameCoord1);
-          // PointOnLeg = m_LegLayoutPoint.GetNColumns(k+1,1);
-          PointOnLeg[0] = m_LegLayoutPoint(0, k + 1);
-          PointOnLeg[1] = m_LegLayoutPoint(1, k + 1);
-          PointOnLeg[2] = m_LegLayoutPoint(2, k + 1);
-
-          // MAL_MATRIX_C_eq_EXTRACT_A(PointOnLeg,m_LegLayoutPoint,
-          // double,0,k+1,3,1);
-          ODEBUG("PointOnLeg : " << k + 1 << endl << PointOnLeg << endl);
-          m_CollDet->CalcCoordShankLowerLegPoint(
-              PointOnLeg, AbsCoord, LeftLegAngles, WaistRot, WaistPos, 1);
-          m_CollDet->WorldFrameToObstacleFrame(AbsCoord, ObstFrameCoord2);
-          CollisionStatus = m_CollDet->CollisionLineObstacleComplete(
-              ObstFrameCoord1, ObstFrameCoord2);
-          // cout << "collision status for line with starting point "
-          // << k+1 << " is : " << CollisionStatus << endl;
-          FinalCollisionStatus = FinalCollisionStatus || CollisionStatus;
-        }
+        LegWaist.block<1, 9>(0, 0) =
+            Eigen::Map<const Eigen::Matrix<double, 1, 9> >(
+                Eigen::Matrix3d(WaistRot.transpose()).data());
+        LegWaist.block<1, 3>(0, 9) = WaistPos.transpose();
+        LegAnglesInSwing.row(0) = LeftLegAngles.transpose();
+        FinalCollisionStatus =
+            (m_CollDet->CollisionLegSwingObstacle(LegAnglesInSwing, LegWaist,
+                                                  1, m_LegLinesStarts,
+                                                  m_LegLinesEnds) >= 0);
       }
       // cout << "FinalCollisionStatus is " << FinalCollisionStatus << endl;
       if (!FinalCollisionStatus)
@@ -649,6 +668,209 @@ void StepOverPlanner::DoubleSupportFeasibility() {
   }
 }
 
+void StepOverPlanner::SetCandidateSearch(bool CandidateSearch, bool Parallel,
+                                         unsigned int Resolution,
+                                         double TimeBudget) {
+  m_CandidateSearch = CandidateSearch;
+  m_ParallelCandidateSearch = Parallel;
+  m_CandidateResolution = std::max(Resolution, 1u);
+  m_CandidateTimeBudget = TimeBudget;
+}
+
+int StepOverPlanner::SearchCandidates() {
+  m_NbCheckedCandidates = 0;
+  m_CandidateSearchTimedOut = false;
+  if (m_PR == 0) {
+    cerr << "WARNING: no robot for the step over candidate search." << endl;
+    return -1;
+  }
+
+  // same bounds as in DoubleSupportFeasibility
+  double StepOverStepLenghtMax = 0.6;
+  double StepOverCOMHeightMin =
+      0.4 - m_DiffBetweenComAndWaist + m_soleToAnkle;
+  m_CandidateLenghtMin = m_ObstacleParameters.d + m_heelToAnkle +
+                         m_tipToAnkle + m_heelDistAfter + m_tipDistBefore;
+  m_CandidateHeightMax = 0.75 - m_DeltaStepOverCOMHeightMax;
+  m_CandidateLenghtIncrement = (StepOverStepLenghtMax - m_CandidateLenghtMin) /
+                               (double)m_CandidateResolution;
+  m_CandidateHeightIncrement = (m_CandidateHeightMax - StepOverCOMHeightMin) /
+                               (double)m_CandidateResolution;
+  m_NbCandidates = (m_CandidateResolution + 1) * (m_CandidateResolution + 1);
+  m_BestCandidate = (int)m_NbCandidates;
+  m_CandidateDeadline =
+      (m_CandidateTimeBudget > 0.0) ? Now() + m_CandidateTimeBudget : 0.0;
+
+  CandidateSearchJob *Jobs[2] = {&m_CallerSearch, &m_WorkerSearch};
+  if (m_ParallelCandidateSearch)
+    m_Worker.create();
+  unsigned int NbJobs = m_Worker.running() ? 2 : 1;
+  for (unsigned int i = 0; i < NbJobs; i++) {
+    Jobs[i]->m_First = i;
+    Jobs[i]->m_Stride = NbJobs;
+    PrepareCandidateJob(*Jobs[i]);
+  }
+  if (NbJobs > 1)
+    m_Worker.start(&m_WorkerSearch);
+  CheckCandidates(m_CallerSearch);
+  m_Worker.wait();
+  m_Worker.stop();
+
+  bool Status = true;
+  for (unsigned int i = 0; i < NbJobs; i++) {
+    m_NbCheckedCandidates += Jobs[i]->m_NbChecked;
+    m_CandidateSearchTimedOut =
+        m_CandidateSearchTimedOut || Jobs[i]->m_TimedOut;
+    Status = Status && Jobs[i]->m_Status;
+  }
+  if (!Status) {
+    cerr << "WARNING: no analytical inverse kinematics for the legs, "
+         << "the step over candidates cannot be checked." << endl;
+    return -1;
+  }
+  if (m_BestCandidate >= (int)m_NbCandidates) {
+    cerr << "WARNING: no feasible candidate to step over the obstacle."
+         << endl;
+    return -1;
+  }
+
+  CandidateParameters(m_BestCandidate, m_StepOverStepLenght,
+                      m_StepOverHipHeight);
+  return m_BestCandidate;
+}
+
+int StepOverPlanner::CheckCandidate(double StepLenght, double COMHeight) {
+  if (m_PR == 0)
+    return CANDIDATE_NO_IK;
+  PrepareCandidateJob(m_CallerSearch);
+  m_CallerSearch.m_Legs[0].resize(1);
+  m_CallerSearch.m_Legs[1].resize(1);
+  SetCandidatePose(m_CallerSearch, 0, StepLenght, COMHeight);
+  if (!SolveCandidateLegs(m_CallerSearch))
+    return CANDIDATE_NO_IK;
+  return CandidateStatus(m_CallerSearch, 0);
+}
+
+void StepOverPlanner::CandidateParameters(unsigned int Rank,
+                                          double &StepLenght,
+                                          double &COMHeight) {
+  unsigned int j = Rank % (m_CandidateResolution + 1);
+  unsigned int i = Rank / (m_CandidateResolution + 1);
+  StepLenght = m_CandidateLenghtMin + i * m_CandidateLenghtIncrement;
+  COMHeight = m_CandidateHeightMax - j * m_CandidateHeightIncrement;
+}
+
+void StepOverPlanner::PrepareCandidateJob(CandidateSearchJob &aJob) {
+  if (aJob.m_CollDet == 0)
+    aJob.m_CollDet = new CollisionDetector();
+  aJob.m_CollDet->SetObstacleCoordinates(m_ObstacleParameters);
+  aJob.m_Angles.resize(1, 6);
+  aJob.m_Waist.resize(1, 12);
+}
+
+void StepOverPlanner::SetCandidatePose(CandidateSearchJob &aJob,
+                                       unsigned int l, double StepLenght,
+                                       double COMHeight) {
+  // orientation of the waist as in DoubleSupportFeasibility,
+  // the feet stand flat on the ground, oriented as the obstacle
+  double c = cos(-m_WaistRotationStepOver * M_PI / 180.0);
+  double s = sin(-m_WaistRotationStepOver * M_PI / 180.0);
+  Eigen::Matrix<double, 1, 9> WaistRot, FootRot;
+  WaistRot << c, -s, 0.0, s, c, 0.0, 0.0, 0.0, 1.0;
+  c = cos(m_ObstacleParameters.theta * M_PI / 180.0);
+  s = sin(m_ObstacleParameters.theta * M_PI / 180.0);
+  FootRot << c, -s, 0.0, s, c, 0.0, 0.0, 0.0, 1.0;
+
+  // coordinates in obstacle frame as in DoubleSupportFeasibility
+  Eigen::Vector3d AnkleBeforeObst, AnkleAfterObst, TempCOMState;
+  AnkleBeforeObst(0) = -(StepLenght - m_heelToAnkle - m_heelDistAfter -
+                         m_ObstacleParameters.d);
+  AnkleBeforeObst(1) = m_nominalStepWidth / 2.0;
+  AnkleBeforeObst(2) = m_soleToAnkle;
+  AnkleAfterObst(0) = AnkleBeforeObst(0) + StepLenght;
+  AnkleAfterObst(1) = -m_nominalStepWidth / 2.0;
+  AnkleAfterObst(2) = m_soleToAnkle;
+  TempCOMState(0) = AnkleBeforeObst(0) + DoubleSupportCOMPosFactor * StepLenght;
+  TempCOMState(1) = 0.0;
+  TempCOMState(2) = COMHeight;
+
+  Eigen::Vector3d WaistPos = m_ObstaclePosition + m_ObstacleRot * TempCOMState;
+  WaistPos(2) += m_DiffBetweenComAndWaist;
+  for (unsigned int Leg = 0; Leg < 2; Leg++) {
+    aJob.m_Legs[Leg].waist.block<1, 9>(l, 0) = WaistRot;
+    aJob.m_Legs[Leg].waist.block<1, 3>(l, 9) = WaistPos.transpose();
+    aJob.m_Legs[Leg].ankle.block<1, 9>(l, 0) = FootRot;
+  }
+  aJob.m_Legs[0].ankle.block<1, 3>(l, 9) =
+      (m_ObstaclePosition + m_ObstacleRot * AnkleBeforeObst).transpose();
+  aJob.m_Legs[1].ankle.block<1, 3>(l, 9) =
+      (m_ObstaclePosition + m_ObstacleRot * AnkleAfterObst).transpose();
+}
+
+bool StepOverPlanner::SolveCandidateLegs(CandidateSearchJob &aJob) {
+  return m_PR->ComputeLegInverseKinematicsBatch(
+             m_PR->leftFoot()->associatedAnkle, aJob.m_Legs[0]) &&
+         m_PR->ComputeLegInverseKinematicsBatch(
+             m_PR->rightFoot()->associatedAnkle, aJob.m_Legs[1]);
+}
+
+int StepOverPlanner::CandidateStatus(CandidateSearchJob &aJob,
+                                     unsigned int l) {
+  if (!aJob.m_Legs[0].reachable(l) || !aJob.m_Legs[1].reachable(l))
+    return CANDIDATE_UNREACHABLE;
+  if ((aJob.m_Legs[0].q(l, 3) < m_KneeAngleBound) ||
+      (aJob.m_Legs[1].q(l, 3) < m_KneeAngleBound))
+    return CANDIDATE_KNEE_BOUND;
+
+  // leg in front of the obstacle (for now always left leg)
+  aJob.m_Angles.row(0) = aJob.m_Legs[0].q.row(l);
+  aJob.m_Waist.row(0) = aJob.m_Legs[0].waist.row(l);
+  if (aJob.m_CollDet->CollisionLegSwingObstacle(aJob.m_Angles, aJob.m_Waist,
+                                                1, m_LegLinesStarts,
+                                                m_LegLinesEnds) >= 0)
+    return CANDIDATE_COLLISION;
+  return CANDIDATE_FEASIBLE;
+}
+
+void StepOverPlanner::CheckCandidates(CandidateSearchJob &aJob) {
+  aJob.m_NbChecked = 0;
+  aJob.m_Status = true;
+  aJob.m_TimedOut = false;
+
+  for (unsigned int Begin = aJob.m_First * CandidateBlockSize;;
+       Begin += aJob.m_Stride * CandidateBlockSize) {
+    // the candidates of the block cannot be better than the best one
+    if ((int)Begin >= loadRank(&m_BestCandidate))
+      return;
+    if ((m_CandidateDeadline > 0.0) && (Now() >= m_CandidateDeadline)) {
+      aJob.m_TimedOut = true;
+      return;
+    }
+
+    unsigned int End = std::min(Begin + CandidateBlockSize, m_NbCandidates);
+    aJob.m_Legs[0].resize(End - Begin);
+    aJob.m_Legs[1].resize(End - Begin);
+    for (unsigned int r = Begin; r < End; r++) {
+      double StepOverStepLenght, StepOverCOMHeight;
+      CandidateParameters(r, StepOverStepLenght, StepOverCOMHeight);
+      SetCandidatePose(aJob, r - Begin, StepOverStepLenght, StepOverCOMHeight);
+    }
+    if (!SolveCandidateLegs(aJob)) {
+      aJob.m_Status = false;
+      return;
+    }
+
+    for (unsigned int r = Begin; r < End; r++) {
+      aJob.m_NbChecked++;
+      if (CandidateStatus(aJob, r - Begin) == CANDIDATE_FEASIBLE) {
+        // the next candidates of the job are not better
+        lowerRank(&m_BestCandidate, (int)r);
+        return;
+      }
+    }
+  }
+}
+
 void StepOverPlanner::PolyPlanner(deque<COMState> &aCOMBuffer,
                                   deque<FootAbsolutePosition> &aLeftFootBuffer,
                                   deque<FootAbsolutePosition> &aRightFootBuffer,
@@ -720,6 +942,28 @@ void StepOverPlanner::PolyPlanner(deque<COMState> &aCOMBuffer,
     PolyPlannerSecondStep(m_LeftFootBuffer);
   }
 
+  // check the swings of both steps against the obstacle
+  // with the posture given by the first preview round
+  m_SwingCollision = -1;
+  if (m_SwingCheck) {
+    if (m_WhoIsFirst == -1) {
+      m_SwingCollision = SwingCollision(m_LeftFootBuffer, m_StartStepOver,
+                                        m_StartDoubleSupp, 1);
+      if (m_SwingCollision < 0)
+        m_SwingCollision = SwingCollision(m_RightFootBuffer,
+                                          m_StartSecondStep, m_EndStepOver, -1);
+    } else {
+      m_SwingCollision = SwingCollision(m_RightFootBuffer, m_StartStepOver,
+                                        m_StartDoubleSupp, -1);
+      if (m_SwingCollision < 0)
+        m_SwingCollision = SwingCollision(m_LeftFootBuffer, m_StartSecondStep,
+                                          m_EndStepOver, 1);
+    }
+    if (m_SwingCollision >= 0)
+      cerr << "WARNING: the leg collides with the obstacle at "
+           << m_LeftFootBuffer[m_SwingCollision].time << " s." << endl;
+  }
+
   aRightFootBuffer = m_RightFootBuffer;
   aLeftFootBuffer = m_LeftFootBuffer;
   aCOMBuffer = m_COMBuffer;
@@ -767,6 +1011,67 @@ void StepOverPlanner::PolyPlanner(deque<COMState> &aCOMBuffer,
   // return 1;*/
 }
 
+int StepOverPlanner::SwingCollision(deque<FootAbsolutePosition> &aFootBuffer,
+                                    unsigned int Start, unsigned int End,
+                                    int WhichLeg) {
+  if ((m_PR == 0) || (m_CollDet == 0) || (End <= Start) ||
+      (End > aFootBuffer.size()) || (End > m_COMBuffer.size()))
+    return -1;
+
+  PRFoot *aFoot = (WhichLeg == 1) ? m_PR->leftFoot() : m_PR->rightFoot();
+  m_SwingIK.resize(End - Start);
+  for (unsigned int u = Start; u < End; u++) {
+    const COMState &aCOMState = m_COMBuffer[u];
+    const FootAbsolutePosition &aFootPosition = aFootBuffer[u];
+    unsigned int k = u - Start;
+
+    // waist, with the orientation of the COM
+    double c = cos(aCOMState.yaw[0] * M_PI / 180.0);
+    double s = sin(aCOMState.yaw[0] * M_PI / 180.0);
+    m_SwingIK.waist.row(k) << c, -s, 0.0, s, c, 0.0, 0.0, 0.0, 1.0,
+        aCOMState.x[0], aCOMState.y[0],
+        aCOMState.z[0] + m_DiffBetweenComAndWaist;
+
+    // ankle
+    c = cos(aFootPosition.theta * M_PI / 180.0);
+    s = sin(aFootPosition.theta * M_PI / 180.0);
+    double co = cos(aFootPosition.omega * M_PI / 180.0);
+    double so = sin(aFootPosition.omega * M_PI / 180.0);
+    Eigen::Matrix3d Foot_R;
+    Foot_R << c * co, -s, c * so, s * co, c, s * so, -so, 0.0, co;
+    Eigen::Vector3d Foot_P(aFootPosition.x, aFootPosition.y, aFootPosition.z);
+    Foot_P += Foot_R * aFoot->anklePosition;
+    m_SwingIK.ankle.block<1, 9>(k, 0) =
+        Eigen::Map<const Eigen::Matrix<double, 1, 9> >(
+            Eigen::Matrix3d(Foot_R.transpose()).data());
+    m_SwingIK.ankle.block<1, 3>(k, 9) = Foot_P.transpose();
+  }
+
+  if (!m_PR->ComputeLegInverseKinematicsBatch(aFoot->associatedAnkle,
+                                              m_SwingIK))
+    return -1;
+
+  // keep the samples where the ankle is reached
+  m_SwingSamples.clear();
+  for (unsigned int k = 0; k < End - Start; k++)
+    if (m_SwingIK.reachable(k))
+      m_SwingSamples.push_back(k);
+  m_SwingAngles.resize(m_SwingSamples.size(), 6);
+  m_SwingWaist.resize(m_SwingSamples.size(), 12);
+  for (unsigned int i = 0; i < m_SwingSamples.size(); i++) {
+    m_SwingAngles.row(i) = m_SwingIK.q.row(m_SwingSamples[i]);
+    m_SwingWaist.row(i) = m_SwingIK.waist.row(m_SwingSamples[i]);
+  }
+  if (m_SwingSamples.empty())
+    return -1;
+
+  int Collision = m_CollDet->CollisionLegSwingObstacle(
+      m_SwingAngles, m_SwingWaist, WhichLeg, m_LegLinesStarts, m_LegLinesEnds);
+  if (Collision < 0)
+    return -1;
+  return (int)(Start + m_SwingSamples[Collision]);
+}
+
 void StepOverPlanner::PolyPlannerFirstStep(
     deque<FootAbsolutePosition> &aStepOverFootBuffer) {
 
@@ -49,6 +49,8 @@
 #include <Mathematics/StepOverPolynome.hh>
 #include <PreviewControl/PreviewControl.hh>
 
+#include "portability/thread.hh"
+
 namespace PatternGeneratorJRL {
 class ZMPDiscretization;
 class CollisionDetector;
@@ -150,12 +152,97 @@ public:
                                    Eigen::MatrixXd WaistRot,
                                    Eigen::MatrixXd WaistPos, int WhichLeg);
 
+  /*! Check the swings planned by PolyPlanner against the obstacle,
+    off by default. */
+  inline void SetSwingCheck(bool SwingCheck) { m_SwingCheck = SwingCheck; }
+
+  /*! First sample of the foot buffers where a leg collides with the
+    obstacle during the swings planned by PolyPlanner, -1 if there is
+    none or if the swings are not checked. */
+  inline int GetSwingCollision() const { return m_SwingCollision; }
+
+  /*! \name Candidate search.
+    Instead of DoubleSupportFeasibility, the step length and the hip
+    height of the double support over the obstacle are sampled on a
+    grid. The COM is placed in the middle of the double support, where
+    the planner places it. The candidates are checked by blocks,
+    alternately by the calling thread and a worker thread: reachability
+    of both legs with the batch inverse kinematics, bound of the knees,
+    then collision of the leg in front of the obstacle.
+
+    The candidates are ranked as in DoubleSupportFeasibility: shortest
+    step first, then highest hip. The feasible candidate of lowest rank
+    is kept, whichever thread checked it, so that the result does not
+    depend on the threads unless the time budget is exceeded.
+    @{ */
+  /*! Result of the check of a candidate. */
+  enum CandidateStatus_t {
+    CANDIDATE_FEASIBLE,
+    CANDIDATE_UNREACHABLE,
+    CANDIDATE_KNEE_BOUND,
+    CANDIDATE_COLLISION,
+    CANDIDATE_NO_IK
+  };
+
+  /*! Use the candidate search in CalculateFootHolds.
+    \param Parallel use a worker thread.
+    \param Resolution number of intervals of the step lengths and of
+    the hip heights.
+    \param TimeBudget time after which the search stops, in seconds,
+    no limit if it is not positive. The best candidate checked so far
+    is then kept. */
+  void SetCandidateSearch(bool CandidateSearch, bool Parallel = true,
+                          unsigned int Resolution = 10,
+                          double TimeBudget = 0.0);
+
+  /*! Search the candidates and set the step length and the hip height
+    of the step over.
+    \return the rank of the candidate, -1 if none is feasible. */
+  int SearchCandidates();
+
+  /*! Check the double support over the obstacle of one candidate, as
+    in the search.
+    \return a CandidateStatus_t. */
+  int CheckCandidate(double StepLenght, double COMHeight);
+
+  /*! Step length and hip height of the candidate of rank Rank,
+    on the grid of the last search. */
+  void CandidateParameters(unsigned int Rank, double &StepLenght,
+                           double &COMHeight);
+
+  /*! Number of candidates of the grid of the last search. */
+  inline unsigned int GetNbCandidates() const { return m_NbCandidates; }
+
+  /*! Number of candidates checked by the last search. */
+  inline unsigned int GetNbCheckedCandidates() const {
+    return m_NbCheckedCandidates;
+  }
+
+  /*! Did the last search exceed the time budget. */
+  inline bool GetCandidateSearchTimedOut() const {
+    return m_CandidateSearchTimedOut;
+  }
+  /*! @} */
+
+  /*! Step length and hip height selected for the step over. */
+  inline double GetStepOverStepLenght() const { return m_StepOverStepLenght; }
+  inline double GetStepOverHipHeight() const { return m_StepOverHipHeight; }
+
 protected:
   /*! this function will calculate a feasible set
     for the stepleght and hip height during
     double support over the obstacle */
   void DoubleSupportFeasibility();
 
+  /*! Check the swing of a leg between the samples Start and End of
+    the foot buffer, with the waist given by the first preview round.
+    (WhichLeg positive for left leg and negative for right leg)
+    The samples where the ankle cannot be reached are skipped.
+    \return the first sample in collision, -1 if there is none or
+    if the legs have no analytical inverse kinematics. */
+  int SwingCollision(deque<FootAbsolutePosition> &aFootBuffer,
+                     unsigned int Start, unsigned int End, int WhichLeg);
+
   /*! Read parameters from interpretor */
   void m_SetObstacleParameters(istringstream &strm);
 
@@ -245,6 +332,86 @@ protected:
 
   Eigen::MatrixXd m_LegLayoutPoint;
 
+  /*! Lines between the points of the leg layout checked for
+    collision, in the frame of the lower leg. */
+  Eigen::Matrix3Xd m_LegLinesStarts, m_LegLinesEnds;
+
+  /*! Batch of the inverse kinematics along a swing. */
+  PRLegIKBatch m_SwingIK;
+
+  /*! Reachable samples of the swing, and their rank in m_SwingIK. */
+  Eigen::Matrix<double, Eigen::Dynamic, 6> m_SwingAngles;
+  Eigen::Matrix<double, Eigen::Dynamic, 12> m_SwingWaist;
+  std::vector<unsigned int> m_SwingSamples;
+
+  /*! Check of the swings, and its result. */
+  bool m_SwingCheck;
+  int m_SwingCollision;
+
+  /*! Candidates checked by one thread: the blocks First,
+    First + Stride, ... */
+  class CandidateSearchJob : public WorkerThread::Job {
+  public:
+    CandidateSearchJob(StepOverPlanner *aPlanner)
+        : m_Planner(aPlanner), m_First(0), m_Stride(1), m_NbChecked(0),
+          m_Status(true), m_TimedOut(false), m_CollDet(0) {}
+    void run() { m_Planner->CheckCandidates(*this); }
+
+    StepOverPlanner *m_Planner;
+    unsigned int m_First, m_Stride, m_NbChecked;
+    /*! False if the legs have no analytical inverse kinematics. */
+    bool m_Status;
+    bool m_TimedOut;
+    /*! The collision detector keeps the points of a check. */
+    CollisionDetector *m_CollDet;
+    /*! Left leg before and right leg after the obstacle. */
+    PRLegIKBatch m_Legs[2];
+    Eigen::Matrix<double, Eigen::Dynamic, 6> m_Angles;
+    Eigen::Matrix<double, Eigen::Dynamic, 12> m_Waist;
+  };
+  friend class CandidateSearchJob;
+
+  /*! Check the blocks of candidates of a job, until a feasible one,
+    one which cannot be better than m_BestCandidate or the deadline. */
+  void CheckCandidates(CandidateSearchJob &aJob);
+
+  /*! Collision detector and buffers of a job. */
+  void PrepareCandidateJob(CandidateSearchJob &aJob);
+
+  /*! Poses of the waist and of the ankles of a candidate,
+    in the row l of the legs of the job. */
+  void SetCandidatePose(CandidateSearchJob &aJob, unsigned int l,
+                        double StepLenght, double COMHeight);
+
+  /*! Inverse kinematics of both legs of the job.
+    \return false if the legs have no analytical inverse kinematics. */
+  bool SolveCandidateLegs(CandidateSearchJob &aJob);
+
+  /*! Check the candidate of the row l, once its legs are solved.
+    \return a CandidateStatus_t. */
+  int CandidateStatus(CandidateSearchJob &aJob, unsigned int l);
+
+  /*! Rank of the best feasible candidate found by the running search,
+    accessed atomically. */
+  int m_BestCandidate;
+
+  bool m_CandidateSearch, m_ParallelCandidateSearch;
+  unsigned int m_CandidateResolution;
+  double m_CandidateTimeBudget;
+  unsigned int m_NbCandidates, m_NbCheckedCandidates;
+  bool m_CandidateSearchTimedOut;
+  /*! Grid of the running search. */
+  double m_CandidateLenghtMin, m_CandidateLenghtIncrement;
+  double m_CandidateHeightMax, m_CandidateHeightIncrement;
+  /*! Time at which the running search stops, in seconds since the
+    epoch, 0 if there is no time budget. */
+  double m_CandidateDeadline;
+
+  /*! The thread is created for each search only: it would spin
+    between two searches. */
+  WorkerThread m_Worker;
+  CandidateSearchJob m_CallerSearch, m_WorkerSearch;
+
   /*! Vector from the Waist to the left and right hip. */
   Eigen::Vector3d m_StaticToTheLeftHip;
   Eigen::Vector3d m_StaticToTheRightHip;
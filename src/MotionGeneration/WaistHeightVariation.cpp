@@ -153,7 +153,7 @@ void WaistHeightVariation::PolyPlanner(deque<COMPosition> &aCOMBuffer,
   // return 1;*/
 }
 
-WaistPolynome::WaistPolynome() : Polynome(4) {
+WaistPolynome::WaistPolynome() : FixedDegreePolynome<4>() {
   // SetParameters(boundCond,timeDistr);
 }
 
@@ -48,6 +48,7 @@
 #include <string>
 #include <vector>
 
+#include <Mathematics/FixedDegreePolynome.hh>
 #include <Mathematics/Polynome.hh>
 #include <PreviewControl/PreviewControl.hh>
 #include <ZMPRefTrajectoryGeneration/ZMPDiscretization.hh>
@@ -56,7 +57,7 @@
 
 namespace PatternGeneratorJRL {
 
-class WaistPolynome : public Polynome {
+class WaistPolynome : public FixedDegreePolynome<4> {
 public:
   /// Constructor:
   /// boundCond: the different boundary conditions begin,
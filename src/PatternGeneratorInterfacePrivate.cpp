@@ -174,7 +174,7 @@ void PatternGeneratorInterfacePrivate::AllowFPE() {
 }
 
 void PatternGeneratorInterfacePrivate::RegisterPluginMethods() {
-#define number_of_method 18
+#define number_of_method 20
   std::string aMethodName[number_of_method] = {":LimitsFeasibility",
                                                ":ZMPShiftParameters",
                                                ":TimeDistributionParameters",
@@ -192,7 +192,9 @@ void PatternGeneratorInterfacePrivate::RegisterPluginMethods() {
                                                ":NaveauOnline",
                                                ":setVelReference",
                                                ":setCoMPerturbationForce",
-                                               ":feedBackControl"};
+                                               ":feedBackControl",
+                                               ":StepOverCandidateSearch",
+                                               ":StepOverSwingCheck"};
 
   for (int i = 0; i < number_of_method; i++) {
     if (!SimplePlugin::RegisterMethod(aMethodName[i])) {
@@ -597,7 +599,7 @@ void PatternGeneratorInterfacePrivate::EvaluateStartingCOM(
 
   m_PinocchioRobot->currentRPYConfiguration(Configuration);
   m_PinocchioRobot->currentRPYVelocity(Velocity);
-  m_PinocchioRobot->computeForwardKinematics();
+  m_PinocchioRobot->computeLegsForwardKinematics();
   m_PinocchioRobot->positionCenterOfMass(lStartingCOMState);
 }
 
@@ -1058,6 +1060,29 @@ void PatternGeneratorInterfacePrivate::CallMethod(string &aCmd,
   else if (aCmd == ":LimitsFeasibility")
     m_SetLimitsFeasibility(strm);
 
+  else if (aCmd == ":StepOverCandidateSearch") {
+    // :StepOverCandidateSearch true|false [Parallel [Resolution [Budget]]]
+    std::string lCandidateSearch, lParallel("true");
+    unsigned int lResolution = 10;
+    double lTimeBudget = 0.0;
+    strm >> lCandidateSearch;
+    if (strm.good())
+      strm >> lParallel;
+    if (strm.good())
+      strm >> lResolution;
+    if (strm.good())
+      strm >> lTimeBudget;
+    m_StOvPl->SetCandidateSearch(lCandidateSearch == "true",
+                                 lParallel == "true", lResolution,
+                                 lTimeBudget);
+  }
+
+  else if (aCmd == ":StepOverSwingCheck") {
+    std::string lSwingCheck;
+    strm >> lSwingCheck;
+    m_StOvPl->SetSwingCheck(lSwingCheck == "true");
+  }
+
   else if (aCmd == ":ZMPShiftParameters")
     m_SetZMPShiftParameters(strm);
 
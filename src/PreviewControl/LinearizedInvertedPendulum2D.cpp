@@ -162,6 +162,10 @@ int LinearizedInvertedPendulum2D::InitializeSystem() {
   m_C(0, 1) = 0.0;
   m_C(0, 2) = -m_ComHeight / 9.81;
 
+  if ((m_SamplingPeriod > 0.0) && (m_InterpolationInterval > 0))
+    m_Propagator.InitializeJerkIntegrator(m_SamplingPeriod,
+                                          m_InterpolationInterval);
+
   return 0;
 }
 
@@ -179,35 +183,31 @@ int LinearizedInvertedPendulum2D::Interpolation(
   // PG ?
   int loopEnd = std::min<int>(m_InterpolationInterval - 1,
                               ((int)COMStates.size()) - 1 - CurrentPosition);
+  if (loopEnd < 0)
+    return 0;
+
+  // The transitions for (lk+1) * m_SamplingPeriod are precomputed,
+  // and the two axis are propagated together.
+  m_Propagator.InitializeJerkIntegrator(m_SamplingPeriod,
+                                        m_InterpolationInterval);
+  Eigen::Matrix<double, 3, 2> lxy, lxyk;
+  for (int i = 0; i < 3; i++) {
+    lxy(i, 0) = m_CoM.x[i];
+    lxy(i, 1) = m_CoM.y[i];
+  }
+  Eigen::Matrix<double, 1, 2> lu;
+  lu(0, 0) = CX;
+  lu(0, 1) = CY;
+
   for (int lk = 0; lk <= loopEnd; lk++, lCurrentPosition++) {
     ODEBUG("lCurrentPosition: " << lCurrentPosition);
     COMState &aCOMPos = COMStates[lCurrentPosition];
-    double lkSP;
-    lkSP = (lk + 1) * m_SamplingPeriod;
-
-    aCOMPos.x[0] = m_CoM.x[0] +                     // Position
-                   lkSP * m_CoM.x[1] +              // Speed
-                   0.5 * lkSP * lkSP * m_CoM.x[2] + // Acceleration
-                   lkSP * lkSP * lkSP * CX / 6.0;   // Jerk
-
-    aCOMPos.x[1] = m_CoM.x[1] +            // Speed
-                   lkSP * m_CoM.x[2] +     // Acceleration
-                   0.5 * lkSP * lkSP * CX; // Jerk
-
-    aCOMPos.x[2] = m_CoM.x[2] + // Acceleration
-                   lkSP * CX;   // Jerk
-
-    aCOMPos.y[0] = m_CoM.y[0] +                     // Position
-                   lkSP * m_CoM.y[1] +              // Speed
-                   0.5 * lkSP * lkSP * m_CoM.y[2] + // Acceleration
-                   lkSP * lkSP * lkSP * CY / 6.0;   // Jerk
-
-    aCOMPos.y[1] = m_CoM.y[1] +            // Speed
-                   lkSP * m_CoM.y[2] +     // Acceleration
-                   0.5 * lkSP * lkSP * CY; // Jerk
+    m_Propagator.Propagate(lk + 1, lxy, lu, lxyk);
 
-    aCOMPos.y[2] = m_CoM.y[2] + // Acceleration
-                   lkSP * CY;   // Jerk
+    for (int i = 0; i < 3; i++) {
+      aCOMPos.x[i] = lxyk(i, 0);
+      aCOMPos.y[i] = lxyk(i, 1);
+    }
 
     aCOMPos.yaw[0] = ZMPRefPositions[lCurrentPosition].theta;
 
@@ -229,7 +229,7 @@ int LinearizedInvertedPendulum2D::Interpolation(
                          << aCOMPos.y[2] << " " << aCOMPos.yaw << " "
                          << aZMPPos.px << " " << aZMPPos.py << " "
                          << aZMPPos.theta << " " << CX << " " << CY << " "
-                         << lkSP << " " << m_T,
+                         << (lk + 1) * m_SamplingPeriod << " " << m_T,
             "DebugInterpol.dat");
   }
   return 0;
@@ -34,6 +34,7 @@
 
 /*! Framework includes */
 
+#include <Mathematics/LIPMPropagator.hh>
 #include <jrl/walkgen/pgtypes.hh>
 #include <privatepgtypes.hh>
 
@@ -112,6 +113,10 @@ private:
   /* ! \brief Vector of ZMP  */
   Eigen::VectorXd m_zk;
 
+  /* ! \brief Transitions over the multiples of the robot control period,
+     used for the interpolation. */
+  LIPMPropagator m_Propagator;
+
   /* ! @} */
 
 public:
@@ -56,6 +56,7 @@ PreviewControl::PreviewControl(SimplePluginManager *lSPM,
 
   m_Kx.resize(1, 3);
   m_Ks = 0;
+  m_GainsCache = 0;
 
   ODEBUG("Identification: " << this);
   std::string aMethodName[3] = {":samplingperiod", ":previewcontroltime",
@@ -203,6 +204,16 @@ void PreviewControl::ComputeOptimalWeights(unsigned int mode) {
 
   Nl = (int)(m_PreviewControlTime / T);
 
+  if ((m_GainsCache != 0) &&
+      (m_GainsCache->Find(T, m_Zc, m_PreviewControlTime, mode, m_Kx, m_Ks,
+                          m_F))) {
+    ODEBUG("Optimal weights found in the cache");
+    m_SizeOfPreviewWindow =
+        (unsigned int)(m_PreviewControlTime / m_SamplingPeriod);
+    m_Coherent = true;
+    return;
+  }
+
   if (mode == OptimalControllerSolver::MODE_WITHOUT_INITIALPOS) {
     ODEBUG("COMPUTATION WITHOUT INITIALPOS !");
     Q = 1;
@@ -275,6 +286,11 @@ void PreviewControl::ComputeOptimalWeights(unsigned int mode) {
     delete anOCS;
   }
 
+  if ((m_GainsCache != 0) &&
+      ((mode == OptimalControllerSolver::MODE_WITHOUT_INITIALPOS) ||
+       (mode == OptimalControllerSolver::MODE_WITH_INITIALPOS)))
+    m_GainsCache->Store(T, m_Zc, m_PreviewControlTime, mode, m_Kx, m_Ks, m_F);
+
   ODEBUG("Nl:" << Nl);
   ODEBUG("Zc:" << m_Zc << " T:" << T);
   ODEBUG("Q:" << Q << " R:" << R);
@@ -294,6 +310,10 @@ void PreviewControl::ComputeOptimalWeights(unsigned int mode) {
   m_Coherent = true;
 }
 
+void PreviewControl::SetGainsCache(PreviewControlGainsCache *aGainsCache) {
+  m_GainsCache = aGainsCache;
+}
+
 int PreviewControl::OneIterationOfPreview(
     Eigen::MatrixXd &x, Eigen::MatrixXd &y, double &sxzmp, double &syzmp,
     deque<PatternGeneratorJRL::ZMPPosition> &ZMPPositions,
@@ -36,6 +36,7 @@
 using namespace ::std;
 
 #include <PreviewControl/OptimalControllerSolver.hh>
+#include <PreviewControl/PreviewControlGainsCache.hh>
 #include <SimplePlugin.hh>
 #include <jrl/walkgen/pgtypes.hh>
 
@@ -122,6 +123,11 @@ public:
   */
   void ComputeOptimalWeights(unsigned int mode);
 
+  /*! \brief Set the cache in which the optimal weights are looked for
+    before solving the Riccati equation, and stored after.
+    The cache is not owned by this object, 0 disables it. */
+  void SetGainsCache(PreviewControlGainsCache *aGainsCache);
+
   /*! \brief Overloading of << operator. */
   void print();
 
@@ -168,6 +174,9 @@ private:
 
   /*! \brief Default Mode. */
   unsigned int m_DefaultWeightComputationMode;
+
+  /*! \brief Cache of the optimal weights. */
+  PreviewControlGainsCache *m_GainsCache;
 };
 } // namespace PatternGeneratorJRL
 #include <ZMPRefTrajectoryGeneration/ZMPDiscretization.hh>
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/* \doc Persistent cache of the preview control gains. */
+
+#include <string.h>
+
+#include <iostream>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* HAVE_SYS_MMAN_H */
+
+#include <Debug.hh>
+#include <PreviewControl/PreviewControlGainsCache.hh>
+
+using namespace PatternGeneratorJRL;
+
+namespace {
+const char PCGC_MAGIC[8] = {'J', 'R', 'L', 'P', 'C', 'G', 'C', '\0'};
+const unsigned int PCGC_VERSION = 1;
+} // namespace
+
+PreviewControlGainsCache::PreviewControlGainsCache() {
+  m_FileDescriptor = -1;
+  m_Data = 0;
+  m_MappedSize = 0;
+}
+
+PreviewControlGainsCache::~PreviewControlGainsCache() { Close(); }
+
+bool PreviewControlGainsCache::IsOpen() const { return m_Data != 0; }
+
+bool PreviewControlGainsCache::Open(const std::string &aFileName) {
+  if (IsOpen() && (aFileName == m_FileName))
+    return true;
+  Close();
+
+#ifdef HAVE_SYS_MMAN_H
+  m_FileDescriptor = open(aFileName.c_str(), O_RDWR | O_CREAT, 0644);
+  if (m_FileDescriptor < 0) {
+    std::cerr << "PreviewControlGainsCache - Unable to open " << aFileName
+              << std::endl;
+    return false;
+  }
+  m_FileName = aFileName;
+
+  struct stat st;
+  if ((fstat(m_FileDescriptor, &st) != 0) ||
+      ((unsigned int)st.st_size < sizeof(FileHeader))) {
+    if (!Reset()) {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  if (!Map((unsigned int)st.st_size)) {
+    Close();
+    return false;
+  }
+
+  // A file from another version is discarded.
+  FileHeader *aHeader = (FileHeader *)m_Data;
+  if ((memcmp(aHeader->Magic, PCGC_MAGIC, sizeof(PCGC_MAGIC)) != 0) ||
+      (aHeader->Version != PCGC_VERSION) ||
+      (aHeader->UsedBytes > m_MappedSize)) {
+    ODEBUG("Discard the preview control gains cache " << aFileName);
+    if (!Reset()) {
+      Close();
+      return false;
+    }
+  }
+  return true;
+#else
+  std::cerr << "PreviewControlGainsCache - memory-mapped files are not "
+               "supported, the gains will not be cached."
+            << std::endl;
+  return false;
+#endif /* HAVE_SYS_MMAN_H */
+}
+
+void PreviewControlGainsCache::Close() {
+#ifdef HAVE_SYS_MMAN_H
+  if (m_Data != 0)
+    munmap(m_Data, m_MappedSize);
+  if (m_FileDescriptor >= 0)
+    close(m_FileDescriptor);
+#endif /* HAVE_SYS_MMAN_H */
+  m_Data = 0;
+  m_MappedSize = 0;
+  m_FileDescriptor = -1;
+  m_FileName.clear();
+}
+
+bool PreviewControlGainsCache::Map(unsigned int aSize) {
+#ifdef HAVE_SYS_MMAN_H
+  if (m_Data != 0)
+    munmap(m_Data, m_MappedSize);
+  m_Data = 0;
+  m_MappedSize = 0;
+
+  void *lData = mmap(0, aSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     m_FileDescriptor, 0);
+  if (lData == MAP_FAILED) {
+    std::cerr << "PreviewControlGainsCache - Unable to map " << m_FileName
+              << std::endl;
+    return false;
+  }
+  m_Data = (char *)lData;
+  m_MappedSize = aSize;
+  return true;
+#else
+  (void)aSize;
+  return false;
+#endif /* HAVE_SYS_MMAN_H */
+}
+
+bool PreviewControlGainsCache::Reset() {
+#ifdef HAVE_SYS_MMAN_H
+  if (m_FileDescriptor < 0)
+    return false;
+  if (ftruncate(m_FileDescriptor, sizeof(FileHeader)) != 0)
+    return false;
+  if (!Map(sizeof(FileHeader)))
+    return false;
+
+  FileHeader *aHeader = (FileHeader *)m_Data;
+  memcpy(aHeader->Magic, PCGC_MAGIC, sizeof(PCGC_MAGIC));
+  aHeader->Version = PCGC_VERSION;
+  aHeader->NbOfEntries = 0;
+  aHeader->UsedBytes = sizeof(FileHeader);
+  aHeader->Reserved = 0;
+  msync(m_Data, m_MappedSize, MS_ASYNC);
+  return true;
+#else
+  return false;
+#endif /* HAVE_SYS_MMAN_H */
+}
+
+void PreviewControlGainsCache::Invalidate() {
+  if (IsOpen())
+    Reset();
+}
+
+unsigned int PreviewControlGainsCache::NbOfEntries() const {
+  if (!IsOpen())
+    return 0;
+  return ((const FileHeader *)m_Data)->NbOfEntries;
+}
+
+bool PreviewControlGainsCache::Find(double SamplingPeriod, double Zc,
+                                    double PreviewControlTime,
+                                    unsigned int Mode, Eigen::MatrixXd &Kx,
+                                    double &Ks, Eigen::MatrixXd &F) const {
+  if (!IsOpen())
+    return false;
+
+  const FileHeader *aHeader = (const FileHeader *)m_Data;
+  unsigned int lOffset = sizeof(FileHeader);
+  for (unsigned int i = 0; i < aHeader->NbOfEntries; i++) {
+    if (lOffset + sizeof(EntryHeader) > aHeader->UsedBytes)
+      return false;
+    const EntryHeader *anEntry = (const EntryHeader *)(m_Data + lOffset);
+    const double *lValues =
+        (const double *)(m_Data + lOffset + sizeof(EntryHeader));
+    unsigned int lEntrySize =
+        sizeof(EntryHeader) + (4 + anEntry->SizeOfF) * sizeof(double);
+    if (lOffset + lEntrySize > aHeader->UsedBytes)
+      return false;
+
+    if ((anEntry->SamplingPeriod == SamplingPeriod) && (anEntry->Zc == Zc) &&
+        (anEntry->PreviewControlTime == PreviewControlTime) &&
+        (anEntry->Mode == Mode)) {
+      Kx.resize(1, 3);
+      for (unsigned int j = 0; j < 3; j++)
+        Kx(0, j) = lValues[j];
+      Ks = lValues[3];
+      F.resize(anEntry->SizeOfF, 1);
+      for (unsigned int j = 0; j < anEntry->SizeOfF; j++)
+        F(j, 0) = lValues[4 + j];
+      return true;
+    }
+    lOffset += lEntrySize;
+  }
+  return false;
+}
+
+bool PreviewControlGainsCache::Store(double SamplingPeriod, double Zc,
+                                     double PreviewControlTime,
+                                     unsigned int Mode,
+                                     const Eigen::MatrixXd &Kx, double Ks,
+                                     const Eigen::MatrixXd &F) {
+#ifdef HAVE_SYS_MMAN_H
+  if (!IsOpen() || (Kx.size() != 3))
+    return false;
+
+  unsigned int SizeOfF = (unsigned int)F.rows();
+  unsigned int lEntrySize =
+      sizeof(EntryHeader) + (4 + SizeOfF) * sizeof(double);
+  unsigned int lOffset = ((FileHeader *)m_Data)->UsedBytes;
+  unsigned int lNewSize = lOffset + lEntrySize;
+
+  if (lNewSize > m_MappedSize) {
+    if (ftruncate(m_FileDescriptor, lNewSize) != 0)
+      return false;
+    if (!Map(lNewSize))
+      return false;
+  }
+
+  EntryHeader *anEntry = (EntryHeader *)(m_Data + lOffset);
+  anEntry->SamplingPeriod = SamplingPeriod;
+  anEntry->Zc = Zc;
+  anEntry->PreviewControlTime = PreviewControlTime;
+  anEntry->Mode = Mode;
+  anEntry->SizeOfF = SizeOfF;
+
+  double *lValues = (double *)(m_Data + lOffset + sizeof(EntryHeader));
+  for (unsigned int j = 0; j < 3; j++)
+    lValues[j] = Kx(0, j);
+  lValues[3] = Ks;
+  for (unsigned int j = 0; j < SizeOfF; j++)
+    lValues[4 + j] = F(j, 0);
+
+  // The header is updated last so that an interrupted write is ignored.
+  FileHeader *aHeader = (FileHeader *)m_Data;
+  aHeader->UsedBytes = lNewSize;
+  aHeader->NbOfEntries++;
+  msync(m_Data, m_MappedSize, MS_ASYNC);
+  return true;
+#else
+  (void)SamplingPeriod;
+  (void)Zc;
+  (void)PreviewControlTime;
+  (void)Mode;
+  (void)Kx;
+  (void)Ks;
+  (void)F;
+  return false;
+#endif /* HAVE_SYS_MMAN_H */
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/* \doc Persistent cache of the preview control gains. */
+#ifndef _PREVIEW_CONTROL_GAINS_CACHE_H_
+#define _PREVIEW_CONTROL_GAINS_CACHE_H_
+
+#include <string>
+
+#include <Eigen/Dense>
+
+namespace PatternGeneratorJRL {
+
+/** @ingroup previewcontrol
+
+    \brief Cache of the preview control gains \f$ K_x, K_s, F \f$ stored in
+    a memory-mapped file.
+
+    Solving the Riccati equation for a long preview window is the main
+    cost of the initialization of the preview controllers.
+    The gains only depend on the sampling period, the height of the CoM,
+    the preview control time and the weight computation mode, they are
+    therefore kept on disk for these keys and reused by the next sessions.
+    The cache has to be invalidated when the model behind the gains changes.
+
+    The file is not protected against concurrent writers,
+    it should not be shared by several processes at the same time.
+    Without mmap support the cache stays closed and nothing is stored.
+*/
+class PreviewControlGainsCache {
+public:
+  /*! \brief Default constructor */
+  PreviewControlGainsCache();
+
+  /*! \brief Destructor: unmap and close the file. */
+  ~PreviewControlGainsCache();
+
+  /*! \brief Map the file aFileName, it is created if needed.
+    Nothing is done if this file is already opened.
+    \return false if the file cannot be used. */
+  bool Open(const std::string &aFileName);
+
+  /*! \brief Unmap and close the file. */
+  void Close();
+
+  /*! \brief Returns true if a file is mapped. */
+  bool IsOpen() const;
+
+  /*! \brief Look for the gains associated with the key.
+    \return true if they have been found. */
+  bool Find(double SamplingPeriod, double Zc, double PreviewControlTime,
+            unsigned int Mode, Eigen::MatrixXd &Kx, double &Ks,
+            Eigen::MatrixXd &F) const;
+
+  /*! \brief Append the gains associated with the key.
+    \return false if they could not be written. */
+  bool Store(double SamplingPeriod, double Zc, double PreviewControlTime,
+             unsigned int Mode, const Eigen::MatrixXd &Kx, double Ks,
+             const Eigen::MatrixXd &F);
+
+  /*! \brief Remove all the entries, to be called when the robot
+    parameters change. */
+  void Invalidate();
+
+  /*! \brief Number of entries in the cache. */
+  unsigned int NbOfEntries() const;
+
+protected:
+  /*! \brief Header of the file. */
+  typedef struct {
+    char Magic[8];
+    unsigned int Version;
+    unsigned int NbOfEntries;
+    unsigned int UsedBytes;
+    unsigned int Reserved;
+  } FileHeader;
+
+  /*! \brief Header of one entry, followed by
+    Kx (3 values), Ks and F (SizeOfF values). */
+  typedef struct {
+    double SamplingPeriod;
+    double Zc;
+    double PreviewControlTime;
+    unsigned int Mode;
+    unsigned int SizeOfF;
+  } EntryHeader;
+
+  /*! \brief Map the first aSize bytes of the file. */
+  bool Map(unsigned int aSize);
+
+  /*! \brief Write an empty header. */
+  bool Reset();
+
+  /*! \brief Name of the mapped file. */
+  std::string m_FileName;
+
+  /*! \brief File descriptor, -1 if closed. */
+  int m_FileDescriptor;
+
+  /*! \brief Mapped memory. */
+  char *m_Data;
+
+  /*! \brief Size of the mapped memory. */
+  unsigned int m_MappedSize;
+};
+} // namespace PatternGeneratorJRL
+#endif /* _PREVIEW_CONTROL_GAINS_CACHE_H_ */
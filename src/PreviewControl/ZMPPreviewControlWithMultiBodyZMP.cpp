@@ -32,22 +32,32 @@
   and the desired ZMP based on a sequence of steps.
 */
 
+#include <stddef.h>
+#include <string.h>
+
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
 #include <Debug.hh>
 
+#include <MotionGeneration/ComAndFootRealizationByGeometry.hh>
 #include <PreviewControl/ZMPPreviewControlWithMultiBodyZMP.hh>
 
 using namespace PatternGeneratorJRL;
 
 ZMPPreviewControlWithMultiBodyZMP::ZMPPreviewControlWithMultiBodyZMP(
     SimplePluginManager *lSPM)
-    : SimplePlugin(lSPM) {
+    : SimplePlugin(lSPM), m_SecondStageJob(this), m_SetupDynamicsJob(this) {
 
   m_ComAndFootRealization = 0;
   m_PinocchioRobot = 0;
+  m_PipelinedStages = false;
+  m_CallerCPU = -1;
+  m_PipelinedRealization = 0;
+  m_AheadComputed = false;
+  m_BatchSetup = false;
+  m_SetupCache = false;
 
   m_StageStrategy = ZMPCOM_TRAJECTORY_FULL;
 
@@ -93,13 +103,16 @@ ZMPPreviewControlWithMultiBodyZMP::ZMPPreviewControlWithMultiBodyZMP(
   m_NumberOfIterations = 0;
 }
 
-ZMPPreviewControlWithMultiBodyZMP::~ZMPPreviewControlWithMultiBodyZMP() {}
+ZMPPreviewControlWithMultiBodyZMP::~ZMPPreviewControlWithMultiBodyZMP() {
+  m_Worker.stop();
+}
 
 void ZMPPreviewControlWithMultiBodyZMP::SetPreviewControl(PreviewControl *aPC) {
   m_PC = aPC;
   m_SamplingPeriod = m_PC->SamplingPeriod();
   m_PreviewControlTime = m_PC->PreviewControlTime();
   m_NL = (unsigned int)(m_PreviewControlTime / m_SamplingPeriod);
+  m_SetupStates.clear();
 }
 
 void ZMPPreviewControlWithMultiBodyZMP::CallToComAndFootRealization(
@@ -107,6 +120,36 @@ void ZMPPreviewControlWithMultiBodyZMP::CallToComAndFootRealization(
     FootAbsolutePosition &aRightFAP, Eigen::VectorXd &CurrentConfiguration,
     Eigen::VectorXd &CurrentVelocity, Eigen::VectorXd &CurrentAcceleration,
     unsigned long int IterationNumber, int StageOfTheAlgorithm) {
+  /* Get the current configuration vector */
+  CurrentConfiguration = m_PinocchioRobot->currentRPYConfiguration();
+
+  /* Get the current velocity vector */
+  CurrentVelocity = m_PinocchioRobot->currentRPYVelocity();
+
+  /* Get the current acceleration vector */
+  CurrentAcceleration = m_PinocchioRobot->currentRPYAcceleration();
+
+  RealizeCoMAndFeet(acomp, aLeftFAP, aRightFAP, CurrentConfiguration,
+                    CurrentVelocity, CurrentAcceleration, IterationNumber,
+                    StageOfTheAlgorithm);
+
+  if (StageOfTheAlgorithm == 0) {
+    /* Update the current configuration vector */
+    m_PinocchioRobot->currentRPYConfiguration(CurrentConfiguration);
+
+    /* Update the current velocity vector */
+    m_PinocchioRobot->currentRPYVelocity(CurrentVelocity);
+
+    /* Update the current acceleration vector */
+    m_PinocchioRobot->currentRPYAcceleration(CurrentAcceleration);
+  }
+}
+
+void ZMPPreviewControlWithMultiBodyZMP::RealizeCoMAndFeet(
+    COMState &acomp, FootAbsolutePosition &aLeftFAP,
+    FootAbsolutePosition &aRightFAP, Eigen::VectorXd &CurrentConfiguration,
+    Eigen::VectorXd &CurrentVelocity, Eigen::VectorXd &CurrentAcceleration,
+    unsigned long int IterationNumber, int StageOfTheAlgorithm) {
 
   // New scheme for WPG v3.0
   // We call the object in charge of generating the whole body
@@ -153,45 +196,24 @@ void ZMPPreviewControlWithMultiBodyZMP::CallToComAndFootRealization(
   aRightFootPosition(3) = aRightFAP.theta;
   aRightFootPosition(4) = aRightFAP.omega;
 
-  /* Get the current configuration vector */
-  CurrentConfiguration = m_PinocchioRobot->currentRPYConfiguration();
-
-  /* Get the current velocity vector */
-  CurrentVelocity = m_PinocchioRobot->currentRPYVelocity();
-
-  /* Get the current acceleration vector */
-  CurrentAcceleration = m_PinocchioRobot->currentRPYAcceleration();
-
   m_ComAndFootRealization->ComputePostureForGivenCoMAndFeetPosture(
       aCOMState, aCOMSpeed, aCOMAcc, aLeftFootPosition, aRightFootPosition,
       CurrentConfiguration, CurrentVelocity, CurrentAcceleration,
       IterationNumber, StageOfTheAlgorithm);
-
-  if (StageOfTheAlgorithm == 0) {
-    /* Update the current configuration vector */
-    m_PinocchioRobot->currentRPYConfiguration(CurrentConfiguration);
-
-    /* Update the current velocity vector */
-    m_PinocchioRobot->currentRPYVelocity(CurrentVelocity);
-
-    /* Update the current acceleration vector */
-    m_PinocchioRobot->currentRPYAcceleration(CurrentAcceleration);
-  }
 }
 
-/* Removed lqr and lql, now they should be set automatically by
-   m_ComAndFootRealization */
-int ZMPPreviewControlWithMultiBodyZMP::OneGlobalStepOfControl(
+void ZMPPreviewControlWithMultiBodyZMP::FirstStageAndPosture(
     FootAbsolutePosition &LeftFootPosition,
-    FootAbsolutePosition &RightFootPosition, ZMPPosition &,
-    COMState &refandfinalCOMState, Eigen::VectorXd &CurrentConfiguration,
-    Eigen::VectorXd &CurrentVelocity, Eigen::VectorXd &CurrentAcceleration) {
-  FirstStageOfControl(LeftFootPosition, RightFootPosition, refandfinalCOMState);
+    FootAbsolutePosition &RightFootPosition, COMState &afCOMState,
+    unsigned int Ahead, unsigned long int IterationNumber,
+    Eigen::VectorXd &CurrentConfiguration, Eigen::VectorXd &CurrentVelocity,
+    Eigen::VectorXd &CurrentAcceleration) {
+  FirstStageOfControl(LeftFootPosition, RightFootPosition, afCOMState);
   // This call is suppose to initialize
   // correctly the current configuration, speed and acceleration.
-  COMState acompos = m_FIFOCOMStates[m_NL];
-  FootAbsolutePosition aLeftFAP = m_FIFOLeftFootPosition[m_NL];
-  FootAbsolutePosition aRightFAP = m_FIFORightFootPosition[m_NL];
+  COMState acompos = m_FIFOCOMStates[m_NL + Ahead];
+  FootAbsolutePosition aLeftFAP = m_FIFOLeftFootPosition[m_NL + Ahead];
+  FootAbsolutePosition aRightFAP = m_FIFORightFootPosition[m_NL + Ahead];
 
   ODEBUG4SIMPLE(m_FIFOZMPRefPositions[0].px
                     << " " << m_FIFOZMPRefPositions[0].py << " "
@@ -204,13 +226,26 @@ int ZMPPreviewControlWithMultiBodyZMP::OneGlobalStepOfControl(
   int StageOfTheAlgorithm = 0;
   CallToComAndFootRealization(
       acompos, aLeftFAP, aRightFAP, CurrentConfiguration, CurrentVelocity,
-      CurrentAcceleration, m_NumberOfIterations, StageOfTheAlgorithm);
+      CurrentAcceleration, IterationNumber, StageOfTheAlgorithm);
+}
+
+/* Removed lqr and lql, now they should be set automatically by
+   m_ComAndFootRealization */
+int ZMPPreviewControlWithMultiBodyZMP::OneGlobalStepOfControl(
+    FootAbsolutePosition &LeftFootPosition,
+    FootAbsolutePosition &RightFootPosition, ZMPPosition &,
+    COMState &refandfinalCOMState, Eigen::VectorXd &CurrentConfiguration,
+    Eigen::VectorXd &CurrentVelocity, Eigen::VectorXd &CurrentAcceleration) {
+  FirstStageAndPosture(LeftFootPosition, RightFootPosition,
+                       refandfinalCOMState, 0, m_NumberOfIterations,
+                       CurrentConfiguration, CurrentVelocity,
+                       CurrentAcceleration);
 
   if (m_StageStrategy != ZMPCOM_TRAJECTORY_FIRST_STAGE_ONLY)
     EvaluateMultiBodyZMP(-1);
 
-  aLeftFAP = m_FIFOLeftFootPosition[0];
-  aRightFAP = m_FIFORightFootPosition[0];
+  FootAbsolutePosition aLeftFAP = m_FIFOLeftFootPosition[0];
+  FootAbsolutePosition aRightFAP = m_FIFORightFootPosition[0];
 
   SecondStageOfControl(refandfinalCOMState);
 
@@ -230,6 +265,231 @@ int ZMPPreviewControlWithMultiBodyZMP::OneGlobalStepOfControl(
         StageOfTheAlgorithm);
   }
 
+  UpdateFinalDesiredCOMPose(CurrentConfiguration, refandfinalCOMState);
+
+  ODEBUG4SIMPLE(
+      CurrentConfiguration[6]
+          << " " << CurrentConfiguration[7] << " " << CurrentConfiguration[8]
+          << " " << CurrentConfiguration[9] << " " << CurrentConfiguration[10]
+          << " " << CurrentConfiguration[11] << " " << CurrentConfiguration[12]
+          << " " << CurrentConfiguration[13] << " " << CurrentConfiguration[14]
+          << " " << CurrentConfiguration[15] << " " << CurrentConfiguration[16]
+          << " " << CurrentConfiguration[17] << " " << CurrentConfiguration[18]
+          << " ",
+      "DebugDataqrql.txt");
+  m_NumberOfIterations++;
+
+  return 1;
+}
+
+namespace {
+/* The inputs are compared bitwise: the first stage computed ahead is
+   kept only if it is exactly the one of the sequential stages. */
+bool SameZMPPosition(const ZMPPosition &a, const ZMPPosition &b) {
+  return (memcmp(&a, &b, offsetof(ZMPPosition, stepType)) == 0) &&
+         (a.stepType == b.stepType);
+}
+
+bool SameFootPosition(const FootAbsolutePosition &a,
+                      const FootAbsolutePosition &b) {
+  return (memcmp(&a, &b, offsetof(FootAbsolutePosition, stepType)) == 0) &&
+         (a.stepType == b.stepType);
+}
+
+/* The references of a setup are compared without their times. */
+bool SameZMPReference(const ZMPPosition &a, const ZMPPosition &b) {
+  return (memcmp(&a, &b, offsetof(ZMPPosition, time)) == 0) &&
+         (a.stepType == b.stepType);
+}
+
+bool SameFootReference(const FootAbsolutePosition &a,
+                       const FootAbsolutePosition &b) {
+  return (memcmp(&a, &b, offsetof(FootAbsolutePosition, time)) == 0) &&
+         (a.stepType == b.stepType);
+}
+
+bool SameCOMState(const COMState &a, const COMState &b) {
+  return (memcmp(a.x, b.x, 3 * sizeof(double)) == 0) &&
+         (memcmp(a.y, b.y, 3 * sizeof(double)) == 0) &&
+         (memcmp(a.z, b.z, 3 * sizeof(double)) == 0) &&
+         (memcmp(a.yaw, b.yaw, 3 * sizeof(double)) == 0) &&
+         (memcmp(a.pitch, b.pitch, 3 * sizeof(double)) == 0) &&
+         (memcmp(a.roll, b.roll, 3 * sizeof(double)) == 0);
+}
+} // namespace
+
+int ZMPPreviewControlWithMultiBodyZMP::OneGlobalStepOfControl(
+    FootAbsolutePosition &LeftFootPosition,
+    FootAbsolutePosition &RightFootPosition, ZMPPosition &NewZMPRefPos,
+    COMState &refandfinalCOMState, Eigen::VectorXd &CurrentConfiguration,
+    Eigen::VectorXd &CurrentVelocity, Eigen::VectorXd &CurrentAcceleration,
+    const ZMPPosition *NextZMPRefPos,
+    const FootAbsolutePosition *NextLeftFootPosition,
+    const FootAbsolutePosition *NextRightFootPosition,
+    const COMState *NextCOMState) {
+  if (m_AheadComputed &&
+      (!m_PipelinedStages || (m_StageStrategy != ZMPCOM_TRAJECTORY_FULL) ||
+       !SameZMPPosition(m_AheadZMPRef, NewZMPRefPos) ||
+       !SameFootPosition(m_AheadLeftFoot, LeftFootPosition) ||
+       !SameFootPosition(m_AheadRightFoot, RightFootPosition) ||
+       !SameCOMState(m_AheadCOMState, refandfinalCOMState)))
+    UndoAheadFirstStage();
+
+  if (!m_PipelinedStages || (m_StageStrategy != ZMPCOM_TRAJECTORY_FULL)) {
+    UpdateTheZMPRefQueue(NewZMPRefPos);
+    return OneGlobalStepOfControl(LeftFootPosition, RightFootPosition,
+                                  NewZMPRefPos, refandfinalCOMState,
+                                  CurrentConfiguration, CurrentVelocity,
+                                  CurrentAcceleration);
+  }
+
+  // First stage of the current sample, unless it has been computed
+  // by the previous call.
+  if (!m_AheadComputed) {
+    UpdateTheZMPRefQueue(NewZMPRefPos);
+    FirstStageAndPosture(LeftFootPosition, RightFootPosition,
+                         refandfinalCOMState, 0, m_NumberOfIterations,
+                         CurrentConfiguration, CurrentVelocity,
+                         CurrentAcceleration);
+  }
+  m_AheadComputed = false;
+
+  // The worker thread computes the multibody ZMP of the first stage
+  // and the second preview control.
+  m_WorkerConfiguration = m_PinocchioRobot->currentRPYConfiguration();
+  m_WorkerVelocity = m_PinocchioRobot->currentRPYVelocity();
+  m_WorkerAcceleration = m_PinocchioRobot->currentRPYAcceleration();
+  m_WorkerZMPRef = m_FIFOZMPRefPositions[0];
+  m_StartingNewSequence = false;
+  if (!m_Worker.pinCaller(m_CallerCPU))
+    ODEBUG("The control thread cannot be pinned.");
+  m_Worker.start(&m_SecondStageJob);
+
+  // Meanwhile the first stage of the next sample is computed.
+  if ((NextZMPRefPos != 0) && (NextLeftFootPosition != 0) &&
+      (NextRightFootPosition != 0) && (NextCOMState != 0)) {
+    m_AheadZMPRef = *NextZMPRefPos;
+    m_AheadLeftFoot = *NextLeftFootPosition;
+    m_AheadRightFoot = *NextRightFootPosition;
+    m_AheadCOMState = *NextCOMState;
+
+    m_UndoPC1x = m_PC1x;
+    m_UndoPC1y = m_PC1y;
+    m_UndoSxzmp = m_sxzmp;
+    m_UndoSyzmp = m_syzmp;
+    m_UndoZMPRef = m_FIFOZMPRefPositions[0];
+    m_UndoPrevConfiguration =
+        m_PipelinedRealization->GetPreviousConfigurationStage0();
+    m_UndoPrevVelocity = m_PipelinedRealization->GetPreviousVelocityStage0();
+
+    COMState aCOMState = m_AheadCOMState;
+    UpdateTheZMPRefQueue(m_AheadZMPRef);
+    FirstStageAndPosture(m_AheadLeftFoot, m_AheadRightFoot, aCOMState, 1,
+                         m_NumberOfIterations + 1, m_AheadConfiguration,
+                         m_AheadVelocity, m_AheadAcceleration);
+    m_AheadComputed = true;
+  }
+  m_Worker.wait();
+
+  FootAbsolutePosition aLeftFAP = m_FIFOLeftFootPosition[0];
+  FootAbsolutePosition aRightFAP = m_FIFORightFootPosition[0];
+  CorrectCoMOfTheFirstStage(refandfinalCOMState);
+
+  // The second stage starts from the posture of the first stage
+  // of the current sample.
+  CurrentConfiguration = m_WorkerConfiguration;
+  CurrentVelocity = m_WorkerVelocity;
+  CurrentAcceleration = m_WorkerAcceleration;
+  RealizeCoMAndFeet(refandfinalCOMState, aLeftFAP, aRightFAP,
+                    CurrentConfiguration, CurrentVelocity, CurrentAcceleration,
+                    m_NumberOfIterations - m_NL, 1);
+
+  UpdateFinalDesiredCOMPose(CurrentConfiguration, refandfinalCOMState);
+  m_NumberOfIterations++;
+
+  return 1;
+}
+
+void ZMPPreviewControlWithMultiBodyZMP::MultiBodyZMPAndSecondPreview() {
+  PRWorkspace &aWorkspace = m_WorkerData.workspace(0);
+  m_PinocchioRobot->computeInverseDynamics(
+      m_WorkerConfiguration, m_WorkerVelocity, m_WorkerAcceleration,
+      aWorkspace);
+
+  Eigen::Vector3d ZMPmultibody;
+  m_PinocchioRobot->zeroMomentumPoint(aWorkspace, ZMPmultibody);
+  ODEBUG5(ZMPmultibody[0] << " " << ZMPmultibody[1] << " "
+                          << m_WorkerZMPRef.px << " " << m_WorkerZMPRef.py,
+          "DebugDataCheckZMP1.txt");
+
+  PushDeltaZMP(m_WorkerZMPRef, ZMPmultibody);
+  SecondPreviewOfControl();
+}
+
+void ZMPPreviewControlWithMultiBodyZMP::UndoAheadFirstStage() {
+  if (!m_AheadComputed)
+    return;
+
+  m_PC1x = m_UndoPC1x;
+  m_PC1y = m_UndoPC1y;
+  m_sxzmp = m_UndoSxzmp;
+  m_syzmp = m_UndoSyzmp;
+
+  m_FIFOZMPRefPositions.pop_back();
+  m_FIFOZMPRefPositions.push_front(m_UndoZMPRef);
+  m_FIFOCOMStates.pop_back();
+  m_FIFOLeftFootPosition.pop_back();
+  m_FIFORightFootPosition.pop_back();
+
+  // The posture of the first stage of the current sample.
+  m_PinocchioRobot->currentRPYConfiguration(m_WorkerConfiguration);
+  m_PinocchioRobot->currentRPYVelocity(m_WorkerVelocity);
+  m_PinocchioRobot->currentRPYAcceleration(m_WorkerAcceleration);
+  m_PipelinedRealization->SetPreviousConfigurationStage0(
+      m_UndoPrevConfiguration);
+  m_PipelinedRealization->SetPreviousVelocityStage0(m_UndoPrevVelocity);
+
+  m_AheadComputed = false;
+}
+
+bool ZMPPreviewControlWithMultiBodyZMP::SetPipelinedStages(
+    bool PipelinedStages, int CallerCPU, int WorkerCPU) {
+  UndoAheadFirstStage();
+  m_Worker.stop();
+  m_PipelinedStages = false;
+  if (!PipelinedStages)
+    return true;
+
+  m_PipelinedRealization =
+      dynamic_cast<ComAndFootRealizationByGeometry *>(m_ComAndFootRealization);
+  if ((m_PinocchioRobot == 0) || (m_PipelinedRealization == 0) ||
+      (m_StageStrategy != ZMPCOM_TRAJECTORY_FULL)) {
+    std::cerr << "The stages of the preview control cannot be pipelined."
+              << std::endl;
+    return false;
+  }
+
+  if (m_WorkerData.size() < 1)
+    m_WorkerData.resize(*m_PinocchioRobot, 1);
+  m_WorkerConfiguration = m_PinocchioRobot->currentRPYConfiguration();
+  m_WorkerVelocity = m_PinocchioRobot->currentRPYVelocity();
+  m_WorkerAcceleration = m_PinocchioRobot->currentRPYAcceleration();
+  m_AheadConfiguration = m_WorkerConfiguration;
+  m_AheadVelocity = m_WorkerVelocity;
+  m_AheadAcceleration = m_WorkerAcceleration;
+  m_UndoPrevConfiguration = m_WorkerConfiguration;
+  m_UndoPrevVelocity = m_WorkerVelocity;
+
+  m_CallerCPU = CallerCPU;
+  if (!m_Worker.create(WorkerCPU)) {
+    ODEBUG("No worker thread: the stages are computed in sequence.");
+  }
+  m_PipelinedStages = true;
+  return true;
+}
+
+void ZMPPreviewControlWithMultiBodyZMP::UpdateFinalDesiredCOMPose(
+    Eigen::VectorXd &CurrentConfiguration, COMState &finalCOMState) {
   // Here it is assumed that the 4x4 CoM matrix
   // is the orientation of the free flyer and
   // its position.
@@ -252,24 +512,10 @@ int ZMPPreviewControlWithMultiBodyZMP::OneGlobalStepOfControl(
   m_FinalDesiredCOMPose(2, 1) = 0;
   m_FinalDesiredCOMPose(2, 2) = co;
 
-  m_FinalDesiredCOMPose(0, 3) = refandfinalCOMState.x[0];
-  m_FinalDesiredCOMPose(1, 3) = refandfinalCOMState.y[0];
-  m_FinalDesiredCOMPose(2, 3) = refandfinalCOMState.z[0];
+  m_FinalDesiredCOMPose(0, 3) = finalCOMState.x[0];
+  m_FinalDesiredCOMPose(1, 3) = finalCOMState.y[0];
+  m_FinalDesiredCOMPose(2, 3) = finalCOMState.z[0];
   m_FinalDesiredCOMPose(3, 3) = 1.0;
-
-  ODEBUG4SIMPLE(
-      CurrentConfiguration[6]
-          << " " << CurrentConfiguration[7] << " " << CurrentConfiguration[8]
-          << " " << CurrentConfiguration[9] << " " << CurrentConfiguration[10]
-          << " " << CurrentConfiguration[11] << " " << CurrentConfiguration[12]
-          << " " << CurrentConfiguration[13] << " " << CurrentConfiguration[14]
-          << " " << CurrentConfiguration[15] << " " << CurrentConfiguration[16]
-          << " " << CurrentConfiguration[17] << " " << CurrentConfiguration[18]
-          << " ",
-      "DebugDataqrql.txt");
-  m_NumberOfIterations++;
-
-  return 1;
 }
 
 COMState ZMPPreviewControlWithMultiBodyZMP::GetLastCOMFromFirstStage() {
@@ -280,31 +526,39 @@ COMState ZMPPreviewControlWithMultiBodyZMP::GetLastCOMFromFirstStage() {
 
 int ZMPPreviewControlWithMultiBodyZMP::SecondStageOfControl(
     COMState &finalCOMState) {
-  // Inverse Kinematics variables.
-
-  COMState aCOMState = m_FIFOCOMStates[0];
-  FootAbsolutePosition LeftFootPosition, RightFootPosition;
+  // Preview control on delta ZMP.
+  if ((m_StageStrategy == ZMPCOM_TRAJECTORY_SECOND_STAGE_ONLY) ||
+      (m_StageStrategy == ZMPCOM_TRAJECTORY_FULL))
+    SecondPreviewOfControl();
 
-  LeftFootPosition = m_FIFOLeftFootPosition[0];
-  RightFootPosition = m_FIFORightFootPosition[0];
+  CorrectCoMOfTheFirstStage(finalCOMState);
+  ODEBUG2("End");
+  return 1;
+}
 
+void ZMPPreviewControlWithMultiBodyZMP::SecondPreviewOfControl() {
   double Deltazmpx2, Deltazmpy2;
 
-  // Preview control on delta ZMP.
-  if ((m_StageStrategy == ZMPCOM_TRAJECTORY_SECOND_STAGE_ONLY) ||
-      (m_StageStrategy == ZMPCOM_TRAJECTORY_FULL)) {
-    ODEBUG2(m_FIFODeltaZMPPositions[0].px << " "
-                                          << m_FIFODeltaZMPPositions[0].py);
+  ODEBUG2(m_FIFODeltaZMPPositions[0].px << " "
+                                        << m_FIFODeltaZMPPositions[0].py);
+
+  ODEBUG("Second Stage Size of FIFODeltaZMPPositions: "
+         << m_FIFODeltaZMPPositions.size() << " " << m_Deltax << " "
+         << m_Deltay << " " << m_sxDeltazmp << " " << m_syDeltazmp);
 
-    ODEBUG("Second Stage Size of FIFODeltaZMPPositions: "
-           << m_FIFODeltaZMPPositions.size() << " " << m_Deltax << " "
-           << m_Deltay << " " << m_sxDeltazmp << " " << m_syDeltazmp << " "
-           << Deltazmpx2 << " " << Deltazmpy2);
+  m_PC->OneIterationOfPreview(m_Deltax, m_Deltay, m_sxDeltazmp, m_syDeltazmp,
+                              m_FIFODeltaZMPPositions, 0, Deltazmpx2,
+                              Deltazmpy2, true);
 
-    m_PC->OneIterationOfPreview(m_Deltax, m_Deltay, m_sxDeltazmp, m_syDeltazmp,
-                                m_FIFODeltaZMPPositions, 0, Deltazmpx2,
-                                Deltazmpy2, true);
+  m_FIFODeltaZMPPositions.pop_front();
+}
 
+void ZMPPreviewControlWithMultiBodyZMP::CorrectCoMOfTheFirstStage(
+    COMState &finalCOMState) {
+  COMState aCOMState = m_FIFOCOMStates[0];
+
+  if ((m_StageStrategy == ZMPCOM_TRAJECTORY_SECOND_STAGE_ONLY) ||
+      (m_StageStrategy == ZMPCOM_TRAJECTORY_FULL)) {
     // Correct COM position
     // but be carefull this is the COM for NL steps behind.
     for (int i = 0; i < 3; i++) {
@@ -318,17 +572,9 @@ int ZMPPreviewControlWithMultiBodyZMP::SecondStageOfControl(
   // Update finalCOMState
   finalCOMState = aCOMState;
 
-  if ((m_StageStrategy == ZMPCOM_TRAJECTORY_SECOND_STAGE_ONLY) ||
-      (m_StageStrategy == ZMPCOM_TRAJECTORY_FULL)) {
-
-    m_FIFODeltaZMPPositions.pop_front();
-  }
   m_FIFOCOMStates.pop_front();
   m_FIFOLeftFootPosition.pop_front();
   m_FIFORightFootPosition.pop_front();
-
-  ODEBUG2("End");
-  return 1;
 }
 
 int ZMPPreviewControlWithMultiBodyZMP::FirstStageOfControl(
@@ -407,33 +653,33 @@ int ZMPPreviewControlWithMultiBodyZMP::EvaluateMultiBodyZMP(
                           << m_FIFOZMPRefPositions[0].py,
           "DebugDataCheckZMP1.txt");
 
-  Eigen::Vector3d CoMmultibody;
-  m_PinocchioRobot->positionCenterOfMass(CoMmultibody);
   ODEBUG("Stage 2");
   // Fill the delta ZMP FIFO for the second stage of the control.
+  PushDeltaZMP(m_FIFOZMPRefPositions[0], ZMPmultibody);
+  m_StartingNewSequence = false;
+  ODEBUG("Final");
+  return 1;
+}
+
+void ZMPPreviewControlWithMultiBodyZMP::PushDeltaZMP(
+    const ZMPPosition &aZMPRef, const Eigen::Vector3d &ZMPmultibody) {
   ZMPPosition aZMPpos;
-  aZMPpos.px = m_FIFOZMPRefPositions[0].px - ZMPmultibody[0];
-  aZMPpos.py = m_FIFOZMPRefPositions[0].py - ZMPmultibody[1];
+  aZMPpos.px = aZMPRef.px - ZMPmultibody[0];
+  aZMPpos.py = aZMPRef.py - ZMPmultibody[1];
   aZMPpos.pz = 0.0;
   aZMPpos.theta = 0.0;
   aZMPpos.stepType = 1;
-  aZMPpos.time = m_FIFOZMPRefPositions[0].time;
-  ODEBUG("Stage 3");
-  Eigen::VectorXd CurrentConfiguration;
-  /* Get the current configuration vector */
-  CurrentConfiguration = m_PinocchioRobot->currentRPYConfiguration();
-
-  ODEBUG("Stage 4");
+  aZMPpos.time = aZMPRef.time;
   m_FIFODeltaZMPPositions.push_back(aZMPpos);
-  m_StartingNewSequence = false;
-  ODEBUG("Final");
-  return 1;
 }
 
 int ZMPPreviewControlWithMultiBodyZMP::Setup(
     deque<ZMPPosition> &ZMPRefPositions, deque<COMState> &COMStates,
     deque<FootAbsolutePosition> &LeftFootPositions,
     deque<FootAbsolutePosition> &RightFootPositions) {
+  // A first stage computed ahead belongs to the previous motion.
+  UndoAheadFirstStage();
+
   m_NumberOfIterations = 0;
   Eigen::VectorXd CurrentConfiguration =
       m_PinocchioRobot->currentRPYConfiguration();
@@ -443,16 +689,252 @@ int ZMPPreviewControlWithMultiBodyZMP::Setup(
 
   m_PC->ComputeOptimalWeights(OptimalControllerSolver::MODE_WITHOUT_INITIALPOS);
 
-  SetupFirstPhase(ZMPRefPositions, COMStates, LeftFootPositions,
-                  RightFootPositions);
-  for (unsigned int i = 0; i < m_NL; i++)
-    SetupIterativePhase(ZMPRefPositions, COMStates, LeftFootPositions,
-                        RightFootPositions, CurrentConfiguration,
-                        CurrentVelocity, CurrentAcceleration, i);
+  SetupInputs_t aInputs;
+  bool KeepSetup = m_SetupCache &&
+                   GetSetupInputs(ZMPRefPositions, COMStates, LeftFootPositions,
+                                  RightFootPositions, aInputs);
+  if (KeepSetup && FindSetupState(aInputs, ZMPRefPositions, LeftFootPositions,
+                                  RightFootPositions))
+    return 0;
+
+  if (m_BatchSetup)
+    SetupInBatch(ZMPRefPositions, COMStates, LeftFootPositions,
+                 RightFootPositions);
+  else {
+    SetupFirstPhase(ZMPRefPositions, COMStates, LeftFootPositions,
+                    RightFootPositions);
+    for (unsigned int i = 0; i < m_NL; i++)
+      SetupIterativePhase(ZMPRefPositions, COMStates, LeftFootPositions,
+                          RightFootPositions, CurrentConfiguration,
+                          CurrentVelocity, CurrentAcceleration, i);
+  }
   ODEBUG4("<========================================>", "ZMPPCWMZOGSOC.dat");
+
+  if (KeepSetup)
+    StoreSetupState(aInputs);
   return 0;
 }
 
+void ZMPPreviewControlWithMultiBodyZMP::SetupInBatch(
+    deque<ZMPPosition> &ZMPRefPositions, deque<COMState> &COMStates,
+    deque<FootAbsolutePosition> &LeftFootPositions,
+    deque<FootAbsolutePosition> &RightFootPositions) {
+  SetupFirstPhase(ZMPRefPositions, COMStates, LeftFootPositions,
+                  RightFootPositions);
+
+  // The first stage does not depend on the postures: its preview
+  // control is run over the whole window, with the references of
+  // SetupIterativePhase.
+  m_SetupZMPRefs.resize(m_NL);
+  for (unsigned int i = 0; i < m_NL; i++) {
+    FirstStageOfControl(LeftFootPositions[i], RightFootPositions[i],
+                        COMStates[i]);
+    m_SetupZMPRefs[i] = m_FIFOZMPRefPositions[0];
+    m_FIFOZMPRefPositions.push_back(ZMPRefPositions[i + 1 + m_NL]);
+  }
+
+  // The velocities and accelerations of a posture may be the finite
+  // differences with the previous one: the postures are computed in
+  // sequence.
+  m_SetupConfigurations.resize(m_NL);
+  m_SetupVelocities.resize(m_NL);
+  m_SetupAccelerations.resize(m_NL);
+  m_SetupZMPs.resize(m_NL);
+  for (unsigned int i = 0; i < m_NL; i++) {
+    CallToComAndFootRealization(
+        m_FIFOCOMStates[i], m_FIFOLeftFootPosition[i],
+        m_FIFORightFootPosition[i], m_SetupConfigurations[i],
+        m_SetupVelocities[i], m_SetupAccelerations[i], m_NumberOfIterations,
+        0);
+    m_NumberOfIterations++;
+  }
+
+  // The multibody ZMPs are independent: the second half of the window
+  // is given to the worker thread.
+  if (m_WorkerData.size() < 2)
+    m_WorkerData.resize(*m_PinocchioRobot, 2);
+  m_SetupDynamicsJob.m_Begin = m_NL / 2;
+  m_SetupDynamicsJob.m_End = m_NL;
+  m_Worker.start(&m_SetupDynamicsJob);
+  SetupDynamics(0, m_NL / 2, 0);
+  m_Worker.wait();
+
+  for (unsigned int i = 0; i < m_NL; i++) {
+    ODEBUG5(m_SetupZMPs[i][0] << " " << m_SetupZMPs[i][1] << " "
+                              << m_SetupZMPRefs[i].px << " "
+                              << m_SetupZMPRefs[i].py,
+            "DebugDataCheckZMP1.txt");
+    PushDeltaZMP(m_SetupZMPRefs[i], m_SetupZMPs[i]);
+  }
+  m_StartingNewSequence = false;
+}
+
+void ZMPPreviewControlWithMultiBodyZMP::SetupDynamics(unsigned int Begin,
+                                                      unsigned int End,
+                                                      std::size_t Workspace) {
+  PRWorkspace &aWorkspace = m_WorkerData.workspace(Workspace);
+  for (unsigned int i = Begin; i < End; i++) {
+    m_PinocchioRobot->computeInverseDynamics(
+        m_SetupConfigurations[i], m_SetupVelocities[i],
+        m_SetupAccelerations[i], aWorkspace);
+    m_PinocchioRobot->zeroMomentumPoint(aWorkspace, m_SetupZMPs[i]);
+  }
+}
+
+bool ZMPPreviewControlWithMultiBodyZMP::GetSetupInputs(
+    deque<ZMPPosition> &ZMPRefPositions, deque<COMState> &COMStates,
+    deque<FootAbsolutePosition> &LeftFootPositions,
+    deque<FootAbsolutePosition> &RightFootPositions, SetupInputs_t &aInputs) {
+  ComAndFootRealizationByGeometry *aRealization =
+      dynamic_cast<ComAndFootRealizationByGeometry *>(m_ComAndFootRealization);
+  if ((aRealization == 0) || (ZMPRefPositions.size() <= 2 * m_NL) ||
+      (COMStates.size() < m_NL) || (LeftFootPositions.size() < m_NL) ||
+      (RightFootPositions.size() < m_NL))
+    return false;
+
+  aInputs.ZMPRefPositions.assign(ZMPRefPositions.begin(),
+                                 ZMPRefPositions.begin() + 2 * m_NL + 1);
+  aInputs.COMStates.assign(COMStates.begin(), COMStates.begin() + m_NL);
+  aInputs.LeftFootPositions.assign(LeftFootPositions.begin(),
+                                   LeftFootPositions.begin() + m_NL);
+  aInputs.RightFootPositions.assign(RightFootPositions.begin(),
+                                    RightFootPositions.begin() + m_NL);
+  aInputs.Configuration = m_PinocchioRobot->currentRPYConfiguration();
+  aInputs.Velocity = m_PinocchioRobot->currentRPYVelocity();
+  aInputs.Acceleration = m_PinocchioRobot->currentRPYAcceleration();
+  aInputs.PrevConfiguration = aRealization->GetPreviousConfigurationStage0();
+  aInputs.PrevVelocity = aRealization->GetPreviousVelocityStage0();
+  aInputs.StartingCOMState = m_StartingCOMState;
+  StepStackHandler *aStepStackHandler =
+      m_ComAndFootRealization->GetStepStackHandler();
+  aInputs.WalkMode =
+      (aStepStackHandler != 0) ? aStepStackHandler->GetWalkMode() : 0;
+  aInputs.GainFactor = aRealization->GainFactor();
+  aInputs.UpperBodyMotion = aRealization->UpperBodyMotionParameters();
+  aInputs.AnalyticalDerivatives = aRealization->AnalyticalDerivatives();
+  return true;
+}
+
+namespace {
+bool SameVector(const Eigen::VectorXd &a, const Eigen::VectorXd &b) {
+  return (a.size() == b.size()) && (a.array() == b.array()).all();
+}
+} // namespace
+
+bool ZMPPreviewControlWithMultiBodyZMP::SameSetupInputs(
+    const SetupInputs_t &a, const SetupInputs_t &b) {
+  if (!SameVector(a.Configuration, b.Configuration) ||
+      !SameVector(a.Velocity, b.Velocity) ||
+      !SameVector(a.Acceleration, b.Acceleration) ||
+      !SameVector(a.PrevConfiguration, b.PrevConfiguration) ||
+      !SameVector(a.PrevVelocity, b.PrevVelocity) ||
+      (a.StartingCOMState.array() != b.StartingCOMState.array()).any() ||
+      (a.WalkMode != b.WalkMode) || (a.GainFactor != b.GainFactor) ||
+      (a.UpperBodyMotion != b.UpperBodyMotion) ||
+      (a.AnalyticalDerivatives != b.AnalyticalDerivatives) ||
+      (a.ZMPRefPositions.size() != b.ZMPRefPositions.size()) ||
+      (a.COMStates.size() != b.COMStates.size()))
+    return false;
+
+  for (unsigned int i = 0; i < a.ZMPRefPositions.size(); i++)
+    if (!SameZMPReference(a.ZMPRefPositions[i], b.ZMPRefPositions[i]))
+      return false;
+  for (unsigned int i = 0; i < a.COMStates.size(); i++)
+    if (!SameCOMState(a.COMStates[i], b.COMStates[i]) ||
+        !SameFootReference(a.LeftFootPositions[i], b.LeftFootPositions[i]) ||
+        !SameFootReference(a.RightFootPositions[i], b.RightFootPositions[i]))
+      return false;
+  return true;
+}
+
+bool ZMPPreviewControlWithMultiBodyZMP::FindSetupState(
+    const SetupInputs_t &aInputs, deque<ZMPPosition> &ZMPRefPositions,
+    deque<FootAbsolutePosition> &LeftFootPositions,
+    deque<FootAbsolutePosition> &RightFootPositions) {
+  ComAndFootRealizationByGeometry *aRealization =
+      dynamic_cast<ComAndFootRealizationByGeometry *>(m_ComAndFootRealization);
+
+  unsigned int k = 0;
+  while ((k < m_SetupStates.size()) &&
+         !SameSetupInputs(m_SetupStates[k].Inputs, aInputs))
+    k++;
+  if (k == m_SetupStates.size())
+    return false;
+  SetupState_t &aState = m_SetupStates[k];
+
+  // The queues of the references are filled as by the setup, with the
+  // times of the current references.
+  m_FIFOZMPRefPositions.resize(m_NL);
+  m_FIFOLeftFootPosition.resize(m_NL);
+  m_FIFORightFootPosition.resize(m_NL);
+  for (unsigned int i = 0; i < m_NL; i++) {
+    m_FIFOZMPRefPositions[i] = ZMPRefPositions[i];
+    m_FIFOLeftFootPosition[i] = LeftFootPositions[i];
+    m_FIFORightFootPosition[i] = RightFootPositions[i];
+  }
+  m_FIFODeltaZMPPositions = aState.FIFODeltaZMPPositions;
+  for (unsigned int i = 0; i < m_NL; i++) {
+    m_FIFOZMPRefPositions.pop_front();
+    m_FIFODeltaZMPPositions[i].time = m_FIFOZMPRefPositions[0].time;
+    m_FIFOZMPRefPositions.push_back(ZMPRefPositions[i + 1 + m_NL]);
+    m_FIFOLeftFootPosition.push_back(LeftFootPositions[i]);
+    m_FIFORightFootPosition.push_back(RightFootPositions[i]);
+  }
+  m_FIFOCOMStates = aState.FIFOCOMStates;
+
+  m_PC1x = aState.PC1x;
+  m_PC1y = aState.PC1y;
+  m_sxzmp = aState.sxzmp;
+  m_syzmp = aState.syzmp;
+  m_Deltax.setZero();
+  m_Deltay.setZero();
+  m_sxDeltazmp = 0.0;
+  m_syDeltazmp = 0.0;
+  m_StartingNewSequence = false;
+  m_NumberOfIterations = m_NL;
+
+  m_PinocchioRobot->currentRPYConfiguration(aState.FinalConfiguration);
+  m_PinocchioRobot->currentRPYVelocity(aState.FinalVelocity);
+  m_PinocchioRobot->currentRPYAcceleration(aState.FinalAcceleration);
+  aRealization->SetPreviousConfigurationStage0(aState.PrevConfiguration);
+  aRealization->SetPreviousVelocityStage0(aState.PrevVelocity);
+#ifdef _DEBUG_MODE_ON_
+  m_FIFOTmpZMPPosition.clear();
+#endif
+  return true;
+}
+
+void ZMPPreviewControlWithMultiBodyZMP::StoreSetupState(
+    const SetupInputs_t &aInputs) {
+  ComAndFootRealizationByGeometry *aRealization =
+      dynamic_cast<ComAndFootRealizationByGeometry *>(m_ComAndFootRealization);
+
+  // The oldest state is replaced.
+  const unsigned int NbSetupStates = 4;
+  if (m_SetupStates.size() == NbSetupStates)
+    m_SetupStates.erase(m_SetupStates.begin());
+  m_SetupStates.push_back(SetupState_t());
+  SetupState_t &aState = m_SetupStates.back();
+
+  aState.Inputs = aInputs;
+  aState.FIFOCOMStates = m_FIFOCOMStates;
+  aState.FIFODeltaZMPPositions = m_FIFODeltaZMPPositions;
+  aState.PC1x = m_PC1x;
+  aState.PC1y = m_PC1y;
+  aState.sxzmp = m_sxzmp;
+  aState.syzmp = m_syzmp;
+  aState.FinalConfiguration = m_PinocchioRobot->currentRPYConfiguration();
+  aState.FinalVelocity = m_PinocchioRobot->currentRPYVelocity();
+  aState.FinalAcceleration = m_PinocchioRobot->currentRPYAcceleration();
+  aState.PrevConfiguration = aRealization->GetPreviousConfigurationStage0();
+  aState.PrevVelocity = aRealization->GetPreviousVelocityStage0();
+}
+
+void ZMPPreviewControlWithMultiBodyZMP::SetSetupCache(bool SetupCache) {
+  m_SetupCache = SetupCache;
+  m_SetupStates.clear();
+}
+
 int ZMPPreviewControlWithMultiBodyZMP::SetupFirstPhase(
     deque<ZMPPosition> &ZMPRefPositions, deque<COMState> &,
     deque<FootAbsolutePosition> &LeftFootPositions,
@@ -585,9 +1067,13 @@ void ZMPPreviewControlWithMultiBodyZMP::CreateExtraCOMBuffer(
   double aSxzmp, aSyzmp;
   double aZmpx2, aZmpy2;
 
-  // initialize ZMP FIFO
+  // The references seen by the preview control at the iteration i
+  // start at the index i of this buffer.
+  aFIFOZMPRefPositions.resize(m_NL + m_ExtraCOMBuffer.size());
   for (unsigned int i = 0; i < m_NL; i++)
-    aFIFOZMPRefPositions.push_back(m_ExtraZMPRefBuffer[i]);
+    aFIFOZMPRefPositions[i] = m_ExtraZMPRefBuffer[i];
+  for (unsigned int i = 0; i < m_ExtraCOMBuffer.size(); i++)
+    aFIFOZMPRefPositions[m_NL + i] = m_ExtraZMPRefBuffer[i];
 
   // use accumulated zmp error  of preview control so far
   aSxzmp = m_sxzmp;
@@ -612,9 +1098,8 @@ void ZMPPreviewControlWithMultiBodyZMP::CreateExtraCOMBuffer(
 #endif
 
   for (unsigned int i = 0; i < m_ExtraCOMBuffer.size(); i++) {
-    aFIFOZMPRefPositions.push_back(m_ExtraZMPRefBuffer[i]);
     m_PC->OneIterationOfPreview(aPC1x, aPC1y, aSxzmp, aSyzmp,
-                                aFIFOZMPRefPositions, 0, aZmpx2, aZmpy2, true);
+                                aFIFOZMPRefPositions, i, aZmpx2, aZmpy2, true);
 
     for (unsigned j = 0; j < 3; j++) {
       m_ExtraCOMBuffer[i].x[j] = aPC1x(j, 0);
@@ -626,8 +1111,6 @@ void ZMPPreviewControlWithMultiBodyZMP::CreateExtraCOMBuffer(
 
     m_ExtraCOMBuffer[i].yaw[0] = m_ExtraZMPRefBuffer[i].theta;
 
-    aFIFOZMPRefPositions.pop_front();
-
 #ifdef _DEBUG_MODE_ON_
     if (aof_ExtraCOM.is_open()) {
       aof_ExtraCOM << m_ExtraZMPRefBuffer[i].time << " "
@@ -653,6 +1136,7 @@ void ZMPPreviewControlWithMultiBodyZMP::UpdateTheZMPRefQueue(
 
 void ZMPPreviewControlWithMultiBodyZMP::SetStrategyForStageActivation(
     int aZMPComTraj) {
+  m_SetupStates.clear();
   switch (aZMPComTraj) {
   case ZMPCOM_TRAJECTORY_FULL:
     m_StageStrategy = ZMPCOM_TRAJECTORY_FULL;
@@ -723,6 +1207,7 @@ int ZMPPreviewControlWithMultiBodyZMP::EvaluateStartingCoM(
 
 void ZMPPreviewControlWithMultiBodyZMP::SetStrategyForPCStages(int Strategy) {
   m_StageStrategy = Strategy;
+  m_SetupStates.clear();
 }
 
 int ZMPPreviewControlWithMultiBodyZMP::GetStrategyForPCStages() {
@@ -730,10 +1215,11 @@ int ZMPPreviewControlWithMultiBodyZMP::GetStrategyForPCStages() {
 }
 
 void ZMPPreviewControlWithMultiBodyZMP::RegisterMethods() {
-  std::string aMethodName[3] = {":samplingperiod", ":previewcontroltime",
-                                ":comheight"};
+  std::string aMethodName[6] = {":samplingperiod", ":previewcontroltime",
+                                ":comheight",      ":pipelinedstages",
+                                ":batchsetup",     ":setupcache"};
 
-  for (int i = 0; i < 3; i++) {
+  for (int i = 0; i < 6; i++) {
     if (!RegisterMethod(aMethodName[i])) {
       std::cerr << "Unable to register " << aMethodName << std::endl;
     } else {
@@ -749,6 +1235,7 @@ void ZMPPreviewControlWithMultiBodyZMP::SetSamplingPeriod(
   m_NL = 0;
   if (m_SamplingPeriod != 0.0)
     m_NL = (unsigned int)(m_PreviewControlTime / m_SamplingPeriod);
+  m_SetupStates.clear();
 }
 
 void ZMPPreviewControlWithMultiBodyZMP::SetPreviewControlTime(
@@ -758,6 +1245,7 @@ void ZMPPreviewControlWithMultiBodyZMP::SetPreviewControlTime(
   m_NL = 0;
   if (m_SamplingPeriod != 0.0)
     m_NL = (unsigned int)(m_PreviewControlTime / m_SamplingPeriod);
+  m_SetupStates.clear();
 }
 
 void ZMPPreviewControlWithMultiBodyZMP::CallMethod(std::string &Method,
@@ -776,5 +1264,27 @@ void ZMPPreviewControlWithMultiBodyZMP::CallMethod(std::string &Method,
       strm >> lpreviewcontroltime;
       SetPreviewControlTime(lpreviewcontroltime);
     }
+  } else if (Method == ":pipelinedstages") {
+    // :pipelinedstages true|false [CallerCPU WorkerCPU]
+    std::string lPipelinedStages;
+    int CallerCPU = -1, WorkerCPU = -1;
+    strm >> lPipelinedStages;
+    if (strm.good())
+      strm >> CallerCPU;
+    if (strm.good())
+      strm >> WorkerCPU;
+    SetPipelinedStages(lPipelinedStages == "true", CallerCPU, WorkerCPU);
+  } else if (Method == ":batchsetup") {
+    // :batchsetup true|false, threaded after :pipelinedstages true
+    std::string lBatchSetup;
+    strm >> lBatchSetup;
+    SetBatchSetup(lBatchSetup == "true");
+  } else if (Method == ":setupcache") {
+    std::string lSetupCache;
+    strm >> lSetupCache;
+    SetSetupCache(lSetupCache == "true");
+  } else if (Method == ":comheight") {
+    // The gains of the preview control change.
+    m_SetupStates.clear();
   }
 }
@@ -33,15 +33,21 @@
 #define _ZMPREVIEWCONTROLWITHMULTIBODYZMP_H_
 
 #include <deque>
+#include <vector>
 
 #include <MotionGeneration/ComAndFootRealization.hh>
 #include <PreviewControl/PreviewControl.hh>
 #include <SimplePlugin.hh>
 #include <jrl/walkgen/pgtypes.hh>
+#include <jrl/walkgen/pinocchiorobot.hh>
+
+#include "portability/thread.hh"
 
 using namespace ::std;
 
 namespace PatternGeneratorJRL {
+class ComAndFootRealizationByGeometry;
+
 /** @ingroup pgjrl
 
     Object to generate the angle positions
@@ -175,6 +181,201 @@ private:
   /*! Set the preview control time and update NL. */
   void SetPreviewControlTime(double lPreviewControlTime);
 
+  /*! \name Pipelined stages.
+    The multibody ZMP and the preview control on the delta ZMP of a
+    sample are computed by a worker thread, while the first stage of the
+    next sample is computed by the calling thread.
+    @{ */
+  /*! Job of the worker thread. */
+  class SecondStageJob : public WorkerThread::Job {
+  public:
+    SecondStageJob(ZMPPreviewControlWithMultiBodyZMP *aZMPPC)
+        : m_ZMPPC(aZMPPC) {}
+    void run() { m_ZMPPC->MultiBodyZMPAndSecondPreview(); }
+
+  private:
+    ZMPPreviewControlWithMultiBodyZMP *m_ZMPPC;
+  };
+  friend class SecondStageJob;
+
+  /*! Are the stages pipelined. */
+  bool m_PipelinedStages;
+
+  /*! The realization, which keeps the previous posture of the first
+    stage. */
+  ComAndFootRealizationByGeometry *m_PipelinedRealization;
+
+  WorkerThread m_Worker;
+  SecondStageJob m_SecondStageJob;
+
+  /*! Processor of the thread running the control steps, none if
+    negative. */
+  int m_CallerCPU;
+
+  /*! Buffers of the inverse dynamics in the worker thread. */
+  PinocchioDataPool m_WorkerData;
+
+  /*! Posture of the first stage and ZMP reference of the sample
+    handled by the worker thread. */
+  Eigen::VectorXd m_WorkerConfiguration, m_WorkerVelocity,
+      m_WorkerAcceleration;
+  ZMPPosition m_WorkerZMPRef;
+
+  /*! The first stage of the next sample has been computed ahead. */
+  bool m_AheadComputed;
+
+  /*! Inputs of the sample computed ahead, checked by the next call. */
+  ZMPPosition m_AheadZMPRef;
+  FootAbsolutePosition m_AheadLeftFoot, m_AheadRightFoot;
+  COMState m_AheadCOMState;
+
+  /*! Posture of the first stage of the sample computed ahead. */
+  Eigen::VectorXd m_AheadConfiguration, m_AheadVelocity,
+      m_AheadAcceleration;
+
+  /*! State before the first stage of the sample computed ahead. */
+  Eigen::MatrixXd m_UndoPC1x, m_UndoPC1y;
+  double m_UndoSxzmp, m_UndoSyzmp;
+  ZMPPosition m_UndoZMPRef;
+  Eigen::VectorXd m_UndoPrevConfiguration, m_UndoPrevVelocity;
+
+  /*! First stage and posture of a sample, Ahead being 1 for the
+    sample after the current one. */
+  void FirstStageAndPosture(FootAbsolutePosition &LeftFootPosition,
+                            FootAbsolutePosition &RightFootPosition,
+                            COMState &afCOMState, unsigned int Ahead,
+                            unsigned long int IterationNumber,
+                            Eigen::VectorXd &CurrentConfiguration,
+                            Eigen::VectorXd &CurrentVelocity,
+                            Eigen::VectorXd &CurrentAcceleration);
+
+  /*! Multibody ZMP of the posture given to the worker thread, and
+    preview control on the delta ZMP. */
+  void MultiBodyZMPAndSecondPreview();
+
+  /*! Undo the first stage of the sample computed ahead. */
+  void UndoAheadFirstStage();
+  /*! @} */
+
+  /*! Posture realizing the CoM and the feet positions, from the
+    configuration given in CurrentConfiguration. The parameters are the
+    ones of CallToComAndFootRealization. */
+  void RealizeCoMAndFeet(COMState &acomp, FootAbsolutePosition &aLeftFAP,
+                         FootAbsolutePosition &aRightFAP,
+                         Eigen::VectorXd &CurrentConfiguration,
+                         Eigen::VectorXd &CurrentVelocity,
+                         Eigen::VectorXd &CurrentAcceleration,
+                         unsigned long int IterationNumber,
+                         int StageOfTheAlgorithm);
+
+  /*! Push the difference between the ZMP reference and the multibody
+    ZMP in the delta ZMP FIFO. */
+  void PushDeltaZMP(const ZMPPosition &aZMPRef,
+                    const Eigen::Vector3d &ZMPmultibody);
+
+  /*! Preview control on the delta ZMP. */
+  void SecondPreviewOfControl();
+
+  /*! Correct the CoM of the first stage by the second preview control,
+    and remove the sample from the FIFOs. */
+  void CorrectCoMOfTheFirstStage(COMState &finalCOMState);
+
+  /*! Update m_FinalDesiredCOMPose from the final posture. */
+  void UpdateFinalDesiredCOMPose(Eigen::VectorXd &CurrentConfiguration,
+                                 COMState &finalCOMState);
+
+  /*! \name Fast setup.
+    @{ */
+  /*! Compute the setup window in batch. */
+  bool m_BatchSetup;
+
+  /*! Reuse the state reached by a previous setup with the same
+    inputs. */
+  bool m_SetupCache;
+
+  /*! Postures of the first stage, their multibody ZMPs and the ZMP
+    references of the setup window. */
+  std::vector<Eigen::VectorXd> m_SetupConfigurations, m_SetupVelocities,
+      m_SetupAccelerations;
+  std::vector<Eigen::Vector3d> m_SetupZMPs;
+  std::vector<ZMPPosition> m_SetupZMPRefs;
+
+  /*! Job computing the multibody ZMPs of a part of the setup window. */
+  class SetupDynamicsJob : public WorkerThread::Job {
+  public:
+    SetupDynamicsJob(ZMPPreviewControlWithMultiBodyZMP *aZMPPC)
+        : m_ZMPPC(aZMPPC), m_Begin(0), m_End(0) {}
+    void run() { m_ZMPPC->SetupDynamics(m_Begin, m_End, 1); }
+
+    ZMPPreviewControlWithMultiBodyZMP *m_ZMPPC;
+    unsigned int m_Begin, m_End;
+  };
+  friend class SetupDynamicsJob;
+  SetupDynamicsJob m_SetupDynamicsJob;
+
+  /*! Inputs of a setup: the references, the state of the robot and of
+    the realization, and the parameters of the realization. The times
+    of the references are not part of the inputs. */
+  struct SetupInputs_t {
+    std::vector<ZMPPosition> ZMPRefPositions;
+    std::vector<COMState> COMStates;
+    std::vector<FootAbsolutePosition> LeftFootPositions, RightFootPositions;
+    Eigen::VectorXd Configuration, Velocity, Acceleration;
+    Eigen::VectorXd PrevConfiguration, PrevVelocity;
+    Eigen::Vector3d StartingCOMState;
+    int WalkMode;
+    double GainFactor;
+    std::vector<double> UpperBodyMotion;
+    bool AnalyticalDerivatives;
+  };
+
+  /*! Inputs of a setup and the state it reached. */
+  struct SetupState_t {
+    SetupInputs_t Inputs;
+
+    deque<COMState> FIFOCOMStates;
+    deque<ZMPPosition> FIFODeltaZMPPositions;
+    Eigen::MatrixXd PC1x, PC1y;
+    double sxzmp, syzmp;
+    Eigen::VectorXd FinalConfiguration, FinalVelocity, FinalAcceleration;
+    Eigen::VectorXd PrevConfiguration, PrevVelocity;
+  };
+  std::vector<SetupState_t> m_SetupStates;
+
+  /*! Setup with the preview control of the first stage over the whole
+    window, then the postures, then their multibody ZMPs. */
+  void SetupInBatch(deque<ZMPPosition> &ZMPRefPositions,
+                    deque<COMState> &COMStates,
+                    deque<FootAbsolutePosition> &LeftFootPositions,
+                    deque<FootAbsolutePosition> &RightFootPositions);
+
+  /*! Multibody ZMPs of the postures [Begin,End) of the setup window,
+    computed in the workspace Workspace. */
+  void SetupDynamics(unsigned int Begin, unsigned int End,
+                     std::size_t Workspace);
+
+  /*! Inputs of the setup starting from the current state.
+    \return false if the setup cannot be kept. */
+  bool GetSetupInputs(deque<ZMPPosition> &ZMPRefPositions,
+                      deque<COMState> &COMStates,
+                      deque<FootAbsolutePosition> &LeftFootPositions,
+                      deque<FootAbsolutePosition> &RightFootPositions,
+                      SetupInputs_t &aInputs);
+
+  /*! Are the inputs of two setups the same. */
+  static bool SameSetupInputs(const SetupInputs_t &a, const SetupInputs_t &b);
+
+  /*! Restore the state reached by a previous setup with the same
+    inputs. \return false if there is none. */
+  bool FindSetupState(const SetupInputs_t &aInputs,
+                      deque<ZMPPosition> &ZMPRefPositions,
+                      deque<FootAbsolutePosition> &LeftFootPositions,
+                      deque<FootAbsolutePosition> &RightFootPositions);
+
+  /*! Keep the state reached by the setup of the inputs. */
+  void StoreSetupState(const SetupInputs_t &aInputs);
+  /*! @} */
+
 public:
   /*! Constantes to define the strategy with the first and second stage.
     @{
@@ -262,6 +463,56 @@ public:
                              Eigen::VectorXd &CurrentVelocity,
                              Eigen::VectorXd &CurrentAcceleration);
 
+  /*! Same as above, the ZMP reference being pushed in the queue by
+    this method. When the stages are pipelined, the inputs of the next
+    sample are used to compute its first stage while the second stage of
+    the current sample is computed. This first stage is undone if the
+    next call is not given the same inputs, the results are therefore
+    the ones of the sequential stages.
+    @param[in] NextZMPRefPos, NextLeftFootPosition, NextRightFootPosition,
+    NextCOMState: The inputs of the next call, 0 if they are not known.
+  */
+  int OneGlobalStepOfControl(
+      FootAbsolutePosition &LeftFootPosition,
+      FootAbsolutePosition &RightFootPosition, ZMPPosition &NewZMPRefPos,
+      COMState &refandfinalCOMState, Eigen::VectorXd &CurrentConfiguration,
+      Eigen::VectorXd &CurrentVelocity, Eigen::VectorXd &CurrentAcceleration,
+      const ZMPPosition *NextZMPRefPos,
+      const FootAbsolutePosition *NextLeftFootPosition,
+      const FootAbsolutePosition *NextRightFootPosition,
+      const COMState *NextCOMState);
+
+  /*! Pipeline the stages of the control with a worker thread.
+    This is possible with the two stages and the realization
+    by geometry only. Without threads the stages are computed in
+    sequence. The parameters of the realization are not expected to
+    change between two calls of OneGlobalStepOfControl.
+    @param[in] CallerCPU, WorkerCPU: Processors on which the thread
+    running the control steps and the worker thread are pinned, none
+    if negative. The former is pinned at its first pipelined step, and
+    gets back its processors when the mode is switched off.
+    @return false if the stages cannot be pipelined. */
+  bool SetPipelinedStages(bool PipelinedStages, int CallerCPU = -1,
+                          int WorkerCPU = -1);
+
+  inline bool GetPipelinedStages() const { return m_PipelinedStages; }
+
+  /*! Setup in batch: the preview control of the first stage is run
+    over the whole window before the postures, and the multibody ZMPs
+    of the postures are computed by the calling thread and the worker
+    thread of the pipelined stages. The worker exists only once
+    SetPipelinedStages(true) has succeeded: without it, the multibody
+    ZMPs are all computed by the calling thread. */
+  inline void SetBatchSetup(bool BatchSetup) { m_BatchSetup = BatchSetup; }
+  inline bool GetBatchSetup() const { return m_BatchSetup; }
+
+  /*! Keep the states reached by the last setups, and restore one of
+    them when the setup is given the same inputs: the references, the
+    configuration, velocity and acceleration of the robot, the previous
+    posture of the realization and its parameters. */
+  void SetSetupCache(bool SetupCache);
+  inline bool GetSetupCache() const { return m_SetupCache; }
+
   /*! First stage of the control,
     i.e.preview control on the CART model with delayed step parameters,
     Inverse Kinematics, and ZMP calculated with the multi body model.
@@ -25,6 +25,77 @@ inline std::string shortname(const pinocchio::JointModelVariant &jmodel) {
   return Joint_shortname::run(jmodel);
 }
 
+namespace {
+/// Samples solved together by the batch leg inverse kinematics,
+/// one lane per sample.
+typedef Eigen::Array<double, 4, 1> LegPacket;
+const Eigen::Index LegPacketSize = 4;
+
+/// Load the 12 components of the poses of the samples [start, start + 4),
+/// the last sample is repeated beyond the end of the batch.
+void loadLegPackets(const Eigen::Matrix<double, Eigen::Dynamic, 12> &poses,
+                    Eigen::Index start, LegPacket *packets) {
+  Eigen::Index n = std::min(LegPacketSize, poses.rows() - start);
+  for (unsigned int c = 0; c < 12; c++) {
+    if (n == LegPacketSize)
+      packets[c] = poses.col(c).segment<4>(start);
+    else
+      for (Eigen::Index l = 0; l < LegPacketSize; l++)
+        packets[c](l) = poses(start + std::min(l, n - 1), c);
+  }
+}
+
+/// Axis of a revolute joint of the legs in its own frame.
+Eigen::Vector3d legJointAxis(const std::string &shortName) {
+  if (shortName == "JointModelRX")
+    return Eigen::Vector3d::UnitX();
+  if (shortName == "JointModelRY")
+    return Eigen::Vector3d::UnitY();
+  if (shortName == "JointModelRZ")
+    return Eigen::Vector3d::UnitZ();
+  return Eigen::Vector3d::Zero();
+}
+
+/// The trigonometric functions are evaluated lane by lane, with the same
+/// precision as for a single pose.
+inline LegPacket sinLanes(const LegPacket &a) {
+  LegPacket r;
+  for (Eigen::Index l = 0; l < LegPacketSize; l++)
+    r(l) = sin(a(l));
+  return r;
+}
+
+inline LegPacket cosLanes(const LegPacket &a) {
+  LegPacket r;
+  for (Eigen::Index l = 0; l < LegPacketSize; l++)
+    r(l) = cos(a(l));
+  return r;
+}
+
+inline LegPacket asinLanes(const LegPacket &a) {
+  LegPacket r;
+  for (Eigen::Index l = 0; l < LegPacketSize; l++)
+    r(l) = asin(a(l));
+  return r;
+}
+
+inline LegPacket atan2Lanes(const LegPacket &y, const LegPacket &x) {
+  LegPacket r;
+  for (Eigen::Index l = 0; l < LegPacketSize; l++)
+    r(l) = atan2(y(l), x(l));
+  return r;
+}
+
+/// c = a b for 3x3 row-major matrices of packets
+inline void multiplyLegPackets(const LegPacket *a, const LegPacket *b,
+                               LegPacket *c) {
+  for (unsigned int i = 0; i < 3; i++)
+    for (unsigned int j = 0; j < 3; j++)
+      c[3 * i + j] = a[3 * i] * b[j] + a[3 * i + 1] * b[3 + j] +
+                     a[3 * i + 2] * b[6 + j];
+}
+} // namespace
+
 PinocchioRobot::PinocchioRobot() {
   // all the pointor are set to 0
   m_robotModel = 0;
@@ -75,6 +146,20 @@ PinocchioRobot::PinocchioRobot() {
   memset(&m_leftFoot, 0, sizeof(m_leftFoot));
   memset(&m_rightFoot, 0, sizeof(m_rightFoot));
 
+  for (unsigned int i = 0; i < 6; i++) {
+    m_leftLeg[i] = 0;
+    m_rightLeg[i] = 0;
+  }
+  m_leftLegAxes.setZero();
+  m_rightLegAxes.setZero();
+  for (unsigned int i = 0; i < 6; i++) {
+    m_leftLegIdxQ[i] = 0;
+    m_rightLegIdxQ[i] = 0;
+  }
+  m_legsFKInitialized = false;
+  m_frozenMass = 0.0;
+  m_frozenMoment.setZero();
+
   m_femurLength = 0.0;
   m_tibiaLengthZ = 0.0;
   m_tibiaLengthY = 0.0;
@@ -375,6 +460,17 @@ void PinocchioRobot::initializeLegsInverseKinematics() {
   if (m_femurLength == 0 || m_tibiaLengthZ == 0) {
     m_isLegInverseKinematic = false;
   }
+
+  // The chains have been checked by testLegsInverseKinematics:
+  // all the leg joints are revolute around one axis of their frame.
+  for (unsigned int i = 0; i < 6; i++) {
+    m_leftLeg[i] = leftLeg[i + 1];
+    m_rightLeg[i] = rightLeg[i + 1];
+    m_leftLegAxes.col(i) =
+        legJointAxis(shortname(m_robotModel->joints[m_leftLeg[i]]));
+    m_rightLegAxes.col(i) =
+        legJointAxis(shortname(m_robotModel->joints[m_rightLeg[i]]));
+  }
   RESETDEBUG4("DebugDataInitIK.dat");
   ODEBUG4("waist_M_leftHip " << waist_M_leftHip, "DebugDataInitIK.dat");
   ODEBUG4("waist_M_rightHip " << waist_M_rightHip, "DebugDataInitIK.dat");
@@ -413,30 +509,153 @@ void PinocchioRobot::computeForwardKinematics() {
   pinocchio::centerOfMass(*m_robotModel, *m_robotData, m_qpino);
 }
 
+bool PinocchioRobot::legsForwardKinematicsIsPossible() const {
+  // The legs are revolute joints hanging from the free flyer,
+  // and nothing else moves with them.
+  if (!m_isLegInverseKinematic || !m_boolData ||
+      (m_robotModel->parents[m_waist] != 0) || (m_PinoFreeFlyerSize != 7))
+    return false;
+  // Each leg is a chain starting at the waist.
+  const pinocchio::JointIndex *legs[2] = {m_leftLeg, m_rightLeg};
+  for (unsigned int l = 0; l < 2; l++)
+    for (unsigned int i = 0; i < 6; i++)
+      if (m_robotModel->parents[legs[l][i]] !=
+          ((i == 0) ? m_waist : legs[l][i - 1]))
+        return false;
+  for (std::size_t j = 1; j < m_robotModel->joints.size(); j++) {
+    pinocchio::JointIndex parent = m_robotModel->parents[j];
+    bool isLegJoint = false, hasLegParent = false;
+    for (unsigned int i = 0; i < 6; i++) {
+      isLegJoint = isLegJoint || (j == m_leftLeg[i]) || (j == m_rightLeg[i]);
+      hasLegParent = hasLegParent || (parent == m_leftLeg[i]) ||
+                     (parent == m_rightLeg[i]);
+    }
+    if (hasLegParent && !isLegJoint)
+      return false;
+  }
+  return true;
+}
+
+void PinocchioRobot::updateFrozenBranches() {
+  computeForwardKinematics();
+
+  std::vector<bool> isLegJoint(m_robotModel->joints.size(), false);
+  m_isFrozenConfiguration.assign(m_robotModel->nq, true);
+  for (int i = 0; i < m_PinoFreeFlyerSize; i++)
+    m_isFrozenConfiguration[i] = false;
+  for (unsigned int i = 0; i < 6; i++) {
+    m_leftLegIdxQ[i] = pinocchio::idx_q(m_robotModel->joints[m_leftLeg[i]]);
+    m_rightLegIdxQ[i] = pinocchio::idx_q(m_robotModel->joints[m_rightLeg[i]]);
+    m_isFrozenConfiguration[m_leftLegIdxQ[i]] = false;
+    m_isFrozenConfiguration[m_rightLegIdxQ[i]] = false;
+    isLegJoint[m_leftLeg[i]] = true;
+    isLegJoint[m_rightLeg[i]] = true;
+  }
+  m_frozenConfiguration = m_qpino;
+
+  // Mass and first moment of the other bodies in the waist frame.
+  const pinocchio::SE3 &oMw = m_robotData->oMi[m_waist];
+  m_frozenMass = 0.0;
+  m_frozenMoment.setZero();
+  for (std::size_t j = 1; j < m_robotModel->joints.size(); j++) {
+    if (isLegJoint[j])
+      continue;
+    const pinocchio::SE3 &oMj = m_robotData->oMi[j];
+    Eigen::Vector3d c = oMj.rotation() * m_robotModel->inertias[j].lever() +
+                        oMj.translation();
+    double mass = m_robotModel->inertias[j].mass();
+    m_frozenMass += mass;
+    m_frozenMoment +=
+        mass * (oMw.rotation().transpose() * (c - oMw.translation()));
+  }
+  m_legsFKInitialized = true;
+}
+
+void PinocchioRobot::computeLegsForwardKinematics() {
+  if (!legsForwardKinematicsIsPossible()) {
+    computeForwardKinematics();
+    return;
+  }
+  if (!m_legsFKInitialized ||
+      (m_frozenConfiguration.size() != m_qpino.size())) {
+    updateFrozenBranches();
+    return;
+  }
+  for (Eigen::Index i = 0; i < m_qpino.size(); i++) {
+    if (m_isFrozenConfiguration[i] &&
+        (m_qpino(i) != m_frozenConfiguration(i))) {
+      updateFrozenBranches();
+      return;
+    }
+  }
+
+  // Free flyer : [pos quarternion]
+  Eigen::Quaterniond quat(m_qpino(6), m_qpino(3), m_qpino(4), m_qpino(5));
+  Eigen::Vector3d position(m_qpino(0), m_qpino(1), m_qpino(2));
+  m_robotData->liMi[m_waist] =
+      m_robotModel->jointPlacements[m_waist] *
+      pinocchio::SE3(quat.toRotationMatrix(), position);
+  m_robotData->oMi[m_waist] = m_robotData->liMi[m_waist];
+
+  const pinocchio::SE3 &oMw = m_robotData->oMi[m_waist];
+  Eigen::Vector3d moment =
+      oMw.rotation() * m_frozenMoment + m_frozenMass * oMw.translation();
+
+  // Legs, from the hips to the ankles.
+  const pinocchio::JointIndex *legs[2] = {m_leftLeg, m_rightLeg};
+  const int *legsIdxQ[2] = {m_leftLegIdxQ, m_rightLegIdxQ};
+  const Eigen::Matrix<double, 3, 6> *legsAxes[2] = {&m_leftLegAxes,
+                                                    &m_rightLegAxes};
+  for (unsigned int l = 0; l < 2; l++) {
+    for (unsigned int i = 0; i < 6; i++) {
+      pinocchio::JointIndex j = legs[l][i];
+      Eigen::AngleAxisd rotation(m_qpino(legsIdxQ[l][i]),
+                                 legsAxes[l]->col(i));
+      m_robotData->liMi[j] =
+          m_robotModel->jointPlacements[j] *
+          pinocchio::SE3(rotation.toRotationMatrix(), Eigen::Vector3d::Zero());
+      m_robotData->oMi[j] =
+          m_robotData->oMi[m_robotModel->parents[j]] * m_robotData->liMi[j];
+
+      const pinocchio::SE3 &oMj = m_robotData->oMi[j];
+      moment += m_robotModel->inertias[j].mass() *
+                (oMj.rotation() * m_robotModel->inertias[j].lever() +
+                 oMj.translation());
+    }
+  }
+  m_robotData->com[0] = moment / m_mass;
+}
+
 void PinocchioRobot::currentPinoConfiguration(Eigen::VectorXd &conf) {
   m_qpino = conf;
 }
 
 void PinocchioRobot::currentRPYConfiguration(Eigen::VectorXd &conf) {
   m_qrpy = conf;
+  RPYToPinocchioConfiguration(conf, m_qpino);
+}
 
-  m_quat =
-      Eigen::Quaterniond(Eigen::AngleAxisd(conf(5), Eigen::Vector3d::UnitZ()) *
-                         Eigen::AngleAxisd(conf(4), Eigen::Vector3d::UnitY()) *
-                         Eigen::AngleAxisd(conf(3), Eigen::Vector3d::UnitX()));
-  m_quat.normalize();
+void PinocchioRobot::RPYToPinocchioConfiguration(const Eigen::VectorXd &qrpy,
+                                                 Eigen::VectorXd &qpino,
+                                                 bool normalize) const {
+  Eigen::Quaterniond quat =
+      Eigen::Quaterniond(Eigen::AngleAxisd(qrpy(5), Eigen::Vector3d::UnitZ()) *
+                         Eigen::AngleAxisd(qrpy(4), Eigen::Vector3d::UnitY()) *
+                         Eigen::AngleAxisd(qrpy(3), Eigen::Vector3d::UnitX()));
+  if (normalize)
+    quat.normalize();
 
   for (unsigned i = 0; i < 3; ++i) {
-    m_qpino(i) = conf(i);
+    qpino(i) = qrpy(i);
   }
   // fill up m_q following the pinocchio standard : [pos quarternion DoFs]
-  m_qpino(3) = m_quat.x();
-  m_qpino(4) = m_quat.y();
-  m_qpino(5) = m_quat.z();
-  m_qpino(6) = m_quat.w();
+  qpino(3) = quat.x();
+  qpino(4) = quat.y();
+  qpino(5) = quat.z();
+  qpino(6) = quat.w();
 
-  for (unsigned i = 6; i < conf.size(); ++i) {
-    m_qpino(i + 1) = conf(i);
+  for (unsigned i = 6; i < qrpy.size(); ++i) {
+    qpino(i + 1) = qrpy(i);
   }
 }
 
@@ -482,6 +701,79 @@ void PinocchioRobot::computeInverseDynamics(Eigen::VectorXd &q,
       pinocchio::rnea(*m_robotModel, *m_robotData, m_qpino, m_vpino, m_apino);
 }
 
+void PinocchioRobot::initializeWorkspace(PRWorkspace &workspace) const {
+  delete workspace.data;
+  workspace.data = new pinocchio::Data(*m_robotModel);
+  workspace.qpino.setZero(m_robotModel->nq);
+  workspace.qpino[6] = 1.0;
+  workspace.vpino.setZero(m_robotModel->nv);
+  workspace.apino.setZero(m_robotModel->nv);
+  workspace.tau.setZero(m_robotModel->nv);
+}
+
+void PinocchioRobot::computeForwardKinematics(const Eigen::VectorXd &q,
+                                              PRWorkspace &workspace) const {
+  RPYToPinocchioConfiguration(q, workspace.qpino);
+  pinocchio::forwardKinematics(*m_robotModel, *workspace.data,
+                               workspace.qpino);
+  pinocchio::centerOfMass(*m_robotModel, *workspace.data, workspace.qpino);
+}
+
+void PinocchioRobot::computeInverseDynamics(const Eigen::VectorXd &q,
+                                            const Eigen::VectorXd &v,
+                                            const Eigen::VectorXd &a,
+                                            PRWorkspace &workspace) const {
+  // The quaternion is not normalized, as in computeInverseDynamics(q, v, a).
+  RPYToPinocchioConfiguration(q, workspace.qpino, false);
+  workspace.vpino = v;
+  workspace.apino = a;
+  workspace.tau = pinocchio::rnea(*m_robotModel, *workspace.data,
+                                  workspace.qpino, workspace.vpino,
+                                  workspace.apino);
+}
+
+void PinocchioRobot::zeroMomentumPoint(const PRWorkspace &workspace,
+                                       Eigen::Vector3d &zmp) const {
+  pinocchio::Force externalForces =
+      workspace.data->liMi[1].act(workspace.data->f[1]);
+  zmp(0) = -externalForces.angular()(1) / externalForces.linear()(2);
+  zmp(1) = externalForces.angular()(0) / externalForces.linear()(2);
+  zmp(2) = 0.0; // by default
+}
+
+void PinocchioRobot::positionCenterOfMass(const PRWorkspace &workspace,
+                                          Eigen::Vector3d &com) const {
+  com = workspace.data->com[0];
+}
+
+void PinocchioRobot::CenterOfMass(const PRWorkspace &workspace,
+                                  Eigen::Vector3d &com, Eigen::Vector3d &dcom,
+                                  Eigen::Vector3d &ddcom) const {
+  com = workspace.data->com[0];
+  dcom = workspace.data->vcom[0];
+  ddcom = workspace.data->acom[0];
+}
+
+PinocchioDataPool::PinocchioDataPool() {}
+
+PinocchioDataPool::~PinocchioDataPool() { clear(); }
+
+void PinocchioDataPool::resize(const PinocchioRobot &aPR,
+                               std::size_t nbWorkspaces) {
+  clear();
+  m_workspaces.resize(nbWorkspaces);
+  for (std::size_t i = 0; i < nbWorkspaces; i++) {
+    m_workspaces[i] = new PRWorkspace();
+    aPR.initializeWorkspace(*m_workspaces[i]);
+  }
+}
+
+void PinocchioDataPool::clear() {
+  for (std::size_t i = 0; i < m_workspaces.size(); i++)
+    delete m_workspaces[i];
+  m_workspaces.clear();
+}
+
 std::vector<pinocchio::JointIndex>
 PinocchioRobot::fromRootToIt(pinocchio::JointIndex it) {
   std::vector<pinocchio::JointIndex> fromRootToIt;
@@ -703,6 +995,220 @@ void PinocchioRobot::getWaistFootKinematics(
   }
 }
 
+bool PinocchioRobot::ComputeLegInverseKinematicsBatch(
+    const pinocchio::JointIndex &jointEnd, PRLegIKBatch &batch) const {
+  if (!m_isLegInverseKinematic)
+    return false;
+  const Eigen::Vector3d *Dt = 0;
+  if (jointEnd == m_leftFoot.associatedAnkle)
+    Dt = &m_leftDt;
+  else if (jointEnd == m_rightFoot.associatedAnkle)
+    Dt = &m_rightDt;
+  else
+    return false;
+
+  const double _epsilon = 1.0e-6;
+  const double A = m_femurLength;
+  const double B = m_tibiaLengthZ;
+  const double OppSignOfDtY = (*Dt)(1) < 0.0 ? 1.0 : -1.0;
+
+  Eigen::Index nbSamples = batch.size();
+  batch.q.resize(nbSamples, 6);
+  batch.reachable.resize(nbSamples);
+
+  // Same steps as getWaistFootKinematics, on 4 samples at once.
+  LegPacket W[12], F[12], q[6];
+  for (Eigen::Index start = 0; start < nbSamples; start += LegPacketSize) {
+    loadLegPackets(batch.waist, start, W);
+    loadLegPackets(batch.ankle, start, F);
+
+    // d3 = Body_P + Body_R Dt - Foot_P
+    LegPacket d3[3];
+    for (unsigned int i = 0; i < 3; i++)
+      d3[i] = W[9 + i] +
+              (W[3 * i] * (*Dt)(0) + W[3 * i + 1] * (*Dt)(1) +
+               W[3 * i + 2] * (*Dt)(2)) -
+              F[9 + i];
+
+    LegPacket l0 = (d3[0] * d3[0] + d3[1] * d3[1] + d3[2] * d3[2] -
+                    m_tibiaLengthY * m_tibiaLengthY)
+                       .sqrt();
+    LegPacket c5 = 0.5 * (l0 * l0 - A * A - B * B) / (A * B);
+    bool inRange[LegPacketSize];
+    for (Eigen::Index l = 0; l < LegPacketSize; l++) {
+      inRange[l] = (c5(l) >= -1.0 + _epsilon) && (c5(l) <= 1.0 - _epsilon);
+      if (c5(l) > 1.0 - _epsilon)
+        q[3](l) = 0.0;
+      else if (c5(l) < -1.0 + _epsilon)
+        q[3](l) = M_PI;
+      else
+        q[3](l) = inRange[l] ? acos(c5(l)) : 0.0;
+    }
+
+    // r3 = Foot_R^t d3
+    LegPacket r3[3];
+    for (unsigned int i = 0; i < 3; i++)
+      r3[i] = F[i] * d3[0] + F[3 + i] * d3[1] + F[6 + i] * d3[2];
+
+    LegPacket q6a =
+        asinLanes((LegPacket::Constant(A) / l0) * sinLanes(M_PI - q[3]));
+
+    LegPacket l3 = (r3[1] * r3[1] + r3[2] * r3[2]).sqrt();
+    LegPacket l4 = (l3 * l3 - m_tibiaLengthY * m_tibiaLengthY).sqrt();
+
+    LegPacket phi = atan2Lanes(r3[0], l4);
+    q[4] = -phi - q6a;
+
+    LegPacket psi1 = atan2Lanes(r3[1], r3[2]) * OppSignOfDtY;
+    LegPacket psi2 = 0.5 * M_PI - psi1;
+    LegPacket psi3 = atan2Lanes(l4, LegPacket::Constant(m_tibiaLengthY));
+    q[5] = (psi3 - psi2) * OppSignOfDtY;
+    for (Eigen::Index l = 0; l < LegPacketSize; l++) {
+      if (q[5](l) > 0.5 * M_PI)
+        q[5](l) -= M_PI;
+      else if (q[5](l) < -0.5 * M_PI)
+        q[5](l) += M_PI;
+    }
+
+    // R = Body_R^t Foot_R Rroll Rpitch
+    LegPacket BRt[9], Rroll[9], Rpitch[9], M[9], N[9], R[9];
+    for (unsigned int i = 0; i < 3; i++)
+      for (unsigned int j = 0; j < 3; j++)
+        BRt[3 * i + j] = W[3 * j + i];
+    LegPacket c = cosLanes(q[5]), s = sinLanes(q[5]);
+    LegPacket zero = LegPacket::Zero(), one = LegPacket::Ones();
+    Rroll[0] = one;
+    Rroll[1] = zero;
+    Rroll[2] = zero;
+    Rroll[3] = zero;
+    Rroll[4] = c;
+    Rroll[5] = s;
+    Rroll[6] = zero;
+    Rroll[7] = -s;
+    Rroll[8] = c;
+    c = cosLanes(q[4] + q[3]);
+    s = sinLanes(q[4] + q[3]);
+    Rpitch[0] = c;
+    Rpitch[1] = zero;
+    Rpitch[2] = -s;
+    Rpitch[3] = zero;
+    Rpitch[4] = one;
+    Rpitch[5] = zero;
+    Rpitch[6] = s;
+    Rpitch[7] = zero;
+    Rpitch[8] = c;
+    multiplyLegPackets(BRt, F, M);
+    multiplyLegPackets(M, Rroll, N);
+    multiplyLegPackets(N, Rpitch, R);
+
+    q[0] = atan2Lanes(-R[1], R[4]);
+    LegPacket cz = cosLanes(q[0]), sz = sinLanes(q[0]);
+    q[1] = atan2Lanes(R[7], -R[1] * sz + R[4] * cz);
+    q[2] = atan2Lanes(-R[6], R[8]);
+
+    if (m_modeLegInverseKinematic == 1) {
+      LegPacket tmp = q[2];
+      q[2] = q[0];
+      q[0] = q[1];
+      q[1] = tmp;
+    }
+
+    Eigen::Index n = std::min(LegPacketSize, nbSamples - start);
+    for (Eigen::Index l = 0; l < n; l++) {
+      bool finite = true;
+      for (unsigned int j = 0; j < 6; j++) {
+        batch.q(start + l, j) = q[j](l);
+        finite = finite && (q[j](l) == q[j](l));
+      }
+      batch.reachable(start + l) = inRange[l] && finite;
+    }
+  }
+  return true;
+}
+
+bool PinocchioRobot::getLegChainKinematics(
+    const pinocchio::JointIndex &jointEnd, const Eigen::VectorXd &q,
+    Eigen::Matrix<double, 3, 6> &axes, Eigen::Matrix<double, 3, 6> &positions,
+    Eigen::Vector3d &end) const {
+  if (!m_isLegInverseKinematic || (q.size() != 6))
+    return false;
+  const pinocchio::JointIndex *leg = 0;
+  const Eigen::Matrix<double, 3, 6> *legAxes = 0;
+  if (jointEnd == m_leftFoot.associatedAnkle) {
+    leg = m_leftLeg;
+    legAxes = &m_leftLegAxes;
+  } else if (jointEnd == m_rightFoot.associatedAnkle) {
+    leg = m_rightLeg;
+    legAxes = &m_rightLegAxes;
+  } else
+    return false;
+
+  // Forward kinematics of the leg from the waist frame.
+  Eigen::Matrix3d R = Eigen::Matrix3d::Identity();
+  Eigen::Vector3d p = Eigen::Vector3d::Zero();
+  for (unsigned int i = 0; i < 6; i++) {
+    const pinocchio::SE3 &placement = m_robotModel->jointPlacements[leg[i]];
+    p += R * placement.translation();
+    R = R * placement.rotation();
+    positions.col(i) = p;
+    axes.col(i) = R * legAxes->col(i);
+    R = R * Eigen::AngleAxisd(q(i), legAxes->col(i)).toRotationMatrix();
+  }
+  end = p;
+  return true;
+}
+
+bool PinocchioRobot::ComputeLegJacobian(const pinocchio::JointIndex &jointEnd,
+                                        const Eigen::VectorXd &q,
+                                        Eigen::Matrix<double, 6, 6> &J) const {
+  Eigen::Matrix<double, 3, 6> axes, positions;
+  Eigen::Vector3d end;
+  if (!getLegChainKinematics(jointEnd, q, axes, positions, end))
+    return false;
+
+  for (unsigned int i = 0; i < 6; i++) {
+    Eigen::Vector3d z = axes.col(i);
+    J.block<3, 1>(0, i) = z.cross(end - positions.col(i));
+    J.block<3, 1>(3, i) = z;
+  }
+  return true;
+}
+
+bool PinocchioRobot::ComputeLegJacobianTimeVariation(
+    const pinocchio::JointIndex &jointEnd, const Eigen::VectorXd &q,
+    const Eigen::Matrix<double, 6, 1> &dq,
+    Eigen::Matrix<double, 6, 1> &dJdq) const {
+  Eigen::Matrix<double, 3, 6> axes, positions;
+  Eigen::Vector3d end;
+  if (!getLegChainKinematics(jointEnd, q, axes, positions, end))
+    return false;
+
+  // Velocity of the ankle.
+  Eigen::Vector3d dEnd = Eigen::Vector3d::Zero();
+  for (unsigned int j = 0; j < 6; j++)
+    dEnd += dq(j) * axes.col(j).cross(end - positions.col(j));
+
+  // The axis of the joint i and its position move with the joints
+  // before it: d(z_i)/dt = w_i x z_i, with w_i the angular velocity
+  // of the link carrying the joint i.
+  dJdq.setZero();
+  Eigen::Vector3d w = Eigen::Vector3d::Zero();
+  for (unsigned int i = 0; i < 6; i++) {
+    Eigen::Vector3d z = axes.col(i);
+    Eigen::Vector3d dz = w.cross(z);
+    Eigen::Vector3d dPosition = Eigen::Vector3d::Zero();
+    for (unsigned int j = 0; j < i; j++)
+      dPosition +=
+          dq(j) * axes.col(j).cross(positions.col(i) - positions.col(j));
+
+    dJdq.head<3>() += dq(i) * (dz.cross(end - positions.col(i)) +
+                               z.cross(dEnd - dPosition));
+    dJdq.tail<3>() += dq(i) * dz;
+    w += dq(i) * z;
+  }
+  return true;
+}
+
 double PinocchioRobot::ComputeXmax(double &Z) {
   double A = 0.25, B = 0.25;
   double Xmax;
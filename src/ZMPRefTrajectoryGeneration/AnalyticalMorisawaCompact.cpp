@@ -109,6 +109,10 @@ AnalyticalMorisawaCompact::AnalyticalMorisawaCompact(SimplePluginManager *lSPM,
   m_FilterYaxisByPC = new FilteringAnalyticalTrajectoryByPreviewControl(
       lSPM, m_AnalyticalZMPCoGTrajectoryY, m_PreviewControl);
 
+  m_PreviewControlGainsCache = new PreviewControlGainsCache();
+  m_FilterXaxisByPC->SetGainsCache(m_PreviewControlGainsCache);
+  m_FilterYaxisByPC->SetGainsCache(m_PreviewControlGainsCache);
+
   m_kajitaDynamicFilter = new DynamicFilter(lSPM, m_PR);
 
   m_VerboseLevel = 0;
@@ -164,6 +168,9 @@ AnalyticalMorisawaCompact::~AnalyticalMorisawaCompact() {
   if (m_PreviewControl != 0)
     delete m_PreviewControl;
 
+  if (m_PreviewControlGainsCache != 0)
+    delete m_PreviewControlGainsCache;
+
   if (m_BackUpm_FeetTrajectoryGenerator != 0)
     delete m_BackUpm_FeetTrajectoryGenerator;
   ODEBUG4("Destructor: did PreviewControl", "DebugPGI.txt");
@@ -780,6 +787,8 @@ void AnalyticalMorisawaCompact::OnLine(
     deque<FootAbsolutePosition> &FinalLeftFootAbsolutePositions,
     deque<FootAbsolutePosition> &FinalRightFootAbsolutePositions) {
   unsigned int lIndexInterval;
+  m_AnalyticalZMPCoGTrajectoryX->SetSamplingPeriod(m_SamplingPeriod);
+  m_AnalyticalZMPCoGTrajectoryY->SetSamplingPeriod(m_SamplingPeriod);
   if (time < m_UpperTimeLimitToUpdateStacks) {
     if (m_AnalyticalZMPCoGTrajectoryX->GetIntervalIndexFromTime(
             time, lIndexInterval)) {
@@ -1565,6 +1574,183 @@ double AnalyticalMorisawaCompact::TimeCompensationForZMPFluctuation(
   return DeltaTNew;
 }
 
+void AnalyticalMorisawaCompact::ComputeZDerivativeTimesWeights(
+    unsigned int IntervalIndex, const Eigen::VectorXd &y,
+    Eigen::VectorXd &dZy) {
+  dZy.resize(m_Z.rows());
+  dZy.setZero();
+
+  double T = m_DeltaTj[IntervalIndex];
+
+  if (((int)IntervalIndex == 0) ||
+      ((int)IntervalIndex == m_NumberOfIntervals - 1)) {
+    /* Derivative of the rows built by ComputeZ1 or ComputeZm. */
+    unsigned int rowindex = 2, colindex = 0;
+    if (IntervalIndex != 0) {
+      rowindex = 6 + 2 * (m_NumberOfIntervals - 2);
+      colindex = m_PolynomialDegrees[0] + 1 + 2 * (m_NumberOfIntervals - 2);
+    }
+    double Omega = m_Omegaj[IntervalIndex];
+    double SquareOmega = Omega * Omega;
+    double c0 = cosh(Omega * T), s0 = sinh(Omega * T);
+    const double *ly = &y(colindex);
+
+    // Connection of the position of the CoM
+    dZy(rowindex) = 2 * T * ly[0] + (3 * T * T + 6.0 / SquareOmega) * ly[1] +
+                    4 * T * T * T * ly[2] + Omega * s0 * ly[3] +
+                    Omega * c0 * ly[4];
+    // Connection of the velocity of the CoM
+    dZy(rowindex + 1) = 2 * ly[0] + 6 * T * ly[1] + 12 * T * T * ly[2] +
+                        SquareOmega * c0 * ly[3] + SquareOmega * s0 * ly[4];
+    // Terminal condition for the ZMP position
+    dZy(rowindex + 2) = 2 * T * ly[0] + 3 * T * T * ly[1] +
+                        (4 * T * T * T - 24 * T / SquareOmega) * ly[2];
+    // Terminal velocity for the ZMP position
+    dZy(rowindex + 3) =
+        2 * ly[0] + 6 * T * ly[1] + (12 * T * T - 24.0 / SquareOmega) * ly[2];
+  } else {
+    /* Derivative of the rows built by ComputeZj. */
+    unsigned int rowindex = 6 + 2 * (IntervalIndex - 1);
+    unsigned int colindex = m_PolynomialDegrees[0] + 1 + 2 * (IntervalIndex - 1);
+    double Omegaj = m_Omegaj[IntervalIndex];
+    double c0 = cosh(Omegaj * T), s0 = sinh(Omegaj * T);
+
+    dZy(rowindex) = Omegaj * (s0 * y(colindex) + c0 * y(colindex + 1));
+    dZy(rowindex + 1) =
+        Omegaj * Omegaj * (c0 * y(colindex) + s0 * y(colindex + 1));
+  }
+}
+
+void AnalyticalMorisawaCompact::ComputeIntermediatePolynomialTimeDerivative(
+    unsigned int IntervalIndex, AnalyticalZMPCOGTrajectory &aAZCT,
+    vector<double> &dCoeffs, double &dEndPos, double &dEndSpeed) {
+  Polynome *aPolynome = 0;
+  aAZCT.GetFromListOfCOGPolynomials(IntervalIndex, aPolynome);
+  vector<double> Coeffs;
+  aPolynome->GetCoefficients(Coeffs);
+
+  double T = m_DeltaTj[IntervalIndex];
+  double SquareOmega = m_Omegaj[IntervalIndex] * m_Omegaj[IntervalIndex];
+
+  /* The ZMP boundary values being fixed, the 2nd and 3rd order
+     coefficients scale respectively as 1/T^2 and 1/T^3
+     (see AnalyticalZMPCOGTrajectory::Building3rdOrderPolynomial). */
+  dCoeffs.resize(4);
+  dCoeffs[2] = -2.0 * Coeffs[2] / T;
+  dCoeffs[3] = -3.0 * Coeffs[3] / T;
+  dCoeffs[1] = dCoeffs[3] * 6.0 / SquareOmega;
+  dCoeffs[0] = dCoeffs[2] * 2.0 / SquareOmega;
+
+  dEndPos = 0.0;
+  dEndSpeed = 0.0;
+  double deltat = 1.0;
+  for (unsigned int k = 0; k < 4; k++) {
+    dEndPos += dCoeffs[k] * deltat;
+    if (k > 0) {
+      dEndPos += k * Coeffs[k] * deltat / T;
+      dEndSpeed += k * dCoeffs[k] * deltat / T;
+    }
+    if (k > 1)
+      dEndSpeed += k * (k - 1) * Coeffs[k] * deltat / (T * T);
+    deltat *= T;
+  }
+}
+
+void AnalyticalMorisawaCompact::ComputeWDerivative(
+    unsigned int IntervalIndex, AnalyticalZMPCOGTrajectory &aAZCT,
+    Eigen::VectorXd &dw) {
+  dw.resize(2 * m_NumberOfIntervals + 6);
+  dw.setZero();
+
+  /* The first and the last polynomials are unknowns of the problem. */
+  if (((int)IntervalIndex == 0) ||
+      ((int)IntervalIndex >= m_NumberOfIntervals - 1))
+    return;
+
+  vector<double> dCoeffs;
+  double dEndPos = 0.0, dEndSpeed = 0.0;
+  ComputeIntermediatePolynomialTimeDerivative(IntervalIndex, aAZCT, dCoeffs,
+                                              dEndPos, dEndSpeed);
+
+  // Same indexing than ComputeW: at iteration j, w is built
+  // for the interval j-1, using the polynomial of the interval j.
+  unsigned int j = IntervalIndex;
+  unsigned int lindex = (j == 1) ? 2 : 6 + 2 * (j - 2);
+  dw[lindex] = dCoeffs[0];
+  dw[lindex + 1] = dCoeffs[1];
+
+  // The end of the interval j appears at iteration j+1.
+  lindex = 6 + 2 * (j - 1);
+  dw[lindex] -= dEndPos;
+  dw[lindex + 1] -= dEndSpeed;
+}
+
+void AnalyticalMorisawaCompact::ComputeTimingSensitivities(
+    CompactTrajectoryInstanceParameters &aCTIP,
+    AnalyticalZMPCOGTrajectory &aAZCT, TimingSensitivities &aTS) {
+  BuildingTheZMatrix();
+  m_TimingZLU.compute(m_Z);
+
+  ComputeW(aCTIP.InitialCoM, aCTIP.InitialCoMSpeed, aCTIP.ZMPProfil,
+           aCTIP.FinalCoMPos, aAZCT);
+
+  aTS.DeltaTj = m_DeltaTj;
+  aTS.y = m_TimingZLU.solve(m_w);
+  aTS.dYdT.resize(m_Z.rows(), m_NumberOfIntervals);
+
+  Eigen::VectorXd ldZy, ldw;
+  for (int j = 0; j < m_NumberOfIntervals; j++) {
+    ComputeZDerivativeTimesWeights(j, aTS.y, ldZy);
+    ComputeWDerivative(j, aAZCT, ldw);
+    aTS.dYdT.col(j) = m_TimingZLU.solve(ldw - ldZy);
+  }
+}
+
+double AnalyticalMorisawaCompact::AdaptStepTiming(
+    vector<double> &NewDeltaTj, CompactTrajectoryInstanceParameters &aCTIP,
+    AnalyticalZMPCOGTrajectory &aAZCT, TimingSensitivities &aTS,
+    unsigned int NbOfNewtonIterations) {
+  if (((int)NewDeltaTj.size() != m_NumberOfIntervals) ||
+      (aTS.DeltaTj.size() != NewDeltaTj.size())) {
+    LTHROW("Timing sensitivities do not match the number of intervals.");
+  }
+
+  /* First order update of the weights. */
+  Eigen::VectorXd lDeltaT(m_NumberOfIntervals);
+  for (int j = 0; j < m_NumberOfIntervals; j++) {
+    lDeltaT(j) = NewDeltaTj[j] - aTS.DeltaTj[j];
+    m_DeltaTj[j] = NewDeltaTj[j];
+  }
+  m_y = aTS.y + aTS.dYdT * lDeltaT;
+
+  /* The intermediate polynomials depend on the intervals duration. */
+  aAZCT.SetStartingTimeIntervalsAndHeightVariation(m_DeltaTj, m_Omegaj);
+  for (int i = 1; i < m_NumberOfIntervals - 1; i++)
+    aAZCT.Building3rdOrderPolynomial(i, aCTIP.ZMPProfil[i - 1],
+                                     aCTIP.ZMPProfil[i]);
+
+  /* Chord-Newton refinement with the LU decomposition of the
+     nominal Z matrix. */
+  BuildingTheZMatrix();
+  ComputeW(aCTIP.InitialCoM, aCTIP.InitialCoMSpeed, aCTIP.ZMPProfil,
+           aCTIP.FinalCoMPos, aAZCT);
+  Eigen::VectorXd lResidual = m_w - m_Z * m_y;
+  for (unsigned int i = 0; i < NbOfNewtonIterations; i++) {
+    m_y += m_TimingZLU.solve(lResidual);
+    lResidual = m_w - m_Z * m_y;
+  }
+
+  TransfertTheCoefficientsToTrajectories(
+      aAZCT, aCTIP.CoMZ, aCTIP.ZMPZ, aCTIP.ZMPProfil[0],
+      aCTIP.ZMPProfil[m_NumberOfIntervals - 1], false);
+
+  /* The LAPACK decomposition does not match the new Z matrix anymore. */
+  ResetTheResolutionOfThePolynomial();
+  ComputePreviewControlTimeWindow();
+
+  return lResidual.norm();
+}
+
 void AnalyticalMorisawaCompact::ChangeZMPProfil(
     vector<unsigned int> &IndexStep,
     vector<FootAbsolutePosition> &NewFootAbsPos,
@@ -2241,6 +2427,10 @@ void AnalyticalMorisawaCompact::FillQueues(
       m_AbsoluteTimeReference, lIndexInterval);
   lPrevIndexInterval = lIndexInterval;
 
+  /*! The CoM is sampled on a regular grid. */
+  m_AnalyticalZMPCoGTrajectoryX->SetSamplingPeriod(samplingPeriod);
+  m_AnalyticalZMPCoGTrajectoryY->SetSamplingPeriod(samplingPeriod);
+
   /*! Fill in the stacks: minimal strategy only 1 reference. */
   for (double t = StartingTime; t <= EndTime; t += samplingPeriod) {
     m_AnalyticalZMPCoGTrajectoryX->GetIntervalIndexFromTime(t, lIndexInterval,
@@ -81,6 +81,23 @@ typedef struct {
   double ZMPSpeedInit, ZMPSpeedNew;
 } FluctuationParameters;
 
+/*!     @ingroup analyticalformulation
+  This structure stores the sensitivities of the polynomial weights
+  with respect to the duration of each interval. It is used to adapt
+  on-line the step timing without solving again the linear system. */
+typedef struct {
+  /*! Durations of the intervals for which the sensitivities
+    were computed. */
+  std::vector<double> DeltaTj;
+
+  /*! Weights solution of the linear system for DeltaTj. */
+  Eigen::VectorXd y;
+
+  /*! Derivatives of the weights with respect to each
+    \f$ \Delta T_j \f$, one column per interval. */
+  Eigen::MatrixXd dYdT;
+} TimingSensitivities;
+
 /*! \brief Class to compute analytically in a compact
   form the trajectories of both the ZMP and the CoM.
   @ingroup analyticalformulation
@@ -332,6 +349,52 @@ public:
                                               bool InitializeaAZCT);
   /*! @} */
 
+  /*! \name Methods for the on-line adaptation of the step timing
+    These methods are a standalone API: they are not used by
+    ChangeFootLandingPosition, whose time compensation also shifts the
+    intervals, the ZMP profile and the initial conditions, and which
+    therefore solves again the whole system.
+    @{ */
+
+  /*! \brief Compute the sensitivities of the polynomial weights
+    with respect to the duration of each interval.
+    The derivative of the weights \f$ y \f$ w.r.t. \f$ \Delta T_j \f$ is
+    obtained from the analytical derivatives of \f$ Z \f$ and \f$ w \f$:
+    \f$ \frac{\partial y}{\partial \Delta T_j} = Z^{-1}
+    (\frac{\partial w}{\partial \Delta T_j} -
+    \frac{\partial Z}{\partial \Delta T_j} y) \f$.
+    The LU decomposition of \f$ Z \f$ is kept for the Newton refinement
+    performed in AdaptStepTiming.
+    This method assumes that the intermediate polynomials of aAZCT
+    have been built for the current intervals.
+    @param[in] aCTIP: The trajectory parameters along one axis.
+    @param[in] aAZCT: The analytical trajectory along the same axis.
+    @param[out] aTS: The sensitivities.
+  */
+  void ComputeTimingSensitivities(CompactTrajectoryInstanceParameters &aCTIP,
+                                  AnalyticalZMPCOGTrajectory &aAZCT,
+                                  TimingSensitivities &aTS);
+
+  /*! \brief Change the duration of the intervals and update the
+    trajectory with a first order approximation of the weights.
+    The approximation can be refined by NbOfNewtonIterations chord-Newton
+    iterations using the LU decomposition computed by
+    ComputeTimingSensitivities. Each iteration costs one back-substitution,
+    the Z matrix is never factorized again.
+    @param[in] NewDeltaTj: The new duration of the intervals.
+    @param[in] aCTIP: The trajectory parameters along one axis.
+    @param[out] aAZCT: The analytical trajectory to be updated.
+    @param[in] aTS: The sensitivities computed for aCTIP and aAZCT.
+    @param[in] NbOfNewtonIterations: Number of refinement iterations.
+    @return The norm of the residual \f$ w - Z y \f$ for the new timing.
+  */
+  double AdaptStepTiming(std::vector<double> &NewDeltaTj,
+                         CompactTrajectoryInstanceParameters &aCTIP,
+                         AnalyticalZMPCOGTrajectory &aAZCT,
+                         TimingSensitivities &aTS,
+                         unsigned int NbOfNewtonIterations = 0);
+  /*! @} */
+
   /*! \brief Initialize automatically Polynomial degrees,
     and temporal intervals.
     @return True if succeedeed, false otherwise.
@@ -507,6 +570,37 @@ protected:
   double TimeCompensationForZMPFluctuation(
       FluctuationParameters &aFluctuationParameters, double DeltaTInit);
 
+  /*! \brief Compute \f$ \frac{\partial Z}{\partial \Delta T_j} y \f$
+    without building the derivative of the Z matrix.
+    @param IntervalIndex: Index j of the interval.
+    @param y: The weights.
+    @param dZy: The result. */
+  void ComputeZDerivativeTimesWeights(unsigned int IntervalIndex,
+                                      const Eigen::VectorXd &y,
+                                      Eigen::VectorXd &dZy);
+
+  /*! \brief Compute \f$ \frac{\partial w}{\partial \Delta T_j} \f$.
+    Only the third order polynomials of the intermediate intervals
+    depend on the duration of the intervals.
+    @param IntervalIndex: Index j of the interval.
+    @param aAZCT: The analytical trajectory storing the polynomials.
+    @param dw: The result. */
+  void ComputeWDerivative(unsigned int IntervalIndex,
+                          AnalyticalZMPCOGTrajectory &aAZCT,
+                          Eigen::VectorXd &dw);
+
+  /*! \brief Derivatives w.r.t. the interval duration of the value and
+    the speed at the end of an intermediate third order CoG polynomial
+    whose ZMP boundary values are fixed.
+    @param IntervalIndex: Index of the intermediate interval.
+    @param aAZCT: The analytical trajectory storing the polynomials.
+    @param dCoeffs: Derivatives of the coefficients.
+    @param dEndPos: Derivative of the final position.
+    @param dEndSpeed: Derivative of the final speed. */
+  void ComputeIntermediatePolynomialTimeDerivative(
+      unsigned int IntervalIndex, AnalyticalZMPCOGTrajectory &aAZCT,
+      std::vector<double> &dCoeffs, double &dEndPos, double &dEndSpeed);
+
   /*! @} */
 
   /*! \name Internal Methods to generate steps and create the associated
@@ -625,10 +719,18 @@ protected:
     precomputed Z matrix LU decomposition */
   bool m_NeedToReset;
 
+  /*! \brief LU decomposition of the Z matrix used by the on-line
+    adaptation of the step timing. */
+  Eigen::PartialPivLU<Eigen::MatrixXd> m_TimingZLU;
+
   /*! \brief Pointer to the preview control object used to
     filter out the orthogonal direction . */
   PreviewControl *m_PreviewControl;
 
+  /*! \brief Persistent cache of the gains of m_PreviewControl,
+    shared by the two filters. */
+  PreviewControlGainsCache *m_PreviewControlGainsCache;
+
   /*! \name Object to handle trajectories.
     @{
   */
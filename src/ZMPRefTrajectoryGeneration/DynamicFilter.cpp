@@ -33,8 +33,8 @@ DynamicFilter::DynamicFilter(SimplePluginManager *SPM, PinocchioRobot *aPR)
   aCoMState_.resize(6);
   aCoMSpeed_.resize(6);
   aCoMAcc_.resize(6);
-  aLeftFootPosition_.resize(5);
-  aRightFootPosition_.resize(5);
+  aLeftFootPosition_.resize(15);
+  aRightFootPosition_.resize(15);
   deltax_.resize(3, 1);
   deltay_.resize(3, 1);
 
@@ -136,8 +136,8 @@ void DynamicFilter::init(double controlPeriod, double interpolationPeriod,
   aCoMState_.resize(6);
   aCoMSpeed_.resize(6);
   aCoMAcc_.resize(6);
-  aLeftFootPosition_.resize(5);
-  aRightFootPosition_.resize(5);
+  aLeftFootPosition_.resize(15);
+  aRightFootPosition_.resize(15);
   deltax_.resize(3, 1);
   deltay_.resize(3, 1);
 
@@ -375,6 +375,30 @@ void DynamicFilter::InverseKinematics(
   aRightFootPosition_(3) = inputRightFoot.theta;
   aRightFootPosition_(4) = inputRightFoot.omega;
 
+  // Velocities and accelerations of the feet, used by the analytical
+  // derivatives of the realization.
+  aLeftFootPosition_(5) = inputLeftFoot.dx;
+  aLeftFootPosition_(6) = inputLeftFoot.dy;
+  aLeftFootPosition_(7) = inputLeftFoot.dz;
+  aLeftFootPosition_(8) = inputLeftFoot.dtheta;
+  aLeftFootPosition_(9) = inputLeftFoot.domega;
+  aLeftFootPosition_(10) = inputLeftFoot.ddx;
+  aLeftFootPosition_(11) = inputLeftFoot.ddy;
+  aLeftFootPosition_(12) = inputLeftFoot.ddz;
+  aLeftFootPosition_(13) = inputLeftFoot.ddtheta;
+  aLeftFootPosition_(14) = inputLeftFoot.ddomega;
+
+  aRightFootPosition_(5) = inputRightFoot.dx;
+  aRightFootPosition_(6) = inputRightFoot.dy;
+  aRightFootPosition_(7) = inputRightFoot.dz;
+  aRightFootPosition_(8) = inputRightFoot.dtheta;
+  aRightFootPosition_(9) = inputRightFoot.domega;
+  aRightFootPosition_(10) = inputRightFoot.ddx;
+  aRightFootPosition_(11) = inputRightFoot.ddy;
+  aRightFootPosition_(12) = inputRightFoot.ddz;
+  aRightFootPosition_(13) = inputRightFoot.ddtheta;
+  aRightFootPosition_(14) = inputRightFoot.ddomega;
+
   /*
     std::cout << "aCoMState_ :" << aCoMState_ << std::endl
     << " aCoMSpeed_ :" << aCoMSpeed_ << std::endl
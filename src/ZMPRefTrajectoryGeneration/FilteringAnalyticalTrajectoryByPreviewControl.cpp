@@ -43,6 +43,7 @@ FilteringAnalyticalTrajectoryByPreviewControl::
 
   m_AnalyticalZMPCOGTrajectory = 0;
   m_PreviewControl = 0;
+  m_GainsCache = 0;
 
   /*! Initialize the state vector used by the preview controller */
   m_ComState.resize(3, 1);
@@ -54,10 +55,11 @@ FilteringAnalyticalTrajectoryByPreviewControl::
 
   m_LocalBufferIndex = 0;
 
-  std::string aMethodName[3] = {":samplingperiod", ":previewcontroltime",
-                                ":singlesupporttime"};
+  std::string aMethodName[5] = {":samplingperiod", ":previewcontroltime",
+                                ":singlesupporttime", ":previewgainscache",
+                                ":invalidatepreviewgainscache"};
 
-  for (int i = 0; i < 3; i++) {
+  for (int i = 0; i < 5; i++) {
     if (!RegisterMethod(aMethodName[i])) {
       std::cerr << "Unable to register " << aMethodName << std::endl;
     } else {
@@ -77,6 +79,8 @@ void FilteringAnalyticalTrajectoryByPreviewControl::SetPreviewControl(
   m_PreviewControl = lPreviewControl;
   m_LocalBufferIndex = 0;
   if (m_PreviewControl != 0) {
+    if (m_GainsCache != 0)
+      m_PreviewControl->SetGainsCache(m_GainsCache);
     m_PreviewControlTime = m_PreviewControl->PreviewControlTime();
     m_SamplingPeriod = m_PreviewControl->SamplingPeriod();
 
@@ -84,6 +88,18 @@ void FilteringAnalyticalTrajectoryByPreviewControl::SetPreviewControl(
   }
 }
 
+void FilteringAnalyticalTrajectoryByPreviewControl::SetGainsCache(
+    PreviewControlGainsCache *aGainsCache) {
+  m_GainsCache = aGainsCache;
+  if (m_PreviewControl != 0)
+    m_PreviewControl->SetGainsCache(m_GainsCache);
+}
+
+void FilteringAnalyticalTrajectoryByPreviewControl::InvalidateGainsCache() {
+  if (m_GainsCache != 0)
+    m_GainsCache->Invalidate();
+}
+
 void FilteringAnalyticalTrajectoryByPreviewControl::Resize() {
 #if 0
   if ((m_SamplingPeriod!=0.0) &&
@@ -211,5 +227,16 @@ void FilteringAnalyticalTrajectoryByPreviewControl::CallMethod(
       strm >> m_Tsingle;
       Resize();
     }
+  } else if (Method == ":previewgainscache") {
+    std::string aFileName;
+    if (strm.good()) {
+      strm >> aFileName;
+      if (m_GainsCache != 0)
+        m_GainsCache->Open(aFileName);
+      else
+        std::cerr << "No cache for the preview control gains." << std::endl;
+    }
+  } else if (Method == ":invalidatepreviewgainscache") {
+    InvalidateGainsCache();
   }
 }
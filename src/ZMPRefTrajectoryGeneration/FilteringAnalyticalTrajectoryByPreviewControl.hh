@@ -49,6 +49,17 @@ public:
   /*! \brief Set PreviewControl */
   void SetPreviewControl(PreviewControl *lPC);
 
+  /*! \brief Set the persistent cache of the preview control gains,
+    it is used each time the optimal weights have to be computed.
+    The cache is not owned by this object.
+    The commands ":previewgainscache filename" and
+    ":invalidatepreviewgainscache" act on this cache. */
+  void SetGainsCache(PreviewControlGainsCache *aGainsCache);
+
+  /*! \brief Remove all the gains stored in the cache.
+    To be called when the robot parameters change. */
+  void InvalidateGainsCache();
+
   /*! \brief Fill in the whole buffer with the analytical trajectory.
     This has to be done if the analytical trajectory has been changed,
     and that the first interval has been changed.
@@ -89,6 +100,9 @@ private:
     filter. */
   PreviewControl *m_PreviewControl;
 
+  /*! \brief Cache of the preview control gains. */
+  PreviewControlGainsCache *m_GainsCache;
+
   /*! \brief State of the CoM */
   Eigen::MatrixXd m_ComState;
 
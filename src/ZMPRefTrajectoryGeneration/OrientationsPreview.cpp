@@ -82,6 +82,12 @@ OrientationsPreview::OrientationsPreview(PinocchioRobot *aPR) {
   TrunkStateYaw_ = new Polynome4(0.0, 0.0);
 
   LastFirstPvwSol_ = 0.0;
+
+  Incremental_ = true;
+  CacheValid_ = false;
+  CachedTrunkYawT_ = 0.0;
+  NbPreviews_ = 0;
+  NbReusedPreviews_ = 0;
 }
 
 OrientationsPreview::~OrientationsPreview() {}
@@ -133,6 +139,49 @@ void OrientationsPreview::preview_orientations(
   int ItBeforeLandingThresh = 3;
   unsigned NbStepsPreviewed = Solution.SupportStates_deq.back().StepNumber;
 
+  preview_key_t Key;
+  Key.RefYaw = Ref.Local.Yaw;
+  Key.StepDuration = StepDuration;
+  Key.SSPeriod = SSPeriod_;
+  Key.N = N_;
+  Key.T = T_;
+  Key.TrunkYaw = TrunkState_.yaw[0];
+  Key.TrunkYawVelocity = TrunkState_.yaw[1];
+  Key.LeftFootAngle = LeftFootPositions_deq[0].theta;
+  Key.RightFootAngle = RightFootPositions_deq[0].theta;
+  Key.LastLeftFootAngle = LeftFoot.theta;
+  Key.LastRightFootAngle = RightFoot.theta;
+  Key.LastLeftFootVelocity = LeftFoot.dtheta;
+  Key.LastRightFootVelocity = RightFoot.dtheta;
+  Key.LastFirstPvwSol = LastFirstPvwSol_;
+  Key.Foot = CurrentSupport.Foot;
+  Key.Phase = CurrentSupport.Phase;
+  Key.KeepLastFirstPvwSol =
+      ItBeforeLanding <= ItBeforeLandingThresh && ItBeforeLanding > 0 &&
+      Solution.SupportStates_deq.front().Phase == SS &&
+      Solution.SupportStates_deq.front().StateChanged != 1 &&
+      NbStepsPreviewed > 0;
+
+  // REUSE THE LAST PREVIEW IF IT DOES NOT DEPEND ON THE TIME:
+  // ---------------------------------------------------------
+  NbPreviews_++;
+  bool Empty = PreviewedSupportAngles_deq.empty() &&
+               PreviewedTrunkOrientations_deq.empty();
+  if (Incremental_ && CacheValid_ && Empty && (Key == CachedKey_)) {
+    NbReusedPreviews_++;
+    if (CurrentSupport.Phase != DS)
+      SupportTimePassed_ = CurrentSupport.TimeLimit - Time;
+    else
+      SupportTimePassed_ = CurrentSupport.TimeLimit + SSPeriod_ - Time;
+    TrunkStateT_.yaw[0] = CachedTrunkYawT_;
+    PreviewedSupportAngles_deq = CachedSupportAngles_deq_;
+    PreviewedTrunkOrientations_deq = CachedTrunkOrientations_deq_;
+    set_support_orientations(Solution);
+    return;
+  }
+
+  // The time is only used to correct the rotation of the trunk.
+  bool TimeInvariant = Empty;
   unsigned StepNumber = 0;
 
   // Trunk angle at the end of the current support phase
@@ -180,6 +229,7 @@ void OrientationsPreview::preview_orientations(
         TrunkAngleOK = verify_angle_hip_joint(
             CurrentSupport, PreviewedTrunkAngleEnd, TrunkState_, TrunkStateT_,
             CurrentSupportAngle, StepNumber);
+        TimeInvariant = TimeInvariant && TrunkAngleOK;
       }
     } else // The trunk does not rotate in the DS phase
     {
@@ -244,13 +294,11 @@ void OrientationsPreview::preview_orientations(
       if (!TrunkAngleOK) {
         PreviewedSupportAngles_deq.clear();
         TrunkVelOK = false;
+        TimeInvariant = false;
         break;
       } else {
 
-        if (ItBeforeLanding <= ItBeforeLandingThresh && ItBeforeLanding > 0 &&
-            Solution.SupportStates_deq.front().Phase == SS &&
-            Solution.SupportStates_deq.front().StateChanged != 1 &&
-            NbStepsPreviewed > 0 &&
+        if (Key.KeepLastFirstPvwSol &&
             StepNumber == (unsigned)FirstFootPreviewed) {
           PreviewedSupportAngles_deq.push_back(LastFirstPvwSol_);
         }
@@ -274,12 +322,30 @@ void OrientationsPreview::preview_orientations(
   // ---------------------------------------
   PreviewedTrunkOrientations_deq.push_back(TrunkState_.yaw[0]);
   PreviewedTrunkOrientations_deq.push_back(TrunkStateT_.yaw[0]);
-  unsigned j = 0;
   for (unsigned i = 1; i < N_; i++) {
     PreviewedTrunkOrientations_deq.push_back(TrunkStateT_.yaw[0] +
                                              TrunkStateT_.yaw[1] * T_);
   }
 
+  // Without rotation of the trunk the preview is kept for the next ones.
+  if (Incremental_) {
+    CacheValid_ = TimeInvariant && (TrunkState_.yaw[1] == 0.0) &&
+                  (TrunkStateT_.yaw[1] == 0.0);
+    if (CacheValid_) {
+      CachedKey_ = Key;
+      CachedTrunkYawT_ = TrunkStateT_.yaw[0];
+      CachedSupportAngles_deq_ = PreviewedSupportAngles_deq;
+      CachedTrunkOrientations_deq_ = PreviewedTrunkOrientations_deq;
+    }
+  }
+
+  set_support_orientations(Solution);
+}
+
+void OrientationsPreview::set_support_orientations(solution_t &Solution) {
+  const std::deque<double> &PreviewedSupportAngles_deq =
+      Solution.SupportOrientations_deq;
+  unsigned j = 0;
   std::deque<support_state_t>::iterator prwSS_it =
       Solution.SupportStates_deq.begin();
   double supportAngle = prwSS_it->Yaw;
@@ -469,6 +535,23 @@ void OrientationsPreview::one_iteration(
   }
 }
 
+bool OrientationsPreview::preview_key_t::operator==(
+    const preview_key_t &Key) const {
+  return (RefYaw == Key.RefYaw) && (StepDuration == Key.StepDuration) &&
+         (SSPeriod == Key.SSPeriod) && (N == Key.N) && (T == Key.T) &&
+         (TrunkYaw == Key.TrunkYaw) &&
+         (TrunkYawVelocity == Key.TrunkYawVelocity) &&
+         (LeftFootAngle == Key.LeftFootAngle) &&
+         (RightFootAngle == Key.RightFootAngle) &&
+         (LastLeftFootAngle == Key.LastLeftFootAngle) &&
+         (LastRightFootAngle == Key.LastRightFootAngle) &&
+         (LastLeftFootVelocity == Key.LastLeftFootVelocity) &&
+         (LastRightFootVelocity == Key.LastRightFootVelocity) &&
+         (LastFirstPvwSol == Key.LastFirstPvwSol) && (Foot == Key.Foot) &&
+         (Phase == Key.Phase) &&
+         (KeepLastFirstPvwSol == Key.KeepLastFirstPvwSol);
+}
+
 double OrientationsPreview::f(double a, double b, double c, double d,
                               double x) {
   return a + b * x + c * x * x + d * x * x * x;
@@ -118,6 +118,46 @@ public:
   };
   /// \}
 
+  /// \name Incremental preview
+  /// As long as the trunk does not rotate, the orientations of the feet
+  /// and the trunk do not depend on the time. The last preview is then
+  /// reused when its inputs are unchanged and only the orientations of
+  /// the previewed supports are shifted.
+  /// \{
+  inline bool Incremental() const { return Incremental_; };
+  inline void Incremental(bool Incremental) {
+    Incremental_ = Incremental;
+    CacheValid_ = false;
+  };
+  /// \brief Number of previews and of reused ones
+  inline unsigned long NbPreviews() const { return NbPreviews_; };
+  inline unsigned long NbReusedPreviews() const { return NbReusedPreviews_; };
+  inline double HitRate() const {
+    return (NbPreviews_ > 0) ? (double)NbReusedPreviews_ / (double)NbPreviews_
+                             : 0.0;
+  };
+  /// \}
+
+  //
+  // Private types:
+  //
+private:
+  /// \brief Inputs of a preview, except the time
+  struct preview_key_t {
+    double RefYaw, StepDuration, SSPeriod, N, T;
+    double TrunkYaw, TrunkYawVelocity;
+    double LeftFootAngle, RightFootAngle;
+    double LastLeftFootAngle, LastRightFootAngle;
+    double LastLeftFootVelocity, LastRightFootVelocity;
+    double LastFirstPvwSol;
+    foot_type_e Foot;
+    PhaseType Phase;
+    /// \brief True if the last first previewed support angle is kept
+    bool KeepLastFirstPvwSol;
+
+    bool operator==(const preview_key_t &Key) const;
+  };
+
   //
   // Private methods:
   //
@@ -172,6 +212,12 @@ private:
                               double CurrentSupportFootAngle,
                               unsigned StepNumber);
 
+  /// \brief Set the orientations of the previewed supports
+  /// from the previewed support angles
+  ///
+  /// \param[in,out] Solution
+  void set_support_orientations(solution_t &Solution);
+
   /// \brief Fourth order polynomial trajectory
   /// \param[in] abcd Parameters
   /// \param[in] x
@@ -230,6 +276,18 @@ private:
   COMState TrunkStateT_;
 
   Polynome4 *TrunkStateYaw_;
+
+  /// \name Incremental preview
+  /// \{
+  bool Incremental_;
+  /// \brief True if the last preview did not depend on the time
+  bool CacheValid_;
+  preview_key_t CachedKey_;
+  std::deque<double> CachedSupportAngles_deq_;
+  std::deque<double> CachedTrunkOrientations_deq_;
+  double CachedTrunkYawT_;
+  unsigned long NbPreviews_, NbReusedPreviews_;
+  /// \}
 };
 } // namespace PatternGeneratorJRL
 #endif /* ORIENTATIONSPREVIEW_H_ */
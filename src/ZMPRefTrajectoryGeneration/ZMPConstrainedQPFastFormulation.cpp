@@ -37,7 +37,8 @@
 #include <fstream>
 #include <iostream>
 
-#include <Mathematics/qld.hh>
+#include <math.h>
+
 #include <ZMPRefTrajectoryGeneration/ZMPConstrainedQPFastFormulation.hh>
 
 #include <Debug.hh>
@@ -51,6 +52,11 @@ ZMPConstrainedQPFastFormulation::ZMPConstrainedQPFastFormulation(
   m_Pu = 0;
   m_FullDebug = 0;
   m_FastFormulationMode = PLDP;
+  m_RollingDPu = 0;
+  m_RollingNbOfConstraints = 0;
+  m_ExplicitMPCMode = EXPLICIT_MPC_OFF;
+  m_ModelPatternKey = 0;
+  m_ConstraintPatternKey = 0;
 
   /*! Getting the ZMP reference from Kajita's heuristic. */
   m_ZMPD = new ZMPDiscretization(lSPM, DataFile, aPR);
@@ -62,9 +68,9 @@ ZMPConstrainedQPFastFormulation::ZMPConstrainedQPFastFormulation(
   m_FCALS = new FootConstraintsAsLinearSystem(lSPM, aPR);
 
   // Register method to handle
-  string aMethodName[1] = {":setdimitrovconstraint"};
+  string aMethodName[2] = {":setdimitrovconstraint", ":explicitmpc"};
 
-  for (int i = 0; i < 1; i++) {
+  for (int i = 0; i < 2; i++) {
     if (!RegisterMethod(aMethodName[i])) {
       std::cerr << "Unable to register " << aMethodName << std::endl;
     }
@@ -135,6 +141,12 @@ ZMPConstrainedQPFastFormulation::~ZMPConstrainedQPFastFormulation() {
     delete[] m_Pu;
 }
 
+void ZMPConstrainedQPFastFormulation::SetPLDPSolverMonitor(
+    Optimization::Solver::PLDPSolverMonitor *aMonitor) {
+  if (m_PLDPSolver != 0)
+    m_PLDPSolver->SetMonitor(aMonitor);
+}
+
 void ZMPConstrainedQPFastFormulation::SetPreviewControl(PreviewControl *) {
   // m_ZMPD->SetPreviewControl(aPC);
 }
@@ -238,6 +250,38 @@ int ZMPConstrainedQPFastFormulation::InitializeMatrixPbConstants() {
   return 0;
 }
 
+int ZMPConstrainedQPFastFormulation::ValidationRollingConstraints(
+    double *DPu, unsigned int N, double StartingTime, double T,
+    deque<LinearConstraintInequality_t *> &QueueOfLConstraintInequalities,
+    unsigned int NbOfConstraints) {
+  deque<LinearConstraintInequality_t *>::iterator LCI_it =
+      QueueOfLConstraintInequalities.begin();
+  while ((LCI_it != QueueOfLConstraintInequalities.end()) &&
+         (StartingTime > (*LCI_it)->EndingTime))
+    LCI_it++;
+
+  unsigned int IndexConstraint = 0;
+  for (unsigned int i = 0; i < N; i++) {
+    if (StartingTime + i * T > (*LCI_it)->EndingTime)
+      LCI_it++;
+    for (unsigned j = 0; j < (*LCI_it)->A.rows(); j++) {
+      for (unsigned k = 0; k < N; k++) {
+        double ldx = DPu[IndexConstraint + k * (NbOfConstraints + 1)] -
+                     (*LCI_it)->A(j, 0) * m_Pu[k * N + i];
+        double ldy = DPu[IndexConstraint + (k + N) * (NbOfConstraints + 1)] -
+                     (*LCI_it)->A(j, 1) * m_Pu[k * N + i];
+        if ((fabs(ldx) > 1e-12) || (fabs(ldy) > 1e-12)) {
+          cerr << "Rolling constraint " << IndexConstraint << " differs."
+               << endl;
+          return -1;
+        }
+      }
+      IndexConstraint++;
+    }
+  }
+  return 0;
+}
+
 int ZMPConstrainedQPFastFormulation::ValidationConstraints(
     double *&DPx, double *&DPu, int NbOfConstraints,
     deque<LinearConstraintInequality_t *> &QueueOfLConstraintInequalities,
@@ -603,6 +647,10 @@ int ZMPConstrainedQPFastFormulation::
     }
   }
 
+  // The key of Pu is only needed by the explicit MPC.
+  if (m_ExplicitMPCMode != EXPLICIT_MPC_OFF)
+    ComputeModelPatternKey();
+
   if (m_FullDebug > 0) {
     ofstream aof;
     char Buffer[1024];
@@ -638,6 +686,20 @@ int ZMPConstrainedQPFastFormulation::
   return 0;
 }
 
+void ZMPConstrainedQPFastFormulation::ComputeModelPatternKey() {
+  // DPu is built from Pu, the explicit MPC keys its patterns on it.
+  double lModel[3] = {(double)m_QP_N, m_QP_T, m_ComHeight};
+  m_ModelPatternKey = 0;
+  ExplicitMPCTable::HashPattern(m_ModelPatternKey, lModel, 3);
+  ExplicitMPCTable::HashPattern(m_ModelPatternKey, m_Pu, m_QP_N * m_QP_N);
+}
+
+void ZMPConstrainedQPFastFormulation::SetExplicitMPCMode(unsigned int aMode) {
+  if ((m_ExplicitMPCMode == EXPLICIT_MPC_OFF) && (aMode != EXPLICIT_MPC_OFF))
+    ComputeModelPatternKey();
+  m_ExplicitMPCMode = aMode;
+}
+
 int ZMPConstrainedQPFastFormulation::InitConstants() {
   int r;
   if ((r = InitializeMatrixPbConstants()) < 0)
@@ -687,8 +749,6 @@ int ZMPConstrainedQPFastFormulation::BuildConstraintMatrices(
   if (DPu == 0)
     DPu = new double[(8 * N + 1) * 2 * N];
 
-  memset(DPu, 0, (8 * N + 1) * 2 * N * sizeof(double));
-
   deque<LinearConstraintInequality_t *>::iterator LCI_it, store_it;
   LCI_it = QueueOfLConstraintInequalities.begin();
   while (LCI_it != QueueOfLConstraintInequalities.end()) {
@@ -735,6 +795,20 @@ int ZMPConstrainedQPFastFormulation::BuildConstraintMatrices(
   }
   NbOfConstraints = IndexConstraint;
 
+  // The rows of a sample are kept from the previous tick if they
+  // are at the same place in DPu and built from the same constraints.
+  bool RollingBufferValid =
+      (m_FastFormulationMode == PLDP) && (m_RollingDPu == DPu) &&
+      (m_RollingNbOfConstraints == NbOfConstraints) &&
+      (m_RollingConstraints.size() == N);
+  if (!RollingBufferValid) {
+    memset(DPu, 0, (8 * N + 1) * 2 * N * sizeof(double));
+    m_RollingConstraints.assign(N, (LinearConstraintInequality_t *)0);
+    m_RollingFirstRow.assign(N, 0);
+  }
+  m_RollingDPu = DPu;
+  m_RollingNbOfConstraints = NbOfConstraints;
+
   Eigen::MatrixXd lD;
   lD.resize(NbOfConstraints, 2 * N);
 
@@ -747,6 +821,7 @@ int ZMPConstrainedQPFastFormulation::BuildConstraintMatrices(
   NextNumberOfRemovedConstraints = (unsigned int)((*LCI_it)->A.rows());
 
   IndexConstraint = 0;
+  m_ConstraintPatternKey = m_ModelPatternKey;
   ODEBUG("Starting Matrix to build the constraints. ");
   ODEBUG((*LCI_it)->A);
   for (unsigned int i = 0; i < N; i++) {
@@ -758,6 +833,22 @@ int ZMPConstrainedQPFastFormulation::BuildConstraintMatrices(
     ZMPRef[i] = (*LCI_it)->Center(0);
     ZMPRef[i + N] = (*LCI_it)->Center(1);
 
+    // DPu only depends on Pu and on the sequence of the constraints
+    // matrices.
+    if (m_ExplicitMPCMode != EXPLICIT_MPC_OFF) {
+      double lNbOfRows = (double)(*LCI_it)->A.rows();
+      ExplicitMPCTable::HashPattern(m_ConstraintPatternKey, &lNbOfRows, 1);
+      ExplicitMPCTable::HashPattern(m_ConstraintPatternKey,
+                                    (*LCI_it)->A.data(),
+                                    (unsigned int)(*LCI_it)->A.size());
+    }
+
+    bool ReuseRows = RollingBufferValid &&
+                     (m_RollingConstraints[i] == *LCI_it) &&
+                     (m_RollingFirstRow[i] == IndexConstraint);
+    m_RollingConstraints[i] = *LCI_it;
+    m_RollingFirstRow[i] = IndexConstraint;
+
     // For each constraint.
     for (unsigned j = 0; j < (*LCI_it)->A.rows(); j++) {
 
@@ -785,7 +876,9 @@ int ZMPConstrainedQPFastFormulation::BuildConstraintMatrices(
 
       m_SimilarConstraints[IndexConstraint] = (*LCI_it)->SimilarConstraints[j];
 
-      if (m_FastFormulationMode == QLD) {
+      if (ReuseRows) {
+        // DPu rows only depend on the constraint and on i.
+      } else if (m_FastFormulationMode == QLD) {
         // In this case, Pu is triangular.
         // so we can speed up the computation.
         for (unsigned k = 0; k <= i; k++) {
@@ -814,6 +907,15 @@ int ZMPConstrainedQPFastFormulation::BuildConstraintMatrices(
   }
 
   ODEBUG6("Index Constraint :" << IndexConstraint, Buffer);
+
+  if ((m_FullDebug > 0) && (RollingBufferValid)) {
+    if (ValidationRollingConstraints(DPu, N, StartingTime, T,
+                                     QueueOfLConstraintInequalities,
+                                     NbOfConstraints) < 0)
+      cerr << "The rolling constraint buffer differs from the full rebuild"
+           << " at time " << StartingTime << endl;
+  }
+
   static double localtime = -m_QP_T;
   localtime += m_QP_T;
 
@@ -984,29 +1086,20 @@ int ZMPConstrainedQPFastFormulation::BuildZMPTrajectoryFromFootTrajectory(
   ZMPRef.resize(2 * N);
 
   int m = NbOfConstraints;
-  int me = 0;
-  int mmax = NbOfConstraints + 1;
   int n = 2 * N;
   int nmax = 2 * N; // Size of the matrix to compute the cost function.
-  int mnn = m + n + n;
 
   double *D = new double[2 * N];    // Constant part of the objective function
-  double *XL = new double[2 * N];   // Lower bound of the jerk.
-  double *XU = new double[2 * N];   // Upper bound of the jerk.
   double *X = new double[2 * N];    // Solution of the system.
   double *NewX = new double[2 * N]; // Solution of the system.
-  double Eps = 1e-8;
-  double *U = (double *)malloc(sizeof(double) *
-                               mnn); // Returns the Lagrange multipliers.;
-
-  int iout = 0;
   int ifail;
-  int iprint = 1;
-  int lwar = 3 * nmax * nmax / 2 + 10 * nmax + 2 * mmax + 20000;
-  ;
-  double *war = (double *)malloc(sizeof(double) * lwar);
-  int liwar = n;              //
-  int *iwar = new int[liwar]; // The Cholesky decomposition is done internally.
+
+  // The workspace of QLD is only allocated for a longer preview window.
+  m_QLDSolver.Reserve(NbOfConstraints, 2 * N);
+  m_QLDSolver.SetPrintLevel(1);
+  m_QLDSolver.SetEps(1e-8);
+  // In the LQ formulation the Cholesky decomposition is done internally.
+  m_QLDSolver.SetUserFactorization(m_FastFormulationMode != QLDANDLQ);
 
   deque<LinearConstraintInequality_t *> QueueOfLConstraintInequalities;
 
@@ -1047,6 +1140,8 @@ int ZMPConstrainedQPFastFormulation::BuildZMPTrajectoryFromFootTrajectory(
                 << " T: " << T << " N: " << N << " interval " << interval);
   unsigned int NumberOfRemovedConstraints = 0,
                NextNumberOfRemovedConstraints = 0;
+  // The constraints of a previous trajectory may have been deleted.
+  m_RollingDPu = 0;
   for (double StartingTime = 0.0;
        StartingTime < QueueOfLConstraintInequalities.back()->EndingTime - N * T;
        StartingTime += T, li++) {
@@ -1074,10 +1169,6 @@ int ZMPConstrainedQPFastFormulation::BuildZMPTrajectoryFromFootTrajectory(
 
     m = NbOfConstraints;
 
-    mmax = NbOfConstraints + 1;
-    lwar = 3 * nmax * nmax / 2 + 10 * nmax + 2 * mmax + 20000;
-    mnn = m + n + n;
-
     // Call to QLD (a linearly constrained quadratic problem solver)
 
     // Prepare D.
@@ -1120,36 +1211,39 @@ int ZMPConstrainedQPFastFormulation::BuildZMPTrajectoryFromFootTrajectory(
         D[i] = 0.0;
     }
 
-    for (unsigned int i = 0; i < 2 * N; i++) {
-      XL[i] = -1e8;
-      XU[i] = 1e8;
-    }
     memset(X, 0, 2 * N * sizeof(double));
 
-    if (m_FastFormulationMode == QLDANDLQ)
-      iwar[0] = 0;
-    else
-      iwar[0] = 1;
-
     ODEBUG("m: " << m);
     //      DumpProblem(m_Q, D, DPu, m, DPx,XL,XU,StartingTime);
 
-    if ((m_FastFormulationMode == QLDANDLQ) || (m_FastFormulationMode == QLD)) {
+    // The explicit MPC evaluates the law of the critical region
+    // instead of calling the solver. Its hessian is the identity,
+    // so it only handles the LQ formulations.
+    bool SolvedByExplicitMPC = false;
+    if ((m_ExplicitMPCMode == EXPLICIT_MPC_LOOKUP) &&
+        (m_FastFormulationMode != QLD)) {
+      SolvedByExplicitMPC = m_ExplicitMPCTable.Solve(
+          m_ConstraintPatternKey, DPu, DPx, m, n, D, X);
+      if ((SolvedByExplicitMPC) && (m_FastFormulationMode == PLDP)) {
+        // The hot start of the PLDP solver has no previous solution.
+        StartingSequence = true;
+        NumberOfRemovedConstraints = NextNumberOfRemovedConstraints;
+      }
+    }
+
+    if (SolvedByExplicitMPC) {
+      ifail = 0;
+    } else if ((m_FastFormulationMode == QLDANDLQ) ||
+               (m_FastFormulationMode == QLD)) {
       struct timeval lbegin, lend;
       gettimeofday(&lbegin, 0);
-      ql0001_(&m, &me, &mmax, &n, &nmax, &mnn, m_Q, D, DPu, DPx, XL, XU, X, U,
-              &iout, &ifail, &iprint, war, &lwar, iwar, &liwar, &Eps);
+      // The bounds of the jerk are the default ones of the solver.
+      ifail = m_QLDSolver.Solve(m, 0, n, m_Q, nmax, D, DPu, m + 1, DPx, X);
       gettimeofday(&lend, 0);
       CODEDEBUG6(double ldt = lend.tv_sec - lbegin.tv_sec +
                               0.000001 * (lend.tv_usec - lbegin.tv_usec););
 
-      unsigned int NbOfActivatedConstraints = 0;
-      for (int lk = 0; lk < m; lk++) {
-        if (U[lk] > 0.0) {
-          NbOfActivatedConstraints++;
-        }
-      }
-      ODEBUG6(NbOfActivatedConstraints, "InfosQLD.dat");
+      ODEBUG6(m_QLDSolver.NbOfActiveLinearConstraints(), "InfosQLD.dat");
       ODEBUG6(ldt, "dtQLD.dat");
     } else if (m_FastFormulationMode == PLDP) {
       ODEBUG("State: " << xk[0] << " " << xk[3] << " " << xk[1] << " " << xk[4]
@@ -1174,6 +1268,10 @@ int ZMPConstrainedQPFastFormulation::BuildZMPTrajectoryFromFootTrajectory(
       return -1;
     }
 
+    if ((m_ExplicitMPCMode == EXPLICIT_MPC_RECORD) &&
+        (m_FastFormulationMode != QLD))
+      m_ExplicitMPCTable.Learn(m_ConstraintPatternKey, DPu, DPx, m, n, D, X);
+
     double *ptX = 0;
     if ((m_FastFormulationMode == QLDANDLQ) ||
         (m_FastFormulationMode == PLDP)) {
@@ -1216,7 +1314,7 @@ int ZMPConstrainedQPFastFormulation::BuildZMPTrajectoryFromFootTrajectory(
     ODEBUG6("xk:" << xk, "DebugPBW.dat");
 
     /* Constraint validation */
-    if (0) {
+    if (m_FullDebug > 1) {
       if (ValidationConstraints(DPx, DPu, m, QueueOfLConstraintInequalities, li,
                                 X, StartingTime) < 0) {
         cout << "Something is wrong with the constraints." << endl;
@@ -1251,12 +1349,8 @@ int ZMPConstrainedQPFastFormulation::BuildZMPTrajectoryFromFootTrajectory(
   /*  cout << "Size of PX: " << vnlStorePx.rows() << " "
       << vnlStorePx.cols() << " " << endl; */
   delete[] D;
-  delete[] XL;
-  delete[] XU;
   delete[] X;
-  free(war);
-  free(U);
-  delete[] iwar;
+  delete[] NewX;
   // Clean the queue of Linear Constraint Inequalities.
   //  deque<LinearConstraintInequality_t *>::iterator LCI_it;
   LCI_it = QueueOfLConstraintInequalities.begin();
@@ -1319,7 +1413,46 @@ void ZMPConstrainedQPFastFormulation::CallMethod(std::string &Method,
     } else if (PBWCmd == "N") {
       strm >> m_QP_N;
       cout << "Preview window for the QP " << m_QP_N << endl;
+    } else if ((PBWCmd == "TIME") && (m_PLDPSolver != 0)) {
+      // A non positive amount of time removes the limit.
+      double lBudget = 0.0;
+      strm >> lBudget;
+      if (lBudget > 0.0)
+        m_PLDPSolver->SetLimitedComputationTime(true, lBudget);
+      else
+        m_PLDPSolver->SetLimitedComputationTime(
+            false, m_PLDPSolver->GetAmountOfLimitedComputationTime());
+      cout << "Computation time for the QP " << lBudget << endl;
+    } else if ((PBWCmd == "HOTSTART") && (m_PLDPSolver != 0)) {
+      bool lHotStart = true;
+      strm >> lHotStart;
+      m_PLDPSolver->SetHotStart(lHotStart);
+      cout << "Hot start for the QP " << lHotStart << endl;
+    }
+  } else if (Method == ":explicitmpc") {
+    string lCmd;
+    strm >> lCmd;
+    if (lCmd == "off")
+      SetExplicitMPCMode(EXPLICIT_MPC_OFF);
+    else if (lCmd == "record")
+      SetExplicitMPCMode(EXPLICIT_MPC_RECORD);
+    else if (lCmd == "lookup")
+      SetExplicitMPCMode(EXPLICIT_MPC_LOOKUP);
+    else if (lCmd == "clear")
+      m_ExplicitMPCTable.Clear();
+    else if (lCmd == "save") {
+      string lFileName;
+      strm >> lFileName;
+      m_ExplicitMPCTable.Save(lFileName);
+    } else if (lCmd == "load") {
+      string lFileName;
+      strm >> lFileName;
+      if (m_ExplicitMPCTable.Load(lFileName))
+        SetExplicitMPCMode(EXPLICIT_MPC_LOOKUP);
     }
+    cout << "Explicit MPC: " << m_ExplicitMPCTable.NbOfRegions()
+         << " regions in " << m_ExplicitMPCTable.NbOfPatterns()
+         << " patterns." << endl;
   }
 
   ZMPRefTrajectoryGeneration::CallMethod(Method, strm);
@@ -30,7 +30,9 @@
 
 #include <Mathematics/FootConstraintsAsLinearSystem.hh>
 #include <Mathematics/OptCholesky.hh>
+#include <Mathematics/ExplicitMPCTable.hh>
 #include <Mathematics/PLDPSolver.hh>
+#include <Mathematics/QLDSolver.hh>
 #include <PreviewControl/LinearizedInvertedPendulum2D.hh>
 #include <ZMPRefTrajectoryGeneration/ZMPRefTrajectoryGeneration.hh>
 
@@ -140,6 +142,13 @@ public:
   */
   int InitConstants();
 
+  /*! \brief Switch the explicit MPC mode, the key of the model is
+    computed when the mode leaves EXPLICIT_MPC_OFF. */
+  void SetExplicitMPCMode(unsigned int aMode);
+
+  /*! \brief Compute m_ModelPatternKey from the model and Pu. */
+  void ComputeModelPatternKey();
+
   /*! Build the necessary matrices for the QP problem under
     linear inequality constraints. */
   int BuildConstraintMatrices(
@@ -148,6 +157,13 @@ public:
       double Com_Height, unsigned int &NbOfConstraints, Eigen::VectorXd &xk,
       Eigen::VectorXd &ZMPRef, unsigned int &NextNumberOfRemovedConstraints);
 
+  /*! \brief Check the rows of DPu kept from the previous tick
+    against a full rebuild. */
+  int ValidationRollingConstraints(
+      double *DPu, unsigned int N, double StartingTime, double T,
+      deque<LinearConstraintInequality_t *> &QueueOfLConstraintInequalities,
+      unsigned int NbOfConstraints);
+
   /*! \brief Build the constant part of the constraint matrices. */
   int BuildingConstantPartOfConstraintMatrices();
 
@@ -256,10 +272,23 @@ public:
   /*! Set the preview control object. */
   void SetPreviewControl(PreviewControl *aPC);
 
+  /*! \brief Specify the object notified after each tick of the
+    PLDP solver (iterations and suboptimality). */
+  void SetPLDPSolverMonitor(Optimization::Solver::PLDPSolverMonitor *aMonitor);
+
   static const unsigned int QLD = 0;
   static const unsigned int QLDANDLQ = 1;
   static const unsigned int PLDP = 2;
 
+  /*! \name Modes of the explicit MPC
+    @{ */
+  static const unsigned int EXPLICIT_MPC_OFF = 0;
+  /*! The regions of the solutions of the solver are stored. */
+  static const unsigned int EXPLICIT_MPC_RECORD = 1;
+  /*! The table is used first, the solver is called on a miss. */
+  static const unsigned int EXPLICIT_MPC_LOOKUP = 2;
+  /*! @} */
+
 private:
   /*! Uses a ZMPDiscretization scheme to get the usual Kajita heuristic. */
   ZMPDiscretization *m_ZMPD;
@@ -342,6 +371,44 @@ private:
   /*! Primal Least square Distance Problem solver */
   Optimization::Solver::PLDPSolver *m_PLDPSolver;
 
+  /*! QLD solver with a workspace sized for the preview window. */
+  QLDSolver m_QLDSolver;
+
+  /*! \name Explicit MPC
+    @{ */
+  /*! \brief Table of the critical regions. */
+  ExplicitMPCTable m_ExplicitMPCTable;
+
+  /*! \brief Mode of the explicit MPC. */
+  unsigned int m_ExplicitMPCMode;
+
+  /*! \brief Key of Pu, which holds the horizon, the sampling period,
+    the height of the CoM and the weights of the LQ formulations. */
+  unsigned long long m_ModelPatternKey;
+
+  /*! \brief Key of the constraints over the current preview window,
+    starting from m_ModelPatternKey. */
+  unsigned long long m_ConstraintPatternKey;
+  /*! @} */
+
+  /*! \name Rolling constraint buffer
+    From one tick to the next, the horizon is shifted by one sample:
+    the rows of DPu of a sample are only rebuilt if the constraints
+    of this sample or their place in DPu have changed.
+    @{ */
+  /*! \brief Buffer filled at the previous tick. */
+  double *m_RollingDPu;
+
+  /*! \brief Number of constraints at the previous tick. */
+  unsigned int m_RollingNbOfConstraints;
+
+  /*! \brief Constraints used by each sample at the previous tick. */
+  std::vector<LinearConstraintInequality_t *> m_RollingConstraints;
+
+  /*! \brief First row of each sample at the previous tick. */
+  std::vector<unsigned int> m_RollingFirstRow;
+  /*! @} */
+
   /*! @} */
 
   int DumpProblem(double *Q, double *D, double *Pu,
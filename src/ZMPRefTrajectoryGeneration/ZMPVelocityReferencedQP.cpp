@@ -41,6 +41,7 @@
 
 #include <time.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -67,6 +68,14 @@ double filterprecision(double adb) {
   return lintadb2 / 1e7;
 }
 
+namespace {
+double Now() {
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return (double)t.tv_sec + 1e-6 * (double)t.tv_usec;
+}
+} // namespace
+
 ZMPVelocityReferencedQP::ZMPVelocityReferencedQP(SimplePluginManager *SPM,
                                                  string, PinocchioRobot *aPR)
     : ZMPRefTrajectoryGeneration(SPM), Robot_(0), SupportFSM_(0), OrientPrw_(0),
@@ -96,6 +105,9 @@ ZMPVelocityReferencedQP::ZMPVelocityReferencedQP(SimplePluginManager *SPM,
   UpperTimeLimitToUpdate_ = 0.0;
   RobotMass_ = PR_->mass();
   Solution_.useWarmStart = false;
+  MultiStart_ = false;
+  MultiStartDeadline_ = 0.002;
+  SelectedCandidate_ = NOMINAL_SUPPORT;
 
   CurrentIndex_ = 0;
 
@@ -141,28 +153,22 @@ ZMPVelocityReferencedQP::ZMPVelocityReferencedQP(SimplePluginManager *SPM,
   CoM_.InitializeSystem();
 
   // Create and initialize simplified robot model
-  Robot_ = new RigidBodySystem(SPM, PR_, SupportFSM_);
-  Robot_->Mass(RobotMass_);
-  Robot_->LeftFoot().Mass(0.0);
-  Robot_->RightFoot().Mass(0.0);
-  Robot_->NbSamplingsPreviewed(QP_N_);
-  Robot_->SamplingPeriodSim(QP_T_);
-  Robot_->SamplingPeriodAct(m_SamplingPeriod);
-  Robot_->CoMHeight(CoMHeight_);
-  Robot_->multiBody(false);
-  Robot_->initialize();
-
+  Robot_ = NewRobot(SPM);
   IntermedData_ = new IntermedQPMat();
-
-  VRQPGenerator_ = new GeneratorVelRef(SPM, IntermedData_, Robot_, RFI_);
-  VRQPGenerator_->NbPrwSamplings(QP_N_);
-  VRQPGenerator_->SamplingPeriodPreview(QP_T_);
-  VRQPGenerator_->SamplingPeriodControl(m_SamplingPeriod);
-  VRQPGenerator_->ComHeight(CoMHeight_);
-  VRQPGenerator_->initialize_matrices();
-  VRQPGenerator_->Ponderation(1.0, INSTANT_VELOCITY);
-  VRQPGenerator_->Ponderation(0.000001, COP_CENTERING);
-  VRQPGenerator_->Ponderation(0.00001, JERK_MIN);
+  VRQPGenerator_ = NewGenerator(SPM, IntermedData_, Robot_);
+
+  // Each candidate support sequence is built by its own generator
+  for (unsigned int c = 0; c < NB_SUPPORT_CANDIDATES - 1; c++) {
+    CandidateJob &Job = CandidateJobs_[c];
+    Job.QP = this;
+    Job.Candidate = (support_candidate_e)(EARLY_TOUCHDOWN + c);
+    Job.Robot = NewRobot(SPM);
+    Job.Data = new IntermedQPMat();
+    Job.Generator = NewGenerator(SPM, Job.Data, Job.Robot);
+  }
+  CandidateLeftFootTraj_ = 0;
+  CandidateRightFootTraj_ = 0;
+  CandidateDeadline_ = 0.0;
 
   // Create and initialize online interpolation of feet trajectories:
   // ----------------------------------------------------------------
@@ -191,10 +197,10 @@ ZMPVelocityReferencedQP::ZMPVelocityReferencedQP(SimplePluginManager *SPM,
   dynamicFilter_ = new DynamicFilter(SPM, PR_);
 
   // Register method to handle
-  const unsigned int NbMethods = 4;
-  const char *lMethodNames[NbMethods] = {":previewcontroltime",
-                                         ":numberstepsbeforestop", ":stoppg",
-                                         ":setfeetconstraint"};
+  const unsigned int NbMethods = 7;
+  const char *lMethodNames[NbMethods] = {
+      ":previewcontroltime", ":numberstepsbeforestop", ":stoppg",
+      ":setfeetconstraint", ":multistart", ":qpformulation", ":qprecord"};
   RESETDEBUG4("PgDebug2.txt");
   ODEBUG4("Before registering methods for ZMPVelocityReferencedQP",
           "PgDebug2.txt");
@@ -226,6 +232,14 @@ ZMPVelocityReferencedQP::ZMPVelocityReferencedQP(SimplePluginManager *SPM,
 
 ZMPVelocityReferencedQP::~ZMPVelocityReferencedQP() {
 
+  for (unsigned int c = 0; c < NB_SUPPORT_CANDIDATES - 1; c++) {
+    CandidateWorkers_[c].stop();
+    CandidateJob &Job = CandidateJobs_[c];
+    delete Job.Generator;
+    delete Job.Data;
+    delete Job.Robot;
+  }
+
   if (VRQPGenerator_ != 0) {
     delete VRQPGenerator_;
     VRQPGenerator_ = 0;
@@ -267,6 +281,36 @@ ZMPVelocityReferencedQP::~ZMPVelocityReferencedQP() {
   }
 }
 
+RigidBodySystem *ZMPVelocityReferencedQP::NewRobot(SimplePluginManager *SPM) {
+  RigidBodySystem *Robot = new RigidBodySystem(SPM, PR_, SupportFSM_);
+  Robot->Mass(RobotMass_);
+  Robot->LeftFoot().Mass(0.0);
+  Robot->RightFoot().Mass(0.0);
+  Robot->NbSamplingsPreviewed(QP_N_);
+  Robot->SamplingPeriodSim(QP_T_);
+  Robot->SamplingPeriodAct(m_SamplingPeriod);
+  Robot->CoMHeight(CoMHeight_);
+  Robot->multiBody(false);
+  Robot->initialize();
+  return Robot;
+}
+
+GeneratorVelRef *
+ZMPVelocityReferencedQP::NewGenerator(SimplePluginManager *SPM,
+                                      IntermedQPMat *Data,
+                                      RigidBodySystem *Robot) {
+  GeneratorVelRef *Generator = new GeneratorVelRef(SPM, Data, Robot, RFI_);
+  Generator->NbPrwSamplings(QP_N_);
+  Generator->SamplingPeriodPreview(QP_T_);
+  Generator->SamplingPeriodControl(m_SamplingPeriod);
+  Generator->ComHeight(CoMHeight_);
+  Generator->initialize_matrices();
+  Generator->Ponderation(1.0, INSTANT_VELOCITY);
+  Generator->Ponderation(0.000001, COP_CENTERING);
+  Generator->Ponderation(0.00001, JERK_MIN);
+  return Generator;
+}
+
 void ZMPVelocityReferencedQP::setCoMPerturbationForce(istringstream &strm) {
 
   PerturbationAcceleration_.resize(6);
@@ -313,6 +357,37 @@ void ZMPVelocityReferencedQP::CallMethod(std::string &Method,
   if (Method == ":setfeetconstraint") {
     RFI_->CallMethod(Method, strm);
   }
+  if (Method == ":multistart") {
+    // :multistart 1 [time budget in s]
+    int lMultiStart = 0;
+    strm >> lMultiStart;
+    MultiStart_ = (lMultiStart != 0);
+    double lDeadline;
+    if (strm >> lDeadline)
+      MultiStartDeadline_ = lDeadline;
+    UpdateCandidateWorkers();
+  }
+  if (Method == ":qpformulation") {
+    // :qpformulation condensed|sparse
+    std::string lFormulation;
+    strm >> lFormulation;
+    if (lFormulation == "sparse")
+      QPFormulation_ = SPARSE_QP;
+    else if (lFormulation == "condensed")
+      QPFormulation_ = CONDENSED_QP;
+    else
+      std::cerr << "ZMPVelocityReferencedQP - Unknown formulation "
+                << lFormulation << std::endl;
+  }
+  if (Method == ":qprecord") {
+    // :qprecord filename [number of problems] or :qprecord off
+    std::string lFileName;
+    strm >> lFileName;
+    unsigned int lNbSlots = 1000;
+    strm >> lNbSlots;
+    RecordProblems((lFileName == "off") ? std::string() : lFileName,
+                   lNbSlots);
+  }
   ZMPRefTrajectoryGeneration::CallMethod(Method, strm);
 }
 
@@ -422,10 +497,22 @@ std::size_t ZMPVelocityReferencedQP::InitOnLine(
   OrientPrw_DF_->CurrentTrunkState(lStartingCOMState);
   // BUILD CONSTANT PART OF THE OBJECTIVE:
   // -------------------------------------
+  // The problem is built in place for at most one step per sample,
+  // four CoP and five feet constraints per sample.
+  Problem_.reserve(4 * QP_N_, 10 * QP_N_);
   Problem_.reset();
   Problem_.nbInvariantRows(2 * QP_N_);
   Problem_.nbInvariantCols(2 * QP_N_);
   VRQPGenerator_->build_invariant_part(Problem_);
+  for (unsigned int i = 0; i < NB_SUPPORT_CANDIDATES - 1; i++) {
+    QPProblem &Candidate = CandidateJobs_[i].Problem;
+    Candidate.reserve(4 * QP_N_, 10 * QP_N_);
+    Candidate.reset();
+    Candidate.nbInvariantRows(2 * QP_N_);
+    Candidate.nbInvariantCols(2 * QP_N_);
+    VRQPGenerator_->build_invariant_part(Candidate);
+  }
+  SelectedCandidate_ = NOMINAL_SUPPORT;
 
   // initialize intermed data needed during the interpolation
   InitStateLIPM_ = LIPM_.GetState();
@@ -446,6 +533,9 @@ void ZMPVelocityReferencedQP::OnLine(
     deque<FootAbsolutePosition> &FinalRightFootTraj_deq)
 
 {
+  // The candidates share the time budget from now on.
+  const double Deadline = Now() + MultiStartDeadline_;
+
   // If on-line mode not activated we go out.
   if (!m_OnLineMode) {
     return;
@@ -465,6 +555,7 @@ void ZMPVelocityReferencedQP::OnLine(
     Problem_.reset_variant();
     Solution_.reset();
     VRQPGenerator_->CurrentTime(time);
+    Recorder_.time(time);
     VelRef_ = NewVelRef_;
     SupportFSM_->update_vel_reference(VelRef_, IntermedData_->SupportState());
     IntermedData_->Reference(VelRef_);
@@ -492,21 +583,40 @@ void ZMPVelocityReferencedQP::OnLine(
     // --------------------------------------
     VRQPGenerator_->compute_global_reference(Solution_);
 
-    // BUILD VARIANT PART OF THE OBJECTIVE:
-    // ------------------------------------
-    VRQPGenerator_->update_problem(Problem_, Solution_.SupportStates_deq);
-
-    // BUILD CONSTRAINTS:
-    // ------------------
-    VRQPGenerator_->build_constraints(Problem_, Solution_);
+    if (QPFormulation_ == SPARSE_QP) {
+      // BUILD AND SOLVE THE SPARSE PROBLEM:
+      // -----------------------------------
+      VRQPGenerator_->solve_sparse_problem(SparseSolver_, Solution_);
+    } else {
+      // START THE OTHER SUPPORT SEQUENCES:
+      // ----------------------------------
+      if (MultiStart_)
+        StartCandidates(FinalLeftFootTraj_deq, FinalRightFootTraj_deq,
+                        Deadline);
+
+      // BUILD VARIANT PART OF THE OBJECTIVE:
+      // ------------------------------------
+      VRQPGenerator_->update_problem(Problem_, Solution_.SupportStates_deq);
+
+      // BUILD CONSTRAINTS:
+      // ------------------
+      VRQPGenerator_->build_constraints(Problem_, Solution_);
+
+      // SOLVE PROBLEM:
+      // --------------
+      Problem_.solve(QLD, Solution_, NONE);
+      if (Solution_.Fail > 0) {
+        Problem_.dump(time);
+      }
 
-    // SOLVE PROBLEM:
-    // --------------
-    Problem_.solve(QLD, Solution_, NONE);
-    if (Solution_.Fail > 0) {
-      Problem_.dump(time);
+      // SELECT THE SUPPORT SEQUENCE:
+      // ----------------------------
+      if (MultiStart_)
+        SelectCandidate();
     }
     VRQPGenerator_->LastFootSol(Solution_);
+    for (unsigned int c = 0; c < NB_SUPPORT_CANDIDATES - 1; c++)
+      CandidateJobs_[c].Generator->LastFootSol(Solution_);
     // OrientPrw_->
 
     // INITIALIZE INTERPOLATION:
@@ -587,6 +697,139 @@ void ZMPVelocityReferencedQP::OnLine(
   //----------"Real-time" loop---------
 }
 
+bool ZMPVelocityReferencedQP::RecordProblems(const std::string &FileName,
+                                             unsigned int NbSlots) {
+  bool Ok = false;
+  if (FileName.empty())
+    Recorder_.close();
+  else
+    Ok = Recorder_.open(FileName, NbSlots, 4 * QP_N_, 10 * QP_N_);
+
+  QPRecorder *lRecorder = Ok ? &Recorder_ : 0;
+  Problem_.recorder(lRecorder);
+  for (unsigned int c = 0; c < NB_SUPPORT_CANDIDATES - 1; c++)
+    CandidateJobs_[c].Problem.recorder(lRecorder);
+  UpdateCandidateWorkers();
+  return Ok;
+}
+
+void ZMPVelocityReferencedQP::UpdateCandidateWorkers() {
+  // The recorder keeps a single pending problem: the candidates of a
+  // recorded resolution are solved one after the other.
+  bool Parallel = MultiStart_ && !Recorder_.is_open();
+  for (unsigned int c = 0; c < NB_SUPPORT_CANDIDATES - 1; c++) {
+    WorkerThread &Worker = CandidateWorkers_[c];
+    if (!Parallel)
+      Worker.stop();
+    else if (!Worker.running())
+      Worker.create();
+  }
+}
+
+void ZMPVelocityReferencedQP::StartCandidates(
+    const deque<FootAbsolutePosition> &FinalLeftFootTraj_deq,
+    const deque<FootAbsolutePosition> &FinalRightFootTraj_deq,
+    double Deadline) {
+  // The candidates only read the nominal sequence, the trajectories and
+  // their own copy of the intermediate data.
+  CandidateNominal_ = Solution_;
+  CandidateLeftFootTraj_ = &FinalLeftFootTraj_deq;
+  CandidateRightFootTraj_ = &FinalRightFootTraj_deq;
+  CandidateDeadline_ = Deadline;
+  for (unsigned int c = 0; c < NB_SUPPORT_CANDIDATES - 1; c++) {
+    *CandidateJobs_[c].Data = *IntermedData_;
+    if (CandidateWorkers_[c].running())
+      CandidateWorkers_[c].start(&CandidateJobs_[c]);
+  }
+}
+
+void ZMPVelocityReferencedQP::SelectCandidate() {
+  // The constant part of the objective depends on the support sequence.
+  SelectedCandidate_ = NOMINAL_SUPPORT;
+  double BestCost = HUGE_VAL;
+  if (Solution_.Fail == 0)
+    BestCost =
+        Problem_.cost(Solution_) + VRQPGenerator_->cop_centering_offset();
+
+  // Without worker, a candidate is solved now if the budget allows it.
+  CandidateJob *Selected = 0;
+  for (unsigned int c = 0; c < NB_SUPPORT_CANDIDATES - 1; c++) {
+    CandidateJob &Job = CandidateJobs_[c];
+    if (CandidateWorkers_[c].running())
+      CandidateWorkers_[c].wait();
+    else
+      Job.run();
+    if (Job.Solved && (Job.Cost < BestCost)) {
+      BestCost = Job.Cost;
+      Selected = &Job;
+    }
+  }
+
+  // The robot, the intermediate data and the generator of the selected
+  // candidate are built for its sequence: they replace the nominal ones.
+  if (Selected != 0) {
+    SelectedCandidate_ = Selected->Candidate;
+    Solution_ = Selected->Solution;
+    std::swap(Robot_, Selected->Robot);
+    std::swap(IntermedData_, Selected->Data);
+    std::swap(VRQPGenerator_, Selected->Generator);
+  }
+
+  // So does the finite state machine at the next sampling.
+  support_state_t &CurrentSupport = IntermedData_->SupportState();
+  if (SelectedCandidate_ == EARLY_TOUCHDOWN)
+    CurrentSupport.TimeLimit -= QP_T_;
+  else if (SelectedCandidate_ == LATE_TOUCHDOWN)
+    CurrentSupport.TimeLimit += QP_T_;
+  ODEBUG("Selected support sequence: " << SelectedCandidate_);
+}
+
+void ZMPVelocityReferencedQP::SolveCandidate(CandidateJob &aJob) {
+  aJob.Solved = false;
+  aJob.Solution.reset();
+  if ((Now() > CandidateDeadline_) ||
+      !aJob.Generator->preview_candidate_support_states(
+          aJob.Candidate, CandidateNominal_, aJob.Solution))
+    return;
+
+  BuildSupportSequence(*aJob.Robot, *aJob.Generator, aJob.Problem,
+                       aJob.Solution, *CandidateLeftFootTraj_,
+                       *CandidateRightFootTraj_);
+
+  // A resolution which has started is not interrupted.
+  if (Now() > CandidateDeadline_)
+    return;
+  aJob.Problem.solve(QLD, aJob.Solution, NONE);
+  if (aJob.Solution.Fail != 0)
+    return;
+  aJob.Cost = aJob.Problem.cost(aJob.Solution) +
+              aJob.Generator->cop_centering_offset();
+  aJob.Solved = true;
+}
+
+void ZMPVelocityReferencedQP::BuildSupportSequence(
+    RigidBodySystem &Robot, GeneratorVelRef &Generator, QPProblem &Pb,
+    solution_t &Sol, const deque<FootAbsolutePosition> &FinalLeftFootTraj_deq,
+    const deque<FootAbsolutePosition> &FinalRightFootTraj_deq) {
+  Pb.reset_variant();
+  Robot.update(Sol.SupportStates_deq, FinalLeftFootTraj_deq,
+               FinalRightFootTraj_deq);
+  Generator.update_problem(Pb, Sol.SupportStates_deq);
+  Generator.build_constraints(Pb, Sol);
+}
+
+bool ZMPVelocityReferencedQP::SolveSupportSequence(
+    solution_t &Sol, const deque<FootAbsolutePosition> &FinalLeftFootTraj_deq,
+    const deque<FootAbsolutePosition> &FinalRightFootTraj_deq) {
+  if (!VRQPGenerator_->preview_candidate_support_states(NOMINAL_SUPPORT, Sol,
+                                                        Sol))
+    return false;
+  BuildSupportSequence(*Robot_, *VRQPGenerator_, Problem_, Sol,
+                       FinalLeftFootTraj_deq, FinalRightFootTraj_deq);
+  Problem_.solve(QLD, Sol, NONE);
+  return Sol.Fail == 0;
+}
+
 void ZMPVelocityReferencedQP::ControlInterpolation(
     std::deque<COMState> &FinalCOMTraj_deq,                   // OUTPUT
     std::deque<ZMPPosition> &FinalZMPTraj_deq,                // OUTPUT
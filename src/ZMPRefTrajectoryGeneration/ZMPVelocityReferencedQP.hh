@@ -30,6 +30,9 @@
 #ifndef _ZMPVELOCITYREFERENCEDQP_WITH_CONSTRAINT_H_
 #define _ZMPVELOCITYREFERENCEDQP_WITH_CONSTRAINT_H_
 
+#include "portability/thread.hh"
+
+#include <Mathematics/RiccatiQPSolver.hh>
 #include <Mathematics/intermediate-qp-matrices.hh>
 #include <Mathematics/relative-feet-inequalities.hh>
 #include <PreviewControl/LinearizedInvertedPendulum2D.hh>
@@ -41,6 +44,7 @@
 #include <ZMPRefTrajectoryGeneration/ZMPRefTrajectoryGeneration.hh>
 #include <ZMPRefTrajectoryGeneration/generator-vel-ref.hh>
 #include <ZMPRefTrajectoryGeneration/qp-problem.hh>
+#include <ZMPRefTrajectoryGeneration/qp-recorder.hh>
 #include <jrl/walkgen/pgtypes.hh>
 #include <privatepgtypes.hh>
 
@@ -119,6 +123,45 @@ public:
 
   inline const int &QP_N(void) const { return QP_N_; }
 
+  /// \brief Support sequence of the last resolution
+  inline support_candidate_e SelectedCandidate() const {
+    return SelectedCandidate_;
+  }
+
+  /// \brief Intermediate data of the generator at the last resolution
+  inline const IntermedQPMat *IntermedData() const { return IntermedData_; }
+
+  /// \brief Build and solve the problem of the support sequence of Sol
+  /// with the state of the last resolution, without candidates
+  ///
+  /// \param[in,out] Sol Support sequence and orientations of the feet
+  /// \param[in] FinalLeftFootTraj_deq, FinalRightFootTraj_deq Trajectories
+  /// given to the last resolution
+  /// \return false if the sequence is invalid or the problem fails
+  bool SolveSupportSequence(
+      solution_t &Sol,
+      const deque<FootAbsolutePosition> &FinalLeftFootTraj_deq,
+      const deque<FootAbsolutePosition> &FinalRightFootTraj_deq);
+
+  /// \brief Formulation of the problem solved at each resolution
+  inline qp_formulation_e QPFormulation() const { return QPFormulation_; }
+  inline void QPFormulation(qp_formulation_e Formulation) {
+    QPFormulation_ = Formulation;
+  }
+
+  /// \brief Preview of the orientations, which counts the reused previews
+  inline const OrientationsPreview *OrientationsPrw() const {
+    return OrientPrw_;
+  }
+  inline OrientationsPreview *OrientationsPrw() { return OrientPrw_; }
+
+  /// \brief Record the condensed problems in a ring file
+  ///
+  /// \param[in] FileName Empty to stop the recording
+  /// \param[in] NbSlots Number of problems kept
+  /// \return false if the file cannot be used
+  bool RecordProblems(const std::string &FileName, unsigned int NbSlots);
+
   /// \brief Setter and getter for the ComAndZMPTrajectoryGeneration.
   inline ComAndFootRealization *getComAndFootRealization() {
     return dynamicFilter_->getComAndFootRealization();
@@ -208,6 +251,66 @@ private:
   /// \brief Copy of the QP_ solution
   solution_t solution_;
 
+  /// \name Multi-start resolution over candidate support sequences
+  /// \{
+  /// \brief True if the candidates are solved along the nominal problem
+  bool MultiStart_;
+
+  /// \brief Time budget of the candidates at each resolution, from the
+  /// start of OnLine (s)
+  double MultiStartDeadline_;
+
+  /// \brief Resolution of a candidate support sequence
+  /// The robot, the intermediate data and the generator of a candidate
+  /// are its own: the candidates are solved by worker threads while the
+  /// nominal problem is solved by the calling one.
+  class CandidateJob : public WorkerThread::Job {
+  public:
+    CandidateJob()
+        : QP(0), Candidate(NOMINAL_SUPPORT), Robot(0), Data(0), Generator(0),
+          Solved(false), Cost(0.0) {}
+    void run() { QP->SolveCandidate(*this); }
+
+    ZMPVelocityReferencedQP *QP;
+    support_candidate_e Candidate;
+    RigidBodySystem *Robot;
+    IntermedQPMat *Data;
+    GeneratorVelRef *Generator;
+    QPProblem Problem;
+    solution_t Solution;
+    /// \brief True if the problem has been solved before the deadline
+    bool Solved;
+    double Cost;
+  };
+  friend class CandidateJob;
+
+  /// \brief Candidates following the nominal sequence, and their threads
+  CandidateJob CandidateJobs_[NB_SUPPORT_CANDIDATES - 1];
+  WorkerThread CandidateWorkers_[NB_SUPPORT_CANDIDATES - 1];
+
+  /// \brief Nominal support sequence and feet trajectories read by the
+  /// candidates, while the calling thread solves the nominal problem
+  solution_t CandidateNominal_;
+  const deque<FootAbsolutePosition> *CandidateLeftFootTraj_;
+  const deque<FootAbsolutePosition> *CandidateRightFootTraj_;
+
+  /// \brief Time at which the candidates stop, in seconds since the epoch
+  double CandidateDeadline_;
+
+  /// \brief Support sequence of the last resolution
+  support_candidate_e SelectedCandidate_;
+  /// \}
+
+  /// \brief Formulation of the problem, the multi-start resolution
+  /// only applies to the condensed one
+  qp_formulation_e QPFormulation_;
+
+  /// \brief Solver of the sparse formulation
+  RiccatiQPSolver SparseSolver_;
+
+  /// \brief Capture of the solved problems
+  QPRecorder Recorder_;
+
   /// \brief HDR allow the computation of the dynamic filter
   PinocchioRobot *PR_;
 
@@ -335,6 +438,43 @@ public:
   /// \brief Prepare the vecteur containing the solution for the interpolation
   void PrepareSolution();
 
+  /// \brief Create a simplified robot model
+  RigidBodySystem *NewRobot(SimplePluginManager *SPM);
+
+  /// \brief Create a generator of the robot and its intermediate data
+  GeneratorVelRef *NewGenerator(SimplePluginManager *SPM, IntermedQPMat *Data,
+                                RigidBodySystem *Robot);
+
+  /// \brief Run the candidates on worker threads if they are solved and
+  /// the problems are not recorded, in the calling thread otherwise
+  void UpdateCandidateWorkers();
+
+  /// \brief Start the resolution of the candidate support sequences
+  /// from the nominal one, before the nominal problem is built
+  ///
+  /// \param[in] Deadline Time at which the candidates stop, in seconds
+  /// since the epoch
+  void
+  StartCandidates(const deque<FootAbsolutePosition> &FinalLeftFootTraj_deq,
+                  const deque<FootAbsolutePosition> &FinalRightFootTraj_deq,
+                  double Deadline);
+
+  /// \brief Wait for the candidates once the nominal problem is solved
+  /// and keep in Solution_ the feasible sequence of lowest cost
+  void SelectCandidate();
+
+  /// \brief Build and solve the problem of a candidate, unless the
+  /// deadline is reached first
+  void SolveCandidate(CandidateJob &aJob);
+
+  /// \brief Build the problem of the support sequence of Sol, the
+  /// dynamics of the robot and the inequalities of the generator
+  void BuildSupportSequence(
+      RigidBodySystem &Robot, GeneratorVelRef &Generator, QPProblem &Pb,
+      solution_t &Sol,
+      const deque<FootAbsolutePosition> &FinalLeftFootTraj_deq,
+      const deque<FootAbsolutePosition> &FinalRightFootTraj_deq);
+
   /// \brief Project the found third foot step on the constraints
   void ProjectionOnConstraints(double &X, double &Y);
 };
@@ -112,6 +112,110 @@ void GeneratorVelRef::preview_support_states(
   generate_selection_matrices(SupportStates_deq);
 }
 
+bool GeneratorVelRef::preview_candidate_support_states(
+    support_candidate_e Candidate, const solution_t &Nominal,
+    solution_t &Solution) {
+
+  Solution.SupportStates_deq = Nominal.SupportStates_deq;
+  Solution.SupportOrientations_deq = Nominal.SupportOrientations_deq;
+  Solution.TrunkOrientations_deq = Nominal.TrunkOrientations_deq;
+  Solution.useWarmStart = Nominal.useWarmStart;
+  deque<support_state_t> &SS_deq = Solution.SupportStates_deq;
+  if (SS_deq.size() != N_ + 1)
+    return false;
+
+  // FIND THE PREVIEWED STEPS:
+  // -------------------------
+  // The foot landing at the first previewed instant is not free.
+  unsigned int FirstChange = 0, FirstStep = 0, LastStep = 0;
+  for (unsigned int pi = 1; pi <= N_; pi++) {
+    if (!SS_deq[pi].StateChanged)
+      continue;
+    if (FirstChange == 0)
+      FirstChange = pi;
+    if (pi > 1 && SS_deq[pi].Phase == SS &&
+        SS_deq[pi].StepNumber > SS_deq[pi - 1].StepNumber) {
+      if (FirstStep == 0)
+        FirstStep = pi;
+      LastStep = pi;
+    }
+  }
+  // The touchdown can only move if it ends the current single support.
+  bool TouchdownFree = (SS_deq.front().Phase == SS) && (FirstStep > 0) &&
+                       (FirstChange == FirstStep);
+
+  support_state_t Support;
+  switch (Candidate) {
+  case NOMINAL_SUPPORT:
+    break;
+
+  case EARLY_TOUCHDOWN:
+    // Remove the last sample before the touchdown, the end of the
+    // preview lasts one sample more.
+    if (!TouchdownFree || (FirstStep < 3))
+      return false;
+    SS_deq.erase(SS_deq.begin() + (FirstStep - 1));
+    Support = SS_deq.back();
+    Support.StateChanged = false;
+    Support.NbInstants++;
+    SS_deq.push_back(Support);
+    break;
+
+  case LATE_TOUCHDOWN:
+    // Repeat the last sample before the touchdown, the end of the
+    // preview is dropped.
+    if (!TouchdownFree || (FirstStep + 1 > N_))
+      return false;
+    Support = SS_deq[FirstStep - 1];
+    Support.NbInstants++;
+    SS_deq.insert(SS_deq.begin() + FirstStep, Support);
+    SS_deq.pop_back();
+    break;
+
+  case EXTRA_STEP:
+    // Split the last previewed step in two shorter ones.
+    if ((LastStep == 0) || (N_ + 1 - LastStep < 4))
+      return false;
+    {
+      unsigned int NewStep = LastStep + (N_ + 1 - LastStep) / 2;
+      for (unsigned int pi = NewStep; pi <= N_; pi++) {
+        support_state_t &PreviewedSupport = SS_deq[pi];
+        PreviewedSupport.Foot = (PreviewedSupport.Foot == LEFT) ? RIGHT : LEFT;
+        PreviewedSupport.StepNumber++;
+        PreviewedSupport.NbInstants = pi - NewStep;
+        PreviewedSupport.StateChanged = (pi == NewStep);
+        PreviewedSupport.X = 0.0;
+        PreviewedSupport.Y = 0.0;
+      }
+    }
+    break;
+
+  default:
+    return false;
+  }
+
+  // The new step keeps the orientation of the last previewed one.
+  std::deque<double> &Angles_deq = Solution.SupportOrientations_deq;
+  while (!Angles_deq.empty() && Angles_deq.size() < SS_deq.back().StepNumber)
+    Angles_deq.push_back(Angles_deq.back());
+
+  generate_selection_matrices(SS_deq);
+  return true;
+}
+
+double GeneratorVelRef::cop_centering_offset() const {
+
+  const IntermedQPMat::objective_variant_t &COPCent =
+      IntermedData_->Objective(COP_CENTERING);
+  const IntermedQPMat::state_variant_t &State = IntermedData_->State();
+  const linear_dynamics_t &CoPDynamics = Robot_->DynamicsCoPJerk();
+
+  // a/2 * |S*x - Vc*xc|^2
+  Eigen::VectorXd ZX = CoPDynamics.S * State.CoM.x - State.VcX;
+  Eigen::VectorXd ZY = CoPDynamics.S * State.CoM.y - State.VcY;
+  return 0.5 * COPCent.weight * (ZX.squaredNorm() + ZY.squaredNorm());
+}
+
 void GeneratorVelRef::generate_selection_matrices(
     const std::deque<support_state_t> &SupportStates_deq) {
 
@@ -365,25 +469,25 @@ void GeneratorVelRef::build_constraints_cop(const linear_inequality_t &IneqCoP,
                                             QPProblem &Pb) {
 
   unsigned int NbConstraints = Pb.NbConstraints();
+  unsigned int NbIneqs = (unsigned int)IneqCoP.D.X_mat.rows();
 
+  // The terms of the constraint matrix are written in place.
   // -D*U
-  compute_term(MM_, -1.0, IneqCoP.D.X_mat, Robot_->DynamicsCoPJerk().U);
-  Pb.add_term_to(MATRIX_DU, MM_, NbConstraints, 0);
-  compute_term(MM_, -1.0, IneqCoP.D.Y_mat, Robot_->DynamicsCoPJerk().U);
-  Pb.add_term_to(MATRIX_DU, MM_, NbConstraints, N_);
+  const Eigen::MatrixXd &U = Robot_->DynamicsCoPJerk().U;
+  Pb.term(MATRIX_DU, NbConstraints, 0, NbIneqs, (unsigned int)U.cols())
+      .noalias() -= IneqCoP.D.X_mat * U;
+  Pb.term(MATRIX_DU, NbConstraints, N_, NbIneqs, (unsigned int)U.cols())
+      .noalias() -= IneqCoP.D.Y_mat * U;
 
   // +D*V
-  compute_term(MM_, 1.0, IneqCoP.D.X_mat, IntermedData_->State().V);
   // +  Robot_->LeftFoot().Dynamics(COP).U +
   // Robot_->RightFoot().Dynamics(COP).U        );
-  Pb.add_term_to(MATRIX_DU, MM_, NbConstraints, 2 * N_);
-
-  //  cout << "IntermedData_->State().V  = "
-  // << IntermedData_->State().V  << endl ;
-  compute_term(MM_, 1.0, IneqCoP.D.Y_mat, IntermedData_->State().V);
-  // +  Robot_->LeftFoot().Dynamics(COP).U +
-  // Robot_->RightFoot().Dynamics(COP).U        );
-  Pb.add_term_to(MATRIX_DU, MM_, NbConstraints, 2 * N_ + NbStepsPreviewed);
+  const Eigen::MatrixXd &V = IntermedData_->State().V;
+  Pb.term(MATRIX_DU, NbConstraints, 2 * N_, NbIneqs, (unsigned int)V.cols())
+      .noalias() += IneqCoP.D.X_mat * V;
+  Pb.term(MATRIX_DU, NbConstraints, 2 * N_ + NbStepsPreviewed, NbIneqs,
+          (unsigned int)V.cols())
+      .noalias() += IneqCoP.D.Y_mat * V;
 
   // constant part
   // +dc
@@ -433,13 +537,15 @@ void GeneratorVelRef::build_constraints_feet(
     const IntermedQPMat::state_variant_t &State, int NbStepsPreviewed,
     QPProblem &Pb) {
   unsigned int NbConstraints = Pb.NbConstraints();
+  unsigned int NbIneqs = (unsigned int)IneqFeet.D.X_mat.rows();
 
   // -D*V_f
-  compute_term(MM_, -1.0, IneqFeet.D.X_mat, State.V_f);
-  Pb.add_term_to(MATRIX_DU, MM_, NbConstraints, 2 * N_);
-
-  compute_term(MM_, -1.0, IneqFeet.D.Y_mat, State.V_f);
-  Pb.add_term_to(MATRIX_DU, MM_, NbConstraints, 2 * N_ + NbStepsPreviewed);
+  Pb.term(MATRIX_DU, NbConstraints, 2 * N_, NbIneqs,
+          (unsigned int)State.V_f.cols())
+      .noalias() -= IneqFeet.D.X_mat * State.V_f;
+  Pb.term(MATRIX_DU, NbConstraints, 2 * N_ + NbStepsPreviewed, NbIneqs,
+          (unsigned int)State.V_f.cols())
+      .noalias() -= IneqFeet.D.Y_mat * State.V_f;
 
   // +dc
   Pb.add_term_to(VECTOR_DS, IneqFeet.Dc_vec, NbConstraints);
@@ -524,8 +630,7 @@ void GeneratorVelRef::build_eq_constraints_feet(
   }
 }
 
-void GeneratorVelRef::build_eq_constraints_limitPosFeet(
-    const solution_t &Solution, QPProblem &Pb) {
+bool GeneratorVelRef::first_foot_restrained(const solution_t &Solution) const {
   std::deque<support_state_t>::const_iterator SPTraj_it =
       Solution.SupportStates_deq.begin();
   int ItBeforeLanding = 0;
@@ -539,10 +644,16 @@ void GeneratorVelRef::build_eq_constraints_limitPosFeet(
   }
   int ItBeforeLandingThresh = 2;
   unsigned NbStepsPreviewed = Solution.SupportStates_deq.back().StepNumber;
-  if (ItBeforeLanding <= ItBeforeLandingThresh && ItBeforeLanding > 0 &&
-      Solution.SupportStates_deq.front().Phase == SS &&
-      Solution.SupportStates_deq.front().StateChanged != 1 &&
-      NbStepsPreviewed > 0) {
+  return (ItBeforeLanding <= ItBeforeLandingThresh && ItBeforeLanding > 0 &&
+          Solution.SupportStates_deq.front().Phase == SS &&
+          Solution.SupportStates_deq.front().StateChanged != 1 &&
+          NbStepsPreviewed > 0);
+}
+
+void GeneratorVelRef::build_eq_constraints_limitPosFeet(
+    const solution_t &Solution, QPProblem &Pb) {
+  unsigned NbStepsPreviewed = Solution.SupportStates_deq.back().StepNumber;
+  if (first_foot_restrained(Solution)) {
     unsigned int NbConstraints = Pb.NbConstraints();
     Eigen::MatrixXd EqualityMatrix;
     Eigen::VectorXd EqualityVector;
@@ -694,6 +805,168 @@ void GeneratorVelRef::update_problem(
   Pb.add_term_to(VECTOR_D, MV_, 2 * N_ + nbStepsPreviewed);
 }
 
+void GeneratorVelRef::solve_sparse_problem(RiccatiQPSolver &Solver,
+                                           solution_t &Solution) {
+
+  const std::deque<support_state_t> &SS_deq = Solution.SupportStates_deq;
+  const IntermedQPMat::state_variant_t &State = IntermedData_->State();
+  unsigned int NbStepsPreviewed = SS_deq.back().StepNumber;
+  bool FirstFootRestrained = first_foot_restrained(Solution);
+  const double T = Tprw_;
+  const double hg = Robot_->CoMHeight() / 9.81;
+
+  const double VelWeight = IntermedData_->Objective(INSTANT_VELOCITY).weight;
+  const double CoPWeight = IntermedData_->Objective(COP_CENTERING).weight;
+  const double JerkWeight = IntermedData_->Objective(JERK_MIN).weight;
+
+  linear_inequality_t &IneqCoP = IntermedData_->Inequalities(INEQ_COP);
+  build_inequalities_cop(IneqCoP, SS_deq);
+  linear_inequality_t &IneqFeet = IntermedData_->Inequalities(INEQ_FEET);
+  build_inequalities_feet(IneqFeet, SS_deq);
+
+  // The condensed problem leaves out the linear term of the CoP
+  // centering in the jerks, a*U'*(S*x-Vc*fc): it is removed from the
+  // stage costs so that both formulations minimize the same cost.
+  const linear_dynamics_t &CoPDynamics = Robot_->DynamicsCoPJerk();
+  Eigen::VectorXd CoPJerkX, CoPJerkY;
+  compute_term(CoPJerkX, -CoPWeight, CoPDynamics.UT, CoPDynamics.S,
+               State.CoM.x);
+  compute_term(MV_, CoPWeight, CoPDynamics.UT, State.VcX);
+  CoPJerkX += MV_;
+  compute_term(CoPJerkY, -CoPWeight, CoPDynamics.UT, CoPDynamics.S,
+               State.CoM.y);
+  compute_term(MV_, CoPWeight, CoPDynamics.UT, State.VcY);
+  CoPJerkY += MV_;
+
+  // STAGES:
+  // -------
+  // x_k = [c_x dc_x ddc_x c_y dc_y ddc_y p_x p_y] at the instant k*T,
+  // p being the support foot of the sample k-1.
+  // u_k = [jerk_x jerk_y] and the foot landing at the sample k, if any.
+  Solver.Resize(N_, 8);
+  for (unsigned int k = 0; k <= N_; k++) {
+    const support_state_t &Support = SS_deq[k];
+    unsigned int StepNumber = 0;
+    bool NewFoot = false, FeetIneq = false;
+    if (k < N_) {
+      const support_state_t &Next = SS_deq[k + 1];
+      StepNumber = Next.StepNumber;
+      NewFoot = (Next.StepNumber > Support.StepNumber) &&
+                !(FirstFootRestrained && Next.StepNumber == 1);
+      FeetIneq = NewFoot && Next.StateChanged && Next.Phase != DS;
+    }
+    Solver.ResizeStage(k, NewFoot ? 4 : 2,
+                       (k > 0 ? 4 : 0) + (FeetIneq ? 5 : 0));
+    RiccatiQPSolver::stage_t &s = Solver.Stage(k);
+
+    if (k < N_) {
+      // Dynamics of the CoM
+      for (unsigned int a = 0; a < 2; a++) {
+        unsigned int o = 3 * a;
+        s.A(o, o) = s.A(o + 1, o + 1) = s.A(o + 2, o + 2) = 1.0;
+        s.A(o, o + 1) = s.A(o + 1, o + 2) = T;
+        s.A(o, o + 2) = T * T / 2;
+        s.B(o, a) = T * T * T / 6;
+        s.B(o + 1, a) = T * T / 2;
+        s.B(o + 2, a) = T;
+      }
+      // Next support foot: known, landing or kept
+      if (StepNumber == 0) {
+        s.b(6) = SS_deq[k + 1].X;
+        s.b(7) = SS_deq[k + 1].Y;
+      } else if (NewFoot) {
+        s.B(6, 2) = s.B(7, 3) = 1.0;
+      } else if (StepNumber > Support.StepNumber) {
+        s.b(6) = LastFootSolX_;
+        s.b(7) = LastFootSolY_;
+      } else {
+        s.A(6, 6) = s.A(7, 7) = 1.0;
+      }
+      // +a*jerk^2
+      s.R(0, 0) = s.R(1, 1) = JerkWeight;
+      s.r(0) = CoPJerkX(k);
+      s.r(1) = CoPJerkY(k);
+    }
+
+    if (k > 0) {
+      unsigned int i = k - 1;
+      // +a*(dc-ref)^2
+      s.Q(1, 1) = s.Q(4, 4) = VelWeight;
+      s.q(1) = -VelWeight * State.Ref.Global.X_vec(i);
+      s.q(4) = -VelWeight * State.Ref.Global.Y_vec(i);
+      // +a*(z-p)^2, z = c-h/g*ddc
+      for (unsigned int a = 0; a < 2; a++) {
+        unsigned int o = 3 * a;
+        s.Q(o, o) += CoPWeight;
+        s.Q(o, o + 2) = s.Q(o + 2, o) = -CoPWeight * hg;
+        s.Q(o + 2, o + 2) = CoPWeight * hg * hg;
+        s.Q(o, 6 + a) = s.Q(6 + a, o) = -CoPWeight;
+        s.Q(o + 2, 6 + a) = s.Q(6 + a, o + 2) = CoPWeight * hg;
+        s.Q(6 + a, 6 + a) = CoPWeight;
+      }
+      // Dx*(z_x-p_x)+Dy*(z_y-p_y) <= dc
+      for (unsigned int j = 0; j < 4; j++) {
+        double Dx = IneqCoP.D.X_mat.coeff(4 * i + j, i);
+        double Dy = IneqCoP.D.Y_mat.coeff(4 * i + j, i);
+        s.C(j, 0) = Dx;
+        s.C(j, 2) = -Dx * hg;
+        s.C(j, 3) = Dy;
+        s.C(j, 5) = -Dy * hg;
+        s.C(j, 6) = -Dx;
+        s.C(j, 7) = -Dy;
+        s.d(j) = IneqCoP.Dc_vec(4 * i + j);
+      }
+    }
+
+    // Dx*(f_j-f_{j-1})+Dy*(f_j-f_{j-1}) <= dc, f_0 being the current
+    // support foot
+    if (FeetIneq) {
+      unsigned int r = (k > 0) ? 4 : 0;
+      for (unsigned int j = 0; j < 5; j++) {
+        unsigned int Row = (StepNumber - 1) * 5 + j;
+        double Dx = IneqFeet.D.X_mat.coeff(Row, StepNumber - 1);
+        double Dy = IneqFeet.D.Y_mat.coeff(Row, StepNumber - 1);
+        s.D(r + j, 2) = Dx;
+        s.D(r + j, 3) = Dy;
+        s.d(r + j) = IneqFeet.Dc_vec(Row);
+        if (StepNumber == 1) {
+          s.d(r + j) += Dx * State.Vc_fX(0) + Dy * State.Vc_fY(0);
+        } else {
+          s.C(r + j, 6) = -Dx;
+          s.C(r + j, 7) = -Dy;
+        }
+      }
+    }
+  }
+
+  // SOLVE:
+  // ------
+  MV_.resize(8);
+  MV_.segment(0, 3) = State.CoM.x;
+  MV_.segment(3, 3) = State.CoM.y;
+  MV_(6) = SS_deq.front().X;
+  MV_(7) = SS_deq.front().Y;
+  Solution.resize(2 * N_ + 2 * NbStepsPreviewed, 0);
+  Solution.Fail = Solver.Solve(MV_);
+  Solution.Print = 0;
+  Solution.LBoundsLagr_vec.setZero();
+  Solution.UBoundsLagr_vec.setZero();
+
+  // Jerks and previewed feet in the layout of the condensed problem
+  for (unsigned int k = 0; k < N_; k++) {
+    const Eigen::VectorXd &u = Solver.Control(k);
+    Solution.Solution_vec(k) = u(0);
+    Solution.Solution_vec(N_ + k) = u(1);
+    unsigned int StepNumber = SS_deq[k + 1].StepNumber;
+    if (StepNumber > SS_deq[k].StepNumber) {
+      const Eigen::VectorXd &x = Solver.State(k + 1);
+      Solution.Solution_vec(2 * N_ + StepNumber - 1) = x(6);
+      Solution.Solution_vec(2 * N_ + NbStepsPreviewed + StepNumber - 1) =
+          x(7);
+    }
+  }
+}
+
 void GeneratorVelRef::compute_warm_start(solution_t &Solution) {
 
   // Initialize:
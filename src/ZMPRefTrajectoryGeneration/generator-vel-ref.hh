@@ -30,6 +30,7 @@
 
 #include <ZMPRefTrajectoryGeneration/mpc-trajectory-generation.hh>
 
+#include <Mathematics/RiccatiQPSolver.hh>
 #include <Mathematics/intermediate-qp-matrices.hh>
 #include <Mathematics/relative-feet-inequalities.hh>
 #include <PreviewControl/LinearizedInvertedPendulum2D.hh>
@@ -71,6 +72,23 @@ public:
       const deque<FootAbsolutePosition> &FinalRightFootTraj_deq,
       deque<support_state_t> &SupportStates_deq);
 
+  /// \brief Derive a candidate support sequence from the previewed one
+  /// and compute its selection matrices
+  /// The touchdown ending the current single support phase moves by one
+  /// sample, or the last previewed step is split in two.
+  ///
+  /// \param[in] Candidate Change of the step timing
+  /// \param[in] Nominal Solution holding the previewed support states
+  /// \param[out] Solution Support states and orientations of the candidate
+  /// \return false if the candidate does not exist for this preview
+  bool preview_candidate_support_states(support_candidate_e Candidate,
+                                        const solution_t &Nominal,
+                                        solution_t &Solution);
+
+  /// \brief Constant part of the CoP centering objective, which depends
+  /// on the support sequence through the selection matrices
+  double cop_centering_offset() const;
+
   /// \brief Set the global reference from the local one and the
   /// orientation of the trunk frame
   /// for the whole preview window
@@ -100,6 +118,15 @@ public:
   void update_problem(QPProblem &Pb,
                       const std::deque<support_state_t> &SupportStates_deq);
 
+  /// \brief Build and solve the problem in its sparse formulation
+  /// The CoM and the support foot are the states of a problem with one
+  /// stage per sample, the jerks and the landing feet its controls.
+  /// The solution vector has the layout of the condensed problem.
+  ///
+  /// \param[in] Solver
+  /// \param[out] Solution
+  void solve_sparse_problem(RiccatiQPSolver &Solver, solution_t &Solution);
+
   /// \brief Compute the initial solution vector for warm start
   ///
   /// \param[in] Solution
@@ -214,6 +241,12 @@ protected:
   void build_eq_constraints_limitPosFeet(const solution_t &Solution,
                                          QPProblem &Pb);
 
+  /// \brief Check if the position of the first previewed foot is
+  /// restrained, some iterations before landing
+  ///
+  /// \param[in] Solution
+  bool first_foot_restrained(const solution_t &Solution) const;
+
   /// \brief Initialize inequality matrices
   ///
   /// \param[out] Inequalities
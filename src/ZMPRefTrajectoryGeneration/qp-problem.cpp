@@ -40,6 +40,7 @@
 #include <exception>
 
 #include <ZMPRefTrajectoryGeneration/qp-problem.hh>
+#include <ZMPRefTrajectoryGeneration/qp-recorder.hh>
 
 #ifdef LSSOL_FOUND
 #include <lssol/lssol.h>
@@ -49,13 +50,14 @@ using namespace PatternGeneratorJRL;
 
 QPProblem::QPProblem()
     : m_(0), me_(0), mmax_(0), n_(0), nmax_(0), mnn_(0), iout_(0), ifail_(0),
-      iprint_(0), lwar_(0), liwar_(0), eps_(0), NbVariables_(0),
+      iprint_(0), eps_(0), DenseHessianValid_(false), NbVariables_(0),
       NbConstraints_(0), NbEqConstraints_(0), nbInvariantRows_(0),
       nbInvariantCols_(0)
 
 {
   NbVariables_ = 0;
   NbConstraints_ = 0;
+  clean_dirty();
 
   m_ = NbConstraints_;
   me_ = NbEqConstraints_;
@@ -66,11 +68,12 @@ QPProblem::QPProblem()
 
   iout_ = 0;
   iprint_ = 1;
-  lwar_ = 3 * nmax_ * nmax_ / 2 + 10 * nmax_ + 2 * mmax_ + 20000;
-  liwar_ = n_;
+  lwar_ = 0;
+  liwar_ = 0;
   eps_ = 1e-8;
 
   lastSolution_.resize(1, 1);
+  Recorder_ = 0;
 
   istate_ = 0x0;
   kx_ = 0x0;
@@ -82,15 +85,23 @@ QPProblem::QPProblem()
 
 QPProblem::~QPProblem() { release_memory(); }
 
-void QPProblem::release_memory() {}
+void QPProblem::release_memory() {
+  if (istate_ != 0x0) {
+    delete[] istate_;
+    delete[] kx_;
+    delete[] b_;
+    delete[] clamda_;
+    istate_ = 0x0;
+  }
+}
 
 void QPProblem::resize_all() {
   bool ok = false;
 
-  if ((NbConstraints_ > 0) && (NbVariables_ > 0)) {
-    DU_.resize(2 * NbConstraints_, 2 * NbVariables_, true);
+  // The arrays of the constraints are grown by grow_arrays(),
+  // they are never shrunk since they are preserved.
+  if ((NbConstraints_ > 0) && (NbVariables_ > 0))
     ok = true;
-  }
 
   if (NbVariables_ > 0) {
     Q_.resize(2 * NbVariables_, 2 * NbVariables_, true);
@@ -100,15 +111,12 @@ void QPProblem::resize_all() {
     XU_.resize(2 * NbVariables_, 1, true);
     XU_.fill(1e8);
     X_.resize(2 * NbVariables_, 1, true);
-    iwar_.resize(2 * NbVariables_ + 1000, 1, true);
     ok = true;
   }
 
   if (ok) {
-    U_.resize(2 * (NbConstraints_ + 2 * NbVariables_), 1, true);
-    war_.resize(2 * (3 * NbVariables_ * NbVariables_ / 2 + 10 * NbVariables_ +
-                     2 * (NbConstraints_ + 1) + 20000),
-                1, true);
+    // solve() adds one empty constraint.
+    qld_.Reserve(2 * (NbConstraints_ + 1), 2 * NbVariables_);
   }
 
   if (istate_ != 0x0) {
@@ -146,6 +154,7 @@ void QPProblem::clear(qp_element_e Type) {
     XU_.fill(1e8);
     break;
   }
+  mark_dirty(Type);
 }
 
 void QPProblem::reset() {
@@ -159,6 +168,10 @@ void QPProblem::reset() {
   NbConstraints_ = 0;
   NbEqConstraints_ = 0;
   NbVariables_ = 0;
+
+  for (int Type = MATRIX_Q; Type <= VECTOR_XU; Type++)
+    mark_dirty((qp_element_e)Type);
+  DenseHessianValid_ = false;
 }
 
 int QPProblem::reset_variant() {
@@ -179,6 +192,8 @@ int QPProblem::reset_variant() {
       ++p_it;
     }
   }
+  mark_dirty(MATRIX_Q, firstRow, firstCol, Q_.NbRows_ - firstRow,
+             lastCol - firstCol);
 
   firstRow = 0;
   firstCol = (nbInvariantCols_ < Q_.NbCols_) ? nbInvariantCols_ : Q_.NbCols_;
@@ -193,12 +208,17 @@ int QPProblem::reset_variant() {
       ++p_it;
     }
   }
+  mark_dirty(MATRIX_Q, firstRow, firstCol, Q_.NbRows_ - firstRow,
+             lastCol - firstCol);
 
-  Q_dense_.fill(0.0);
+  // The dense hessian keeps the invariant part for the next resolution.
   DU_.fill(0.0);
   DU_dense_.fill(0.0);
   D_.fill(0.0);
   DS_.fill(0.0);
+  mark_dirty(MATRIX_DU);
+  mark_dirty(VECTOR_D);
+  mark_dirty(VECTOR_DS);
   NbConstraints_ = 0;
   NbEqConstraints_ = 0;
   NbVariables_ = 0;
@@ -218,37 +238,59 @@ void QPProblem::solve(solver_e Solver, solution_t &Result,
 
   iout_ = 0;
   iprint_ = 1;
-  lwar_ = 2 * (3 * NbVariables_ * NbVariables_ / 2 + 10 * NbVariables_ +
-               2 * (NbConstraints_ + 1) + 20000);
-  liwar_ = 2 * NbVariables_ + 1000;
   eps_ = 1e-8;
 
-  iwar_.Array_[0] = 1;
-
-  Q_.stick_together(Q_dense_, n_, n_);
+  if (Solver != QLD)
+    DenseHessianValid_ = false;
+  update_dense_hessian();
   DU_.stick_together(DU_dense_, mmax_, n_);
 
   Result.resize(n_, m_);
 
+  // The problem is captured before the solver modifies its arrays,
+  // without the first empty constraint.
+  struct timeval begin, end;
+  bool Recording = false;
+  if (Recorder_ != 0) {
+    const double *X0 = 0;
+    if (Result.useWarmStart && (Result.initialSolution.size() == n_))
+      X0 = Result.initialSolution.data();
+    Recording = Recorder_->write_problem(
+        Solver, NbVariables_, NbConstraints_, NbEqConstraints_,
+        Q_dense_.Array_, n_, D_.Array_, DU_dense_.Array_ + 1, mmax_,
+        DS_.Array_ + 1, XL_.Array_, XU_.Array_, X0);
+    gettimeofday(&begin, 0);
+  }
+
   switch (Solver) {
   case QLD:
 
-    ql0001_(&m_, &me_, &mmax_, &n_, &nmax_, &mnn_, Q_dense_.Array_, D_.Array_,
-            DU_dense_.Array_, DS_.Array_, XL_.Array_, XU_.Array_, X_.Array_,
-            U_.Array_, &iout_, &ifail_, &iprint_, war_.Array_, &lwar_,
-            iwar_.Array_, &liwar_, &eps_);
-
-    for (int i = 0; i < n_; i++) {
-      Result.Solution_vec(i) = X_.Array_[i];
-      Result.LBoundsLagr_vec(i) = U_.Array_[m_ + i];
-      Result.UBoundsLagr_vec(i) = U_.Array_[m_ + n_ + i];
-    }
-    for (int i = 0; i < m_; i++) {
-      Result.ConstrLagr_vec(i) = U_.Array_[i];
+    // The workspace follows the size of the problem in add_term_to,
+    // this only allocates when the dimensions were set directly.
+    qld_.Reserve(m_, n_);
+    qld_.SetUserFactorization(true);
+    qld_.SetPrintLevel(iprint_);
+    qld_.SetEps(eps_);
+    ifail_ = qld_.Solve(m_, me_, n_, Q_dense_.Array_, nmax_, D_.Array_,
+                        DU_dense_.Array_, mmax_, DS_.Array_, X_.Array_,
+                        XL_.Array_, XU_.Array_);
+
+    {
+      Eigen::Map<const Eigen::VectorXd> lU = qld_.Multipliers();
+      for (int i = 0; i < n_; i++) {
+        Result.Solution_vec(i) = X_.Array_[i];
+        Result.LBoundsLagr_vec(i) = lU(m_ + i);
+        Result.UBoundsLagr_vec(i) = lU(m_ + n_ + i);
+      }
+      for (int i = 0; i < m_; i++) {
+        Result.ConstrLagr_vec(i) = lU(i);
+      }
     }
 
     Result.Fail = ifail_;
     Result.Print = iprint_;
+    // QLD restores the hessian on success.
+    DenseHessianValid_ = (ifail_ == 0);
 
     if (tests == ITT || tests == ALL) {
       int nb_itt_approx = 0;
@@ -268,6 +310,15 @@ void QPProblem::solve(solver_e Solver, solution_t &Result,
 
     sendOption("Problem Type = QP2");
 
+    // The workspace of QLD is owned by qld_, only LSSOL uses these.
+    lwar_ = 2 * (3 * NbVariables_ * NbVariables_ / 2 + 10 * NbVariables_ +
+                 2 * (NbConstraints_ + 1) + 20000);
+    liwar_ = 2 * NbVariables_ + 1000;
+    if ((unsigned int)lwar_ > war_.NbRows_)
+      war_.resize(lwar_, 1, false);
+    if ((unsigned int)liwar_ > iwar_.NbRows_)
+      iwar_.resize(liwar_, 1, false);
+
     double *bl = new double[n_ + m_];
     double *bu = new double[n_ + m_];
     int size1 = n_;
@@ -349,134 +400,191 @@ void QPProblem::solve(solver_e Solver, solution_t &Result,
 
     break;
   }
+  if (Recording) {
+    gettimeofday(&end, 0);
+    Recorder_->write_result(Result,
+                            (double)(end.tv_sec - begin.tv_sec) +
+                                1e-6 * (double)(end.tv_usec - begin.tv_usec));
+  }
+  clean_dirty();
+}
+
+double QPProblem::cost(const solution_t &Result) const {
+  unsigned int n = (unsigned int)Result.Solution_vec.size();
+  if ((n > Q_.NbRows_) || (n > Q_.NbCols_) || (n > D_.NbRows_)) {
+    std::cerr << "QPProblem::cost - The solution does not match the problem."
+              << std::endl;
+    return HUGE_VAL;
+  }
+
+  Eigen::Map<const Eigen::MatrixXd, 0, Eigen::OuterStride<> > Q(
+      Q_.Array_, n, n, Eigen::OuterStride<>(Q_.NbRows_));
+  Eigen::Map<const Eigen::VectorXd> D(D_.Array_, n);
+  const Eigen::VectorXd &X = Result.Solution_vec;
+  return 0.5 * X.dot(Q * X) + D.dot(X);
 }
 
 void QPProblem::add_term_to(qp_element_e Type, const Eigen::MatrixXd &Mat,
                             unsigned int row, unsigned int col) {
+  term(Type, row, col, (unsigned int)Mat.rows(), (unsigned int)Mat.cols()) +=
+      Mat;
+}
+
+void QPProblem::add_term_to(qp_element_e Type, const Eigen::VectorXd &Vec,
+                            unsigned row, unsigned col) {
+  term(Type, row, col, (unsigned int)Vec.size(), 1) += Vec;
+}
+
+QPProblem::term_t QPProblem::term(qp_element_e Type, unsigned int row,
+                                  unsigned int col, unsigned int NbRows,
+                                  unsigned int NbCols) {
 
   array_s<double> *Array_p = 0;
+  mark_dirty(Type, row, col, NbRows, NbCols);
 
   switch (Type) {
   case MATRIX_Q:
     Array_p = &Q_;
-    NbVariables_ =
-        (unsigned int)((col + Mat.cols() > NbVariables_) ? col + Mat.cols()
-                                                         : NbVariables_);
+    NbVariables_ = (col + NbCols > NbVariables_) ? col + NbCols : NbVariables_;
     break;
 
   case MATRIX_DU:
     Array_p = &DU_;
     NbConstraints_ =
-        (unsigned int)((row + Mat.rows() > NbConstraints_) ? row + Mat.rows()
-                                                           : NbConstraints_);
-    NbVariables_ =
-        (unsigned int)((col + Mat.cols() > NbVariables_) ? col + Mat.cols()
-                                                         : NbVariables_);
+        (row + NbRows > NbConstraints_) ? row + NbRows : NbConstraints_;
+    NbVariables_ = (col + NbCols > NbVariables_) ? col + NbCols : NbVariables_;
     row++; // The first rows of DU,DS are empty
     break;
 
   case VECTOR_D:
+    Array_p = &D_;
+    NbVariables_ = (row + NbRows > NbVariables_) ? row + NbRows : NbVariables_;
     break;
+
   case VECTOR_XL:
+    Array_p = &XL_;
+    NbVariables_ = (row + NbRows > NbVariables_) ? row + NbRows : NbVariables_;
     break;
+
   case VECTOR_XU:
+    Array_p = &XU_;
+    NbVariables_ = (row + NbRows > NbVariables_) ? row + NbRows : NbVariables_;
     break;
+
   case VECTOR_DS:
     Array_p = &DS_;
     NbConstraints_ =
-        (unsigned int)((row + Mat.rows() > NbConstraints_) ? row + Mat.rows()
-                                                           : NbConstraints_);
+        (row + NbRows > NbConstraints_) ? row + NbRows : NbConstraints_;
     row++; // The first rows of DU,DS are empty
     break;
   }
 
-  if (NbVariables_ > Array_p->NbCols_)
+  grow_arrays();
+
+  return term_t(&Array_p->Array_[row + col * Array_p->NbRows_], NbRows, NbCols,
+                Eigen::OuterStride<>(Array_p->NbRows_));
+}
+
+void QPProblem::grow_arrays() {
+
+  if ((NbVariables_ > Q_.NbCols_) || (NbVariables_ > D_.NbRows_))
     resize_all();
 
-  if ((NbConstraints_ > DU_.NbRows_) && (NbConstraints_ > 0)) {
-    if (NbVariables_ > 0)
-      DU_.resize(2 * NbConstraints_, 2 * NbVariables_, true);
+  // solve() adds one empty constraint to the first empty row.
+  if ((NbVariables_ > 0) &&
+      ((NbConstraints_ + 2 > DU_.NbRows_) || (NbVariables_ > DU_.NbCols_))) {
+    unsigned int NbRows = (2 * (NbConstraints_ + 1) > DU_.NbRows_)
+                              ? 2 * (NbConstraints_ + 1)
+                              : DU_.NbRows_;
+    unsigned int NbCols =
+        (2 * NbVariables_ > DU_.NbCols_) ? 2 * NbVariables_ : DU_.NbCols_;
+    DU_.resize(NbRows, NbCols, true);
   }
 
-  if ((NbConstraints_ > DS_.NbRows_) && (NbConstraints_ > 0))
-    DS_.resize(2 * NbConstraints_, 1, true);
+  if (NbConstraints_ + 2 > DS_.NbRows_)
+    DS_.resize(2 * (NbConstraints_ + 1), 1, true);
 
-  if (U_.NbRows_ < NbConstraints_ + 2 * NbVariables_)
-    U_.resize(NbConstraints_ + 2 * NbVariables_, 1, true);
+  if ((NbConstraints_ + 1 > qld_.MaxNbOfConstraints()) ||
+      (NbVariables_ > qld_.MaxNbOfVariables()))
+    qld_.Reserve(2 * (NbConstraints_ + 1), 2 * NbVariables_);
+}
 
-  unsigned warsize = 3 * NbVariables_ * NbVariables_ / 2 + 10 * NbVariables_ +
-                     2 * (NbConstraints_ + 1) + 20000;
-  if (warsize > war_.NbRows_)
-    war_.resize(warsize, 1, true);
+void QPProblem::reserve(unsigned int MaxNbVariables,
+                        unsigned int MaxNbConstraints) {
 
-  double *p = Array_p->Array_;
-  double *p_it = &p[row + (col)*Array_p->NbRows_];
-  for (unsigned j = 0; j < Mat.cols(); j++) {
-    p_it = &p[row + (col + j) * Array_p->NbRows_];
-    for (unsigned i = 0; i < Mat.rows(); i++) {
-      *p_it += Mat(i, j);
-      ++p_it;
-    }
-  }
-}
+  unsigned int NbVariables = NbVariables_, NbConstraints = NbConstraints_;
+  if (MaxNbVariables > NbVariables_)
+    NbVariables_ = MaxNbVariables;
+  if (MaxNbConstraints > NbConstraints_)
+    NbConstraints_ = MaxNbConstraints;
 
-void QPProblem::add_term_to(qp_element_e Type, const Eigen::VectorXd &Vec,
-                            unsigned row, unsigned col) {
+  grow_arrays();
+  Q_dense_.reserve(NbVariables_ * NbVariables_);
+  DU_dense_.reserve((NbConstraints_ + 2) * NbVariables_);
+  DenseHessianValid_ = false;
 
-  array_s<double> *Array_p = 0;
+  NbVariables_ = NbVariables;
+  NbConstraints_ = NbConstraints;
+}
 
-  switch (Type) {
-  case VECTOR_D:
-    Array_p = &D_;
-    NbVariables_ =
-        (unsigned int)((row + Vec.size() > NbVariables_) ? row + Vec.size()
-                                                         : NbVariables_);
-    break;
+void QPProblem::mark_dirty(qp_element_e Type, unsigned int Row,
+                           unsigned int Col, unsigned int NbRows,
+                           unsigned int NbCols) {
 
-  case VECTOR_XL:
-    Array_p = &XL_;
-    NbVariables_ =
-        (unsigned int)((row + Vec.size() > NbVariables_) ? row + Vec.size()
-                                                         : NbVariables_);
-    break;
+  if ((NbRows == 0) || (NbCols == 0))
+    return;
 
-  case VECTOR_XU:
-    Array_p = &XU_;
-    NbVariables_ =
-        (unsigned int)((row + Vec.size() > NbVariables_) ? row + Vec.size()
-                                                         : NbVariables_);
-    break;
+  dirty_t &lDirty = Dirty_[Type];
+  if (!lDirty.Dirty) {
+    lDirty.Dirty = true;
+    lDirty.FirstRow = Row;
+    lDirty.EndRow = Row + NbRows;
+    lDirty.FirstCol = Col;
+    lDirty.EndCol = Col + NbCols;
+  } else {
+    lDirty.FirstRow = (Row < lDirty.FirstRow) ? Row : lDirty.FirstRow;
+    lDirty.EndRow =
+        (Row + NbRows > lDirty.EndRow) ? Row + NbRows : lDirty.EndRow;
+    lDirty.FirstCol = (Col < lDirty.FirstCol) ? Col : lDirty.FirstCol;
+    lDirty.EndCol =
+        (Col + NbCols > lDirty.EndCol) ? Col + NbCols : lDirty.EndCol;
+  }
 
-  case VECTOR_DS:
-    Array_p = &DS_;
-    NbConstraints_ =
-        (unsigned int)((row + Vec.size() > NbConstraints_) ? row + Vec.size()
-                                                           : NbConstraints_);
-    row++; // The first rows of DU,DS are empty
-    break;
+  // The block intersects the leading blocks larger than max(Row,Col).
+  unsigned int lLeading = (Row > Col) ? Row : Col;
+  if (lLeading < lDirty.CleanLeadingSize)
+    lDirty.CleanLeadingSize = lLeading;
+}
 
-  case MATRIX_DU:
-    Array_p = &DU_;
-    NbConstraints_ = (row + 1 > NbConstraints_) ? row + 1 : NbConstraints_;
-    break;
-  case MATRIX_Q:
-    break;
+void QPProblem::mark_dirty(qp_element_e Type) {
+  mark_dirty(Type, 0, 0, (unsigned int)-1, (unsigned int)-1);
+}
+
+void QPProblem::clean_dirty() {
+  for (int Type = MATRIX_Q; Type <= VECTOR_XU; Type++) {
+    dirty_t &lDirty = Dirty_[Type];
+    lDirty.Dirty = false;
+    lDirty.FirstRow = lDirty.EndRow = 0;
+    lDirty.FirstCol = lDirty.EndCol = 0;
+    lDirty.CleanLeadingSize = (unsigned int)-1;
   }
+}
 
-  if ((NbVariables_ > D_.NbRows_) && (NbVariables_ > 0))
-    resize_all();
+void QPProblem::update_dense_hessian() {
 
-  double *p_it = &Array_p->Array_[row + col * Array_p->NbRows_];
-  if (Type == MATRIX_DU) {
-    for (unsigned i = 0; i < Vec.size(); i++) {
-      *p_it += Vec(i);
-      ++p_it;
-    }
-  } else {
-    for (unsigned i = 0; i < Vec.size(); i++) {
-      *p_it += Vec(i);
-      ++p_it;
-    }
+  unsigned int n = (unsigned int)n_;
+  if ((!DenseHessianValid_) || (Q_dense_.NbRows_ != n) ||
+      (Q_dense_.NbCols_ != n)) {
+    Q_.stick_together(Q_dense_, n, n);
+    return;
+  }
+
+  // The leading block is the one of the last resolution.
+  unsigned int lClean = Dirty_[MATRIX_Q].CleanLeadingSize;
+  for (unsigned int j = 0; j < n; j++) {
+    unsigned int FirstRow = (j < lClean) ? lClean : 0;
+    for (unsigned int i = FirstRow; i < n; i++)
+      Q_dense_.Array_[i + n * j] = Q_.Array_[i + Q_.NbRows_ * j];
   }
 }
 
@@ -27,6 +27,7 @@
 #ifndef _QP_PROBLEM_H_
 #define _QP_PROBLEM_H_
 
+#include <Mathematics/QLDSolver.hh>
 #include <Mathematics/intermediate-qp-matrices.hh>
 #include <Mathematics/qld.hh>
 #include <PreviewControl/rigid-body-system.hh>
@@ -35,11 +36,31 @@
 
 namespace PatternGeneratorJRL {
 
+class QPRecorder;
+
 /// \brief Final optimization problem.
 /// Store and solve a quadratic problem with linear constraints.
 ///
 class QPProblem {
 
+  //
+  // Public types
+  //
+public:
+  /// \brief Writable block of a term, stored by columns
+  typedef Eigen::Map<Eigen::MatrixXd, 0, Eigen::OuterStride<> > term_t;
+
+  /// \brief Elements of a term modified since the last resolution
+  struct dirty_t {
+    /// \brief True if some elements have been modified
+    bool Dirty;
+    /// \brief Bounding box of the modified elements
+    unsigned int FirstRow, EndRow, FirstCol, EndCol;
+    /// \brief Size of the leading block which has not been modified
+    /// For the hessian, the factorization of this block can be kept.
+    unsigned int CleanLeadingSize;
+  };
+
   //
   // Public methods
   //
@@ -73,6 +94,33 @@ public:
   void add_term_to(qp_element_e Type, const Eigen::VectorXd &Vec, unsigned Row,
                    unsigned Col = 0);
 
+  /// \brief Reserve the memory for the maximal dimensions of the problem
+  /// Afterwards, building a smaller problem does not reallocate.
+  ///
+  /// \param[in] MaxNbVariables
+  /// \param[in] MaxNbConstraints
+  void reserve(unsigned int MaxNbVariables, unsigned int MaxNbConstraints);
+
+  /// \brief Block of a term to be written in place
+  /// The dimensions of the problem grow to contain the block, which
+  /// is marked as dirty. The block is valid as long as the reserved
+  /// dimensions are not exceeded.
+  ///
+  /// \param[in] Type Target term
+  /// \param[in] Row First row inside the target
+  /// \param[in] Col First column inside the target
+  /// \param[in] NbRows Number of rows of the block
+  /// \param[in] NbCols Number of columns of the block
+  term_t term(qp_element_e Type, unsigned int Row, unsigned int Col,
+              unsigned int NbRows, unsigned int NbCols = 1);
+
+  /// \brief Elements of a term modified since the last call to solve
+  ///
+  /// \param[in] Type
+  inline const dirty_t &dirty(qp_element_e Type) const {
+    return Dirty_[Type];
+  };
+
   /// \brief Dump current problem on disk.
   void dump(const char *Filename);
   void dump(double Time);
@@ -102,6 +150,11 @@ public:
   /// \param[in] Tests
   void solve(solver_e Solver, solution_t &Result, const tests_e &Tests = NONE);
 
+  /// \brief Value of the objective 1/2 x'Qx + D'x at a solution
+  ///
+  /// \param[in] Result
+  double cost(const solution_t &Result) const;
+
   /// \name Accessors and mutators
   /// \{
   inline void NbVariables(unsigned int NbVariables) {
@@ -128,6 +181,10 @@ public:
     nbInvariantCols_ = nbInvariantCols;
   };
   inline unsigned int nbInvariantCols() { return nbInvariantCols_; };
+
+  /// \brief Record the solved problems, 0 to stop the recording
+  inline void recorder(QPRecorder *Recorder) { Recorder_ = Recorder; };
+  inline QPRecorder *recorder() const { return Recorder_; };
   /// \}
 
   /// \brief Print_ array
@@ -144,6 +201,26 @@ private:
   ///
   void resize_all();
 
+  /// \brief Grow the arrays to the current dimensions, keeping the terms
+  void grow_arrays();
+
+  /// \name Dirty elements
+  /// \{
+  /// \brief Mark a block of a term
+  void mark_dirty(qp_element_e Type, unsigned int Row, unsigned int Col,
+                  unsigned int NbRows, unsigned int NbCols);
+
+  /// \brief Mark a whole term
+  void mark_dirty(qp_element_e Type);
+
+  /// \brief Mark all the terms as clean
+  void clean_dirty();
+  /// \}
+
+  /// \brief Update the dense hessian given to the solver
+  /// Only the part outside the clean leading block is copied.
+  void update_dense_hessian();
+
   /// \name Dumping functions
   /// \{
   /// \brief Print_ on disk the parameters that are passed to the solver
@@ -185,6 +262,8 @@ private:
         type *NewArray = 0;
         if ((FinalArray.SizeMem_ < NbRows * NbCols) ||
             (FinalArray.Array_ == 0)) {
+          if (FinalArray.Array_ != 0)
+            delete[] FinalArray.Array_;
           FinalArray.Array_ = new type[NbRows * NbCols];
           FinalArray.SizeMem_ = NbRows * NbCols;
         }
@@ -215,18 +294,34 @@ private:
       try {
         bool Reallocate = false;
         type *NewArray = 0;
-        if (NbRows * NbCols > SizeMem_) {
+        // Growing rows are preserved in place, starting from the end so
+        // that the values are moved before being overwritten. Otherwise
+        // the values are copied from the old array.
+        bool InPlace = (Preserve) && (Array_ != 0) && (NbRows >= NbRows_) &&
+                       (NbRows * NbCols <= SizeMem_);
+        if ((NbRows * NbCols > SizeMem_) ||
+            ((Preserve) && (Array_ != 0) && (!InPlace))) {
           NewArray = new type[NbRows * NbCols];
           SizeMem_ = NbRows * NbCols;
           Reallocate = true;
         } else
           NewArray = Array_;
 
-        fill(NewArray, NbRows * NbCols, (type)0);
-        if ((Preserve) && (Array_ != 0)) {
-          for (unsigned int j = 0; j < NbCols_; j++)
-            for (unsigned int i = 0; i < NbRows_; i++)
-              NewArray[i + NbRows * j] = Array_[i + NbRows_ * j];
+        if (InPlace) {
+          for (unsigned int j = NbCols; j-- > 0;)
+            for (unsigned int i = NbRows; i-- > 0;)
+              NewArray[i + NbRows * j] = ((i < NbRows_) && (j < NbCols_))
+                                             ? Array_[i + NbRows_ * j]
+                                             : (type)0;
+        } else {
+          fill(NewArray, NbRows * NbCols, (type)0);
+          if ((Preserve) && (Array_ != 0)) {
+            unsigned int lNbRows = (NbRows < NbRows_) ? NbRows : NbRows_;
+            unsigned int lNbCols = (NbCols < NbCols_) ? NbCols : NbCols_;
+            for (unsigned int j = 0; j < lNbCols; j++)
+              for (unsigned int i = 0; i < lNbRows; i++)
+                NewArray[i + NbRows * j] = Array_[i + NbRows_ * j];
+          }
         }
 
         if ((Array_ != 0) && Reallocate) {
@@ -243,6 +338,26 @@ private:
       return 0;
     }
 
+    /// \brief Allocate memory without changing the dimensions
+    /// The values are lost if the array is reallocated.
+    ///
+    /// \param[in] Size Number of elements
+    /// \return 0
+    int reserve(unsigned int Size) {
+      try {
+        if ((Size > SizeMem_) || (Array_ == 0)) {
+          if (Array_ != 0)
+            delete[] Array_;
+          Array_ = new type[Size];
+          SizeMem_ = Size;
+          fill(Array_, Size, (type)0);
+        }
+      } catch (std::bad_alloc &ba) {
+        std::cerr << "bad_alloc caught: " << ba.what() << std::endl;
+      }
+      return 0;
+    }
+
     array_s() : Array_(0), Id_(0), NbRows_(0), NbCols_(0), SizeMem_(0){};
     ~array_s() {
 
@@ -264,23 +379,36 @@ private:
   int iter_;
   double obj_;
   double *clamda_;
+  array_s<double> war_;
+  array_s<int> iwar_;
+  int lwar_, liwar_;
   /// \}
 
   /// \name ql-parameters
   /// \{
   int m_, me_, mmax_, n_, nmax_, mnn_;
-  array_s<double> Q_, Q_dense_, D_, DU_, DU_dense_, DS_, XL_, XU_, X_, U_, war_;
-  array_s<int> iwar_;
-  int iout_, ifail_, iprint_, lwar_, liwar_;
+  array_s<double> Q_, Q_dense_, D_, DU_, DU_dense_, DS_, XL_, XU_, X_;
+  int iout_, ifail_, iprint_;
   double eps_;
+  /// \brief QLD with a workspace following the size of the problem
+  QLDSolver qld_;
   /// \}
 
+  /// \brief Modified elements of each term
+  dirty_t Dirty_[VECTOR_XU + 1];
+
+  /// \brief True if the dense hessian holds the hessian of the last solve
+  bool DenseHessianValid_;
+
   ///  \brief Robot
   RigidBodySystem *Robot_;
 
   /// \brief Last solution
   Eigen::VectorXd lastSolution_;
 
+  /// \brief Recorder of the solved problems, may be 0
+  QPRecorder *Recorder_;
+
   /// \brief Number of optimization parameters
   unsigned int NbVariables_;
 
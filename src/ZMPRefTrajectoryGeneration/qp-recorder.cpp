@@ -0,0 +1,394 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <iostream>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* HAVE_SYS_MMAN_H */
+
+#include <ZMPRefTrajectoryGeneration/qp-problem.hh>
+#include <ZMPRefTrajectoryGeneration/qp-recorder.hh>
+
+using namespace PatternGeneratorJRL;
+
+namespace {
+const char QPR_MAGIC[8] = {'J', 'R', 'L', 'Q', 'P', 'R', 'C', '\0'};
+const unsigned int QPR_VERSION = 1;
+const unsigned long QPR_PAGE_SIZE = 4096;
+
+/// \brief Copy a block stored by columns with the leading dimension Ld
+double *copy_block(double *Dest, const double *Src, unsigned int NbRows,
+                   unsigned int NbCols, unsigned int Ld) {
+  if (Ld == NbRows) {
+    memcpy(Dest, Src, NbRows * NbCols * sizeof(double));
+    return Dest + NbRows * NbCols;
+  }
+  for (unsigned int j = 0; j < NbCols; j++) {
+    memcpy(Dest, Src + j * Ld, NbRows * sizeof(double));
+    Dest += NbRows;
+  }
+  return Dest;
+}
+
+/// \brief Copy a vector or fill it with Value if Src is 0
+double *copy_vector(double *Dest, const double *Src, unsigned int Size,
+                    double Value = 0.0) {
+  if (Src != 0)
+    memcpy(Dest, Src, Size * sizeof(double));
+  else
+    std::fill_n(Dest, Size, Value);
+  return Dest + Size;
+}
+
+const double *read_vector(Eigen::VectorXd &Dest, const double *Src,
+                          unsigned int Size) {
+  Dest = Eigen::Map<const Eigen::VectorXd>(Src, Size);
+  return Src + Size;
+}
+
+const double *read_matrix(Eigen::MatrixXd &Dest, const double *Src,
+                          unsigned int NbRows, unsigned int NbCols) {
+  Dest = Eigen::Map<const Eigen::MatrixXd>(Src, NbRows, NbCols);
+  return Src + NbRows * NbCols;
+}
+} // namespace
+
+QPRecorder::QPRecorder()
+    : FileDescriptor_(-1), Data_(0), MappedSize_(0), ReadOnly_(false),
+      Time_(0.0), Pending_(0) {}
+
+QPRecorder::~QPRecorder() { close(); }
+
+unsigned int QPRecorder::slot_size(unsigned int MaxNbVariables,
+                                   unsigned int MaxNbConstraints) {
+  unsigned int n = MaxNbVariables, m = MaxNbConstraints;
+  return (unsigned int)(sizeof(slot_header_t) +
+                        (n * n + m * n + 8 * n + 2 * m) * sizeof(double));
+}
+
+bool QPRecorder::open(const std::string &FileName, unsigned int NbSlots,
+                      unsigned int MaxNbVariables,
+                      unsigned int MaxNbConstraints) {
+  close();
+  if ((NbSlots == 0) || (MaxNbVariables == 0)) {
+    std::cerr << "QPRecorder - Wrong dimensions of the ring." << std::endl;
+    return false;
+  }
+
+#ifdef HAVE_SYS_MMAN_H
+  FileDescriptor_ = ::open(FileName.c_str(), O_RDWR | O_CREAT, 0644);
+  if (FileDescriptor_ < 0) {
+    std::cerr << "QPRecorder - Unable to open " << FileName << std::endl;
+    return false;
+  }
+  FileName_ = FileName;
+
+  unsigned int SlotSize = slot_size(MaxNbVariables, MaxNbConstraints);
+  unsigned long Size =
+      sizeof(file_header_t) + (unsigned long)NbSlots * SlotSize;
+
+  // The records of a file with the same dimensions are kept.
+  struct stat st;
+  bool Keep = (fstat(FileDescriptor_, &st) == 0) &&
+              ((unsigned long)st.st_size == Size) && map(Size, false);
+  if (Keep) {
+    file_header_t *aHeader = header();
+    Keep = (memcmp(aHeader->Magic, QPR_MAGIC, sizeof(QPR_MAGIC)) == 0) &&
+           (aHeader->Version == QPR_VERSION) &&
+           (aHeader->NbSlots == NbSlots) &&
+           (aHeader->MaxNbVariables == MaxNbVariables) &&
+           (aHeader->MaxNbConstraints == MaxNbConstraints) &&
+           (aHeader->SlotSize == SlotSize);
+  }
+
+  if (!Keep) {
+    if ((ftruncate(FileDescriptor_, 0) != 0) ||
+        (ftruncate(FileDescriptor_, (off_t)Size) != 0) ||
+        !map(Size, false)) {
+      std::cerr << "QPRecorder - Unable to allocate " << FileName
+                << std::endl;
+      close();
+      return false;
+    }
+    file_header_t *aHeader = header();
+    memcpy(aHeader->Magic, QPR_MAGIC, sizeof(QPR_MAGIC));
+    aHeader->Version = QPR_VERSION;
+    aHeader->NbSlots = NbSlots;
+    aHeader->MaxNbVariables = MaxNbVariables;
+    aHeader->MaxNbConstraints = MaxNbConstraints;
+    aHeader->SlotSize = SlotSize;
+    aHeader->Reserved = 0;
+    aHeader->NbWritten = 0;
+    aHeader->NbDropped = 0;
+  }
+
+  // The pages are faulted in now rather than during the recording.
+  for (unsigned long i = 0; i < MappedSize_; i += QPR_PAGE_SIZE) {
+    volatile char *lByte = Data_ + i;
+    *lByte = *lByte;
+  }
+  return true;
+#else
+  (void)FileName;
+  std::cerr << "QPRecorder - memory-mapped files are not supported, "
+               "the problems will not be recorded."
+            << std::endl;
+  return false;
+#endif /* HAVE_SYS_MMAN_H */
+}
+
+bool QPRecorder::open(const std::string &FileName) {
+  close();
+
+#ifdef HAVE_SYS_MMAN_H
+  FileDescriptor_ = ::open(FileName.c_str(), O_RDONLY);
+  if (FileDescriptor_ < 0) {
+    std::cerr << "QPRecorder - Unable to open " << FileName << std::endl;
+    return false;
+  }
+  FileName_ = FileName;
+
+  struct stat st;
+  if ((fstat(FileDescriptor_, &st) != 0) ||
+      ((unsigned long)st.st_size < sizeof(file_header_t)) ||
+      !map((unsigned long)st.st_size, true)) {
+    std::cerr << "QPRecorder - " << FileName << " is not a record."
+              << std::endl;
+    close();
+    return false;
+  }
+
+  const file_header_t *aHeader = header();
+  if ((memcmp(aHeader->Magic, QPR_MAGIC, sizeof(QPR_MAGIC)) != 0) ||
+      (aHeader->Version != QPR_VERSION) || (aHeader->NbSlots == 0) ||
+      (aHeader->SlotSize != slot_size(aHeader->MaxNbVariables,
+                                      aHeader->MaxNbConstraints)) ||
+      (sizeof(file_header_t) +
+           (unsigned long)aHeader->NbSlots * aHeader->SlotSize >
+       MappedSize_)) {
+    std::cerr << "QPRecorder - " << FileName << " is not a record."
+              << std::endl;
+    close();
+    return false;
+  }
+  return true;
+#else
+  (void)FileName;
+  std::cerr << "QPRecorder - memory-mapped files are not supported."
+            << std::endl;
+  return false;
+#endif /* HAVE_SYS_MMAN_H */
+}
+
+void QPRecorder::close() {
+#ifdef HAVE_SYS_MMAN_H
+  if (Data_ != 0) {
+    if (!ReadOnly_)
+      msync(Data_, MappedSize_, MS_ASYNC);
+    munmap(Data_, MappedSize_);
+  }
+  if (FileDescriptor_ >= 0)
+    ::close(FileDescriptor_);
+#endif /* HAVE_SYS_MMAN_H */
+  Data_ = 0;
+  MappedSize_ = 0;
+  FileDescriptor_ = -1;
+  ReadOnly_ = false;
+  Pending_ = 0;
+  FileName_.clear();
+}
+
+bool QPRecorder::map(unsigned long Size, bool ReadOnly) {
+#ifdef HAVE_SYS_MMAN_H
+  if (Data_ != 0)
+    munmap(Data_, MappedSize_);
+  Data_ = 0;
+  MappedSize_ = 0;
+
+  void *lData = mmap(0, Size, ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE,
+                     MAP_SHARED, FileDescriptor_, 0);
+  if (lData == MAP_FAILED) {
+    std::cerr << "QPRecorder - Unable to map " << FileName_ << std::endl;
+    return false;
+  }
+  Data_ = (char *)lData;
+  MappedSize_ = Size;
+  ReadOnly_ = ReadOnly;
+  return true;
+#else
+  (void)Size;
+  (void)ReadOnly;
+  return false;
+#endif /* HAVE_SYS_MMAN_H */
+}
+
+bool QPRecorder::write_problem(solver_e Solver, unsigned int NbVariables,
+                               unsigned int NbConstraints,
+                               unsigned int NbEqConstraints, const double *Q,
+                               unsigned int LdQ, const double *D,
+                               const double *DU, unsigned int LdDU,
+                               const double *DS, const double *XL,
+                               const double *XU, const double *X0) {
+  Pending_ = 0;
+  if (!is_open() || ReadOnly_)
+    return false;
+
+  file_header_t *aHeader = header();
+  if ((NbVariables > aHeader->MaxNbVariables) ||
+      (NbConstraints > aHeader->MaxNbConstraints)) {
+    aHeader->NbDropped++;
+    return false;
+  }
+
+  // The slot is invalid until write_result.
+  char *lSlot = slot(aHeader->NbWritten + 1);
+  slot_header_t *aSlot = (slot_header_t *)lSlot;
+  aSlot->Sequence = 0;
+  aSlot->Time = Time_;
+  aSlot->SolveTime = 0.0;
+  aSlot->Solver = (int)Solver;
+  aSlot->Fail = 0;
+  aSlot->NbVariables = NbVariables;
+  aSlot->NbConstraints = NbConstraints;
+  aSlot->NbEqConstraints = NbEqConstraints;
+  aSlot->WarmStart = (X0 != 0) ? 1 : 0;
+
+  unsigned int n = NbVariables, m = NbConstraints;
+  double *lValues = (double *)(lSlot + sizeof(slot_header_t));
+  lValues = copy_block(lValues, Q, n, n, LdQ);
+  lValues = copy_vector(lValues, D, n);
+  lValues = copy_block(lValues, DU, m, n, LdDU);
+  lValues = copy_vector(lValues, DS, m);
+  lValues = copy_vector(lValues, XL, n, -1e8);
+  lValues = copy_vector(lValues, XU, n, 1e8);
+  copy_vector(lValues, X0, n);
+
+  Pending_ = lSlot;
+  return true;
+}
+
+void QPRecorder::write_result(const solution_t &Result, double SolveTime) {
+  if (Pending_ == 0)
+    return;
+
+  slot_header_t *aSlot = (slot_header_t *)Pending_;
+  unsigned int n = aSlot->NbVariables, m = aSlot->NbConstraints;
+  aSlot->Fail = Result.Fail;
+  aSlot->SolveTime = SolveTime;
+
+  double *lValues = (double *)(Pending_ + sizeof(slot_header_t)) + n * n +
+                    n + m * n + m + 3 * n;
+  for (unsigned int i = 0; i < n; i++)
+    lValues[i] = (i < Result.Solution_vec.size()) ? Result.Solution_vec(i)
+                                                  : 0.0;
+  lValues += n;
+  for (unsigned int i = 0; i < m; i++)
+    lValues[i] = (i + 1 < Result.ConstrLagr_vec.size())
+                     ? Result.ConstrLagr_vec(i + 1)
+                     : 0.0;
+  lValues += m;
+  for (unsigned int i = 0; i < n; i++) {
+    lValues[i] = (i < Result.LBoundsLagr_vec.size())
+                     ? Result.LBoundsLagr_vec(i)
+                     : 0.0;
+    lValues[n + i] = (i < Result.UBoundsLagr_vec.size())
+                         ? Result.UBoundsLagr_vec(i)
+                         : 0.0;
+  }
+
+  // The counter is updated last so that an interrupted write is ignored.
+  file_header_t *aHeader = header();
+  aSlot->Sequence = aHeader->NbWritten + 1;
+  aHeader->NbWritten++;
+  Pending_ = 0;
+}
+
+unsigned int QPRecorder::nb_records() const {
+  if (!is_open())
+    return 0;
+  const file_header_t *aHeader = header();
+  return (aHeader->NbWritten < aHeader->NbSlots)
+             ? (unsigned int)aHeader->NbWritten
+             : aHeader->NbSlots;
+}
+
+unsigned long long QPRecorder::nb_dropped() const {
+  return is_open() ? header()->NbDropped : 0;
+}
+
+bool QPRecorder::read(unsigned int Index, record_t &Record) const {
+  unsigned int NbRecords = nb_records();
+  if (Index >= NbRecords)
+    return false;
+
+  unsigned long long Sequence = header()->NbWritten - NbRecords + 1 + Index;
+  const char *lSlot = slot(Sequence);
+  const slot_header_t *aSlot = (const slot_header_t *)lSlot;
+  if ((aSlot->Sequence != Sequence) ||
+      (aSlot->NbVariables > header()->MaxNbVariables) ||
+      (aSlot->NbConstraints > header()->MaxNbConstraints))
+    return false;
+
+  unsigned int n = aSlot->NbVariables, m = aSlot->NbConstraints;
+  Record.Sequence = Sequence;
+  Record.Time = aSlot->Time;
+  Record.SolveTime = aSlot->SolveTime;
+  Record.Solver = (solver_e)aSlot->Solver;
+  Record.Fail = aSlot->Fail;
+  Record.NbVariables = n;
+  Record.NbConstraints = m;
+  Record.NbEqConstraints = aSlot->NbEqConstraints;
+  Record.WarmStart = (aSlot->WarmStart != 0);
+
+  const double *lValues = (const double *)(lSlot + sizeof(slot_header_t));
+  lValues = read_matrix(Record.Q, lValues, n, n);
+  lValues = read_vector(Record.D, lValues, n);
+  lValues = read_matrix(Record.DU, lValues, m, n);
+  lValues = read_vector(Record.DS, lValues, m);
+  lValues = read_vector(Record.XL, lValues, n);
+  lValues = read_vector(Record.XU, lValues, n);
+  lValues = read_vector(Record.X0, lValues, n);
+  lValues = read_vector(Record.X, lValues, n);
+  lValues = read_vector(Record.ConstrLagr, lValues, m);
+  lValues = read_vector(Record.LBoundsLagr, lValues, n);
+  read_vector(Record.UBoundsLagr, lValues, n);
+
+  // The slot may have been reused by a writer meanwhile.
+  return aSlot->Sequence == Sequence;
+}
+
+void QPRecorder::load_problem(const record_t &Record, QPProblem &Problem) {
+  unsigned int n = Record.NbVariables, m = Record.NbConstraints;
+  Problem.reset();
+  Problem.term(MATRIX_Q, 0, 0, n, n) = Record.Q;
+  Problem.term(VECTOR_D, 0, 0, n) = Record.D;
+  Problem.term(VECTOR_XL, 0, 0, n) = Record.XL;
+  Problem.term(VECTOR_XU, 0, 0, n) = Record.XU;
+  if (m > 0) {
+    Problem.term(MATRIX_DU, 0, 0, m, n) = Record.DU;
+    Problem.term(VECTOR_DS, 0, 0, m) = Record.DS;
+  }
+  Problem.NbEqConstraints(Record.NbEqConstraints);
+}
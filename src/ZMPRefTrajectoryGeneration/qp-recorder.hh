@@ -0,0 +1,221 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _QP_RECORDER_H_
+#define _QP_RECORDER_H_
+
+#include <string>
+
+#include <Eigen/Dense>
+
+#include <privatepgtypes.hh>
+
+namespace PatternGeneratorJRL {
+
+class QPProblem;
+
+/// \brief Binary capture of the solved quadratic problems.
+/// The problems are written in a ring of fixed size slots of a
+/// memory-mapped file: recording copies the arrays given to the solver
+/// and does not call the system. Once the ring is full, the oldest
+/// problems are overwritten. A problem larger than the slots is
+/// dropped and counted.
+///
+/// The captured problem is
+/// min 1/2 x'Qx + D'x s.t. DU x + DS = 0 for the NbEqConstraints first
+/// rows, DU x + DS >= 0 for the others and XL <= x <= XU,
+/// with the warm start, the result and the resolution time.
+///
+/// The file is not protected against concurrent writers.
+/// Without mmap support the recorder stays closed and nothing is stored.
+class QPRecorder {
+
+  //
+  // Public types
+  //
+public:
+  /// \brief Problem read from the file
+  struct record_t {
+    /// \brief Number of the problem since the creation of the file, from 1
+    unsigned long long Sequence;
+    /// \brief Time given by the owner of the problem
+    double Time;
+    /// \brief Duration of the resolution (s)
+    double SolveTime;
+    solver_e Solver;
+    int Fail;
+    unsigned int NbVariables, NbConstraints, NbEqConstraints;
+    bool WarmStart;
+    Eigen::MatrixXd Q, DU;
+    Eigen::VectorXd D, DS, XL, XU;
+    /// \brief Initial solution, meaningful if WarmStart
+    Eigen::VectorXd X0;
+    /// \brief Solution and multipliers of the constraints and the bounds
+    Eigen::VectorXd X, ConstrLagr, LBoundsLagr, UBoundsLagr;
+  };
+
+  //
+  // Public methods
+  //
+public:
+  QPRecorder();
+
+  ~QPRecorder();
+
+  /// \brief Map a file to record problems, it is created if needed.
+  /// The records of a file with the same dimensions are kept.
+  ///
+  /// \param[in] FileName
+  /// \param[in] NbSlots Number of problems kept in the ring
+  /// \param[in] MaxNbVariables Largest recorded problem
+  /// \param[in] MaxNbConstraints
+  /// \return false if the file cannot be used
+  bool open(const std::string &FileName, unsigned int NbSlots,
+            unsigned int MaxNbVariables, unsigned int MaxNbConstraints);
+
+  /// \brief Map an existing file to read its problems
+  ///
+  /// \param[in] FileName
+  /// \return false if the file cannot be used
+  bool open(const std::string &FileName);
+
+  /// \brief Unmap and close the file
+  void close();
+
+  /// \brief True if a file is mapped
+  inline bool is_open() const { return Data_ != 0; };
+
+  /// \brief Time of the next recorded problems
+  inline void time(double Time) { Time_ = Time; };
+
+  /// \brief Write the problem in the next slot, before its resolution
+  /// Q and DU are stored by columns with the leading dimensions LdQ
+  /// and LdDU, X0 is the warm start or 0.
+  ///
+  /// \return false if the problem is not recorded
+  bool write_problem(solver_e Solver, unsigned int NbVariables,
+                     unsigned int NbConstraints, unsigned int NbEqConstraints,
+                     const double *Q, unsigned int LdQ, const double *D,
+                     const double *DU, unsigned int LdDU, const double *DS,
+                     const double *XL, const double *XU, const double *X0);
+
+  /// \brief Complete the slot of the last written problem
+  /// The multipliers of the constraints follow the layout of QPProblem,
+  /// where the first constraint is empty.
+  ///
+  /// \param[in] Result
+  /// \param[in] SolveTime Duration of the resolution (s)
+  void write_result(const solution_t &Result, double SolveTime);
+
+  /// \brief Number of complete problems in the ring
+  unsigned int nb_records() const;
+
+  /// \brief Number of problems larger than the slots
+  unsigned long long nb_dropped() const;
+
+  /// \brief Read a problem
+  ///
+  /// \param[in] Index From 0, the oldest problem, to nb_records() - 1
+  /// \param[out] Record
+  /// \return false if the slot has been overwritten meanwhile
+  bool read(unsigned int Index, record_t &Record) const;
+
+  /// \brief Build the problem of a record as it has been solved
+  ///
+  /// \param[in] Record
+  /// \param[out] Problem
+  static void load_problem(const record_t &Record, QPProblem &Problem);
+
+  //
+  // Private types
+  //
+private:
+  /// \brief Header of the file
+  struct file_header_t {
+    char Magic[8];
+    unsigned int Version;
+    unsigned int NbSlots;
+    unsigned int MaxNbVariables;
+    unsigned int MaxNbConstraints;
+    unsigned int SlotSize;
+    unsigned int Reserved;
+    /// \brief Number of complete problems since the creation of the file
+    unsigned long long NbWritten;
+    unsigned long long NbDropped;
+  };
+
+  /// \brief Header of a slot, followed by Q, D, DU, DS, XL, XU, X0, X,
+  /// the multipliers of the constraints, the lower and upper bounds.
+  struct slot_header_t {
+    /// \brief 0 while the slot is written
+    unsigned long long Sequence;
+    double Time;
+    double SolveTime;
+    int Solver;
+    int Fail;
+    unsigned int NbVariables, NbConstraints, NbEqConstraints;
+    unsigned int WarmStart;
+  };
+
+  //
+  // Private methods
+  //
+private:
+  /// \brief Map the first Size bytes of the file
+  bool map(unsigned long Size, bool ReadOnly);
+
+  /// \brief Size of a slot for the given dimensions
+  static unsigned int slot_size(unsigned int MaxNbVariables,
+                                unsigned int MaxNbConstraints);
+
+  inline file_header_t *header() const { return (file_header_t *)Data_; };
+
+  inline char *slot(unsigned long long Sequence) const {
+    return Data_ + sizeof(file_header_t) +
+           (unsigned long)((Sequence - 1) % header()->NbSlots) *
+               header()->SlotSize;
+  };
+
+  //
+  // Private members
+  //
+private:
+  /// \brief Name of the mapped file
+  std::string FileName_;
+
+  /// \brief File descriptor, -1 if closed
+  int FileDescriptor_;
+
+  /// \brief Mapped memory
+  char *Data_;
+
+  /// \brief Size of the mapped memory
+  unsigned long MappedSize_;
+
+  /// \brief True if the file is only read
+  bool ReadOnly_;
+
+  /// \brief Time of the next recorded problems
+  double Time_;
+
+  /// \brief Slot of the problem written by write_problem, 0 if none
+  char *Pending_;
+};
+
+} // namespace PatternGeneratorJRL
+#endif /* _QP_RECORDER_H_ */
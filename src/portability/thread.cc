@@ -0,0 +1,199 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "thread.hh"
+
+#ifdef HAVE_PTHREAD_H
+#include <sched.h>
+#endif // HAVE_PTHREAD_H
+
+#include <iostream>
+
+using namespace PatternGeneratorJRL;
+
+namespace {
+/*! Number of tests of a counter before blocking. */
+const unsigned int NbSpins = 4096;
+
+#ifdef HAVE_PTHREAD_H
+inline unsigned long load(const unsigned long *counter) {
+  return __atomic_load_n(counter, __ATOMIC_SEQ_CST);
+}
+
+inline void store(unsigned long *counter, unsigned long value) {
+  __atomic_store_n(counter, value, __ATOMIC_SEQ_CST);
+}
+#endif // HAVE_PTHREAD_H
+} // namespace
+
+WorkerThread::WorkerThread()
+    : m_Job(0), m_Requested(0), m_Done(0), m_Stop(false), m_Running(false),
+      m_CallerPinned(false), m_CPU(-1) {
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_init(&m_Mutex, 0);
+  pthread_cond_init(&m_Condition, 0);
+  m_Blocked = 0;
+#endif // HAVE_PTHREAD_H
+}
+
+WorkerThread::~WorkerThread() {
+  stop();
+#ifdef HAVE_PTHREAD_H
+  pthread_cond_destroy(&m_Condition);
+  pthread_mutex_destroy(&m_Mutex);
+#endif // HAVE_PTHREAD_H
+}
+
+bool WorkerThread::create(int CPU) {
+  stop();
+#ifdef HAVE_PTHREAD_H
+  m_CPU = CPU;
+  m_Stop = false;
+  m_Requested = m_Done = 0;
+  if (pthread_create(&m_Thread, 0, WorkerThread::loop, this) != 0) {
+    std::cerr << "WorkerThread: the thread cannot be created, "
+              << "the jobs are run by the caller." << std::endl;
+    return false;
+  }
+  m_Running = true;
+#else
+  (void)CPU;
+#endif // HAVE_PTHREAD_H
+  return m_Running;
+}
+
+void WorkerThread::stop() {
+#ifdef HAVE_PTHREAD_H
+  unpinCaller();
+#endif // HAVE_PTHREAD_H
+  if (!m_Running)
+    return;
+#ifdef HAVE_PTHREAD_H
+  // The stop request is a request without job.
+  wait();
+  m_Job = 0;
+  m_Stop = true;
+  notify(&m_Requested, m_Requested + 1);
+  pthread_join(m_Thread, 0);
+#endif // HAVE_PTHREAD_H
+  m_Running = false;
+}
+
+void WorkerThread::start(Job *aJob) {
+  if (!m_Running) {
+    aJob->run();
+    return;
+  }
+#ifdef HAVE_PTHREAD_H
+  m_Job = aJob;
+  notify(&m_Requested, m_Requested + 1);
+#endif // HAVE_PTHREAD_H
+}
+
+void WorkerThread::wait() {
+#ifdef HAVE_PTHREAD_H
+  if (m_Running)
+    waitWhileEqual(&m_Done, m_Requested - 1);
+#endif // HAVE_PTHREAD_H
+}
+
+bool WorkerThread::pinCurrentThread(int CPU) {
+#if defined(HAVE_PTHREAD_H) && defined(__linux__)
+  if (CPU < 0)
+    return false;
+  cpu_set_t CPUs;
+  CPU_ZERO(&CPUs);
+  CPU_SET(CPU, &CPUs);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &CPUs) ==
+         0;
+#else
+  (void)CPU;
+  return false;
+#endif
+}
+
+bool WorkerThread::pinCaller(int CPU) {
+  if ((CPU < 0) || m_CallerPinned)
+    return true;
+#if defined(HAVE_PTHREAD_H) && defined(__linux__)
+  m_Caller = pthread_self();
+  if (pthread_getaffinity_np(m_Caller, sizeof(cpu_set_t), &m_CallerCPUs) !=
+      0)
+    return false;
+  m_CallerPinned = pinCurrentThread(CPU);
+#endif
+  return m_CallerPinned;
+}
+
+#ifdef HAVE_PTHREAD_H
+void WorkerThread::unpinCaller() {
+  if (!m_CallerPinned)
+    return;
+#ifdef __linux__
+  // The pinned thread may not be the calling one.
+  pthread_setaffinity_np(m_Caller, sizeof(cpu_set_t), &m_CallerCPUs);
+#endif // __linux__
+  m_CallerPinned = false;
+}
+
+void WorkerThread::waitWhileEqual(const unsigned long *counter,
+                                  unsigned long value) {
+  for (unsigned int i = 0; i < NbSpins; i++) {
+    if (load(counter) != value)
+      return;
+  }
+
+  // The counter is tested again once the thread is counted as blocked:
+  // either notify() sees it blocked, or the new value is seen here.
+  pthread_mutex_lock(&m_Mutex);
+  __atomic_add_fetch(&m_Blocked, 1, __ATOMIC_SEQ_CST);
+  while (load(counter) == value)
+    pthread_cond_wait(&m_Condition, &m_Mutex);
+  __atomic_sub_fetch(&m_Blocked, 1, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&m_Mutex);
+}
+
+void WorkerThread::notify(unsigned long *counter, unsigned long value) {
+  store(counter, value);
+  if (load(&m_Blocked) == 0)
+    return;
+  pthread_mutex_lock(&m_Mutex);
+  pthread_cond_broadcast(&m_Condition);
+  pthread_mutex_unlock(&m_Mutex);
+}
+#endif // HAVE_PTHREAD_H
+
+#ifdef HAVE_PTHREAD_H
+void *WorkerThread::loop(void *aWorkerThread) {
+  WorkerThread *self = (WorkerThread *)aWorkerThread;
+  if ((self->m_CPU >= 0) && !pinCurrentThread(self->m_CPU))
+    std::cerr << "WorkerThread: the thread cannot be pinned on the CPU "
+              << self->m_CPU << std::endl;
+
+  unsigned long lDone = 0;
+  for (;;) {
+    self->waitWhileEqual(&self->m_Requested, lDone);
+    if (self->m_Stop)
+      break;
+    self->m_Job->run();
+    lDone++;
+    self->notify(&self->m_Done, lDone);
+  }
+  return 0;
+}
+#endif // HAVE_PTHREAD_H
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JRL_WALKGEN_PORTABILITY_THREAD_HH
+#define JRL_WALKGEN_PORTABILITY_THREAD_HH
+
+// This deals with the portability of the worker threads.
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif // HAVE_PTHREAD_H
+
+namespace PatternGeneratorJRL {
+/*! A thread running one job at a time. The job is handed over through
+  atomic counters: start() publishes it and wait() spins until it is
+  done. The thread spins as well between two jobs. After a short spin
+  budget, both sides block on a condition variable, so that an idle
+  thread does not use a processor between two walking sequences.
+
+  Without pthreads, or when the thread cannot be created, the job is run
+  by start() in the calling thread. */
+class WorkerThread {
+public:
+  /*! A job run by the thread. */
+  class Job {
+  public:
+    virtual ~Job() {}
+    virtual void run() = 0;
+  };
+
+  WorkerThread();
+
+  /*! Stop the thread. */
+  ~WorkerThread();
+
+  /*! Create the thread, pinned on the processor CPU when it is not
+    negative.
+    \return false if the jobs are run in the calling thread. */
+  bool create(int CPU = -1);
+
+  /*! Stop the thread once the current job is done, and give back its
+    processors to the thread pinned by pinCaller(). */
+  void stop();
+
+  /*! Is there a thread to run the jobs. */
+  bool running() const { return m_Running; }
+
+  /*! Hand a job to the thread. The job must not be changed
+    before wait() returns. */
+  void start(Job *aJob);
+
+  /*! Wait until the job given to start() is done. */
+  void wait();
+
+  /*! Pin the calling thread on a processor.
+    \return false if it is not supported on this system. */
+  static bool pinCurrentThread(int CPU);
+
+  /*! Pin the calling thread on a processor until stop(), which restores
+    its former affinity. Nothing is done if a thread is already pinned
+    or if CPU is negative.
+    \return false if the calling thread cannot be pinned. */
+  bool pinCaller(int CPU);
+
+private:
+  WorkerThread(const WorkerThread &);
+  WorkerThread &operator=(const WorkerThread &);
+
+#ifdef HAVE_PTHREAD_H
+  static void *loop(void *aWorkerThread);
+  /*! Wait until the counter is different from value. */
+  void waitWhileEqual(const unsigned long *counter, unsigned long value);
+  /*! Set the counter and wake up the blocked threads. */
+  void notify(unsigned long *counter, unsigned long value);
+  void unpinCaller();
+
+  pthread_t m_Thread;
+  pthread_mutex_t m_Mutex;
+  pthread_cond_t m_Condition;
+  /*! Number of threads blocked on the condition, accessed atomically. */
+  unsigned long m_Blocked;
+#ifdef __linux__
+  /*! Thread pinned by pinCaller() and its former processors. */
+  pthread_t m_Caller;
+  cpu_set_t m_CallerCPUs;
+#endif // __linux__
+#endif // HAVE_PTHREAD_H
+
+  /*! Job of the last request. */
+  Job *m_Job;
+  /*! Number of jobs requested and done, accessed atomically. */
+  unsigned long m_Requested, m_Done;
+  bool m_Stop, m_Running, m_CallerPinned;
+  int m_CPU;
+};
+} // namespace PatternGeneratorJRL
+#endif //! JRL_WALKGEN_PORTABILITY_THREAD_HH
@@ -230,9 +230,9 @@ void linear_inequality_t::resize(int NbRows, int NbCols, bool) {
 }
 
 solution_t::solution_t()
-    : NbVariables(0), NbConstraints(0), Fail(0), Print(0), Solution_vec(0),
-      SupportOrientations_deq(0), SupportStates_deq(0), ConstrLagr_vec(0),
-      LBoundsLagr_vec(0), UBoundsLagr_vec(0) {}
+    : NbVariables(0), NbConstraints(0), Fail(0), Print(0), useWarmStart(false),
+      Solution_vec(0), SupportOrientations_deq(0), SupportStates_deq(0),
+      ConstrLagr_vec(0), LBoundsLagr_vec(0), UBoundsLagr_vec(0) {}
 
 void solution_t::reset() {
 
@@ -255,10 +255,10 @@ void solution_t::resize(unsigned int SizeSolution,
   NbVariables = SizeSolution;
   NbConstraints = SizeConstraints;
 
-  Solution_vec.resize(SizeSolution, false);
-  ConstrLagr_vec.resize(SizeConstraints, false);
-  LBoundsLagr_vec.resize(SizeSolution, false);
-  UBoundsLagr_vec.resize(SizeSolution, false);
+  Solution_vec.resize(SizeSolution);
+  ConstrLagr_vec.resize(SizeConstraints);
+  LBoundsLagr_vec.resize(SizeSolution);
+  UBoundsLagr_vec.resize(SizeSolution);
 }
 
 void solution_t::dump(const char *FileName) {
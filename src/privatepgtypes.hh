@@ -91,6 +91,18 @@ enum solver_e { QLD, LSSOL };
 enum tests_e { NONE, ALL, ITT, CTR };
 
 enum axis_e { X_AXIS, Y_AXIS, Z_AXIS, YAW, PITCH, ROLL };
+
+/// \brief Support sequences derived from the one of the finite state machine
+enum support_candidate_e {
+  NOMINAL_SUPPORT,
+  EARLY_TOUCHDOWN,
+  LATE_TOUCHDOWN,
+  EXTRA_STEP,
+  NB_SUPPORT_CANDIDATES
+};
+
+/// \brief Formulation of the problem of the velocity reference generator
+enum qp_formulation_e { CONDENSED_QP, SPARSE_QP };
 /// \}
 
 //
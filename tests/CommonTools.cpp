@@ -57,6 +57,11 @@ double filterprecision(double adb) {
   return lintadb2 / 1e7;
 }
 
+double Time(const struct timeval &begin, const struct timeval &end) {
+  return (double)(end.tv_sec - begin.tv_sec) +
+         1e-6 * (double)(end.tv_usec - begin.tv_usec);
+}
+
 void CommonInitialization(PatternGeneratorInterface &aPGI) {
   const unsigned int nbMethod = 13;
   const char lBuffer[nbMethod][256] = {
@@ -36,6 +36,8 @@
 #include <string>
 #include <time.h>
 
+#include "portability/gettimeofday.hh"
+
 #include "ClockCPUTime.hh"
 #include <jrl/walkgen/patterngeneratorinterface.hh>
 
@@ -46,6 +48,9 @@ namespace PatternGeneratorJRL {
 namespace TestSuite {
 double filterprecision(double adb);
 
+/*! \brief Time elapsed between begin and end (s). */
+double Time(const struct timeval &begin, const struct timeval &end);
+
 void getOptions(int argc, char *argv[], std::string &urdfFullPath,
                 std::string &srdfFullPath,
                 unsigned int &); // TestProfil)
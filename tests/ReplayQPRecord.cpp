@@ -0,0 +1,186 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file ReplayQPRecord.cpp
+  \brief Solve again the problems captured by QPRecorder and report the
+  distribution of the resolution times.
+
+  ReplayQPRecord file [qld|qpproblem|lssol] [repetitions]
+
+  - qld solves the arrays with QLDSolver only,
+  - qpproblem (default) builds a QPProblem solved by QLD, as online,
+  - lssol builds a QPProblem solved by LSSOL.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "portability/gettimeofday.hh"
+
+#include <Mathematics/QLDSolver.hh>
+#include <ZMPRefTrajectoryGeneration/qp-problem.hh>
+#include <ZMPRefTrajectoryGeneration/qp-recorder.hh>
+
+#include "CommonTools.hh"
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+using namespace PatternGeneratorJRL::TestSuite;
+
+/*! Solve with QLDSolver the arrays given by QPProblem to QL0001,
+  where the first constraint is empty. */
+int SolveWithQLD(const QPRecorder::record_t &R, QLDSolver &aQLD,
+                 Eigen::VectorXd &X) {
+  unsigned int n = R.NbVariables, m = R.NbConstraints + 1;
+  Eigen::MatrixXd Q = R.Q, A = Eigen::MatrixXd::Zero(m + 1, n);
+  Eigen::VectorXd D = R.D, B = Eigen::VectorXd::Zero(m + 1);
+  Eigen::VectorXd XL = R.XL, XU = R.XU;
+  A.block(1, 0, R.NbConstraints, n) = R.DU;
+  B.segment(1, R.NbConstraints) = R.DS;
+  X.setZero(n);
+  aQLD.Reserve(m, n);
+  return aQLD.Solve(m, R.NbEqConstraints, n, Q.data(), n, D.data(), A.data(),
+                    m + 1, B.data(), X.data(), XL.data(), XU.data());
+}
+
+/*! Value at the ratio p of the sorted values. */
+double Quantile(const vector<double> &Sorted, double p) {
+  if (Sorted.empty())
+    return 0.0;
+  unsigned int i = (unsigned int)floor(p * (double)(Sorted.size() - 1) + 0.5);
+  return Sorted[i];
+}
+
+void PrintDistribution(const char *Name, vector<double> Times) {
+  sort(Times.begin(), Times.end());
+  double Sum = 0.0;
+  for (unsigned int i = 0; i < Times.size(); i++)
+    Sum += Times[i];
+  printf("%-10s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", Name,
+         1e6 * Quantile(Times, 0.0), 1e6 * Quantile(Times, 0.5),
+         1e6 * Quantile(Times, 0.9), 1e6 * Quantile(Times, 0.99),
+         1e6 * Quantile(Times, 1.0),
+         Times.empty() ? 0.0 : 1e6 * Sum / (double)Times.size());
+}
+
+bool SlowerRecord(const pair<double, unsigned int> &a,
+                  const pair<double, unsigned int> &b) {
+  return a.first > b.first;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    cerr << "Usage: " << argv[0]
+         << " file [qld|qpproblem|lssol] [repetitions]" << endl;
+    return 1;
+  }
+  string Backend = (argc > 2) ? argv[2] : "qpproblem";
+  unsigned int NbRepetitions = (argc > 3) ? (unsigned int)atoi(argv[3]) : 10;
+  if (NbRepetitions == 0)
+    NbRepetitions = 1;
+  if ((Backend != "qld") && (Backend != "qpproblem") && (Backend != "lssol")) {
+    cerr << "Unknown backend " << Backend << endl;
+    return 1;
+  }
+
+  QPRecorder aRecorder;
+  if (!aRecorder.open(argv[1]))
+    return 1;
+  unsigned int NbRecords = aRecorder.nb_records();
+  printf("%u problems, %llu dropped while recording\n", NbRecords,
+         aRecorder.nb_dropped());
+
+  QLDSolver aQLD;
+  aQLD.SetPrintLevel(0);
+  QPProblem aPb;
+  QPRecorder::record_t aRecord;
+  vector<double> Recorded, Replayed;
+  vector<unsigned int> Indexes;
+  vector<pair<double, unsigned int> > Slowest;
+  unsigned int NbDifferentFails = 0;
+  double MaxDifference = 0.0;
+  for (unsigned int i = 0; i < NbRecords; i++) {
+    if (!aRecorder.read(i, aRecord)) {
+      cerr << "Problem " << i << " cannot be read." << endl;
+      continue;
+    }
+
+    // The fastest of the repetitions is kept.
+    double ReplayTime = HUGE_VAL;
+    int Fail = 0;
+    Eigen::VectorXd X;
+    for (unsigned int r = 0; r < NbRepetitions; r++) {
+      struct timeval begin, end;
+      if (Backend == "qld") {
+        gettimeofday(&begin, 0);
+        Fail = SolveWithQLD(aRecord, aQLD, X);
+        gettimeofday(&end, 0);
+      } else {
+        solution_t aSolution;
+        aSolution.useWarmStart = aRecord.WarmStart;
+        aSolution.initialSolution = aRecord.X0;
+        QPRecorder::load_problem(aRecord, aPb);
+        gettimeofday(&begin, 0);
+        aPb.solve((Backend == "lssol") ? LSSOL : QLD, aSolution);
+        gettimeofday(&end, 0);
+        Fail = aSolution.Fail;
+        X = aSolution.Solution_vec;
+      }
+      ReplayTime = min(ReplayTime, Time(begin, end));
+    }
+
+    Slowest.push_back(
+        make_pair(aRecord.SolveTime, (unsigned int)Indexes.size()));
+    Recorded.push_back(aRecord.SolveTime);
+    Replayed.push_back(ReplayTime);
+    Indexes.push_back(i);
+    if (Fail != aRecord.Fail)
+      NbDifferentFails++;
+    else if ((Fail == 0) && (X.size() == aRecord.X.size()))
+      MaxDifference =
+          max(MaxDifference, (X - aRecord.X).lpNorm<Eigen::Infinity>());
+  }
+
+  printf("\n%-10s %10s %10s %10s %10s %10s %10s\n", "time (us)", "min",
+         "median", "p90", "p99", "max", "mean");
+  PrintDistribution("recorded", Recorded);
+  PrintDistribution(Backend.c_str(), Replayed);
+  printf("\n%u different failures, largest difference of the solutions "
+         "%.3e\n",
+         NbDifferentFails, MaxDifference);
+
+  // The overruns are the problems to look at.
+  sort(Slowest.begin(), Slowest.end(), SlowerRecord);
+  printf("\n%10s %10s %6s %6s %12s %12s %5s\n", "sequence", "time", "n", "m",
+         "recorded", "replayed", "fail");
+  for (unsigned int k = 0; (k < Slowest.size()) && (k < 10); k++) {
+    unsigned int j = Slowest[k].second;
+    if (!aRecorder.read(Indexes[j], aRecord))
+      continue;
+    printf("%10llu %10.3f %6u %6u %12.1f %12.1f %5d\n", aRecord.Sequence,
+           aRecord.Time, aRecord.NbVariables, aRecord.NbConstraints,
+           1e6 * aRecord.SolveTime, 1e6 * Replayed[j], aRecord.Fail);
+  }
+  return 0;
+}
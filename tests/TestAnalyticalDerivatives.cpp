@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestAnalyticalDerivatives.cpp
+  \brief Compare the velocities and accelerations of the legs given by
+  the analytical jacobian, and of the arms moved by the upper body
+  heuristic, with central differences of the postures. */
+
+#include <math.h>
+
+#include <iostream>
+#include <vector>
+
+#include "CommonTools.hh"
+#include "TestObject.hh"
+
+using namespace ::PatternGeneratorJRL;
+using namespace ::PatternGeneratorJRL::TestSuite;
+using namespace std;
+
+class TestAnalyticalDerivatives : public TestObject {
+public:
+  TestAnalyticalDerivatives(int argc, char *argv[], string &aString)
+      : TestObject(argc, argv, aString) {}
+
+  /*! The CoM sways and turns while the left foot swings. */
+  void Motion(double t) {
+    for (unsigned int i = 0; i < 3; i++)
+      m_CoMPosition(i) = m_StartingCOMPosition(i);
+    m_CoMSpeed.setZero();
+    m_CoMAcc.setZero();
+    double w = 2.0 * M_PI;
+    m_CoMPosition(1) += 0.03 * sin(w * t);
+    m_CoMSpeed(1) = 0.03 * w * cos(w * t);
+    m_CoMAcc(1) = -0.03 * w * w * sin(w * t);
+    // The angular velocity is in rad/s, the orientation in degrees.
+    m_CoMPosition(5) = 5.0 * sin(M_PI * t);
+    m_CoMSpeed(5) = 5.0 * M_PI / 180.0 * M_PI * cos(M_PI * t);
+    m_CoMAcc(5) = -5.0 * M_PI / 180.0 * M_PI * M_PI * sin(M_PI * t);
+
+    m_LeftFoot.setZero();
+    m_LeftFoot(0) = m_InitLeftFoot.x + 0.05 * sin(M_PI * t);
+    m_LeftFoot(5) = 0.05 * M_PI * cos(M_PI * t);
+    m_LeftFoot(10) = -0.05 * M_PI * M_PI * sin(M_PI * t);
+    m_LeftFoot(1) = m_InitLeftFoot.y;
+    m_LeftFoot(2) = m_InitLeftFoot.z + 0.02 * (1.0 - cos(w * t));
+    m_LeftFoot(7) = 0.02 * w * sin(w * t);
+    m_LeftFoot(12) = 0.02 * w * w * cos(w * t);
+    m_LeftFoot(3) = m_InitLeftFoot.theta + 10.0 * sin(M_PI * t);
+    m_LeftFoot(8) = 10.0 * M_PI * cos(M_PI * t);
+    m_LeftFoot(13) = -10.0 * M_PI * M_PI * sin(M_PI * t);
+    m_LeftFoot(4) = 5.0 * sin(w * t);
+    m_LeftFoot(9) = 5.0 * w * cos(w * t);
+    m_LeftFoot(14) = -5.0 * w * w * sin(w * t);
+
+    m_RightFoot.setZero();
+    m_RightFoot(0) = m_InitRightFoot.x;
+    m_RightFoot(1) = m_InitRightFoot.y;
+    m_RightFoot(2) = m_InitRightFoot.z;
+    m_RightFoot(3) = m_InitRightFoot.theta;
+  }
+
+  void Realize(double t, Eigen::VectorXd &q, Eigen::VectorXd &dq,
+               Eigen::VectorXd &ddq) {
+    Motion(t);
+    m_ComAndFootRealization->ComputePostureForGivenCoMAndFeetPosture(
+        m_CoMPosition, m_CoMSpeed, m_CoMAcc, m_LeftFoot, m_RightFoot, q, dq,
+        ddq, 10, 0);
+  }
+
+  bool doTest(ostream &os) {
+    Eigen::Matrix<double, 6, 1> lStartingWaistPose;
+    m_ComAndFootRealization->InitializationCoM(
+        m_HalfSitting, m_StartingCOMPosition, lStartingWaistPose,
+        m_InitLeftFoot, m_InitRightFoot);
+    m_ComAndFootRealization->AnalyticalDerivatives(true);
+    m_CoMPosition.setZero(6);
+    m_CoMSpeed.setZero(6);
+    m_CoMAcc.setZero(6);
+    m_LeftFoot.setZero(15);
+    m_RightFoot.setZero(15);
+
+    vector<int> lJoints, lLimb;
+    m_ComAndFootRealization->leftLegIndexinVelocity(lJoints);
+    m_ComAndFootRealization->rightLegIndexinVelocity(lLimb);
+    lJoints.insert(lJoints.end(), lLimb.begin(), lLimb.end());
+    m_ComAndFootRealization->leftArmIndexinVelocity(lLimb);
+    lJoints.insert(lJoints.end(), lLimb.begin(), lLimb.end());
+    m_ComAndFootRealization->rightArmIndexinVelocity(lLimb);
+    lJoints.insert(lJoints.end(), lLimb.begin(), lLimb.end());
+
+    Eigen::VectorXd q = m_CurrentConfiguration, dq = m_CurrentVelocity,
+                    ddq = m_CurrentAcceleration;
+    Eigen::VectorXd qp = q, qm = q, dqd = dq, ddqd = ddq, dq2 = dq,
+                    ddq2 = ddq;
+    const double h = 1e-4;
+    double MaxVelocityError = 0.0, MaxAccelerationError = 0.0;
+    for (unsigned int k = 0; k < 100; k++) {
+      double t = 0.01 * k;
+      Realize(t, q, dq, ddq);
+      Realize(t + h, qp, dqd, ddqd);
+      Realize(t - h, qm, dqd, ddqd);
+      // The postures do not depend on the previous ones.
+      Realize(t, q, dq2, ddq2);
+      if ((dq2 != dq) || (ddq2 != ddq)) {
+        os << "The derivatives depend on the previous postures." << endl;
+        return false;
+      }
+      for (unsigned int i = 0; i < lJoints.size(); i++) {
+        int j = lJoints[i];
+        double dqc = (qp(j) - qm(j)) / (2.0 * h);
+        double ddqc = (qp(j) - 2.0 * q(j) + qm(j)) / (h * h);
+        MaxVelocityError = max(MaxVelocityError, fabs(dq(j) - dqc));
+        MaxAccelerationError = max(MaxAccelerationError, fabs(ddq(j) - ddqc));
+      }
+    }
+    os << "largest errors: velocity " << MaxVelocityError << ", acceleration "
+       << MaxAccelerationError << endl;
+    return (MaxVelocityError < 1e-5) && (MaxAccelerationError < 1e-3);
+  }
+
+protected:
+  void chooseTestProfile() {}
+  void generateEvent() {}
+
+  Eigen::Vector3d m_StartingCOMPosition;
+  FootAbsolutePosition m_InitLeftFoot, m_InitRightFoot;
+  Eigen::VectorXd m_CoMPosition, m_CoMSpeed, m_CoMAcc;
+  Eigen::VectorXd m_LeftFoot, m_RightFoot;
+};
+
+int main(int argc, char *argv[]) {
+  string TestName("TestAnalyticalDerivatives");
+  try {
+    TestAnalyticalDerivatives aTest(argc, argv, TestName);
+    if (!aTest.init())
+      return 1;
+    if (!aTest.doTest(std::cout)) {
+      cerr << "The analytical derivatives differ from the postures." << endl;
+      return 1;
+    }
+  } catch (const std::string &msg) {
+    std::cerr << msg << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -29,9 +29,91 @@
 #include <fstream>
 #include <iostream>
 #include <stdlib.h>
+#include <sys/time.h>
 
 using namespace std;
 
+/*! Gives access to the evaluation through the full
+  table of basis functions, used as a reference. */
+class ReferenceBSplinesFoot : public PatternGeneratorJRL::BSplinesFoot {
+public:
+  ReferenceBSplinesFoot(double FT, double IP, double FP, vector<double> ToMP,
+                        vector<double> MP, double IS, double IA, double FS,
+                        double FA)
+      : BSplinesFoot(FT, IP, FP, ToMP, MP, IS, IA, FS, FA) {}
+
+  void ReferenceCompute(double t, double &x, double &dx, double &ddx) {
+    double time = t / FT();
+    if (time <= 0.0)
+      time = 0.0;
+    if (time >= 1.0)
+      time = 1.0;
+    ComputeBasisFunctions(time);
+    x = 0.0;
+    dx = 0.0;
+    ddx = 0.0;
+    for (unsigned int i = 0; i < m_control_points.size(); i++) {
+      x += m_basis_functions[m_degree][i] * m_control_points[i];
+      dx += m_basis_functions_derivative[i] * m_control_points[i];
+      ddx += m_basis_functions_sec_derivative[i] * m_control_points[i];
+    }
+  }
+};
+
+double ElapsedTime(struct timeval &begin, struct timeval &end) {
+  return (double)(end.tv_sec - begin.tv_sec) +
+         1e-6 * (double)(end.tv_usec - begin.tv_usec);
+}
+
+/*! Compare the de Boor evaluator with the reference evaluation over
+  a swing-foot trajectory sampled at 5 ms, and report their timings. */
+bool CompareWithReference(ReferenceBSplinesFoot &aBSpline,
+                          const string &aName) {
+  const double SamplingPeriod = 0.005;
+  unsigned int NbOfSamples =
+      (unsigned int)(aBSpline.FT() / SamplingPeriod) + 1;
+  vector<double> x, dx, ddx;
+  aBSpline.Compute(0.0, SamplingPeriod, NbOfSamples, x, dx, ddx);
+
+  double maxerror = 0.0;
+  double rx, rdx, rddx, lx, ldx, lddx;
+  for (unsigned int k = 0; k < NbOfSamples; k++) {
+    double t = k * SamplingPeriod;
+    aBSpline.ReferenceCompute(t, rx, rdx, rddx);
+    aBSpline.Compute(t, lx, ldx, lddx);
+    double errors[6] = {fabs(rx - lx),    fabs(rdx - ldx),  fabs(rddx - lddx),
+                        fabs(rx - x[k]), fabs(rdx - dx[k]), fabs(rddx - ddx[k])};
+    for (unsigned int i = 0; i < 6; i++)
+      maxerror = errors[i] > maxerror ? errors[i] : maxerror;
+  }
+
+  const unsigned int NbOfRuns = 1000;
+  struct timeval begin, end;
+  gettimeofday(&begin, 0);
+  for (unsigned int r = 0; r < NbOfRuns; r++)
+    for (unsigned int k = 0; k < NbOfSamples; k++)
+      aBSpline.ReferenceCompute(k * SamplingPeriod, rx, rdx, rddx);
+  gettimeofday(&end, 0);
+  double referencetime = ElapsedTime(begin, end);
+
+  gettimeofday(&begin, 0);
+  for (unsigned int r = 0; r < NbOfRuns; r++)
+    aBSpline.Compute(0.0, SamplingPeriod, NbOfSamples, x, dx, ddx);
+  gettimeofday(&end, 0);
+  double batchtime = ElapsedTime(begin, end);
+
+  double nbevals = (double)NbOfRuns * NbOfSamples;
+  cout << aName << ": max error " << maxerror << " reference "
+       << 1e9 * referencetime / nbevals << " ns/sample de Boor (batch) "
+       << 1e9 * batchtime / nbevals << " ns/sample" << endl;
+
+  bool ok = maxerror < 1e-8;
+  if (!ok)
+    std::cerr << "Error: de Boor evaluation of " << aName
+              << " differs from the reference" << std::endl;
+  return ok;
+}
+
 int PerformTests(int, char *[]) {
   // Test Bspline without way point
   /////////////////////////////////
@@ -74,6 +156,10 @@ int PerformTests(int, char *[]) {
   delete bsplineNoWayPoint;
   bsplineNoWayPoint = NULL;
 
+  ReferenceBSplinesFoot refNoWayPoint(0.8, IP, FP, ToMP, MP, IS, IA, FS, FA);
+  bool testDeBoorNoWayPoint =
+      CompareWithReference(refNoWayPoint, "no way point");
+
   // Test Bspline with one way point
   //////////////////////////////////
   MP.clear();
@@ -111,6 +197,10 @@ int PerformTests(int, char *[]) {
   delete bsplineOneWayPoint;
   bsplineOneWayPoint = NULL;
 
+  ReferenceBSplinesFoot refOneWayPoint(FT, IP, FP, ToMP, MP, IS, IA, FS, FA);
+  bool testDeBoorOneWayPoint =
+      CompareWithReference(refOneWayPoint, "one way point");
+
   // Test Bspline with two way point
   //////////////////////////////////
   FT = 1.0;
@@ -152,6 +242,10 @@ int PerformTests(int, char *[]) {
   delete bsplineTwoWayPoint;
   bsplineTwoWayPoint = NULL;
 
+  ReferenceBSplinesFoot refTwoWayPoint(FT, IP, FP, ToMP, MP, IS, IA, FS, FA);
+  bool testDeBoorTwoWayPoint =
+      CompareWithReference(refTwoWayPoint, "two way points");
+
   // Test Bspline with knots and control points
   ///////////////////////////////////////////
   /// \brief bsplineKnotsControl
@@ -240,9 +334,10 @@ int PerformTests(int, char *[]) {
   bsplineKnotsControl = NULL;
 
   return (testBsplinenowayPoint && testBsplineOneWayPoint &&
-          testBsplineTwoWayPoint)
-             ? 1
-             : 0;
+          testBsplineTwoWayPoint && testDeBoorNoWayPoint &&
+          testDeBoorOneWayPoint && testDeBoorTwoWayPoint)
+             ? 0
+             : 1;
 }
 
 int main(int argc, char *argv[]) {
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestCollisionDetectorBatch.cpp
+  \brief Compare the batch collision checks between the legs and the
+  obstacle with the checks of a single segment. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+
+#include "portability/gettimeofday.hh"
+
+#include <MotionGeneration/StepOverPlanner.hh>
+
+#include "CommonTools.hh"
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+using namespace PatternGeneratorJRL::TestSuite;
+
+double Random(double Min, double Max) {
+  return Min + (Max - Min) * (double)rand() / (double)RAND_MAX;
+}
+
+/*! First segment in collision with the checks of a single segment. */
+int FirstSegment(CollisionDetector &aCD, const CollisionDetector::Points &a,
+                 const CollisionDetector::Points &b) {
+  for (int i = 0; i < (int)a.rows(); i++) {
+    Eigen::Vector3d p1 = a.row(i).transpose(), p2 = b.row(i).transpose();
+    if (aCD.CollisionLineObstacleComplete(p1, p2))
+      return i;
+  }
+  return -1;
+}
+
+/*! First sample of a swing in collision with the checks of a single
+  segment. */
+int FirstSample(CollisionDetector &aCD,
+                const Eigen::Matrix<double, Eigen::Dynamic, 6> &LegAngles,
+                const Eigen::Matrix<double, Eigen::Dynamic, 12> &Waist,
+                int WhichLeg, const Eigen::Matrix3Xd &LegStarts,
+                const Eigen::Matrix3Xd &LegEnds) {
+  for (int k = 0; k < (int)LegAngles.rows(); k++) {
+    Eigen::VectorXd q = LegAngles.row(k).transpose();
+    Eigen::Matrix3d WaistRot;
+    WaistRot << Waist.block<1, 3>(k, 0), Waist.block<1, 3>(k, 3),
+        Waist.block<1, 3>(k, 6);
+    Eigen::Vector3d WaistPos = Waist.block<1, 3>(k, 9).transpose();
+    for (int j = 0; j < (int)LegStarts.cols(); j++) {
+      Eigen::Vector3d Abs, p1, p2;
+      aCD.CalcCoordShankLowerLegPoint(LegStarts.col(j), Abs, q, WaistRot,
+                                      WaistPos, WhichLeg);
+      aCD.WorldFrameToObstacleFrame(Abs, p1);
+      aCD.CalcCoordShankLowerLegPoint(LegEnds.col(j), Abs, q, WaistRot,
+                                      WaistPos, WhichLeg);
+      aCD.WorldFrameToObstacleFrame(Abs, p2);
+      if (aCD.CollisionLineObstacleComplete(p1, p2))
+        return k;
+    }
+  }
+  return -1;
+}
+
+int main(int, char *[]) {
+  ObstaclePar anObstacle;
+  anObstacle.x = 0.3;
+  anObstacle.y = 0.05;
+  anObstacle.z = 0.0;
+  anObstacle.theta = 10.0;
+  anObstacle.h = 0.05;
+  anObstacle.w = 1.0;
+  anObstacle.d = 0.05;
+  CollisionDetector aCD;
+  aCD.SetObstacleCoordinates(anObstacle);
+  srand(0);
+
+  // Segments around the obstacle, expressed in the obstacle frame.
+  const int NbSegments = 1000;
+  CollisionDetector::Points Starts(NbSegments, 3), Ends(NbSegments, 3);
+  for (int i = 0; i < NbSegments; i++) {
+    Starts.row(i) << Random(-0.1, 0.15), Random(-0.6, 0.6), Random(0.0, 0.1);
+    Ends.row(i) = Starts.row(i);
+    Ends.row(i) += Eigen::RowVector3d(Random(-0.05, 0.05),
+                                      Random(-0.05, 0.05),
+                                      Random(-0.05, 0.05));
+  }
+  int NbCollisions = 0;
+  for (int n = 1; n <= NbSegments; n++) {
+    int Expected = FirstSegment(aCD, Starts.topRows(n), Ends.topRows(n));
+    int Batch = aCD.CollisionSegmentsObstacle(Starts.topRows(n),
+                                              Ends.topRows(n));
+    if (Batch != Expected) {
+      cerr << n << " segments: " << Batch << " instead of " << Expected
+           << endl;
+      return 1;
+    }
+  }
+  // Every segment is checked when there is no collision: the segments
+  // in collision are moved in front of the obstacle.
+  for (int i = 0; i < NbSegments; i++) {
+    CollisionDetector::Points a = Starts.row(i), b = Ends.row(i);
+    if (FirstSegment(aCD, a, b) == 0) {
+      NbCollisions++;
+      Starts.row(i) << -0.2, 0.0, 0.0;
+      Ends.row(i) << -0.2, 0.0, 0.1;
+    }
+  }
+  if ((NbCollisions == 0) || (NbCollisions == NbSegments) ||
+      (aCD.CollisionSegmentsObstacle(Starts, Ends) != -1)) {
+    cerr << "Wrong check of the segments without collision." << endl;
+    return 1;
+  }
+
+  // Swings of the leg above the obstacle: the shin goes over it.
+  const int NbSamples = 300;
+  Eigen::Matrix3Xd LegStarts(3, 5), LegEnds(3, 5);
+  LegStarts << 0.059, 0.102, 0.118, -0.0772, -0.0163, 0.0, 0.0, 0.0, 0.0,
+      0.0, 0.102, 0.059, 0.0, -0.2492, -0.0939;
+  LegEnds << 0.102, 0.118, 0.0772, -0.0163, -0.0322, 0.0, 0.0, 0.0, 0.0,
+      0.0, 0.059, 0.0, -0.2253, -0.0939, -0.0183;
+  Eigen::Matrix<double, Eigen::Dynamic, 6> LegAngles(NbSamples, 6);
+  Eigen::Matrix<double, Eigen::Dynamic, 12> Waist(NbSamples, 12);
+  const unsigned int NbRepeats = 20;
+  double BatchTime = 0.0, SingleTime = 0.0;
+  int NbSwingCollisions = 0;
+  for (int Swing = 0; Swing < 20; Swing++) {
+    double Lift = Random(0.0, 0.5);
+    for (int k = 0; k < NbSamples; k++) {
+      double s = (double)k / (double)(NbSamples - 1);
+      double Yaw = Random(-0.1, 0.1);
+      Waist.row(k) << cos(Yaw), -sin(Yaw), 0.0, sin(Yaw), cos(Yaw), 0.0, 0.0,
+          0.0, 1.0, 0.1 + 0.4 * s, 0.05, 0.6;
+      LegAngles.row(k) << Yaw, 0.0, -Lift * sin(M_PI * s) - 0.2,
+          2.0 * Lift * sin(M_PI * s) + 0.4, 0.0, 0.0;
+    }
+    int WhichLeg = (Swing % 2 == 0) ? 1 : -1;
+
+    struct timeval begin, end;
+    int Expected = 0, Batch = 0;
+    gettimeofday(&begin, 0);
+    for (unsigned int r = 0; r < NbRepeats; r++)
+      Expected =
+          FirstSample(aCD, LegAngles, Waist, WhichLeg, LegStarts, LegEnds);
+    gettimeofday(&end, 0);
+    SingleTime += Time(begin, end);
+
+    gettimeofday(&begin, 0);
+    for (unsigned int r = 0; r < NbRepeats; r++)
+      Batch = aCD.CollisionLegSwingObstacle(LegAngles, Waist, WhichLeg,
+                                            LegStarts, LegEnds);
+    gettimeofday(&end, 0);
+    BatchTime += Time(begin, end);
+
+    if (Batch != Expected) {
+      cerr << "Swing " << Swing << ": sample " << Batch << " instead of "
+           << Expected << endl;
+      return 1;
+    }
+    if (Expected >= 0)
+      NbSwingCollisions++;
+  }
+
+  printf("%d segments in collision out of %d, %d swings out of 20\n",
+         NbCollisions, NbSegments, NbSwingCollisions);
+  printf("time per swing (us): batch %.3f, single %.3f\n",
+         1e6 * BatchTime / (20 * NbRepeats),
+         1e6 * SingleTime / (20 * NbRepeats));
+  return 0;
+}
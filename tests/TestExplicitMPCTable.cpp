@@ -0,0 +1,220 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestExplicitMPCTable.cpp
+  \brief Check the laws of the explicit MPC against the QLD solver,
+  for several constraint patterns and after a change of the model. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+#include <Mathematics/ExplicitMPCTable.hh>
+#include <Mathematics/qld.hh>
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+
+double Random() { return (double)rand() / (double)RAND_MAX - 0.5; }
+
+/*! Solve min 1/2 V'V + D'V s.t. G V + h >= 0 with QLD. */
+int SolveWithQLD(vector<double> &G, vector<double> &h, int m, int n,
+                 vector<double> &D, vector<double> &V) {
+  int me = 0, mmax = m + 1, nmax = n, mnn = m + n + n;
+  int iout = 0, ifail = 0, iprint = 0;
+  int lwar = 3 * nmax * nmax / 2 + 10 * nmax + 2 * mmax + 20000;
+  int liwar = n;
+  double Eps = 1e-12;
+  vector<double> Q(n * n, 0.0), XL(n, -1e8), XU(n, 1e8), U(mnn);
+  vector<double> war(lwar);
+  vector<int> iwar(liwar);
+  for (int i = 0; i < n; i++)
+    Q[i * n + i] = 1.0;
+  iwar[0] = 1;
+  ql0001_(&m, &me, &mmax, &n, &nmax, &mnn, &Q[0], &D[0], &G[0], &h[0], &XL[0],
+          &XU[0], &V[0], &U[0], &iout, &ifail, &iprint, &war[0], &lwar,
+          &iwar[0], &liwar, &Eps);
+  return ifail;
+}
+
+/*! A constraint pattern built as in the fast formulation: the
+  constraints A are applied on the model P, G = A P, stored by columns
+  with a leading dimension m+1, and the key covers P then A. */
+struct Pattern {
+  vector<double> A, G;
+  unsigned long long Key;
+
+  void Build(const vector<double> &P, int m, int n) {
+    G.assign((m + 1) * n, 0.0);
+    for (int i = 0; i < m; i++)
+      for (int k = 0; k < n; k++)
+        for (int l = 0; l < n; l++)
+          G[i + k * (m + 1)] += A[i * n + l] * P[l * n + k];
+    Key = 0;
+    ExplicitMPCTable::HashPattern(Key, &P[0], (unsigned int)P.size());
+    ExplicitMPCTable::HashPattern(Key, &A[0], (unsigned int)A.size());
+  }
+};
+
+void RandomParameters(vector<double> &h, vector<double> &D) {
+  for (unsigned int i = 0; i < h.size(); i++)
+    h[i] = 0.2 + 0.1 * Random();
+  for (unsigned int k = 0; k < D.size(); k++)
+    D[k] = 2.0 * Random();
+}
+
+bool SameSolution(const vector<double> &V, const vector<double> &VTable) {
+  for (unsigned int k = 0; k < V.size(); k++)
+    if (fabs(V[k] - VTable[k]) > 1e-6)
+      return false;
+  return true;
+}
+
+int main(int, char *[]) {
+  int m = 12, n = 4;
+  const unsigned int NbOfPatterns = 3;
+  unsigned int NbOfTrainingSamples = 2000, NbOfTestSamples = 500;
+  srand(0);
+
+  // The model, close to the identity, and the patterns built on it.
+  vector<double> P(n * n);
+  for (int l = 0; l < n; l++)
+    for (int k = 0; k < n; k++)
+      P[l * n + k] = (l == k ? 1.0 : 0.0) + 0.2 * Random();
+  vector<Pattern> Patterns(NbOfPatterns);
+  for (unsigned int p = 0; p < NbOfPatterns; p++) {
+    Patterns[p].A.resize(m * n);
+    for (int i = 0; i < m * n; i++)
+      Patterns[p].A[i] = Random();
+    Patterns[p].Build(P, m, n);
+    for (unsigned int q = 0; q < p; q++)
+      if (Patterns[q].Key == Patterns[p].Key) {
+        cerr << "Two patterns have the same key." << endl;
+        return 1;
+      }
+  }
+
+  vector<double> h(m), D(n), V(n), VTable(n);
+  ExplicitMPCTable aTable;
+  aTable.SetMaxNbOfCandidates(1000);
+
+  // Offline: learn the regions visited by the solutions of the QP.
+  for (unsigned int s = 0; s < NbOfTrainingSamples; s++) {
+    Pattern &aPattern = Patterns[s % NbOfPatterns];
+    RandomParameters(h, D);
+    if (SolveWithQLD(aPattern.G, h, m, n, D, V) != 0)
+      continue;
+    aTable.Learn(aPattern.Key, &aPattern.G[0], &h[0], m, n, &D[0], &V[0]);
+  }
+  cout << aTable.NbOfRegions() << " regions learned in "
+       << aTable.NbOfPatterns() << " patterns." << endl;
+  if ((aTable.NbOfPatterns() != NbOfPatterns) ||
+      (aTable.NbOfRegions() < 2 * NbOfPatterns)) {
+    cerr << "Not enough regions." << endl;
+    return 1;
+  }
+
+  string aFileName("TestExplicitMPCTable.bin");
+  if (!aTable.Save(aFileName)) {
+    cerr << "Unable to save the table." << endl;
+    return 1;
+  }
+  ExplicitMPCTable aLoadedTable;
+  aLoadedTable.SetMaxNbOfCandidates(1000);
+  if ((!aLoadedTable.Load(aFileName)) ||
+      (aLoadedTable.NbOfRegions() != aTable.NbOfRegions())) {
+    cerr << "Unable to load the table." << endl;
+    return 1;
+  }
+  remove(aFileName.c_str());
+
+  // Online: the laws found in the table are the solutions of the QP.
+  for (unsigned int p = 0; p < NbOfPatterns; p++) {
+    Pattern &aPattern = Patterns[p];
+    unsigned int NbOfHits = aLoadedTable.NbOfHits();
+    for (unsigned int s = 0; s < NbOfTestSamples; s++) {
+      RandomParameters(h, D);
+      if (SolveWithQLD(aPattern.G, h, m, n, D, V) != 0)
+        continue;
+      if (!aLoadedTable.Solve(aPattern.Key, &aPattern.G[0], &h[0], m, n,
+                              &D[0], &VTable[0]))
+        continue;
+      if (!SameSolution(V, VTable)) {
+        cerr << "Pattern " << p << ", sample " << s
+             << ": the explicit law differs from QLD." << endl;
+        return 1;
+      }
+    }
+    NbOfHits = aLoadedTable.NbOfHits() - NbOfHits;
+    cout << "Pattern " << p << ": " << NbOfHits << " hits." << endl;
+    if (NbOfHits < NbOfTestSamples / 2) {
+      cerr << "The table should cover most of the samples." << endl;
+      return 1;
+    }
+  }
+
+  // A change of the model, as of the height of the CoM, changes the key
+  // of the patterns: the table is not used.
+  vector<double> PChanged(P);
+  for (int l = 0; l < n; l++)
+    PChanged[l * n + l] *= 1.1;
+  Pattern aChanged = Patterns[0];
+  aChanged.Build(PChanged, m, n);
+  unsigned int NbOfHits = aLoadedTable.NbOfHits();
+  unsigned int NbOfStaleMisses = 0;
+  for (unsigned int s = 0; s < NbOfTestSamples; s++) {
+    RandomParameters(h, D);
+    if (SolveWithQLD(aChanged.G, h, m, n, D, V) != 0)
+      continue;
+    if (aLoadedTable.Solve(aChanged.Key, &aChanged.G[0], &h[0], m, n, &D[0],
+                           &VTable[0])) {
+      cerr << "Sample " << s << ": a pattern of the former model is used."
+           << endl;
+      return 1;
+    }
+    // Even with the former key, the regions learned for the former
+    // matrix are rejected, but for the solutions without active
+    // constraint, which do not depend on G.
+    if (!aLoadedTable.Solve(Patterns[0].Key, &aChanged.G[0], &h[0], m, n,
+                            &D[0], &VTable[0]))
+      NbOfStaleMisses++;
+    else if (!SameSolution(V, VTable)) {
+      cerr << "Sample " << s << ": a law of the former model is used."
+           << endl;
+      return 1;
+    }
+  }
+  cout << "Changed model: " << aLoadedTable.NbOfHits() - NbOfHits
+       << " hits, " << NbOfStaleMisses << " misses with the former key."
+       << endl;
+  if (NbOfStaleMisses == 0) {
+    cerr << "The regions of the former model should be rejected." << endl;
+    return 1;
+  }
+
+  // Another pattern is not found.
+  if (aLoadedTable.Solve(Patterns[0].Key + 1, &Patterns[0].G[0], &h[0], m, n,
+                         &D[0], &VTable[0])) {
+    cerr << "Wrong pattern matched." << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestFastSetup.cpp
+  \brief Check that the setup of the two stages of preview control
+  computed in batch, and restored from the setup cache, gives the motion
+  of the sequential setup. */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <deque>
+#include <iostream>
+#include <vector>
+
+#include "portability/gettimeofday.hh"
+
+#include <PreviewControl/ZMPPreviewControlWithMultiBodyZMP.hh>
+
+#include "CommonTools.hh"
+#include "TestObject.hh"
+
+using namespace ::PatternGeneratorJRL;
+using namespace ::PatternGeneratorJRL::TestSuite;
+using namespace std;
+
+/*! Outputs of the control loop after a setup. */
+struct Motion {
+  vector<Eigen::VectorXd> Configurations;
+  vector<COMState> COMStates;
+  double SetupTime;
+};
+
+/*! Largest difference between two motions. */
+double Difference(const Motion &a, const Motion &b) {
+  double MaxDifference = 0.0;
+  for (unsigned int k = 0; k < a.Configurations.size(); k++) {
+    MaxDifference = max(MaxDifference, (a.Configurations[k] -
+                                        b.Configurations[k])
+                                           .lpNorm<Eigen::Infinity>());
+    for (unsigned int i = 0; i < 3; i++) {
+      MaxDifference =
+          max(MaxDifference, fabs(a.COMStates[k].x[i] - b.COMStates[k].x[i]));
+      MaxDifference =
+          max(MaxDifference, fabs(a.COMStates[k].y[i] - b.COMStates[k].y[i]));
+    }
+  }
+  return MaxDifference;
+}
+
+class TestFastSetup : public TestObject {
+public:
+  TestFastSetup(int argc, char *argv[], string &aString)
+      : TestObject(argc, argv, aString), m_NL(320) {}
+
+  bool doTest(ostream &os) {
+    ZMPPreviewControlWithMultiBodyZMP aZMPPC(m_SPM);
+    callMethod(":samplingperiod 0.005");
+    callMethod(":previewcontroltime 1.6");
+    callMethod(":comheight 0.814");
+    aZMPPC.setPinocchioRobot(m_PR);
+    aZMPPC.setComAndFootRealization(m_ComAndFootRealization);
+
+    // The robot stands on its feet, the ZMP sways between them.
+    const unsigned int NbSteps = 400;
+    Eigen::Vector3d StartingCOM;
+    Eigen::Matrix<double, 6, 1> StartingWaist;
+    FootAbsolutePosition InitLeftFoot, InitRightFoot;
+    aZMPPC.EvaluateStartingCoM(m_HalfSitting, StartingCOM, StartingWaist,
+                               InitLeftFoot, InitRightFoot);
+    for (unsigned int k = 0; k < 2 * m_NL + NbSteps + 1; k++) {
+      double t = 0.005 * (double)k;
+      ZMPPosition aZMP;
+      memset(&aZMP, 0, sizeof(aZMP));
+      aZMP.px = 0.5 * (InitLeftFoot.x + InitRightFoot.x);
+      aZMP.py = 0.5 * (InitLeftFoot.y + InitRightFoot.y) +
+                0.05 * sin(2.0 * M_PI * t);
+      aZMP.time = t;
+      aZMP.stepType = 11;
+      m_ZMPRefPositions.push_back(aZMP);
+
+      FootAbsolutePosition aLeftFoot = InitLeftFoot,
+                           aRightFoot = InitRightFoot;
+      aLeftFoot.time = aRightFoot.time = t;
+      aLeftFoot.stepType = aRightFoot.stepType = 11;
+      m_LeftFootPositions.push_back(aLeftFoot);
+      m_RightFootPositions.push_back(aRightFoot);
+
+      COMState aCOMState;
+      aCOMState.z[0] = StartingCOM(2);
+      m_COMStates.push_back(aCOMState);
+    }
+
+    Motion Sequential, Inline, Batch, Cached;
+    run(aZMPPC, NbSteps, Sequential);
+    // Without the worker thread of the pipelined stages, the batch is
+    // computed by the calling thread only.
+    callMethod(":batchsetup true");
+    run(aZMPPC, NbSteps, Inline);
+    callMethod(":pipelinedstages true");
+    if (!aZMPPC.GetPipelinedStages()) {
+      os << "The stages cannot be pipelined." << endl;
+      return false;
+    }
+    callMethod(":setupcache true");
+    run(aZMPPC, NbSteps, Batch);
+
+    // The times of the references are not compared by the cache.
+    for (unsigned int k = 0; k < m_ZMPRefPositions.size(); k++) {
+      m_ZMPRefPositions[k].time += 1.0;
+      m_LeftFootPositions[k].time += 1.0;
+      m_RightFootPositions[k].time += 1.0;
+    }
+    run(aZMPPC, NbSteps, Cached);
+
+    // A parameter of the realization is part of the inputs: the state
+    // kept above is not restored.
+    Motion Analytical, AnalyticalWithoutCache;
+    callMethod(":analyticalderivatives true");
+    run(aZMPPC, NbSteps, Analytical);
+    callMethod(":setupcache false");
+    run(aZMPPC, NbSteps, AnalyticalWithoutCache);
+    callMethod(":analyticalderivatives false");
+
+    double InlineDifference = Difference(Sequential, Inline);
+    double BatchDifference = Difference(Sequential, Batch);
+    double CachedDifference = Difference(Batch, Cached);
+    double AnalyticalDifference =
+        Difference(AnalyticalWithoutCache, Analytical);
+    os << "largest difference: inline batch " << InlineDifference
+       << ", threaded batch " << BatchDifference << ", cached "
+       << CachedDifference << ", analytical derivatives "
+       << AnalyticalDifference << " (" << Difference(Cached, Analytical)
+       << " from the kept state)" << endl;
+    printf("setup time (ms): sequential %.3f, inline batch %.3f, "
+           "threaded batch %.3f, cached %.3f\n",
+           1e3 * Sequential.SetupTime, 1e3 * Inline.SetupTime,
+           1e3 * Batch.SetupTime, 1e3 * Cached.SetupTime);
+    // The multibody ZMPs of the batch are computed in workspaces of the
+    // robot, with the same operations.
+    return (InlineDifference == 0.0) && (BatchDifference == 0.0) &&
+           (CachedDifference <= 1e-12) && (AnalyticalDifference <= 1e-12) &&
+           (Difference(Cached, Analytical) > 0.0);
+  }
+
+protected:
+  /*! Setup from the starting posture and run NbSteps steps. */
+  void run(ZMPPreviewControlWithMultiBodyZMP &aZMPPC, unsigned int NbSteps,
+           Motion &aMotion) {
+    Eigen::Vector3d StartingCOM;
+    Eigen::Matrix<double, 6, 1> StartingWaist;
+    FootAbsolutePosition InitLeftFoot, InitRightFoot;
+    aZMPPC.EvaluateStartingCoM(m_HalfSitting, StartingCOM, StartingWaist,
+                               InitLeftFoot, InitRightFoot);
+    Eigen::VectorXd v = m_PR->currentRPYVelocity();
+    v.setZero();
+    m_PR->currentRPYVelocity(v);
+    m_PR->currentRPYAcceleration(v);
+
+    deque<ZMPPosition> ZMPRefPositions(m_ZMPRefPositions);
+    deque<COMState> COMStates(m_COMStates);
+    deque<FootAbsolutePosition> LeftFootPositions(m_LeftFootPositions),
+        RightFootPositions(m_RightFootPositions);
+    struct timeval begin, end;
+    gettimeofday(&begin, 0);
+    aZMPPC.Setup(ZMPRefPositions, COMStates, LeftFootPositions,
+                 RightFootPositions);
+    gettimeofday(&end, 0);
+    aMotion.SetupTime = Time(begin, end);
+
+    Eigen::VectorXd q, dq, ddq;
+    for (unsigned int k = 0; k < NbSteps; k++) {
+      COMState aCOMState = COMStates[m_NL + k];
+      aZMPPC.UpdateTheZMPRefQueue(ZMPRefPositions[2 * m_NL + k]);
+      aZMPPC.OneGlobalStepOfControl(
+          LeftFootPositions[2 * m_NL + k], RightFootPositions[2 * m_NL + k],
+          ZMPRefPositions[2 * m_NL + k], aCOMState, q, dq, ddq);
+      aMotion.Configurations.push_back(q);
+      aMotion.COMStates.push_back(aCOMState);
+    }
+  }
+
+  void callMethod(const char *aCmd) {
+    istringstream strm(aCmd);
+    string aMethod;
+    strm >> aMethod;
+    m_SPM->CallMethod(aMethod, strm);
+  }
+
+  void chooseTestProfile() {}
+  void generateEvent() {}
+
+  /*! Size of the preview window: 1.6 s at 5 ms. */
+  unsigned int m_NL;
+  deque<ZMPPosition> m_ZMPRefPositions;
+  deque<COMState> m_COMStates;
+  deque<FootAbsolutePosition> m_LeftFootPositions, m_RightFootPositions;
+};
+
+int main(int argc, char *argv[]) {
+  string TestName("TestFastSetup");
+  try {
+    TestFastSetup aTest(argc, argv, TestName);
+    if (!aTest.init())
+      return 1;
+    if (!aTest.doTest(std::cout)) {
+      cerr << "The fast setup does not give the motion of the setup."
+           << endl;
+      return 1;
+    }
+  } catch (const std::string &msg) {
+    std::cerr << msg << std::endl;
+    return 1;
+  }
+  return 0;
+}
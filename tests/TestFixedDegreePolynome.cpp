@@ -0,0 +1,124 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestFixedDegreePolynome.cpp
+  \brief Compare the polynomes whose degree is a template parameter
+  with the polynomes whose degree is given at run time. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+#include <Mathematics/PolynomeFoot.hh>
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+
+double Random(double Min, double Max) {
+  return Min + (Max - Min) * (double)rand() / (double)RAND_MAX;
+}
+
+/*! Largest relative difference over [-0.5, FT+0.5] between a foot
+  polynome and the run-time degree polynome with the same coefficients,
+  evaluated at the time saturated on [0,FT]. */
+template <int Degree>
+double Difference(const PolynomeFoot<Degree> &aFoot, double FT) {
+  vector<double> lCoefficients;
+  aFoot.GetCoefficients(lCoefficients);
+  Polynome aReference(Degree);
+  aReference.SetCoefficients(lCoefficients);
+
+  double r = 0.0;
+  for (double t = -0.5; t <= FT + 0.5; t += 0.01) {
+    double s = (t < 0.0) ? 0.0 : ((t > FT) ? FT : t);
+    double p, dp, ddp;
+    aFoot.ComputeAll(t, p, dp, ddp);
+    double Values[5][2] = {
+        {aFoot.Compute(t), aReference.Compute(s)},
+        {aFoot.ComputeDerivative(t), aReference.ComputeDerivative(s)},
+        {aFoot.ComputeSecDerivative(t), aReference.ComputeSecDerivative(s)},
+        {aFoot.ComputeJerk(t), aReference.ComputeJerk(s)},
+        {p + dp + ddp, aReference.Compute(s) + aReference.ComputeDerivative(s) +
+                           aReference.ComputeSecDerivative(s)}};
+    for (unsigned int i = 0; i < 5; i++)
+      r = fmax(r, fabs(Values[i][0] - Values[i][1]) /
+                      (1.0 + fabs(Values[i][1])));
+  }
+  return r;
+}
+
+/*! Random coefficients. */
+template <int Degree> double RandomDifference() {
+  const double FT = 1.3;
+  PolynomeFoot<Degree> aFoot(FT);
+  vector<double> lCoefficients(Degree + 1);
+  for (int i = 0; i <= Degree; i++)
+    lCoefficients[i] = Random(-2.0, 2.0);
+  aFoot.SetCoefficients(lCoefficients);
+  if (aFoot.Degree() != Degree)
+    return 1.0;
+  return Difference(aFoot, FT);
+}
+
+int main(int, char *[]) {
+  srand(0);
+  double Max = 0.0;
+  for (unsigned int r = 0; r < 10; r++) {
+    Max = fmax(Max, RandomDifference<1>());
+    Max = fmax(Max, RandomDifference<2>());
+    Max = fmax(Max, RandomDifference<3>());
+    Max = fmax(Max, RandomDifference<5>());
+    Max = fmax(Max, RandomDifference<8>());
+  }
+  if (Max > 1e-12) {
+    cerr << "Random coefficients: difference " << Max << endl;
+    return 1;
+  }
+
+  // The foot trajectories and their boundary conditions.
+  const double FT = 0.8;
+  Polynome3 aPolynome3(FT, 0.2);
+  Polynome4 aPolynome4(FT, 0.05);
+  Polynome5 aPolynome5(FT, 0.2);
+  Polynome6 aPolynome6(FT, 0.05);
+  Polynome7 aPolynome7(FT, 0.2);
+  double Differences[5] = {
+      Difference(aPolynome3, FT), Difference(aPolynome4, FT),
+      Difference(aPolynome5, FT), Difference(aPolynome6, FT),
+      Difference(aPolynome7, FT)};
+  for (unsigned int i = 0; i < 5; i++) {
+    if (Differences[i] > 1e-12) {
+      cerr << "Polynome" << i + 3 << ": difference " << Differences[i] << endl;
+      return 1;
+    }
+    Max = fmax(Max, Differences[i]);
+  }
+  if ((fabs(aPolynome3.Compute(FT) - 0.2) > 1e-12) ||
+      (fabs(aPolynome4.Compute(FT / 2.0) - 0.05) > 1e-12) ||
+      (fabs(aPolynome5.ComputeSecDerivative(FT)) > 1e-12) ||
+      (fabs(aPolynome6.Compute(FT / 2.0) - 0.05) > 1e-12) ||
+      (fabs(aPolynome7.Compute(FT) - 0.2) > 1e-12)) {
+    cerr << "Wrong boundary conditions." << endl;
+    return 1;
+  }
+  printf("largest difference: %g\n", Max);
+  return 0;
+}
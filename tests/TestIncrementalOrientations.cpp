@@ -0,0 +1,147 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestIncrementalOrientations.cpp
+  \brief Check that the reuse of the orientations preview does not
+  change the trajectories of the velocity referenced generator on a
+  walk which goes straight, turns, goes straight again and stops. */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+#include <vector>
+
+#include "CommonTools.hh"
+#include "TestObject.hh"
+
+#include <SimplePluginManager.hh>
+#include <ZMPRefTrajectoryGeneration/ZMPVelocityReferencedQP.hh>
+
+using namespace ::PatternGeneratorJRL;
+using namespace ::PatternGeneratorJRL::TestSuite;
+using namespace std;
+
+class TestIncrementalOrientations : public TestObject {
+public:
+  TestIncrementalOrientations(int argc, char *argv[], string &aString)
+      : TestObject(argc, argv, aString) {}
+
+  /*! Walk with or without the incremental preview and keep the
+    samples given to the robot, the previewed orientations and the
+    solutions of the generator.
+    \return The hit rate of the preview. */
+  double walk(bool Incremental, vector<double> &Values) {
+    SimplePluginManager SPM;
+    ZMPVelocityReferencedQP QP(&SPM, "", m_PR);
+    QP.SetTimeWindowPreviewControl(1.6);
+    QP.OrientationsPrw()->Incremental(Incremental);
+
+    deque<ZMPPosition> ZMPTraj;
+    deque<COMState> COMTraj;
+    deque<FootAbsolutePosition> LeftFootTraj, RightFootTraj;
+    COMState lStartingCOMState;
+    memset(&lStartingCOMState, 0, sizeof(COMState));
+    lStartingCOMState.z[0] = 0.814;
+    Eigen::Vector3d lStartingZMPPosition = Eigen::Vector3d::Zero();
+    FootAbsolutePosition InitLeftFootAbsPos, InitRightFootAbsPos;
+    memset(&InitLeftFootAbsPos, 0, sizeof(InitLeftFootAbsPos));
+    memset(&InitRightFootAbsPos, 0, sizeof(InitRightFootAbsPos));
+    InitLeftFootAbsPos.y = 0.095;
+    InitRightFootAbsPos.y = -0.095;
+    deque<RelativeFootPosition> RelativeFootPositions;
+    QP.SetCurrentTime(0.0);
+    QP.InitOnLine(ZMPTraj, COMTraj, LeftFootTraj, RightFootTraj,
+                  InitLeftFootAbsPos, InitRightFootAbsPos,
+                  RelativeFootPositions, lStartingCOMState,
+                  lStartingZMPPosition);
+
+    Values.clear();
+    for (unsigned int k = 0; k < 1600; k++) {
+      double time = 0.005 * k;
+      if (k == 0)
+        QP.Reference(0.2, 0.0, 0.0);
+      else if (k == 400)
+        QP.Reference(0.2, 0.0, 0.2);
+      else if (k == 800)
+        QP.Reference(0.2, 0.0, 0.0);
+      else if (k == 1200)
+        QP.Reference(0.0, 0.0, 0.0);
+
+      QP.OnLine(time, ZMPTraj, COMTraj, LeftFootTraj, RightFootTraj);
+      const COMState &aCOM = COMTraj.back();
+      const ZMPPosition &aZMP = ZMPTraj.back();
+      const FootAbsolutePosition &aLeft = LeftFootTraj.back(),
+                                 &aRight = RightFootTraj.back();
+      double Sample[] = {aCOM.x[0], aCOM.y[0], aCOM.yaw[0], aZMP.px,
+                         aZMP.py,   aLeft.x,   aLeft.y,     aLeft.theta,
+                         aRight.x,  aRight.y,  aRight.theta};
+      Values.insert(Values.end(), Sample,
+                    Sample + sizeof(Sample) / sizeof(double));
+      ZMPTraj.pop_front();
+      COMTraj.pop_front();
+      LeftFootTraj.pop_front();
+      RightFootTraj.pop_front();
+
+      const solution_t &aSolution = QP.Solution();
+      Values.insert(Values.end(), aSolution.SupportOrientations_deq.begin(),
+                    aSolution.SupportOrientations_deq.end());
+      Values.insert(Values.end(), aSolution.TrunkOrientations_deq.begin(),
+                    aSolution.TrunkOrientations_deq.end());
+      for (Eigen::Index i = 0; i < aSolution.Solution_vec.size(); i++)
+        Values.push_back(aSolution.Solution_vec(i));
+    }
+    return QP.OrientationsPrw()->HitRate();
+  }
+
+  bool compare() {
+    vector<double> Incremental, Full;
+    double HitRate = walk(true, Incremental);
+    walk(false, Full);
+    printf("%.1f %% of the previews reused\n", 100.0 * HitRate);
+    if (Incremental != Full) {
+      cerr << "The incremental preview changes the walk." << endl;
+      return false;
+    }
+    // The preview is reused on the straight parts only.
+    if ((HitRate <= 0.0) || (HitRate >= 1.0)) {
+      cerr << "The previews are " << ((HitRate <= 0.0) ? "never" : "always")
+           << " reused." << endl;
+      return false;
+    }
+    return true;
+  }
+
+protected:
+  void chooseTestProfile() {}
+  void generateEvent() {}
+};
+
+int main(int argc, char *argv[]) {
+  string aName("TestIncrementalOrientations");
+  try {
+    TestIncrementalOrientations aTest(argc, argv, aName);
+    if (!aTest.init() || !aTest.compare())
+      return 1;
+  } catch (const std::string &msg) {
+    std::cerr << msg << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestLIPMPropagator.cpp
+  \brief Compare the propagation of the linear inverted pendulum by the
+  precomputed transition matrices with its closed-form solution. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+
+#include <Mathematics/LIPMPropagator.hh>
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+
+double Random(double Min, double Max) {
+  return Min + (Max - Min) * (double)rand() / (double)RAND_MAX;
+}
+
+/*! Relative error between two states. */
+double Error(const Eigen::Vector3d &x, const Eigen::Vector3d &Expected) {
+  return (x - Expected).norm() / (1.0 + Expected.norm());
+}
+
+/*! Free pendulum around a ZMP at the origin:
+  \f$ c(t) = c_0 \cosh(\omega t) + \dot{c}_0 / \omega \sinh(\omega t) \f$.
+*/
+void Hyperbolic(double omega, double t, const Eigen::Vector3d &x0,
+                Eigen::Vector3d &x) {
+  double c = cosh(omega * t), s = sinh(omega * t);
+  x(0) = x0(0) * c + x0(1) * s / omega;
+  x(1) = x0(0) * omega * s + x0(1) * c;
+  x(2) = omega * omega * x(0);
+}
+
+/*! Triple integrator with a constant jerk u. */
+void Jerk(double t, const Eigen::Vector3d &x0, double u, Eigen::Vector3d &x) {
+  x(0) = x0(0) + x0(1) * t + x0(2) * t * t / 2.0 + u * t * t * t / 6.0;
+  x(1) = x0(1) + x0(2) * t + u * t * t / 2.0;
+  x(2) = x0(2) + u * t;
+}
+
+int main(int, char *[]) {
+  const double T = 0.005, omega = sqrt(9.81 / 0.814);
+  const unsigned int K = 400;
+  srand(0);
+
+  LIPMPropagator aPropagator;
+  if (aPropagator.NbOfMultiples() != 0) {
+    cerr << "The tables are not empty before the initialization." << endl;
+    return 1;
+  }
+
+  // The hyperbolic part of the analytical trajectories.
+  aPropagator.InitializeHyperbolic(omega, T, K);
+  if ((aPropagator.NbOfMultiples() != K) || (aPropagator.Period() != T)) {
+    cerr << "Wrong size of the hyperbolic tables." << endl;
+    return 1;
+  }
+  double MaxError = 0.0, MaxStepError = 0.0;
+  for (unsigned int r = 0; r < 20; r++) {
+    Eigen::Vector3d x0, xk, Expected, Step;
+    x0(0) = Random(-0.1, 0.1);
+    x0(1) = Random(-0.5, 0.5);
+    x0(2) = omega * omega * x0(0);
+    Step = x0;
+    for (unsigned int k = 0; k <= K; k++) {
+      Hyperbolic(omega, k * T, x0, Expected);
+      aPropagator.Propagate(k, x0, 0.0, xk);
+      MaxError = fmax(MaxError, Error(xk, Expected));
+      // Propagating over k periods or k times over one period
+      // is the same.
+      MaxStepError = fmax(MaxStepError, Error(Step, Expected));
+      aPropagator.Propagate(1, Eigen::Vector3d(Step), 0.0, Step);
+    }
+  }
+  if ((MaxError > 1e-12) || (MaxStepError > 1e-9)) {
+    cerr << "Hyperbolic propagation: error " << MaxError
+         << ", one period at a time " << MaxStepError << endl;
+    return 1;
+  }
+  printf("hyperbolic: error %g, one period at a time %g\n", MaxError,
+         MaxStepError);
+
+  // Without gravity the pendulum moves at constant speed.
+  aPropagator.InitializeHyperbolic(0.0, T, K);
+  {
+    Eigen::Vector3d x0(0.1, 0.3, 0.0), xk;
+    aPropagator.Propagate(K, x0, 0.0, xk);
+    Eigen::Vector3d Expected(0.1 + 0.3 * K * T, 0.3, 0.0);
+    if (Error(xk, Expected) > 1e-12) {
+      cerr << "Wrong propagation with omega = 0." << endl;
+      return 1;
+    }
+  }
+
+  // The linearized inverted pendulum, both axes at once.
+  aPropagator.InitializeJerkIntegrator(T, K);
+  MaxError = 0.0;
+  for (unsigned int r = 0; r < 20; r++) {
+    Eigen::Matrix<double, 3, 2> xy0, xyk;
+    Eigen::Matrix<double, 1, 2> u;
+    for (unsigned int i = 0; i < 3; i++)
+      for (unsigned int j = 0; j < 2; j++)
+        xy0(i, j) = Random(-0.5, 0.5);
+    u << Random(-2.0, 2.0), Random(-2.0, 2.0);
+    for (unsigned int k = 0; k <= K; k++) {
+      aPropagator.Propagate(k, xy0, u, xyk);
+      for (unsigned int j = 0; j < 2; j++) {
+        Eigen::Vector3d Expected, xk;
+        Jerk(k * T, xy0.col(j), u(j), Expected);
+        aPropagator.Propagate(k, xy0.col(j), u(j), xk);
+        MaxError = fmax(MaxError, Error(xyk.col(j), Expected));
+        MaxError = fmax(MaxError, Error(xk, Expected));
+      }
+    }
+  }
+  if (MaxError > 1e-12) {
+    cerr << "Jerk integrator: error " << MaxError << endl;
+    return 1;
+  }
+  printf("jerk integrator: error %g\n", MaxError);
+
+  // The tables follow a change of the dynamics.
+  aPropagator.InitializeHyperbolic(omega, T, K / 2);
+  {
+    Eigen::Vector3d x0(0.05, -0.2, omega * omega * 0.05), xk, Expected;
+    aPropagator.Propagate(K / 2, x0, 0.0, xk);
+    Hyperbolic(omega, K / 2 * T, x0, Expected);
+    if ((aPropagator.NbOfMultiples() != K / 2) ||
+        (Error(xk, Expected) > 1e-12)) {
+      cerr << "The tables have not been recomputed." << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestLegIKBatch.cpp
+  \brief Compare the batch leg inverse kinematics with the inverse
+  kinematics of a single pose, on a preview window of both legs. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+#include "portability/gettimeofday.hh"
+
+#include <jrl/walkgen/pinocchiorobot.hh>
+
+#include "CommonTools.hh"
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+using namespace PatternGeneratorJRL::TestSuite;
+
+double Random(double Min, double Max) {
+  return Min + (Max - Min) * (double)rand() / (double)RAND_MAX;
+}
+
+Eigen::Matrix4d Pose(const Eigen::Vector3d &Position, double Yaw,
+                     double Pitch) {
+  Eigen::Matrix4d M = Eigen::Matrix4d::Identity();
+  M.block<3, 3>(0, 0) = (Eigen::AngleAxisd(Yaw, Eigen::Vector3d::UnitZ()) *
+                         Eigen::AngleAxisd(Pitch, Eigen::Vector3d::UnitY()))
+                            .toRotationMatrix();
+  M.block<3, 1>(0, 3) = Position;
+  return M;
+}
+
+int main(int, char *[]) {
+  pinocchio::Model aModel;
+  pinocchio::urdf::buildModel(URDF_FULL_PATH, pinocchio::JointModelFreeFlyer(),
+                              aModel);
+  pinocchio::Data aData(aModel);
+  PinocchioRobot aPR;
+  if (!aPR.initializeRobotModelAndData(&aModel, &aData)) {
+    cerr << "The robot cannot be initialized." << endl;
+    return 1;
+  }
+
+  // A preview window of 1.6 s at 5 ms: the ankles move below the hips,
+  // 1 sample out of 10 is out of reach.
+  const unsigned int NbSamples = 322;
+  pinocchio::JointIndex Ankles[2] = {aPR.leftFoot()->associatedAnkle,
+                                     aPR.rightFoot()->associatedAnkle};
+  PRLegIKBatch Batches[2];
+  vector<Eigen::Matrix4d, Eigen::aligned_allocator<Eigen::Matrix4d> >
+      WaistPoses[2], AnklePoses[2];
+  srand(0);
+  for (unsigned int Leg = 0; Leg < 2; Leg++) {
+    // In the initial pose the legs are stretched.
+    const pinocchio::SE3 &oMw = aPR.DataInInitialePose()->oMi[aPR.waist()];
+    const pinocchio::SE3 &oMa = aPR.DataInInitialePose()->oMi[Ankles[Leg]];
+    Eigen::Vector3d Stretched =
+        oMw.rotation().transpose() * (oMa.translation() - oMw.translation());
+
+    Batches[Leg].resize(NbSamples);
+    for (unsigned int k = 0; k < NbSamples; k++) {
+      Eigen::Vector3d Waist(Random(-0.1, 0.1), Random(-0.1, 0.1), 1.0);
+      double WaistYaw = Random(-0.3, 0.3);
+      Eigen::Vector3d Ankle = Waist + Stretched;
+      Ankle(0) += Random(-0.15, 0.15);
+      Ankle(1) += Random(-0.05, 0.05);
+      Ankle(2) += (k % 10 == 9) ? -0.2 : Random(0.05, 0.15);
+      WaistPoses[Leg].push_back(Pose(Waist, WaistYaw, Random(-0.1, 0.1)));
+      AnklePoses[Leg].push_back(
+          Pose(Ankle, WaistYaw + Random(-0.2, 0.2), Random(-0.2, 0.2)));
+      Batches[Leg].setWaist(k, WaistPoses[Leg][k]);
+      Batches[Leg].setAnkle(k, AnklePoses[Leg][k]);
+    }
+  }
+
+  if (aPR.ComputeLegInverseKinematicsBatch(aPR.waist(), Batches[0])) {
+    cerr << "The waist has been taken as an ankle." << endl;
+    return 1;
+  }
+
+  const unsigned int NbRepeats = 100;
+  struct timeval begin, end;
+  double BatchTime = 0.0, SingleTime = 0.0;
+  for (unsigned int Leg = 0; Leg < 2; Leg++) {
+    gettimeofday(&begin, 0);
+    for (unsigned int r = 0; r < NbRepeats; r++) {
+      if (!aPR.ComputeLegInverseKinematicsBatch(Ankles[Leg], Batches[Leg])) {
+        cerr << "No analytical inverse kinematics for the legs." << endl;
+        return 1;
+      }
+    }
+    gettimeofday(&end, 0);
+    BatchTime += Time(begin, end);
+
+    Eigen::VectorXd q(6);
+    gettimeofday(&begin, 0);
+    for (unsigned int r = 0; r < NbRepeats; r++)
+      for (unsigned int k = 0; k < NbSamples; k++)
+        aPR.ComputeSpecializedInverseKinematics(
+            aPR.waist(), Ankles[Leg], WaistPoses[Leg][k], AnklePoses[Leg][k],
+            q);
+    gettimeofday(&end, 0);
+    SingleTime += Time(begin, end);
+
+    for (unsigned int k = 0; k < NbSamples; k++) {
+      aPR.ComputeSpecializedInverseKinematics(aPR.waist(), Ankles[Leg],
+                                              WaistPoses[Leg][k],
+                                              AnklePoses[Leg][k], q);
+      double Difference =
+          (Batches[Leg].q.row(k).transpose() - q).lpNorm<Eigen::Infinity>();
+      if (!(Difference <= 1e-12)) {
+        cerr << "Leg " << Leg << ", sample " << k << ": "
+             << Batches[Leg].q.row(k) << " instead of " << q.transpose()
+             << endl;
+        return 1;
+      }
+      if (Batches[Leg].reachable(k) != (k % 10 != 9)) {
+        cerr << "Leg " << Leg << ", sample " << k
+             << ": wrong reachability." << endl;
+        return 1;
+      }
+    }
+  }
+
+  printf("time per pose (us): batch %.3f, single %.3f\n",
+         1e6 * BatchTime / (2 * NbRepeats * NbSamples),
+         1e6 * SingleTime / (2 * NbRepeats * NbSamples));
+  return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestLegsForwardKinematics.cpp
+  \brief Compare the forward kinematics of the legs with the forward
+  kinematics of the whole robot, while the upper body is frozen and
+  when it moves, and check that it is faster during a walk. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+#include "portability/gettimeofday.hh"
+
+#include <jrl/walkgen/pinocchiorobot.hh>
+
+#include "CommonTools.hh"
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+using namespace PatternGeneratorJRL::TestSuite;
+
+/*! CoM and ankle placements of the last forward kinematics. */
+struct Result {
+  Eigen::Vector3d CoM;
+  pinocchio::SE3 LeftAnkle, RightAnkle;
+
+  Result(PinocchioRobot &aPR) {
+    aPR.positionCenterOfMass(CoM);
+    LeftAnkle = aPR.Data()->oMi[aPR.leftFoot()->associatedAnkle];
+    RightAnkle = aPR.Data()->oMi[aPR.rightFoot()->associatedAnkle];
+  }
+
+  double Distance(const Result &R) const {
+    return (CoM - R.CoM).norm() +
+           (LeftAnkle.toHomogeneousMatrix() - R.LeftAnkle.toHomogeneousMatrix())
+               .norm() +
+           (RightAnkle.toHomogeneousMatrix() -
+            R.RightAnkle.toHomogeneousMatrix())
+               .norm();
+  }
+};
+
+int main(int, char *[]) {
+  pinocchio::Model aModel;
+  pinocchio::urdf::buildModel(URDF_FULL_PATH, pinocchio::JointModelFreeFlyer(),
+                              aModel);
+  pinocchio::Data aData(aModel);
+  PinocchioRobot aPR;
+  if (!aPR.initializeRobotModelAndData(&aModel, &aData)) {
+    cerr << "The robot cannot be initialized." << endl;
+    return 1;
+  }
+
+  // The joints of the legs in the configuration with RPY.
+  vector<int> Legs;
+  pinocchio::JointIndex Ankles[2] = {aPR.leftFoot()->associatedAnkle,
+                                     aPR.rightFoot()->associatedAnkle};
+  for (unsigned int l = 0; l < 2; l++) {
+    vector<pinocchio::JointIndex> Leg =
+        aPR.jointsBetween(aPR.waist(), Ankles[l]);
+    for (unsigned int i = 1; i < Leg.size(); i++)
+      Legs.push_back(pinocchio::idx_q(aModel.joints[Leg[i]]) - 1);
+  }
+
+  // The other joints of the configuration with RPY.
+  vector<bool> IsLeg(aModel.nq - 1, false);
+  vector<int> UpperBody;
+  for (unsigned int i = 0; i < Legs.size(); i++)
+    IsLeg[Legs[i]] = true;
+  for (int i = 6; i < aModel.nq - 1; i++)
+    if (!IsLeg[i])
+      UpperBody.push_back(i);
+
+  srand(0);
+  Eigen::VectorXd q = 0.2 * Eigen::VectorXd::Random(aModel.nq - 1);
+  const unsigned int NbSamples = 200;
+  double MaxDistance = 0.0, LegsTime = 0.0, FullTime = 0.0;
+  struct timeval begin, end;
+  for (unsigned int k = 0; k < NbSamples; k++) {
+    // The free flyer and the legs move, the upper body moves
+    // once every 50 samples.
+    q.head(6) = 0.1 * Eigen::VectorXd::Random(6);
+    for (unsigned int i = 0; i < Legs.size(); i++)
+      q(Legs[i]) = 0.5 * (double)rand() / (double)RAND_MAX - 0.25;
+    if (k % 50 == 49)
+      for (unsigned int i = 0; i < UpperBody.size(); i++)
+        q(UpperBody[i]) = 0.4 * (double)rand() / (double)RAND_MAX - 0.2;
+    aPR.currentRPYConfiguration(q);
+
+    gettimeofday(&begin, 0);
+    aPR.computeLegsForwardKinematics();
+    gettimeofday(&end, 0);
+    LegsTime += Time(begin, end);
+    Result LegsOnly(aPR);
+
+    gettimeofday(&begin, 0);
+    aPR.computeForwardKinematics();
+    gettimeofday(&end, 0);
+    FullTime += Time(begin, end);
+    Result Full(aPR);
+
+    MaxDistance = max(MaxDistance, LegsOnly.Distance(Full));
+  }
+
+  printf("largest difference %.3e, time (us): legs %.3f, full %.3f\n",
+         MaxDistance, 1e6 * LegsTime / NbSamples, 1e6 * FullTime / NbSamples);
+  if (!(MaxDistance < 1e-9)) {
+    cerr << "The forward kinematics of the legs differs." << endl;
+    return 1;
+  }
+
+  // Timing of a walk: only the free flyer and the legs move.
+  vector<Eigen::VectorXd> Walk(NbSamples, q);
+  for (unsigned int k = 0; k < NbSamples; k++) {
+    Walk[k].head(6) = 0.1 * Eigen::VectorXd::Random(6);
+    for (unsigned int i = 0; i < Legs.size(); i++)
+      Walk[k](Legs[i]) = 0.5 * (double)rand() / (double)RAND_MAX - 0.25;
+  }
+  const unsigned int NbRepeats = 50;
+  aPR.currentRPYConfiguration(Walk[0]);
+  aPR.computeLegsForwardKinematics();
+  gettimeofday(&begin, 0);
+  for (unsigned int r = 0; r < NbRepeats; r++)
+    for (unsigned int k = 0; k < NbSamples; k++) {
+      aPR.currentRPYConfiguration(Walk[k]);
+      aPR.computeLegsForwardKinematics();
+    }
+  gettimeofday(&end, 0);
+  LegsTime = Time(begin, end);
+  gettimeofday(&begin, 0);
+  for (unsigned int r = 0; r < NbRepeats; r++)
+    for (unsigned int k = 0; k < NbSamples; k++) {
+      aPR.currentRPYConfiguration(Walk[k]);
+      aPR.computeForwardKinematics();
+    }
+  gettimeofday(&end, 0);
+  FullTime = Time(begin, end);
+  printf("walk time (us): legs %.3f, full %.3f\n",
+         1e6 * LegsTime / (NbRepeats * NbSamples),
+         1e6 * FullTime / (NbRepeats * NbSamples));
+  return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestMultiStartVelRefQP.cpp
+  \brief Check that after the resolution of the candidate support
+  sequences, the solution and the intermediate data of the velocity
+  referenced generator are those of a single resolution of the selected
+  sequence. */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+#include <sstream>
+
+#include "CommonTools.hh"
+#include "TestObject.hh"
+
+#include <SimplePluginManager.hh>
+#include <ZMPRefTrajectoryGeneration/ZMPVelocityReferencedQP.hh>
+
+using namespace ::PatternGeneratorJRL;
+using namespace ::PatternGeneratorJRL::TestSuite;
+using namespace std;
+
+/*! Largest difference between two matrices, infinite if their sizes
+  differ. */
+double difference(const Eigen::MatrixXd &A, const Eigen::MatrixXd &B) {
+  if ((A.rows() != B.rows()) || (A.cols() != B.cols()))
+    return HUGE_VAL;
+  if (A.size() == 0)
+    return 0.0;
+  return (A - B).cwiseAbs().maxCoeff();
+}
+
+/*! Largest difference between the selection matrices and the
+  inequalities of two states of the generator. */
+double difference(const IntermedQPMat::state_variant_t &a,
+                  const linear_inequality_t *aIneq,
+                  const IntermedQPMat::state_variant_t &b,
+                  const linear_inequality_t *bIneq) {
+  double d = 0.0;
+  d = max(d, difference(a.VcX, b.VcX));
+  d = max(d, difference(a.VcY, b.VcY));
+  d = max(d, difference(a.V, b.V));
+  d = max(d, difference(a.VT, b.VT));
+  d = max(d, difference(a.Vc_fX, b.Vc_fX));
+  d = max(d, difference(a.Vc_fY, b.Vc_fY));
+  d = max(d, difference(a.V_f, b.V_f));
+  d = max(d, difference(a.Vshift, b.Vshift));
+  d = max(d, difference(a.VcshiftX, b.VcshiftX));
+  d = max(d, difference(a.VcshiftY, b.VcshiftY));
+  for (unsigned int i = 0; i < 2; i++) {
+    d = max(d, difference(Eigen::MatrixXd(aIneq[i].D.X_mat),
+                          Eigen::MatrixXd(bIneq[i].D.X_mat)));
+    d = max(d, difference(Eigen::MatrixXd(aIneq[i].D.Y_mat),
+                          Eigen::MatrixXd(bIneq[i].D.Y_mat)));
+    d = max(d, difference(aIneq[i].Dc_vec, bIneq[i].Dc_vec));
+  }
+  return d;
+}
+
+class TestMultiStartVelRefQP : public TestObject {
+public:
+  TestMultiStartVelRefQP(int argc, char *argv[], string &aString)
+      : TestObject(argc, argv, aString) {}
+
+  /*! Walk with the candidate support sequences and solve again the
+    selected sequence after each resolution.
+    \return false if the resolutions differ. */
+  bool compare() {
+    SimplePluginManager SPM;
+    ZMPVelocityReferencedQP QP(&SPM, "", m_PR);
+    QP.SetTimeWindowPreviewControl(1.6);
+    string Method(":multistart");
+    istringstream strm("1 1.0");
+    QP.CallMethod(Method, strm);
+
+    deque<ZMPPosition> ZMPTraj;
+    deque<COMState> COMTraj;
+    deque<FootAbsolutePosition> LeftFootTraj, RightFootTraj;
+    COMState lStartingCOMState;
+    memset(&lStartingCOMState, 0, sizeof(COMState));
+    lStartingCOMState.z[0] = 0.814;
+    Eigen::Vector3d lStartingZMPPosition = Eigen::Vector3d::Zero();
+    FootAbsolutePosition InitLeftFootAbsPos, InitRightFootAbsPos;
+    memset(&InitLeftFootAbsPos, 0, sizeof(InitLeftFootAbsPos));
+    memset(&InitRightFootAbsPos, 0, sizeof(InitRightFootAbsPos));
+    InitLeftFootAbsPos.y = 0.095;
+    InitRightFootAbsPos.y = -0.095;
+    deque<RelativeFootPosition> RelativeFootPositions;
+    QP.SetCurrentTime(0.0);
+    QP.InitOnLine(ZMPTraj, COMTraj, LeftFootTraj, RightFootTraj,
+                  InitLeftFootAbsPos, InitRightFootAbsPos,
+                  RelativeFootPositions, lStartingCOMState,
+                  lStartingZMPPosition);
+
+    unsigned int NbResolutions = 0, NbCandidatesSelected = 0;
+    double MaxSolutionDifference = 0.0, MaxStateDifference = 0.0;
+    for (unsigned int k = 0; k < 600; k++) {
+      double time = 0.005 * k;
+      // A turning walk, which accelerates and then stops.
+      if (k == 0)
+        QP.Reference(0.2, 0.0, 0.1);
+      else if (k == 200)
+        QP.Reference(0.3, 0.1, -0.1);
+      else if (k == 400)
+        QP.Reference(0.0, 0.0, 0.0);
+
+      deque<FootAbsolutePosition> LeftFootStart = LeftFootTraj,
+                                  RightFootStart = RightFootTraj;
+      QP.OnLine(time, ZMPTraj, COMTraj, LeftFootTraj, RightFootTraj);
+      ZMPTraj.pop_front();
+      COMTraj.pop_front();
+      LeftFootTraj.pop_front();
+      RightFootTraj.pop_front();
+      if (k % 20 != 0)
+        continue;
+
+      // A new problem has been solved.
+      NbResolutions++;
+      if (QP.SelectedCandidate() != NOMINAL_SUPPORT)
+        NbCandidatesSelected++;
+      const solution_t Selected = QP.Solution();
+      const IntermedQPMat::state_variant_t SelectedState =
+          QP.IntermedData()->State();
+      linear_inequality_t SelectedIneq[2] = {
+          QP.IntermedData()->Inequalities(INEQ_COP),
+          QP.IntermedData()->Inequalities(INEQ_FEET)};
+      if (Selected.Fail != 0) {
+        cerr << "t = " << time << ": the resolution failed." << endl;
+        return false;
+      }
+
+      solution_t Single = Selected;
+      Single.Solution_vec.setZero();
+      if (!QP.SolveSupportSequence(Single, LeftFootStart, RightFootStart)) {
+        cerr << "t = " << time << ": the selected sequence "
+             << QP.SelectedCandidate() << " cannot be solved again." << endl;
+        return false;
+      }
+      linear_inequality_t SingleIneq[2] = {
+          QP.IntermedData()->Inequalities(INEQ_COP),
+          QP.IntermedData()->Inequalities(INEQ_FEET)};
+      MaxSolutionDifference =
+          max(MaxSolutionDifference,
+              difference(Selected.Solution_vec, Single.Solution_vec));
+      MaxStateDifference =
+          max(MaxStateDifference,
+              difference(SelectedState, SelectedIneq,
+                         QP.IntermedData()->State(), SingleIneq));
+    }
+
+    printf("%u resolutions, %u with another sequence than the nominal one: "
+           "largest difference of the solutions %.3e, of the states %.3e\n",
+           NbResolutions, NbCandidatesSelected, MaxSolutionDifference,
+           MaxStateDifference);
+    if ((MaxSolutionDifference > 1e-8) || (MaxStateDifference > 0.0)) {
+      cerr << "The selected sequence is not the one of the generator."
+           << endl;
+      return false;
+    }
+    return true;
+  }
+
+protected:
+  void chooseTestProfile() {}
+  void generateEvent() {}
+};
+
+int main(int argc, char *argv[]) {
+  string aName("TestMultiStartVelRefQP");
+  try {
+    TestMultiStartVelRefQP aTest(argc, argv, aName);
+    if (!aTest.init() || !aTest.compare())
+      return 1;
+  } catch (const std::string &msg) {
+    std::cerr << msg << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -32,6 +32,7 @@
 #include <iostream>
 
 #include <math.h>
+#include <sys/time.h>
 
 #include "Mathematics/OptCholesky.hh"
 
@@ -75,12 +76,134 @@ double CheckCholeskyDecomposition(double *A, double *L, int n) {
     }
   }
 
-  delete LLT;
+  delete[] LLT;
   distance = sqrt(distance);
 
   return distance;
 }
 
+double ElapsedTime(struct timeval &begin, struct timeval &end) {
+  return (double)(end.tv_sec - begin.tv_sec) +
+         1e-6 * (double)(end.tv_usec - begin.tv_usec);
+}
+
+/*! Distance between L L^t and the Gram matrix of the rows Rows of A,
+  where L is stored with a leading dimension NbMax and A by columns
+  with a leading dimension m+1. */
+double CheckFactorOnRows(double *A, unsigned int m, unsigned int lCardU,
+                         double *L, unsigned int NbMax,
+                         vector<unsigned int> &Rows) {
+  double distance = 0.0;
+  for (unsigned int i = 0; i < Rows.size(); i++) {
+    for (unsigned int j = 0; j < Rows.size(); j++) {
+      double Mij = 0.0, LLTij = 0.0;
+      for (unsigned int k = 0; k < lCardU; k++)
+        Mij += A[Rows[i] + k * (m + 1)] * A[Rows[j] + k * (m + 1)];
+      for (unsigned int k = 0; k <= i && k <= j; k++)
+        LLTij += L[i * NbMax + k] * L[j * NbMax + k];
+      distance += (Mij - LLTij) * (Mij - LLTij);
+    }
+  }
+  return sqrt(distance);
+}
+
+/*! Check the block update and the downdate on a matrix stored as in
+  the PLDP solver, and compare the time of the one-by-one update with
+  the block update with the scalar and the SIMD kernels. */
+int CheckBlockUpdatesAndBenchmark() {
+  unsigned int m = 128, lCardU = 32, NbMax = 8 * 16;
+  unsigned int NbOfActive = 24, NbOfTrials = 2000;
+  int return_value = 0;
+
+  double *A = new double[(m + 1) * lCardU];
+  double *L = new double[NbMax * NbMax];
+  double *iL = new double[NbMax * NbMax];
+  for (unsigned int i = 0; i < (m + 1) * lCardU; i++)
+    A[i] = (double)rand() / (double)RAND_MAX - 0.5;
+
+  vector<unsigned int> Rows;
+  for (unsigned int i = 0; i < NbOfActive; i++)
+    Rows.push_back((i * 37) % m);
+
+  PatternGeneratorJRL::OptCholesky anOptCholesky(
+      NbMax, lCardU, PatternGeneratorJRL::OptCholesky::MODE_FORTRAN);
+  anOptCholesky.SetA(A, m);
+  anOptCholesky.SetL(L);
+  anOptCholesky.SetiL(iL);
+
+  // Block update: first half one by one, then the rest as a block.
+  vector<unsigned int> Block(Rows.begin() + NbOfActive / 2, Rows.end());
+  for (unsigned int i = 0; i < NbOfActive / 2; i++)
+    anOptCholesky.AddActiveConstraint(Rows[i]);
+  anOptCholesky.AddActiveConstraints(Block);
+  double r = CheckFactorOnRows(A, m, lCardU, L, NbMax, Rows);
+  if (r > 1e-8) {
+    cout << "Block update of the Cholesky decomposition pb:" << r << endl;
+    return_value = -1;
+  }
+
+  // Downdate: remove some rows and compare with the remaining set.
+  unsigned int Removed[3] = {NbOfActive - 1, 5, 0};
+  for (unsigned int i = 0; i < 3; i++) {
+    anOptCholesky.RemoveActiveConstraint(Removed[i]);
+    Rows.erase(Rows.begin() + Removed[i]);
+    r = CheckFactorOnRows(A, m, lCardU, L, NbMax, Rows);
+    if (r > 1e-8) {
+      cout << "Downdate of the Cholesky decomposition pb:" << r << endl;
+      return_value = -1;
+    }
+  }
+  if (anOptCholesky.RemoveActiveConstraint(Rows.size()) != -1) {
+    cout << "Removing a row which does not exist should fail." << endl;
+    return_value = -1;
+  }
+
+  // Benchmark
+  Rows.clear();
+  for (unsigned int i = 0; i < NbOfActive; i++)
+    Rows.push_back((i * 37) % m);
+
+  struct timeval begin, end;
+  double Timings[3];
+  for (unsigned int lTest = 0; lTest < 3; lTest++) {
+    bool SIMD = PatternGeneratorJRL::OptCholesky::SetSIMDKernels(lTest == 2);
+    if ((lTest == 2) && (!SIMD)) {
+      Timings[lTest] = Timings[1];
+      break;
+    }
+    gettimeofday(&begin, 0);
+    for (unsigned int lTrial = 0; lTrial < NbOfTrials; lTrial++) {
+      anOptCholesky.SetToZero();
+      if (lTest == 0)
+        for (unsigned int i = 0; i < NbOfActive; i++)
+          anOptCholesky.AddActiveConstraint(Rows[i]);
+      else
+        anOptCholesky.AddActiveConstraints(Rows);
+    }
+    gettimeofday(&end, 0);
+    Timings[lTest] = ElapsedTime(begin, end) / NbOfTrials;
+
+    r = CheckFactorOnRows(A, m, lCardU, L, NbMax, Rows);
+    if (r > 1e-8) {
+      cout << "Cholesky decomposition pb in benchmark " << lTest << ":" << r
+           << endl;
+      return_value = -1;
+    }
+  }
+  PatternGeneratorJRL::OptCholesky::SetSIMDKernels(true);
+
+  cout << "Factorization of " << NbOfActive << " constraints on " << lCardU
+       << " variables (us):" << endl
+       << " one by one: " << 1e6 * Timings[0] << endl
+       << " block, scalar: " << 1e6 * Timings[1] << endl
+       << " block, SIMD: " << 1e6 * Timings[2] << endl;
+
+  delete[] iL;
+  delete[] L;
+  delete[] A;
+  return return_value;
+}
+
 int main() {
   PatternGeneratorJRL::OptCholesky *anOptCholesky;
 
@@ -159,9 +282,14 @@ int main() {
     DisplayMatrix(iL, lNbOfConstraints, lNbOfConstraints, string("iL"), 0);
 
   delete anOptCholesky;
+  delete[] AAT;
+  delete[] iL;
   delete[] L;
   delete[] A;
 
+  if (CheckBlockUpdatesAndBenchmark() != 0)
+    return_value = -1;
+
   if (return_value == -1) {
     cout << "Failed test" << endl;
   } else {
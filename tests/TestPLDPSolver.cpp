@@ -0,0 +1,212 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestPLDPSolver.cpp
+  \brief Check the anytime and the hot start modes of the PLDP solver
+  on a receding horizon problem with a closed-form solution:
+  the ZMP is the control, it tracks a reference going out of a box. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <iostream>
+#include <vector>
+
+#include <Mathematics/PLDPSolver.hh>
+
+using namespace std;
+using namespace Optimization::Solver;
+
+const unsigned int N = 32;
+const double Bound = 0.1;
+const double Tol = 1e-8;
+
+/*! Reference of the ZMP at the sample i of the tick k: its amplitude
+  changes with the tick so that the constraints carried by the hot
+  start do not always bind. */
+double Target(unsigned int k, unsigned int i, unsigned int Axis) {
+  double Amplitude = 0.12 + 0.06 * sin(0.1 * k);
+  return (Axis == 0) ? Amplitude * sin(0.3 * (k + i))
+                     : Amplitude * cos(0.2 * (k + i));
+}
+
+/*! Box constraints -Bound <= V <= Bound, four rows per sample:
+  the rows of the first sample are removed by the next tick. */
+void BuildConstraints(vector<double> &A, vector<double> &b,
+                      vector<int> &SimilarConstraints) {
+  const unsigned int NbCstr = 4 * N;
+  A.assign((NbCstr + 1) * 2 * N, 0.0);
+  b.assign(NbCstr, Bound);
+  SimilarConstraints.assign(NbCstr, 0);
+  for (unsigned int i = 0; i < N; i++) {
+    for (unsigned int Axis = 0; Axis < 2; Axis++) {
+      unsigned int Row = 4 * i + 2 * Axis, Col = i + Axis * N;
+      A[Row + Col * (NbCstr + 1)] = 1.0;
+      A[Row + 1 + Col * (NbCstr + 1)] = -1.0;
+      SimilarConstraints[Row + 1] = -1;
+    }
+  }
+}
+
+/*! Cost of the problem min 1/2 V'V + c'V. */
+double Cost(const vector<double> &c, const vector<double> &V) {
+  double r = 0.0;
+  for (unsigned int i = 0; i < 2 * N; i++)
+    r += 0.5 * V[i] * V[i] + c[i] * V[i];
+  return r;
+}
+
+bool IsFeasible(const vector<double> &A, const vector<double> &b,
+                const vector<double> &V) {
+  const unsigned int NbCstr = b.size();
+  for (unsigned int li = 0; li < NbCstr; li++) {
+    double r = b[li];
+    for (unsigned int lj = 0; lj < 2 * N; lj++)
+      r += A[li + lj * (NbCstr + 1)] * V[lj];
+    if (r < -Tol)
+      return false;
+  }
+  return true;
+}
+
+/*! The ZMP is the control: Pu = iPu = I and Px = 0. */
+class Problem {
+public:
+  Problem()
+      : m_iPu(N * N, 0.0), m_Pu(N * N, 0.0), m_Px(N * 3, 0.0),
+        m_iLQ(N * 2 * N, 0.0), m_ZMPRef(2 * N, 0.0), m_XkYk(6, 0.0) {
+    for (unsigned int i = 0; i < N; i++)
+      m_iPu[i * N + i] = m_Pu[i * N + i] = 1.0;
+    BuildConstraints(m_A, m_b, m_SimilarConstraints);
+  }
+
+  PLDPSolver *NewSolver() {
+    return new PLDPSolver(N, &m_iPu[0], &m_Px[0], &m_Pu[0], &m_iLQ[0]);
+  }
+
+  int Solve(PLDPSolver &aSolver, unsigned int k, vector<double> &X) {
+    vector<double> c(2 * N);
+    for (unsigned int i = 0; i < N; i++) {
+      c[i] = -Target(k, i, 0);
+      c[i + N] = -Target(k, i, 1);
+    }
+    m_c = c;
+    X.assign(2 * N, 0.0);
+    return aSolver.SolveProblem(&m_c[0], m_b.size(), &m_A[0], &m_b[0],
+                                &m_ZMPRef[0], &m_XkYk[0], &X[0],
+                                m_SimilarConstraints, 4, k == 0);
+  }
+
+  /*! The constraints are decoupled: the solution is the projection
+    of the reference on the box. */
+  double Error(unsigned int k, const vector<double> &X) {
+    double r = 0.0;
+    for (unsigned int i = 0; i < N; i++)
+      for (unsigned int Axis = 0; Axis < 2; Axis++) {
+        double Expected = Target(k, i, Axis);
+        Expected = (Expected > Bound) ? Bound : Expected;
+        Expected = (Expected < -Bound) ? -Bound : Expected;
+        r = fmax(r, fabs(X[i + Axis * N] - Expected));
+      }
+    return r;
+  }
+
+  vector<double> m_iPu, m_Pu, m_Px, m_iLQ, m_ZMPRef, m_XkYk;
+  vector<double> m_A, m_b, m_c;
+  vector<int> m_SimilarConstraints;
+};
+
+int main(int, char *[]) {
+  Problem aProblem;
+  PLDPSolver *Cold = aProblem.NewSolver(), *Hot = aProblem.NewSolver(),
+             *Anytime = aProblem.NewSolver(),
+             *HotAnytime = aProblem.NewSolver();
+  Cold->SetHotStart(false);
+  Cold->SetLimitedComputationTime(false, 0.0);
+  Hot->SetHotStart(true);
+  Hot->SetLimitedComputationTime(false, 0.0);
+  Anytime->SetHotStart(false);
+  Anytime->SetLimitedComputationTime(true, 0.0);
+  HotAnytime->SetHotStart(true);
+  HotAnytime->SetLimitedComputationTime(true, 0.0);
+
+  const unsigned int NbTicks = 200;
+  unsigned int NbColdIterations = 0, NbHotIterations = 0;
+  unsigned int NbCarried = 0, NbDeadlines = 0;
+  vector<double> XCold, XHot, XAnytime, XHotAnytime;
+  for (unsigned int k = 0; k < NbTicks; k++) {
+    aProblem.Solve(*Cold, k, XCold);
+    double Optimum = Cost(aProblem.m_c, XCold);
+    if (aProblem.Error(k, XCold) > Tol) {
+      cerr << "Tick " << k << ": cold start error "
+           << aProblem.Error(k, XCold) << endl;
+      return 1;
+    }
+    NbColdIterations += Cold->GetLastTickReport().NbOfIterations;
+
+    // The hot start converges to the same solution.
+    aProblem.Solve(*Hot, k, XHot);
+    double Error = 0.0;
+    for (unsigned int i = 0; i < 2 * N; i++)
+      Error = fmax(Error, fabs(XHot[i] - XCold[i]));
+    const PLDPSolverTickReport &HotReport = Hot->GetLastTickReport();
+    if ((Error > Tol) || HotReport.HotStartRejected) {
+      cerr << "Tick " << k << ": hot start error " << Error << endl;
+      return 1;
+    }
+    NbHotIterations += HotReport.NbOfIterations;
+    NbCarried += HotReport.NbOfCarriedConstraints;
+
+    // Within the budget the iterates stay feasible and the cost
+    // decreases from the one of the ZMP reference.
+    aProblem.Solve(*Anytime, k, XAnytime);
+    const PLDPSolverTickReport &Report = Anytime->GetLastTickReport();
+    if (!IsFeasible(aProblem.m_A, aProblem.m_b, XAnytime) ||
+        (Report.Cost > Tol) || (Report.Cost < Optimum - Tol) ||
+        (!Report.DeadlineReached && (aProblem.Error(k, XAnytime) > Tol))) {
+      cerr << "Tick " << k << ": bounded time solution with cost "
+           << Report.Cost << " for " << Optimum << endl;
+      return 1;
+    }
+    if (Report.DeadlineReached)
+      NbDeadlines++;
+
+    aProblem.Solve(*HotAnytime, k, XHotAnytime);
+    if (!IsFeasible(aProblem.m_A, aProblem.m_b, XHotAnytime) ||
+        (HotAnytime->GetLastTickReport().Cost < Optimum - Tol)) {
+      cerr << "Tick " << k << ": hot started bounded time solution "
+           << "not feasible" << endl;
+      return 1;
+    }
+  }
+
+  printf("iterations: cold %u, hot %u, carried constraints %u\n",
+         NbColdIterations, NbHotIterations, NbCarried);
+  printf("%u ticks out of %u stopped by the deadline\n", NbDeadlines,
+         NbTicks);
+  delete Cold;
+  delete Hot;
+  delete Anytime;
+  delete HotAnytime;
+  if ((NbCarried == 0) || (NbHotIterations >= NbColdIterations) ||
+      (NbDeadlines == 0)) {
+    cerr << "The hot start or the deadline has not been exercised." << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestPinocchioDataPool.cpp
+  \brief Check that the queries in the workspaces of a pool give the
+  results of the robot, without modifying it, also when they are run
+  by concurrent threads. */
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+#include "portability/thread.hh"
+
+#include <jrl/walkgen/pinocchiorobot.hh>
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+
+/*! The queries first, first + step, ... in one workspace. */
+class Queries : public WorkerThread::Job {
+public:
+  Queries(const PinocchioRobot &aPR, PRWorkspace &aWorkspace,
+          const vector<Eigen::VectorXd> &Q, const vector<Eigen::VectorXd> &V,
+          const vector<Eigen::VectorXd> &A, unsigned int first,
+          unsigned int step)
+      : m_PR(aPR), m_Workspace(aWorkspace), m_Q(Q), m_V(V), m_A(A),
+        m_First(first), m_Step(step), m_CoMs(Q.size()), m_ZMPs(Q.size()),
+        m_Taus(Q.size()) {}
+
+  void run() {
+    for (unsigned int k = m_First; k < m_Q.size(); k += m_Step) {
+      m_PR.computeForwardKinematics(m_Q[k], m_Workspace);
+      m_PR.positionCenterOfMass(m_Workspace, m_CoMs[k]);
+      m_PR.computeInverseDynamics(m_Q[k], m_V[k], m_A[k], m_Workspace);
+      m_PR.zeroMomentumPoint(m_Workspace, m_ZMPs[k]);
+      m_Taus[k] = m_Workspace.tau;
+    }
+  }
+
+  const PinocchioRobot &m_PR;
+  PRWorkspace &m_Workspace;
+  const vector<Eigen::VectorXd> &m_Q, &m_V, &m_A;
+  unsigned int m_First, m_Step;
+  vector<Eigen::Vector3d> m_CoMs, m_ZMPs;
+  vector<Eigen::VectorXd> m_Taus;
+};
+
+int main(int, char *[]) {
+  pinocchio::Model aModel;
+  pinocchio::urdf::buildModel(URDF_FULL_PATH, pinocchio::JointModelFreeFlyer(),
+                              aModel);
+  pinocchio::Data aData(aModel);
+  PinocchioRobot aPR;
+  if (!aPR.initializeRobotModelAndData(&aModel, &aData)) {
+    cerr << "The robot cannot be initialized." << endl;
+    return 1;
+  }
+
+  const unsigned int NbWorkspaces = 4, NbQueries = 40;
+  PinocchioDataPool aPool;
+  aPool.resize(aPR, NbWorkspaces);
+  if (aPool.size() != NbWorkspaces) {
+    cerr << "Wrong number of workspaces." << endl;
+    return 1;
+  }
+
+  srand(0);
+  vector<Eigen::VectorXd> Q, V, A;
+  for (unsigned int k = 0; k < NbQueries; k++) {
+    Q.push_back(0.3 * Eigen::VectorXd::Random(aModel.nq - 1));
+    Q[k](2) += 1.0;
+    V.push_back(Eigen::VectorXd::Random(aModel.nv));
+    A.push_back(Eigen::VectorXd::Random(aModel.nv));
+  }
+
+  // The queries of the pool are interleaved, by packets of
+  // NbWorkspaces as for as many threads.
+  Eigen::VectorXd RobotConfiguration = aPR.currentRPYConfiguration();
+  for (unsigned int start = 0; start < NbQueries; start += NbWorkspaces) {
+    vector<Eigen::Vector3d> ZMPs(NbWorkspaces), CoMs(NbWorkspaces);
+    for (unsigned int i = 0; i < NbWorkspaces; i++) {
+      PRWorkspace &aWorkspace = aPool.workspace(i);
+      aPR.computeForwardKinematics(Q[start + i], aWorkspace);
+      aPR.positionCenterOfMass(aWorkspace, CoMs[i]);
+      aPR.computeInverseDynamics(Q[start + i], V[start + i], A[start + i],
+                                 aWorkspace);
+      aPR.zeroMomentumPoint(aWorkspace, ZMPs[i]);
+    }
+    if (aPR.currentRPYConfiguration() != RobotConfiguration) {
+      cerr << "A const query has modified the robot." << endl;
+      return 1;
+    }
+
+    for (unsigned int i = 0; i < NbWorkspaces; i++) {
+      unsigned int k = start + i;
+      Eigen::Vector3d CoM, ZMP;
+      aPR.currentRPYConfiguration(Q[k]);
+      aPR.computeForwardKinematics();
+      aPR.positionCenterOfMass(CoM);
+      aPR.computeInverseDynamics(Q[k], V[k], A[k]);
+      aPR.zeroMomentumPoint(ZMP);
+      double Error = (CoM - CoMs[i]).norm() + (ZMP - ZMPs[i]).norm() +
+                     (aPR.currentTau() - aPool.workspace(i).tau).norm();
+      if (!(Error < 1e-9)) {
+        cerr << "Query " << k << " differs from the robot: " << Error << endl;
+        return 1;
+      }
+    }
+    RobotConfiguration = aPR.currentRPYConfiguration();
+  }
+
+  // The same queries by one thread per workspace, several times,
+  // in workspaces initialized again.
+  aPool.resize(aPR, NbWorkspaces);
+  aPR.initializeWorkspace(aPool.workspace(0));
+  vector<Eigen::Vector3d> CoMs(NbQueries), ZMPs(NbQueries);
+  vector<Eigen::VectorXd> Taus(NbQueries);
+  for (unsigned int k = 0; k < NbQueries; k++) {
+    aPR.currentRPYConfiguration(Q[k]);
+    aPR.computeForwardKinematics();
+    aPR.positionCenterOfMass(CoMs[k]);
+    aPR.computeInverseDynamics(Q[k], V[k], A[k]);
+    aPR.zeroMomentumPoint(ZMPs[k]);
+    Taus[k] = aPR.currentTau();
+  }
+  RobotConfiguration = aPR.currentRPYConfiguration();
+  vector<WorkerThread *> Threads(NbWorkspaces);
+  vector<Queries *> Jobs(NbWorkspaces);
+  unsigned int NbThreads = 0;
+  for (unsigned int i = 0; i < NbWorkspaces; i++) {
+    Threads[i] = new WorkerThread();
+    if (Threads[i]->create())
+      NbThreads++;
+    Jobs[i] = new Queries(aPR, aPool.workspace(i), Q, V, A, i, NbWorkspaces);
+  }
+  for (unsigned int r = 0; r < 20; r++) {
+    for (unsigned int i = 0; i < NbWorkspaces; i++)
+      Threads[i]->start(Jobs[i]);
+    for (unsigned int i = 0; i < NbWorkspaces; i++)
+      Threads[i]->wait();
+    if (aPR.currentRPYConfiguration() != RobotConfiguration) {
+      cerr << "A concurrent query has modified the robot." << endl;
+      return 1;
+    }
+    for (unsigned int k = 0; k < NbQueries; k++) {
+      const Queries &aJob = *Jobs[k % NbWorkspaces];
+      double Error = (CoMs[k] - aJob.m_CoMs[k]).norm() +
+                     (ZMPs[k] - aJob.m_ZMPs[k]).norm() +
+                     (Taus[k] - aJob.m_Taus[k]).norm();
+      if (!(Error < 1e-9)) {
+        cerr << "Concurrent query " << k << " differs from the robot: "
+             << Error << endl;
+        return 1;
+      }
+    }
+  }
+  for (unsigned int i = 0; i < NbWorkspaces; i++) {
+    delete Threads[i];
+    delete Jobs[i];
+  }
+  cout << "Data pool: ok, " << NbThreads << " threads" << endl;
+  return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestPipelinedStages.cpp
+  \brief Check that the walk generated with the pipelined stages of the
+  preview control is the one generated with the sequential stages. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <iostream>
+#include <vector>
+
+#include "portability/gettimeofday.hh"
+
+#include "CommonTools.hh"
+#include "TestObject.hh"
+
+using namespace ::PatternGeneratorJRL;
+using namespace ::PatternGeneratorJRL::TestSuite;
+using namespace std;
+
+/*! Outputs of the control loop along a walk. */
+struct Walk {
+  vector<Eigen::VectorXd> Configurations;
+  vector<COMState> COMStates;
+  double Time;
+};
+
+class TestPipelinedStages : public TestObject {
+public:
+  TestPipelinedStages(int argc, char *argv[], string &aString, bool Pipelined)
+      : TestObject(argc, argv, aString), m_Pipelined(Pipelined) {}
+
+  /*! Walk with turning steps. With the pipelined stages, they are
+    switched off and on in the middle of the walk: the first stage
+    computed ahead is then undone. */
+  void walk(Walk &aWalk) {
+    CommonInitialization(*m_PGI);
+    parseCmd(":SetAlgoForZmpTrajectory Kajita");
+    if (m_Pipelined)
+      parseCmd(":pipelinedstages true");
+    parseCmd(":stepseq 0.0 -0.095 0.0 0.0 \
+                       0.2 0.19 0.0 10.0 \
+                       0.2 -0.19 0.0 10.0 \
+                       0.2 0.19 0.0 0.0 \
+                       0.0 -0.19 0.0 0.0");
+
+    struct timeval begin, end;
+    aWalk.Time = 0.0;
+    for (unsigned long k = 0;; k++) {
+      gettimeofday(&begin, 0);
+      bool ok = m_PGI->RunOneStepOfTheControlLoop(
+          m_CurrentConfiguration, m_CurrentVelocity, m_CurrentAcceleration,
+          m_OneStep.m_ZMPTarget, m_OneStep.m_finalCOMPosition,
+          m_OneStep.m_LeftFootPosition, m_OneStep.m_RightFootPosition);
+      gettimeofday(&end, 0);
+      if (!ok)
+        break;
+      aWalk.Time += Time(begin, end);
+      aWalk.Configurations.push_back(m_CurrentConfiguration);
+      aWalk.COMStates.push_back(m_OneStep.m_finalCOMPosition);
+
+      if (m_Pipelined && (k == 500)) {
+        parseCmd(":pipelinedstages false");
+        parseCmd(":pipelinedstages true");
+      }
+    }
+  }
+
+protected:
+  void parseCmd(const char *aCmd) {
+    istringstream strm(aCmd);
+    m_PGI->ParseCmd(strm);
+  }
+
+  void chooseTestProfile() {}
+  void generateEvent() {}
+
+  bool m_Pipelined;
+};
+
+int main(int argc, char *argv[]) {
+  string SequentialName("TestSequentialStages");
+  string PipelinedName("TestPipelinedStages");
+  try {
+    TestPipelinedStages Sequential(argc, argv, SequentialName, false);
+    TestPipelinedStages Pipelined(argc, argv, PipelinedName, true);
+    if (!Sequential.init() || !Pipelined.init())
+      return 1;
+
+    Walk SequentialWalk, PipelinedWalk;
+    Sequential.walk(SequentialWalk);
+    Pipelined.walk(PipelinedWalk);
+    unsigned long NbSamples = SequentialWalk.Configurations.size();
+    if ((NbSamples < 1000) ||
+        (PipelinedWalk.Configurations.size() != NbSamples)) {
+      cerr << "The walks have " << NbSamples << " and "
+           << PipelinedWalk.Configurations.size() << " samples." << endl;
+      return 1;
+    }
+
+    // The multibody ZMP is computed in a workspace of the robot, with
+    // the same operations: the walks are identical.
+    double MaxDifference = 0.0;
+    for (unsigned long k = 0; k < NbSamples; k++) {
+      const COMState &a = SequentialWalk.COMStates[k];
+      const COMState &b = PipelinedWalk.COMStates[k];
+      double Difference = (SequentialWalk.Configurations[k] -
+                           PipelinedWalk.Configurations[k])
+                              .lpNorm<Eigen::Infinity>();
+      for (unsigned int i = 0; i < 3; i++) {
+        Difference = max(Difference, fabs(a.x[i] - b.x[i]));
+        Difference = max(Difference, fabs(a.y[i] - b.y[i]));
+      }
+      if (!(Difference == 0.0)) {
+        cerr << "Sample " << k << ": the walks differ by " << Difference
+             << endl;
+        return 1;
+      }
+      MaxDifference = max(MaxDifference, Difference);
+    }
+
+    printf("%lu samples, largest difference %.3e\n", NbSamples,
+           MaxDifference);
+    printf("time per sample (us): sequential %.1f, pipelined %.1f\n",
+           1e6 * SequentialWalk.Time / (double)NbSamples,
+           1e6 * PipelinedWalk.Time / (double)NbSamples);
+  } catch (const std::string &msg) {
+    std::cerr << msg << std::endl;
+    return 1;
+  }
+  return 0;
+}
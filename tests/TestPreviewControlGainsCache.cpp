@@ -0,0 +1,144 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestPreviewControlGainsCache.cpp
+  \brief Check that the preview control gains read from the persistent
+  cache are the ones given by the Riccati equation. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <iostream>
+
+#include <PreviewControl/PreviewControl.hh>
+#include <PreviewControl/PreviewControlGainsCache.hh>
+#include <SimplePluginManager.hh>
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+
+void SetParameters(PreviewControl &aPC) {
+  aPC.SetSamplingPeriod(0.005);
+  aPC.SetPreviewControlTime(1.6);
+  aPC.SetHeightOfCoM(0.814);
+}
+
+int main(int, char *[]) {
+  string aFileName("TestPreviewControlGainsCache.bin");
+  remove(aFileName.c_str());
+
+  SimplePluginManager aSPM;
+  Eigen::MatrixXd KxRef, FRef, Kx, F;
+  double KsRef, Ks;
+
+  PreviewControlGainsCache aCache;
+  if (!aCache.Open(aFileName)) {
+    // Without mmap support there is nothing to check.
+    cout << "No memory-mapped files on this system." << endl;
+    return 0;
+  }
+
+  // First session: the gains are computed and stored.
+  {
+    PreviewControl aPC(&aSPM, OptimalControllerSolver::MODE_WITH_INITIALPOS);
+    aPC.SetGainsCache(&aCache);
+    SetParameters(aPC);
+    aPC.ComputeOptimalWeights(OptimalControllerSolver::MODE_WITH_INITIALPOS);
+  }
+  if (aCache.NbOfEntries() != 1) {
+    cerr << "The gains have not been stored." << endl;
+    return 1;
+  }
+  if (!aCache.Find(0.005, 0.814, 1.6,
+                   OptimalControllerSolver::MODE_WITH_INITIALPOS, KxRef, KsRef,
+                   FRef)) {
+    cerr << "The gains have not been found." << endl;
+    return 1;
+  }
+  aCache.Close();
+
+  // Second session: the gains are read back from the file.
+  if (!aCache.Open(aFileName) || (aCache.NbOfEntries() != 1)) {
+    cerr << "The cache has not been kept on disk." << endl;
+    return 1;
+  }
+  if (aCache.Find(0.005, 0.814, 1.6,
+                  OptimalControllerSolver::MODE_WITHOUT_INITIALPOS, Kx, Ks,
+                  F)) {
+    cerr << "Wrong key matched." << endl;
+    return 1;
+  }
+  aCache.Find(0.005, 0.814, 1.6, OptimalControllerSolver::MODE_WITH_INITIALPOS,
+              Kx, Ks, F);
+  if ((Kx != KxRef) || (Ks != KsRef) || (F != FRef) || (F.rows() == 0)) {
+    cerr << "The gains read from the cache differ." << endl;
+    return 1;
+  }
+
+  // A controller using the cache behaves as one solving the Riccati equation.
+  {
+    PreviewControl aPCRiccati(&aSPM,
+                              OptimalControllerSolver::MODE_WITH_INITIALPOS);
+    SetParameters(aPCRiccati);
+    aPCRiccati.ComputeOptimalWeights(
+        OptimalControllerSolver::MODE_WITH_INITIALPOS);
+
+    PreviewControl aPCCache(&aSPM,
+                            OptimalControllerSolver::MODE_WITH_INITIALPOS);
+    aPCCache.SetGainsCache(&aCache);
+    SetParameters(aPCCache);
+    aPCCache.ComputeOptimalWeights(
+        OptimalControllerSolver::MODE_WITH_INITIALPOS);
+
+    vector<double> ZMPRef(640);
+    for (unsigned int i = 0; i < ZMPRef.size(); i++)
+      ZMPRef[i] = i < 100 ? 0.0 : 0.1;
+    Eigen::MatrixXd xRiccati(3, 1), xCache(3, 1);
+    xRiccati.setZero();
+    xCache.setZero();
+    double sRiccati = 0.0, sCache = 0.0, zmpRiccati, zmpCache;
+    for (unsigned int k = 0; k < 300; k++) {
+      aPCRiccati.OneIterationOfPreview1D(xRiccati, sRiccati, ZMPRef, k,
+                                         zmpRiccati, false);
+      aPCCache.OneIterationOfPreview1D(xCache, sCache, ZMPRef, k, zmpCache,
+                                       false);
+      if ((xRiccati != xCache) || (zmpRiccati != zmpCache)) {
+        cerr << "The controller using the cache differs at " << k << endl;
+        return 1;
+      }
+    }
+    if (aCache.NbOfEntries() != 1) {
+      cerr << "The gains have been stored twice." << endl;
+      return 1;
+    }
+  }
+
+  // Another robot: the cache is emptied.
+  aCache.Invalidate();
+  if ((aCache.NbOfEntries() != 0) ||
+      aCache.Find(0.005, 0.814, 1.6,
+                  OptimalControllerSolver::MODE_WITH_INITIALPOS, Kx, Ks, F)) {
+    cerr << "The cache has not been invalidated." << endl;
+    return 1;
+  }
+  aCache.Close();
+  remove(aFileName.c_str());
+
+  cout << "Preview control gains cache: ok" << endl;
+  return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestQLDSolver.cpp
+  \brief Check that QLDSolver gives the solutions of ql0001_. */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+#include <Mathematics/QLDSolver.hh>
+#include <Mathematics/qld.hh>
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+
+double Random() { return (double)rand() / (double)RAND_MAX - 0.5; }
+
+/*! A random problem with a positive definite hessian. */
+struct Problem {
+  int m, n;
+  vector<double> Q, D, A, B;
+
+  Problem(int lm, int ln) : m(lm), n(ln) {
+    Q.assign(n * n, 0.0);
+    vector<double> R(n * n);
+    for (int i = 0; i < n * n; i++)
+      R[i] = Random();
+    for (int i = 0; i < n; i++)
+      for (int j = 0; j < n; j++) {
+        for (int k = 0; k < n; k++)
+          Q[i + j * n] += R[k + i * n] * R[k + j * n];
+        if (i == j)
+          Q[i + j * n] += 1.0;
+      }
+    D.resize(n);
+    for (int i = 0; i < n; i++)
+      D[i] = 4.0 * Random();
+    A.assign((m + 1) * n, 0.0);
+    for (int i = 0; i < m; i++)
+      for (int k = 0; k < n; k++)
+        A[i + k * (m + 1)] = Random();
+    B.resize(m + 1);
+    for (int i = 0; i < m; i++)
+      B[i] = 0.1 + 0.2 * Random();
+  }
+};
+
+/*! Reference: a direct call with the workspace of the callers. */
+int SolveWithQL0001(Problem aPb, vector<double> &X, vector<double> &U) {
+  int me = 0, mmax = aPb.m + 1, nmax = aPb.n, mnn = aPb.m + 2 * aPb.n;
+  int iout = 0, ifail = 0, iprint = 0;
+  int lwar = 3 * nmax * nmax / 2 + 10 * nmax + 2 * mmax + 20000;
+  int liwar = aPb.n;
+  double Eps = 1e-8;
+  vector<double> XL(aPb.n, -1e8), XU(aPb.n, 1e8), war(lwar);
+  vector<int> iwar(liwar);
+  X.assign(aPb.n, 0.0);
+  U.assign(mnn, 0.0);
+  iwar[0] = 1;
+  ql0001_(&aPb.m, &me, &mmax, &aPb.n, &nmax, &mnn, &aPb.Q[0], &aPb.D[0],
+          &aPb.A[0], &aPb.B[0], &XL[0], &XU[0], &X[0], &U[0], &iout, &ifail,
+          &iprint, &war[0], &lwar, &iwar[0], &liwar, &Eps);
+  return ifail;
+}
+
+int main(int, char *[]) {
+  srand(0);
+  QLDSolver aSolver(40, 16);
+  aSolver.SetPrintLevel(0);
+
+  unsigned int NbOfActiveProblems = 0;
+  for (unsigned int s = 0; s < 200; s++) {
+    // Every size up to the maximal one, the workspace is reused.
+    Problem aPb(1 + rand() % 40, 1 + rand() % 16);
+    vector<double> XRef, URef;
+    int ifailRef = SolveWithQL0001(aPb, XRef, URef);
+
+    Problem aCopy(aPb);
+    vector<double> X(aPb.n, 0.0);
+    int ifail = aSolver.Solve(aCopy.m, 0, aCopy.n, &aCopy.Q[0], aCopy.n,
+                              &aCopy.D[0], &aCopy.A[0], aCopy.m + 1,
+                              &aCopy.B[0], &X[0]);
+    if (ifail != ifailRef) {
+      cerr << "Problem " << s << ": IFAIL " << ifail << " instead of "
+           << ifailRef << endl;
+      return 1;
+    }
+    if (ifail != 0)
+      continue;
+
+    // Bit-compatible solution and multipliers.
+    Eigen::Map<const Eigen::VectorXd> U = aSolver.Multipliers();
+    if (U.size() != (int)URef.size()) {
+      cerr << "Problem " << s << ": wrong number of multipliers." << endl;
+      return 1;
+    }
+    for (int k = 0; k < aPb.n; k++)
+      if (X[k] != XRef[k]) {
+        cerr << "Problem " << s << ": the solution differs." << endl;
+        return 1;
+      }
+    for (unsigned int k = 0; k < URef.size(); k++)
+      if (U[k] != URef[k]) {
+        cerr << "Problem " << s << ": the multipliers differ." << endl;
+        return 1;
+      }
+
+    // The active constraints are saturated.
+    Eigen::Map<const Eigen::VectorXi> W = aSolver.ActiveSet();
+    for (int k = 0; k < W.size(); k++) {
+      int j = W[k];
+      if ((j >= aPb.m) || (URef[j] == 0.0)) {
+        cerr << "Problem " << s << ": wrong active set." << endl;
+        return 1;
+      }
+      double lValue = aPb.B[j];
+      for (int l = 0; l < aPb.n; l++)
+        lValue += aPb.A[j + l * (aPb.m + 1)] * X[l];
+      if (fabs(lValue) > 1e-6) {
+        cerr << "Problem " << s << ": constraint " << j
+             << " is not saturated " << lValue << endl;
+        return 1;
+      }
+    }
+    if (W.size() > 0)
+      NbOfActiveProblems++;
+  }
+  cout << NbOfActiveProblems << " problems with active constraints." << endl;
+  if (NbOfActiveProblems == 0) {
+    cerr << "No constraint has been activated." << endl;
+    return 1;
+  }
+
+  // A larger problem is refused instead of overflowing the workspace.
+  Problem aLargePb(41, 4);
+  vector<double> X(aLargePb.n);
+  if (aSolver.Solve(aLargePb.m, 0, aLargePb.n, &aLargePb.Q[0], aLargePb.n,
+                    &aLargePb.D[0], &aLargePb.A[0], aLargePb.m + 1,
+                    &aLargePb.B[0], &X[0]) != 5) {
+    cerr << "The workspace should be too small." << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestQPProblem.cpp
+  \brief Check that the terms written in place in a QPProblem give
+  the problem built by add_term_to. */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <iostream>
+
+#include <ZMPRefTrajectoryGeneration/qp-problem.hh>
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+
+/*! Terms of a problem with N invariant variables and NbSteps variant
+  ones, similar to the ones of GeneratorVelRef. */
+struct Terms {
+  unsigned int N, NbSteps;
+  Eigen::MatrixXd Q, QVariant, DU;
+  Eigen::VectorXd D, DS;
+
+  Terms(unsigned int lN, unsigned int lNbSteps) : N(lN), NbSteps(lNbSteps) {
+    Eigen::MatrixXd R = Eigen::MatrixXd::Random(N, N);
+    Q = R.transpose() * R + Eigen::MatrixXd::Identity(N, N);
+    QVariant = Eigen::MatrixXd::Identity(NbSteps, NbSteps);
+    DU = Eigen::MatrixXd::Random(3 * N, N + NbSteps);
+    D = Eigen::VectorXd::Random(N + NbSteps);
+    DS = Eigen::VectorXd::Constant(3 * N, 0.5);
+  }
+
+  void AddTo(QPProblem &Pb) const {
+    Pb.add_term_to(MATRIX_Q, QVariant, N, N);
+    Pb.add_term_to(MATRIX_DU, DU, 0, 0);
+    Pb.add_term_to(VECTOR_D, D, 0);
+    Pb.add_term_to(VECTOR_DS, DS, 0);
+  }
+
+  void WriteIn(QPProblem &Pb) const {
+    Pb.term(MATRIX_Q, N, N, NbSteps, NbSteps) += QVariant;
+    Pb.term(MATRIX_DU, 0, 0, 3 * N, N) += DU.leftCols(N);
+    Pb.term(MATRIX_DU, 0, N, 3 * N, NbSteps) += DU.rightCols(NbSteps);
+    Pb.term(VECTOR_D, 0, 0, N + NbSteps) += D;
+    Pb.term(VECTOR_DS, 0, 0, 3 * N) += DS;
+  }
+};
+
+bool SameSolutions(const solution_t &S1, const solution_t &S2) {
+  return (S1.Fail == S2.Fail) && (S1.Solution_vec == S2.Solution_vec) &&
+         (S1.ConstrLagr_vec == S2.ConstrLagr_vec);
+}
+
+int main(int, char *[]) {
+  srand(0);
+  unsigned int N = 8;
+
+  QPProblem PbCopy, PbInPlace;
+  PbInPlace.reserve(2 * N, 6 * N);
+  Terms Invariant(N, 0);
+  PbCopy.add_term_to(MATRIX_Q, Invariant.Q, 0, 0);
+  PbInPlace.term(MATRIX_Q, 0, 0, N, N) = Invariant.Q;
+  PbCopy.nbInvariantRows(N);
+  PbCopy.nbInvariantCols(N);
+  PbInPlace.nbInvariantRows(N);
+  PbInPlace.nbInvariantCols(N);
+
+  double *lDU = 0;
+  for (unsigned int k = 0; k < 20; k++) {
+    // The number of variant variables changes as the number of steps.
+    Terms aTerms(N, 1 + k % 3);
+    PbCopy.reset_variant();
+    PbInPlace.reset_variant();
+    aTerms.AddTo(PbCopy);
+    aTerms.WriteIn(PbInPlace);
+
+    if ((PbCopy.NbVariables() != PbInPlace.NbVariables()) ||
+        (PbCopy.NbConstraints() != PbInPlace.NbConstraints())) {
+      cerr << "Iteration " << k << ": wrong dimensions." << endl;
+      return 1;
+    }
+
+    // Within the reserved dimensions the terms do not move.
+    double *lCurrentDU = &PbInPlace.term(MATRIX_DU, 0, 0, 1, 1)(0, 0);
+    if ((lDU != 0) && (lDU != lCurrentDU)) {
+      cerr << "Iteration " << k << ": the problem has been reallocated."
+           << endl;
+      return 1;
+    }
+    lDU = lCurrentDU;
+
+    // Only the variant part of the hessian is dirty.
+    const QPProblem::dirty_t &lDirty = PbInPlace.dirty(MATRIX_Q);
+    if ((!lDirty.Dirty) || (k > 0 && lDirty.CleanLeadingSize != N) ||
+        (k > 0 && PbInPlace.dirty(MATRIX_DU).CleanLeadingSize != 0)) {
+      cerr << "Iteration " << k << ": wrong dirty elements of Q." << endl;
+      return 1;
+    }
+
+    solution_t SolCopy, SolInPlace;
+    PbCopy.solve(QLD, SolCopy);
+    PbInPlace.solve(QLD, SolInPlace);
+    if (!SameSolutions(SolCopy, SolInPlace)) {
+      cerr << "Iteration " << k << ": the solutions differ." << endl;
+      return 1;
+    }
+
+    // Objective at the solution.
+    unsigned int NbVariables = N + aTerms.NbSteps;
+    Eigen::MatrixXd Q = Eigen::MatrixXd::Zero(NbVariables, NbVariables);
+    Q.topLeftCorner(N, N) = Invariant.Q;
+    Q.bottomRightCorner(aTerms.NbSteps, aTerms.NbSteps) = aTerms.QVariant;
+    const Eigen::VectorXd &X = SolInPlace.Solution_vec;
+    double Cost = 0.5 * X.dot(Q * X) + aTerms.D.dot(X);
+    if (fabs(PbInPlace.cost(SolInPlace) - Cost) > 1e-9 * (1.0 + fabs(Cost))) {
+      cerr << "Iteration " << k << ": wrong cost." << endl;
+      return 1;
+    }
+
+    if (PbInPlace.dirty(MATRIX_Q).Dirty || PbInPlace.dirty(MATRIX_DU).Dirty) {
+      cerr << "Iteration " << k << ": dirty after the resolution." << endl;
+      return 1;
+    }
+  }
+  cout << "In place QP problem: ok" << endl;
+  return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestQPRecorder.cpp
+  \brief Check that the problems solved by a QPProblem are read back from
+  the ring file and solved again with the same solutions. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+#include <ZMPRefTrajectoryGeneration/qp-problem.hh>
+#include <ZMPRefTrajectoryGeneration/qp-recorder.hh>
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+
+/*! A random problem with a positive definite hessian,
+  feasible at the origin. */
+struct Problem {
+  Eigen::MatrixXd Q, DU;
+  Eigen::VectorXd D, DS;
+
+  Problem(unsigned int n, unsigned int m) {
+    Eigen::MatrixXd R = Eigen::MatrixXd::Random(n, n);
+    Q = R.transpose() * R + Eigen::MatrixXd::Identity(n, n);
+    DU = Eigen::MatrixXd::Random(m, n);
+    D = 4.0 * Eigen::VectorXd::Random(n);
+    DS = Eigen::VectorXd::Constant(m, 0.2);
+  }
+
+  void WriteIn(QPProblem &Pb) const {
+    Pb.reset();
+    Pb.add_term_to(MATRIX_Q, Q, 0, 0);
+    Pb.add_term_to(MATRIX_DU, DU, 0, 0);
+    Pb.add_term_to(VECTOR_D, D, 0);
+    Pb.add_term_to(VECTOR_DS, DS, 0);
+  }
+};
+
+int main(int, char *[]) {
+  string aFileName("TestQPRecorder.bin");
+  remove(aFileName.c_str());
+  srand(0);
+
+  const unsigned int NbSlots = 8, NbProblems = 12;
+  QPRecorder aRecorder;
+  if (!aRecorder.open(aFileName, NbSlots, 16, 40)) {
+    // Without mmap support there is nothing to check.
+    cout << "No memory-mapped files on this system." << endl;
+    return 0;
+  }
+
+  // The ring is overwritten by the last problems.
+  QPProblem aPb;
+  aPb.recorder(&aRecorder);
+  vector<Problem> Problems;
+  vector<solution_t> Solutions(NbProblems);
+  for (unsigned int k = 0; k < NbProblems; k++) {
+    Problems.push_back(Problem(6 + k % 3, 18));
+    Problems[k].WriteIn(aPb);
+    aRecorder.time(0.1 * k);
+    aPb.solve(QLD, Solutions[k]);
+  }
+  if ((aRecorder.nb_records() != NbSlots) || (aRecorder.nb_dropped() != 0)) {
+    cerr << "Wrong number of records " << aRecorder.nb_records() << endl;
+    return 1;
+  }
+
+  QPRecorder::record_t aRecord;
+  QPProblem aReplay;
+  unsigned int NbActive = 0;
+  for (unsigned int i = 0; i < NbSlots; i++) {
+    unsigned int k = NbProblems - NbSlots + i;
+    if (!aRecorder.read(i, aRecord) || (aRecord.Sequence != k + 1) ||
+        (aRecord.Time != 0.1 * k) || (aRecord.SolveTime < 0.0)) {
+      cerr << "Record " << i << " is not problem " << k << endl;
+      return 1;
+    }
+    const Problem &P = Problems[k];
+    if ((aRecord.Q != P.Q) || (aRecord.D != P.D) || (aRecord.DU != P.DU) ||
+        (aRecord.DS != P.DS) || (aRecord.Solver != QLD) ||
+        aRecord.WarmStart || (aRecord.XL.maxCoeff() != -1e8) ||
+        (aRecord.XU.minCoeff() != 1e8)) {
+      cerr << "Record " << i << ": the problem differs." << endl;
+      return 1;
+    }
+    const solution_t &S = Solutions[k];
+    if ((aRecord.Fail != S.Fail) || (aRecord.X != S.Solution_vec) ||
+        (aRecord.ConstrLagr != S.ConstrLagr_vec.tail(P.DS.size()))) {
+      cerr << "Record " << i << ": the result differs." << endl;
+      return 1;
+    }
+    if (aRecord.ConstrLagr.lpNorm<Eigen::Infinity>() > 0.0)
+      NbActive++;
+
+    // The problem built from the record is the one which was solved.
+    solution_t aSolution;
+    QPRecorder::load_problem(aRecord, aReplay);
+    aReplay.solve(QLD, aSolution);
+    if ((aSolution.Fail != aRecord.Fail) ||
+        (aSolution.Solution_vec != aRecord.X)) {
+      cerr << "Record " << i << ": the replay differs." << endl;
+      return 1;
+    }
+  }
+  if (NbActive == 0) {
+    cerr << "No constraint has been activated." << endl;
+    return 1;
+  }
+
+  // A problem larger than the slots is not recorded.
+  Problem aLargePb(20, 4);
+  solution_t aLargeSolution;
+  aLargePb.WriteIn(aPb);
+  aPb.solve(QLD, aLargeSolution);
+  if ((aRecorder.nb_dropped() != 1) || !aRecorder.read(NbSlots - 1, aRecord) ||
+      (aRecord.Sequence != NbProblems)) {
+    cerr << "The large problem has not been dropped." << endl;
+    return 1;
+  }
+  aRecorder.close();
+
+  // The file is read by another process.
+  QPRecorder aReader;
+  if (!aReader.open(aFileName) || (aReader.nb_records() != NbSlots) ||
+      !aReader.read(0, aRecord) ||
+      (aRecord.Sequence != NbProblems - NbSlots + 1)) {
+    cerr << "The records have not been kept on disk." << endl;
+    return 1;
+  }
+  aReader.close();
+
+  // The recording goes on in a file with the same dimensions.
+  if (!aRecorder.open(aFileName, NbSlots, 16, 40) ||
+      (aRecorder.nb_records() != NbSlots) || (aRecorder.nb_dropped() != 1)) {
+    cerr << "The ring has not been kept." << endl;
+    return 1;
+  }
+  if (!aRecorder.open(aFileName, 2 * NbSlots, 16, 40) ||
+      (aRecorder.nb_records() != 0)) {
+    cerr << "The ring has not been reset." << endl;
+    return 1;
+  }
+  aRecorder.close();
+  remove(aFileName.c_str());
+
+  cout << "QP recorder: ok" << endl;
+  return 0;
+}
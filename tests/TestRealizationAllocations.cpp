@@ -0,0 +1,148 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestRealizationAllocations.cpp
+  \brief Check that ComputePostureForGivenCoMAndFeetPosture does not
+  allocate memory once the realization is initialized. */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <new>
+
+#include "CommonTools.hh"
+#include "TestObject.hh"
+
+using namespace ::PatternGeneratorJRL;
+using namespace ::PatternGeneratorJRL::TestSuite;
+using namespace std;
+
+/*! Number of allocations while CountAllocations is true. */
+static bool CountAllocations = false;
+static unsigned long NbAllocations = 0;
+
+/* Eigen allocates with malloc: with the GNU C library the allocation
+   functions of the libraries are replaced by counting ones. Elsewhere
+   only the operator new is counted. */
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+  if (CountAllocations)
+    NbAllocations++;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+  if (CountAllocations)
+    NbAllocations++;
+  return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  if (CountAllocations)
+    NbAllocations++;
+  return __libc_realloc(ptr, size);
+}
+}
+#else
+void *operator new(size_t size) {
+  if (CountAllocations)
+    NbAllocations++;
+  void *p = malloc(size == 0 ? 1 : size);
+  if (p == 0)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) throw() { free(p); }
+#endif
+
+class TestRealizationAllocations : public TestObject {
+public:
+  TestRealizationAllocations(int argc, char *argv[], string &aString)
+      : TestObject(argc, argv, aString) {}
+
+  /*! Realize the postures of a swaying CoM for the 3 stages,
+    and count the allocations after the first iterations. */
+  bool doTest(ostream &os) {
+    Eigen::Vector3d lStartingCOMPosition;
+    Eigen::Matrix<double, 6, 1> lStartingWaistPose;
+    FootAbsolutePosition InitLeftFoot, InitRightFoot;
+    m_ComAndFootRealization->InitializationCoM(
+        m_HalfSitting, lStartingCOMPosition, lStartingWaistPose, InitLeftFoot,
+        InitRightFoot);
+
+    Eigen::VectorXd CoMPosition(6), CoMSpeed(6), CoMAcc(6);
+    Eigen::VectorXd LeftFoot(5), RightFoot(5);
+    CoMPosition.setZero();
+    CoMSpeed.setZero();
+    CoMAcc.setZero();
+    LeftFoot << InitLeftFoot.x, InitLeftFoot.y, InitLeftFoot.z,
+        InitLeftFoot.theta, InitLeftFoot.omega;
+    RightFoot << InitRightFoot.x, InitRightFoot.y, InitRightFoot.z,
+        InitRightFoot.theta, InitRightFoot.omega;
+
+    const unsigned long NbWarmUps = 3, NbIterations = 600;
+    for (unsigned long k = 0; k < NbWarmUps + NbIterations; k++) {
+      double t = 0.005 * (double)k;
+      for (unsigned int i = 0; i < 3; i++)
+        CoMPosition(i) = lStartingCOMPosition(i);
+      CoMPosition(1) += 0.05 * sin(2.0 * M_PI * t);
+      CoMPosition(5) = 5.0 * sin(M_PI * t);
+      CoMSpeed(1) = 0.1 * M_PI * cos(2.0 * M_PI * t);
+
+      CountAllocations = (k >= NbWarmUps);
+      for (int Stage = 0; Stage < 3; Stage++)
+        m_ComAndFootRealization->ComputePostureForGivenCoMAndFeetPosture(
+            CoMPosition, CoMSpeed, CoMAcc, LeftFoot, RightFoot,
+            m_CurrentConfiguration, m_CurrentVelocity, m_CurrentAcceleration,
+            k, Stage);
+      CountAllocations = false;
+    }
+
+    os << NbAllocations << " allocations in " << 3 * NbIterations
+       << " postures" << endl;
+    return NbAllocations == 0;
+  }
+
+protected:
+  void chooseTestProfile() {}
+  void generateEvent() {}
+};
+
+int main(int argc, char *argv[]) {
+  string TestName("TestRealizationAllocations");
+  try {
+    TestRealizationAllocations aTest(argc, argv, TestName);
+    if (!aTest.init())
+      return 1;
+    if (!aTest.doTest(std::cout)) {
+      cerr << "The realization of the postures allocates memory." << endl;
+      return 1;
+    }
+  } catch (const std::string &msg) {
+    std::cerr << msg << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestRiccatiQPSolver.cpp
+  \brief Compare the sparse formulation solved by RiccatiQPSolver with
+  the condensed one solved by QLD, for several lengths of the horizon. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <iostream>
+#include <vector>
+
+#include "portability/gettimeofday.hh"
+
+#include <Mathematics/QLDSolver.hh>
+#include <Mathematics/RiccatiQPSolver.hh>
+
+#include "CommonTools.hh"
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+using namespace PatternGeneratorJRL::TestSuite;
+
+/*! Walking problem of the velocity reference generator with the states
+  [c_x dc_x ddc_x c_y dc_y ddc_y p_x p_y], p being the support foot,
+  and the controls [jerk_x jerk_y] with the new foot at each step. */
+void BuildWalkingProblem(unsigned int N, RiccatiQPSolver &Pb) {
+  const double T = 0.1, hg = 0.814 / 9.81, Yaw = 0.1;
+  // The jerks are weighted enough for the minimizer to be well defined,
+  // with a lighter weight the cost is nearly flat along them.
+  const double VelWeight = 1.0, CoPWeight = 1e-6, JerkWeight = 1e-4;
+  const double RefX = 0.2;
+  const unsigned int StepSamples = 8, FirstStep = 3;
+
+  Pb.Resize(N, 8);
+  for (unsigned int k = 0; k <= N; k++) {
+    unsigned int NbControls = (k < N) ? 2 : 0;
+    unsigned int NbConstraints = (k > 0) ? 4 : 0;
+    // The step starting at k + 1 is chosen at stage k.
+    bool Step = (k + 1 < N + 1) && (k + 1 >= FirstStep) &&
+                ((k + 1 - FirstStep) % StepSamples == 0);
+    if (Step) {
+      NbControls += 2;
+      NbConstraints += 4;
+    }
+    Pb.ResizeStage(k, NbControls, NbConstraints);
+    RiccatiQPSolver::stage_t &s = Pb.Stage(k);
+
+    // CoM dynamics and support foot.
+    if (k < N) {
+      for (unsigned int a = 0; a < 2; a++) {
+        unsigned int o = 3 * a;
+        s.A(o, o) = s.A(o + 1, o + 1) = s.A(o + 2, o + 2) = 1.0;
+        s.A(o, o + 1) = s.A(o + 1, o + 2) = T;
+        s.A(o, o + 2) = T * T / 2;
+        s.B(o, a) = T * T * T / 6;
+        s.B(o + 1, a) = T * T / 2;
+        s.B(o + 2, a) = T;
+        if (Step)
+          s.B(6 + a, 2 + a) = 1.0;
+        else
+          s.A(6 + a, 6 + a) = 1.0;
+      }
+      s.R(0, 0) = s.R(1, 1) = JerkWeight;
+    }
+
+    // Velocity tracking and CoP centering, CoP in the support foot.
+    if (k > 0) {
+      for (unsigned int a = 0; a < 2; a++) {
+        unsigned int o = 3 * a;
+        s.Q(o + 1, o + 1) += VelWeight;
+        s.q(o + 1) = -VelWeight * ((a == 0) ? RefX : 0.0);
+        Eigen::VectorXd e = Eigen::VectorXd::Zero(8);
+        e(o) = 1.0;
+        e(o + 2) = -hg;
+        e(6 + a) = -1.0;
+        s.Q += CoPWeight * e * e.transpose();
+      }
+      // |R(-Yaw) (z - p)| <= (0.1, 0.05)
+      double Bounds[2] = {0.1, 0.05};
+      for (unsigned int j = 0; j < 4; j++) {
+        double sgn = (j % 2 == 0) ? 1.0 : -1.0;
+        double ax = (j < 2) ? cos(Yaw) : -sin(Yaw);
+        double ay = (j < 2) ? sin(Yaw) : cos(Yaw);
+        s.C(j, 0) = sgn * ax;
+        s.C(j, 2) = -sgn * ax * hg;
+        s.C(j, 3) = sgn * ay;
+        s.C(j, 5) = -sgn * ay * hg;
+        s.C(j, 6) = -sgn * ax;
+        s.C(j, 7) = -sgn * ay;
+        s.d(j) = Bounds[j / 2];
+      }
+    }
+
+    // The new foot is placed relatively to the support one.
+    if (Step) {
+      unsigned int r = NbConstraints - 4;
+      unsigned int StepIndex = (k + 1 - FirstStep) / StepSamples;
+      // The support foot is the left one, the first step is on the right.
+      double Side = (StepIndex % 2 == 0) ? -1.0 : 1.0;
+      // -0.3 <= qx - px <= 0.3, 0.15 <= side (qy - py) <= 0.3
+      s.D(r, 2) = 1.0;
+      s.C(r, 6) = -1.0;
+      s.d(r) = 0.3;
+      s.D(r + 1, 2) = -1.0;
+      s.C(r + 1, 6) = 1.0;
+      s.d(r + 1) = 0.3;
+      s.D(r + 2, 3) = Side;
+      s.C(r + 2, 7) = -Side;
+      s.d(r + 2) = 0.3;
+      s.D(r + 3, 3) = -Side;
+      s.C(r + 3, 7) = Side;
+      s.d(r + 3) = -0.15;
+      // Keep the foot away from infinity if no cost reaches it.
+      s.R(2, 2) = s.R(3, 3) = 1e-8;
+    }
+  }
+}
+
+/*! Condensed problem: the states are eliminated, the variables are the
+  controls of all the stages, then the problem is solved by QLD. */
+struct Condensed {
+  unsigned int n, m;
+  Eigen::MatrixXd H, A;
+  Eigen::VectorXd f, b, X;
+  /*! Part of the cost which does not depend on the controls. */
+  double c;
+  vector<unsigned int> Offsets;
+
+  void Build(const RiccatiQPSolver &Pb, const Eigen::VectorXd &x0) {
+    unsigned int N = Pb.NbStages(), nx = Pb.NbStates();
+    Offsets.resize(N + 1);
+    n = 0;
+    m = 0;
+    for (unsigned int k = 0; k <= N; k++) {
+      Offsets[k] = n;
+      n += (unsigned int)Pb.Stage(k).r.size();
+      m += (unsigned int)Pb.Stage(k).d.size();
+    }
+    H.setZero(n, n);
+    f.setZero(n);
+    A.setZero(m + 1, n);
+    b.setZero(m + 1);
+    X.setZero(n);
+    c = 0.0;
+
+    // x_k = Gx U + hx
+    Eigen::MatrixXd Gx = Eigen::MatrixXd::Zero(nx, n);
+    Eigen::VectorXd hx = x0;
+    unsigned int Row = 0;
+    for (unsigned int k = 0; k <= N; k++) {
+      const RiccatiQPSolver::stage_t &s = Pb.Stage(k);
+      unsigned int nu = (unsigned int)s.r.size(), nc = (unsigned int)s.d.size();
+      Eigen::MatrixXd Gu = Eigen::MatrixXd::Zero(nu, n);
+      Gu.block(0, Offsets[k], nu, nu).setIdentity();
+
+      H += Gx.transpose() * s.Q * Gx;
+      f += Gx.transpose() * (s.Q * hx + s.q);
+      c += 0.5 * hx.dot(s.Q * hx) + s.q.dot(hx);
+      if (nu > 0) {
+        H += Gu.transpose() * s.R * Gu;
+        H += Gu.transpose() * s.S * Gx + Gx.transpose() * s.S.transpose() * Gu;
+        f += Gu.transpose() * (s.S * hx + s.r);
+      }
+      // d - C x - D u >= 0
+      A.block(Row, 0, nc, n) = -s.C * Gx;
+      if (nu > 0)
+        A.block(Row, 0, nc, n) -= s.D * Gu;
+      b.segment(Row, nc) = s.d - s.C * hx;
+      Row += nc;
+
+      if (k < N) {
+        Gx = s.A * Gx + s.B * Gu;
+        hx = s.A * hx + s.b;
+      }
+    }
+  }
+};
+
+int main(int, char *[]) {
+  unsigned int Horizons[4] = {16, 32, 64, 128};
+  QLDSolver aQLD;
+  aQLD.SetPrintLevel(0);
+  aQLD.SetEps(1e-12);
+  RiccatiQPSolver aRiccati;
+
+  Eigen::VectorXd x0 = Eigen::VectorXd::Zero(8);
+  x0(4) = 0.05; // lateral velocity
+  x0(7) = 0.1;  // support foot
+
+  printf("%8s %14s %14s %10s %12s\n", "N", "condensed (s)", "sparse (s)",
+         "iterations", "difference");
+  for (unsigned int h = 0; h < 4; h++) {
+    unsigned int N = Horizons[h];
+    BuildWalkingProblem(N, aRiccati);
+    Condensed aPb;
+    aPb.Build(aRiccati, x0);
+    aQLD.Reserve(aPb.m, aPb.n);
+
+    unsigned int NbRepeats = 1 + 256 / N;
+    struct timeval begin, end;
+
+    // The hessian is modified by QLD, it is copied at each resolution.
+    Eigen::MatrixXd Hessian;
+    int ifail = 0;
+    gettimeofday(&begin, 0);
+    for (unsigned int r = 0; r < NbRepeats; r++) {
+      Hessian = aPb.H;
+      Eigen::MatrixXd Constraints = aPb.A;
+      Eigen::VectorXd Linear = aPb.f, Constant = aPb.b;
+      ifail = aQLD.Solve(aPb.m, 0, aPb.n, Hessian.data(), aPb.n,
+                         Linear.data(), Constraints.data(), aPb.m + 1,
+                         Constant.data(), aPb.X.data());
+    }
+    gettimeofday(&end, 0);
+    double CondensedTime = Time(begin, end) / NbRepeats;
+    if (ifail != 0) {
+      cerr << "N = " << N << ": QLD failed " << ifail << endl;
+      return 1;
+    }
+
+    int Status = 0;
+    gettimeofday(&begin, 0);
+    for (unsigned int r = 0; r < NbRepeats; r++)
+      Status = aRiccati.Solve(x0);
+    gettimeofday(&end, 0);
+    double SparseTime = Time(begin, end) / NbRepeats;
+    if (Status != 0) {
+      cerr << "N = " << N << ": the Riccati solver failed " << Status << endl;
+      return 1;
+    }
+
+    // The minimizer is unique, the trajectories are compared.
+    double Difference = 0.0;
+    Eigen::VectorXd x = x0;
+    for (unsigned int k = 0; k < N; k++) {
+      const RiccatiQPSolver::stage_t &s = aRiccati.Stage(k);
+      x = s.A * x + s.B * aPb.X.segment(aPb.Offsets[k], s.r.size()) + s.b;
+      Difference = max(Difference,
+                       (x - aRiccati.State(k + 1)).lpNorm<Eigen::Infinity>());
+    }
+    double CondensedCost =
+        0.5 * aPb.X.dot(aPb.H * aPb.X) + aPb.f.dot(aPb.X) + aPb.c;
+    printf("%8u %14.6f %14.6f %10u %12.3e\n", N, CondensedTime, SparseTime,
+           aRiccati.NbIterations(), Difference);
+
+    if ((Difference > 1e-5) ||
+        (fabs(aRiccati.Cost() - CondensedCost) >
+         1e-6 * (1.0 + fabs(CondensedCost)))) {
+      cerr << "N = " << N << ": the formulations give different solutions."
+           << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
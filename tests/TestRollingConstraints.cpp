@@ -0,0 +1,151 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestRollingConstraints.cpp
+  \brief Compare the constraint matrices of ZMPConstrainedQPFastFormulation
+  whose rows are kept from one tick to the next with the matrices
+  rebuilt at each tick, along a sequence of support phases. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <deque>
+#include <iostream>
+
+#include <jrl/walkgen/pinocchiorobot.hh>
+
+#include <ZMPRefTrajectoryGeneration/ZMPConstrainedQPFastFormulation.hh>
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+
+/*! Support polygon with \a NbOfRows edges over [Start, End]. */
+LinearConstraintInequality_t *Polygon(unsigned int NbOfRows, double Start,
+                                      double End, double x, double y) {
+  LinearConstraintInequality_t *aLCI = new LinearConstraintInequality_t;
+  aLCI->A.resize(NbOfRows, 2);
+  aLCI->B.resize(NbOfRows, 1);
+  aLCI->SimilarConstraints.assign(NbOfRows, 0);
+  for (unsigned int j = 0; j < NbOfRows; j++) {
+    double Angle = 2.0 * M_PI * j / NbOfRows;
+    aLCI->A(j, 0) = -cos(Angle);
+    aLCI->A(j, 1) = -sin(Angle);
+    aLCI->B(j, 0) = 0.05 + cos(Angle) * x + sin(Angle) * y;
+  }
+  aLCI->Center.resize(2);
+  aLCI->Center << x, y;
+  aLCI->StartingTime = Start;
+  aLCI->EndingTime = End;
+  return aLCI;
+}
+
+int main(int, char *[]) {
+  pinocchio::Model aModel;
+  pinocchio::urdf::buildModel(URDF_FULL_PATH, pinocchio::JointModelFreeFlyer(),
+                              aModel);
+  pinocchio::Data aData(aModel);
+  PinocchioRobot aPR;
+  if (!aPR.initializeRobotModelAndData(&aModel, &aData)) {
+    cerr << "The robot cannot be initialized." << endl;
+    return 1;
+  }
+  SimplePluginManager aSPM;
+  ZMPConstrainedQPFastFormulation Rolling(&aSPM, "", &aPR),
+      Rebuilt(&aSPM, "", &aPR);
+
+  // Single supports of 0.7 s (square) and double supports of 0.2 s
+  // (hexagon): the number of constraints of the horizon changes
+  // with the double supports it covers.
+  const double T = 0.1;
+  const unsigned int N = 16;
+  deque<LinearConstraintInequality_t *> QueueOfLConstraintInequalities;
+  double Time = 0.0;
+  for (unsigned int s = 0; s < 10; s++) {
+    double x = 0.2 * s, y = (s % 2 == 0) ? 0.1 : -0.1;
+    QueueOfLConstraintInequalities.push_back(
+        Polygon(4, Time, Time + 0.7, x, y));
+    QueueOfLConstraintInequalities.push_back(
+        Polygon(6, Time + 0.7, Time + 0.9, x + 0.1, 0.0));
+    Time += 0.9;
+  }
+
+  // The rebuilt matrices alternate between two buffers,
+  // so that none of their rows is kept.
+  double *DPx = 0, *DPu = 0, *RebuiltDPx[2] = {0, 0}, *RebuiltDPu[2] = {0, 0};
+  Eigen::VectorXd xk(6), ZMPRef(2 * N), RebuiltZMPRef(2 * N);
+  xk << 0.01, 0.1, 0.0, 0.1, -0.05, 0.0;
+  unsigned int NbOfTicks = 0, NbOfKeptTicks = 0, PreviousNbOfConstraints = 0;
+  for (double StartingTime = 0.0; StartingTime < Time - (N + 1) * T;
+       StartingTime += T, NbOfTicks++) {
+    unsigned int NbOfConstraints = 0, RebuiltNbOfConstraints = 0,
+                 NbOfRemovedConstraints = 0, RebuiltNbOfRemovedConstraints = 0;
+    double *&lDPx = RebuiltDPx[NbOfTicks % 2];
+    double *&lDPu = RebuiltDPu[NbOfTicks % 2];
+    if ((Rolling.BuildConstraintMatrices(
+             DPx, DPu, N, T, StartingTime, QueueOfLConstraintInequalities,
+             0.8, NbOfConstraints, xk, ZMPRef, NbOfRemovedConstraints) < 0) ||
+        (Rebuilt.BuildConstraintMatrices(
+             lDPx, lDPu, N, T, StartingTime, QueueOfLConstraintInequalities,
+             0.8, RebuiltNbOfConstraints, xk, RebuiltZMPRef,
+             RebuiltNbOfRemovedConstraints) < 0)) {
+      cerr << "No constraint at time " << StartingTime << endl;
+      return 1;
+    }
+    if ((NbOfConstraints != RebuiltNbOfConstraints) ||
+        (NbOfRemovedConstraints != RebuiltNbOfRemovedConstraints) ||
+        (ZMPRef != RebuiltZMPRef)) {
+      cerr << "Different constraints at time " << StartingTime << endl;
+      return 1;
+    }
+    for (unsigned int i = 0; i < NbOfConstraints; i++) {
+      bool Same = (DPx[i] == lDPx[i]);
+      for (unsigned int k = 0; k < 2 * N; k++)
+        Same = Same && (DPu[i + k * (NbOfConstraints + 1)] ==
+                        lDPu[i + k * (NbOfConstraints + 1)]);
+      if (!Same) {
+        cerr << "Row " << i << " differs at time " << StartingTime << endl;
+        return 1;
+      }
+    }
+    if (Rolling.ValidationRollingConstraints(DPu, N, StartingTime, T,
+                                             QueueOfLConstraintInequalities,
+                                             NbOfConstraints) < 0)
+      return 1;
+    if ((NbOfTicks > 0) && (NbOfConstraints == PreviousNbOfConstraints))
+      NbOfKeptTicks++;
+    PreviousNbOfConstraints = NbOfConstraints;
+  }
+
+  printf("%u ticks, %u with rows kept from the previous one\n", NbOfTicks,
+         NbOfKeptTicks);
+  for (unsigned int i = 0; i < 2; i++) {
+    delete[] RebuiltDPx[i];
+    delete[] RebuiltDPu[i];
+  }
+  delete[] DPx;
+  delete[] DPu;
+  for (unsigned int i = 0; i < QueueOfLConstraintInequalities.size(); i++)
+    delete QueueOfLConstraintInequalities[i];
+  // Both the kept rows and the changes of the number of constraints
+  // have been exercised.
+  if ((NbOfKeptTicks == 0) || (NbOfKeptTicks + 1 == NbOfTicks)) {
+    cerr << "The rolling buffer has not been exercised." << endl;
+    return 1;
+  }
+  return 0;
+}
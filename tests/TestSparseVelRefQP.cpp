@@ -0,0 +1,173 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestSparseVelRefQP.cpp
+  \brief Check that the sparse formulation of the velocity referenced
+  walking problem gives the solution of the condensed formulation,
+  with the problems built by GeneratorVelRef. */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+
+#include "CommonTools.hh"
+#include "TestObject.hh"
+
+#include <SimplePluginManager.hh>
+#include <ZMPRefTrajectoryGeneration/ZMPVelocityReferencedQP.hh>
+
+using namespace ::PatternGeneratorJRL;
+using namespace ::PatternGeneratorJRL::TestSuite;
+using namespace std;
+
+/*! A velocity referenced generator and its trajectories. */
+struct Generator {
+  SimplePluginManager SPM;
+  ZMPVelocityReferencedQP *QP;
+  deque<ZMPPosition> ZMPTraj;
+  deque<COMState> COMTraj;
+  deque<FootAbsolutePosition> LeftFootTraj, RightFootTraj;
+
+  Generator(PinocchioRobot *aPR, qp_formulation_e Formulation) {
+    QP = new ZMPVelocityReferencedQP(&SPM, "", aPR);
+    QP->SetTimeWindowPreviewControl(1.6);
+    QP->QPFormulation(Formulation);
+
+    COMState lStartingCOMState;
+    memset(&lStartingCOMState, 0, sizeof(COMState));
+    lStartingCOMState.z[0] = 0.814;
+    Eigen::Vector3d lStartingZMPPosition = Eigen::Vector3d::Zero();
+    FootAbsolutePosition InitLeftFootAbsPos, InitRightFootAbsPos;
+    memset(&InitLeftFootAbsPos, 0, sizeof(InitLeftFootAbsPos));
+    memset(&InitRightFootAbsPos, 0, sizeof(InitRightFootAbsPos));
+    InitLeftFootAbsPos.y = 0.095;
+    InitRightFootAbsPos.y = -0.095;
+    deque<RelativeFootPosition> RelativeFootPositions;
+
+    QP->SetCurrentTime(0.0);
+    QP->InitOnLine(ZMPTraj, COMTraj, LeftFootTraj, RightFootTraj,
+                   InitLeftFootAbsPos, InitRightFootAbsPos,
+                   RelativeFootPositions, lStartingCOMState,
+                   lStartingZMPPosition);
+    QP->Reference(0.2, 0.0, 0.1);
+  }
+
+  ~Generator() { delete QP; }
+
+  /*! One step of the control loop, which consumes the first samples
+    of the trajectories. */
+  void OnLine(double time) {
+    QP->OnLine(time, ZMPTraj, COMTraj, LeftFootTraj, RightFootTraj);
+    ZMPTraj.pop_front();
+    COMTraj.pop_front();
+    LeftFootTraj.pop_front();
+    RightFootTraj.pop_front();
+  }
+};
+
+class TestSparseVelRefQP : public TestObject {
+public:
+  TestSparseVelRefQP(int argc, char *argv[], string &aString)
+      : TestObject(argc, argv, aString) {}
+
+  /*! Walk with both formulations and compare their solutions at each
+    resolution.
+    \return false if they differ. */
+  bool compare() {
+    Generator Condensed(m_PR, CONDENSED_QP);
+    Generator Sparse(m_DebugPR, SPARSE_QP);
+    const unsigned int N = (unsigned int)Condensed.QP->QP_N();
+    const double T = 0.1;
+
+    unsigned int NbResolutions = 0, NbResolutionsWithSteps = 0;
+    double MaxFeetDifference = 0.0, MaxCoMDifference = 0.0;
+    for (unsigned int k = 0; k < 400; k++) {
+      double time = 0.005 * k;
+      Condensed.OnLine(time);
+      Sparse.OnLine(time);
+      if (k % 20 != 0)
+        continue;
+
+      // A new problem has been solved.
+      const solution_t &a = Condensed.QP->Solution();
+      const solution_t &b = Sparse.QP->Solution();
+      NbResolutions++;
+      if ((a.Fail != 0) || (b.Fail != 0) ||
+          (a.Solution_vec.size() != b.Solution_vec.size())) {
+        cerr << "t = " << time << ": the resolutions failed " << a.Fail << " "
+             << b.Fail << " or have different sizes." << endl;
+        return false;
+      }
+
+      // Previewed feet, placed by the foot rows of the sparse problem.
+      unsigned int n = (unsigned int)a.Solution_vec.size();
+      if (n > 2 * N)
+        NbResolutionsWithSteps++;
+      for (unsigned int i = 2 * N; i < n; i++)
+        MaxFeetDifference =
+            max(MaxFeetDifference, fabs(a.Solution_vec(i) - b.Solution_vec(i)));
+
+      // The cost is flat along the jerks, the CoM trajectories they
+      // give from the same state are compared.
+      for (unsigned int Axis = 0; Axis < 2; Axis++) {
+        Eigen::Vector3d dx = Eigen::Vector3d::Zero();
+        for (unsigned int i = 0; i < N; i++) {
+          double dj =
+              a.Solution_vec(Axis * N + i) - b.Solution_vec(Axis * N + i);
+          dx(0) += T * dx(1) + T * T / 2 * dx(2) + T * T * T / 6 * dj;
+          dx(1) += T * dx(2) + T * T / 2 * dj;
+          dx(2) += T * dj;
+          MaxCoMDifference = max(MaxCoMDifference, fabs(dx(0)));
+        }
+      }
+    }
+
+    printf("%u resolutions, %u with steps: largest difference of the feet "
+           "%.3e, of the CoM %.3e\n",
+           NbResolutions, NbResolutionsWithSteps, MaxFeetDifference,
+           MaxCoMDifference);
+    if (NbResolutionsWithSteps == 0) {
+      cerr << "No step has been previewed." << endl;
+      return false;
+    }
+    if ((MaxFeetDifference > 1e-4) || (MaxCoMDifference > 1e-4)) {
+      cerr << "The formulations give different solutions." << endl;
+      return false;
+    }
+    return true;
+  }
+
+protected:
+  void chooseTestProfile() {}
+  void generateEvent() {}
+};
+
+int main(int argc, char *argv[]) {
+  string aName("TestSparseVelRefQP");
+  try {
+    TestSparseVelRefQP aTest(argc, argv, aName);
+    if (!aTest.init() || !aTest.compare())
+      return 1;
+  } catch (const std::string &msg) {
+    std::cerr << msg << std::endl;
+    return 1;
+  }
+  return 0;
+}
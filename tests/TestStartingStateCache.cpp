@@ -0,0 +1,132 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestStartingStateCache.cpp
+  \brief Check that the starting state found in the cache of
+  InitializationCoM is the one given by the forward kinematics. */
+
+#include <stdio.h>
+
+#include <iostream>
+
+#include "portability/gettimeofday.hh"
+
+#include "CommonTools.hh"
+#include "TestObject.hh"
+
+using namespace ::PatternGeneratorJRL;
+using namespace ::PatternGeneratorJRL::TestSuite;
+using namespace std;
+
+/*! Outputs and internal state of InitializationCoM. */
+struct StartingState {
+  Eigen::Vector3d CoM, COGInitialAnkles;
+  Eigen::Matrix<double, 6, 1> WaistPose;
+  FootAbsolutePosition LeftFoot, RightFoot;
+  Eigen::Matrix4d WaistInCoMFrame;
+  Eigen::VectorXd Configuration;
+
+  void Evaluate(ComAndFootRealizationByGeometry &aCFR, Eigen::VectorXd &q) {
+    aCFR.InitializationCoM(q, CoM, WaistPose, LeftFoot, RightFoot);
+    COGInitialAnkles = aCFR.GetCOGInitialAnkles();
+    WaistInCoMFrame = aCFR.GetCurrentPositionofWaistInCOMFrame();
+    Configuration = aCFR.getPinocchioRobot()->currentRPYConfiguration();
+  }
+
+  bool operator==(const StartingState &S) const {
+    return (CoM == S.CoM) && (COGInitialAnkles == S.COGInitialAnkles) &&
+           (WaistPose == S.WaistPose) && (LeftFoot.x == S.LeftFoot.x) &&
+           (LeftFoot.y == S.LeftFoot.y) && (LeftFoot.z == S.LeftFoot.z) &&
+           (LeftFoot.theta == S.LeftFoot.theta) &&
+           (LeftFoot.omega == S.LeftFoot.omega) &&
+           (RightFoot.x == S.RightFoot.x) && (RightFoot.y == S.RightFoot.y) &&
+           (RightFoot.z == S.RightFoot.z) &&
+           (RightFoot.theta == S.RightFoot.theta) &&
+           (RightFoot.omega == S.RightFoot.omega) &&
+           (WaistInCoMFrame == S.WaistInCoMFrame) &&
+           (Configuration == S.Configuration);
+  }
+};
+
+class TestStartingStateCache : public TestObject {
+public:
+  TestStartingStateCache(int argc, char *argv[], string &aString)
+      : TestObject(argc, argv, aString) {}
+
+  bool doTest(ostream &os) {
+    ComAndFootRealizationByGeometry &aCFR = *m_ComAndFootRealization;
+    // The last joint is in the upper body: the feet stay flat.
+    Eigen::VectorXd HalfSitting = m_HalfSitting, Moved = m_HalfSitting;
+    Moved(Moved.size() - 1) += 0.1;
+
+    // Reference given by the forward kinematics.
+    StartingState Reference, MovedReference, Cached;
+    aCFR.StartingStateCache(false);
+    Reference.Evaluate(aCFR, HalfSitting);
+    MovedReference.Evaluate(aCFR, Moved);
+
+    // The second evaluations are found in the cache.
+    aCFR.StartingStateCache(true);
+    Cached.Evaluate(aCFR, HalfSitting);
+    Cached.Evaluate(aCFR, Moved);
+    Cached.Evaluate(aCFR, HalfSitting);
+    if (!(Cached == Reference)) {
+      os << "The cached half-sitting state differs." << endl;
+      return false;
+    }
+    Cached.Evaluate(aCFR, Moved);
+    if (!(Cached == MovedReference) || (Cached == Reference)) {
+      os << "The cached moved state differs." << endl;
+      return false;
+    }
+
+    const unsigned int NbRestarts = 200;
+    double Times[2];
+    struct timeval begin, end;
+    for (unsigned int c = 0; c < 2; c++) {
+      aCFR.StartingStateCache(c == 1);
+      gettimeofday(&begin, 0);
+      for (unsigned int k = 0; k < NbRestarts; k++)
+        Cached.Evaluate(aCFR, HalfSitting);
+      gettimeofday(&end, 0);
+      Times[c] = Time(begin, end);
+    }
+    printf("time per restart (us): forward kinematics %.3f, cache %.3f\n",
+           1e6 * Times[0] / NbRestarts, 1e6 * Times[1] / NbRestarts);
+    return Cached == Reference;
+  }
+
+protected:
+  void chooseTestProfile() {}
+  void generateEvent() {}
+};
+
+int main(int argc, char *argv[]) {
+  string TestName("TestStartingStateCache");
+  try {
+    TestStartingStateCache aTest(argc, argv, TestName);
+    if (!aTest.init())
+      return 1;
+    if (!aTest.doTest(std::cerr))
+      return 1;
+  } catch (const std::string &msg) {
+    std::cerr << msg << std::endl;
+    return 1;
+  }
+  return 0;
+}
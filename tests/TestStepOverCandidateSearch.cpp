@@ -0,0 +1,167 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestStepOverCandidateSearch.cpp
+  \brief Compare the parallel candidate search of the step over planner
+  with the search in the calling thread, on obstacles of several sizes,
+  and check that the candidates ranked before the selected one are
+  rejected. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <iostream>
+
+#include "portability/gettimeofday.hh"
+
+#include <MotionGeneration/StepOverPlanner.hh>
+
+#include "CommonTools.hh"
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+using namespace PatternGeneratorJRL::TestSuite;
+
+/*! Result of a search. */
+struct Search {
+  int Rank;
+  double StepLenght, HipHeight;
+  unsigned int NbChecked;
+  double Time;
+};
+
+void search(StepOverPlanner &aPlanner, bool Parallel, unsigned int Resolution,
+            double TimeBudget, Search &aSearch) {
+  aPlanner.SetCandidateSearch(true, Parallel, Resolution, TimeBudget);
+  struct timeval begin, end;
+  gettimeofday(&begin, 0);
+  aSearch.Rank = aPlanner.SearchCandidates();
+  gettimeofday(&end, 0);
+  aSearch.Time = Time(begin, end);
+  aSearch.StepLenght = aPlanner.GetStepOverStepLenght();
+  aSearch.HipHeight = aPlanner.GetStepOverHipHeight();
+  aSearch.NbChecked = aPlanner.GetNbCheckedCandidates();
+}
+
+/*! Check the candidates of the last search up to the selected one:
+  only the selected one may be feasible.
+  \return false otherwise, and count the rejections for collision. */
+bool checkRanks(StepOverPlanner &aPlanner, int Rank,
+                unsigned int &NbCollisions) {
+  unsigned int End =
+      (Rank >= 0) ? (unsigned int)Rank + 1 : aPlanner.GetNbCandidates();
+  for (unsigned int r = 0; r < End; r++) {
+    double StepLenght, COMHeight;
+    aPlanner.CandidateParameters(r, StepLenght, COMHeight);
+    int Status = aPlanner.CheckCandidate(StepLenght, COMHeight);
+    if (Status == StepOverPlanner::CANDIDATE_COLLISION)
+      NbCollisions++;
+    if ((Status == StepOverPlanner::CANDIDATE_FEASIBLE) != ((int)r == Rank)) {
+      cerr << "Candidate " << r << " (" << StepLenght << ", " << COMHeight
+           << "): status " << Status << " with the candidate " << Rank
+           << " selected." << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int, char *[]) {
+  pinocchio::Model aModel;
+  pinocchio::urdf::buildModel(URDF_FULL_PATH, pinocchio::JointModelFreeFlyer(),
+                              aModel);
+  pinocchio::Data aData(aModel);
+  PinocchioRobot aPR;
+  if (!aPR.initializeRobotModelAndData(&aModel, &aData)) {
+    cerr << "The robot cannot be initialized." << endl;
+    return 1;
+  }
+
+  // Library of obstacles, 1 m in front of the robot.
+  const unsigned int NbHeights = 4, NbDepths = 3;
+  const double Heights[NbHeights] = {0.05, 0.1, 0.15, 0.2};
+  const double Depths[NbDepths] = {0.05, 0.1, 0.15};
+  const unsigned int Resolution = 20;
+  double SequentialTime = 0.0, ParallelTime = 0.0;
+  unsigned int NbFeasible = 0, NbCollisions = 0;
+  printf("  h     d   rank  step  hip   checked  sequential  parallel (ms)\n");
+  for (unsigned int i = 0; i < NbHeights; i++) {
+    for (unsigned int j = 0; j < NbDepths; j++) {
+      ObstaclePar anObstacle;
+      anObstacle.x = 1.0;
+      anObstacle.y = 0.0;
+      anObstacle.z = 0.0;
+      anObstacle.theta = 0.0;
+      anObstacle.h = Heights[i];
+      anObstacle.w = 1.0;
+      anObstacle.d = Depths[j];
+      StepOverPlanner aPlanner(anObstacle, &aPR);
+
+      Search Sequential, Parallel, Budget;
+      search(aPlanner, false, Resolution, 0.0, Sequential);
+      search(aPlanner, true, Resolution, 0.0, Parallel);
+      if ((Parallel.Rank != Sequential.Rank) ||
+          (Parallel.StepLenght != Sequential.StepLenght) ||
+          (Parallel.HipHeight != Sequential.HipHeight) ||
+          aPlanner.GetCandidateSearchTimedOut()) {
+        cerr << "Obstacle " << Heights[i] << " x " << Depths[j]
+             << ": candidate " << Parallel.Rank << " instead of "
+             << Sequential.Rank << endl;
+        return 1;
+      }
+
+      // The candidates before the selected one, with the COM placed
+      // as by the planner, are not accepted.
+      if (!checkRanks(aPlanner, Sequential.Rank, NbCollisions))
+        return 1;
+
+      // Within a short budget only worse candidates may be kept.
+      search(aPlanner, true, Resolution, 1e-4, Budget);
+      bool Valid = (Budget.Rank == Sequential.Rank);
+      if (aPlanner.GetCandidateSearchTimedOut())
+        Valid = Valid || (Budget.Rank == -1) ||
+                ((Sequential.Rank >= 0) && (Budget.Rank > Sequential.Rank));
+      if (!Valid) {
+        cerr << "Obstacle " << Heights[i] << " x " << Depths[j]
+             << ": candidate " << Budget.Rank << " within the budget."
+             << endl;
+        return 1;
+      }
+
+      if (Sequential.Rank >= 0)
+        NbFeasible++;
+      SequentialTime += Sequential.Time;
+      ParallelTime += Parallel.Time;
+      printf("%.2f  %.2f  %4d  %.3f %.3f %4u  %10.3f  %8.3f\n", Heights[i],
+             Depths[j], Sequential.Rank, Sequential.StepLenght,
+             Sequential.HipHeight, Sequential.NbChecked,
+             1e3 * Sequential.Time, 1e3 * Parallel.Time);
+    }
+  }
+
+  printf("%u obstacles out of %u can be stepped over\n", NbFeasible,
+         NbHeights * NbDepths);
+  // Shorter steps collide with the higher obstacles.
+  if (NbCollisions == 0) {
+    cerr << "No candidate has been rejected for collision." << endl;
+    return 1;
+  }
+  printf("search time (ms): sequential %.3f, parallel %.3f\n",
+         1e3 * SequentialTime, 1e3 * ParallelTime);
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2020,
+ *
+ * LAAS, CNRS
+ *
+ * This file is part of jrl-walkgen.
+ * jrl-walkgen is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jrl-walkgen is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with jrl-walkgen.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file TestTimingSensitivities.cpp
+  \brief Compare the sensitivities of the polynomial weights of the
+  analytical trajectories to the duration of the intervals with central
+  differences, and check the adaptation of the step timing. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <iostream>
+#include <vector>
+
+#include <SimplePluginManager.hh>
+#include <ZMPRefTrajectoryGeneration/AnalyticalMorisawaCompact.hh>
+
+using namespace std;
+using namespace PatternGeneratorJRL;
+
+/*! Gives access to the linear system solved along one axis. */
+class TimingSensitivitiesTest : public AnalyticalMorisawaCompact {
+public:
+  TimingSensitivitiesTest(SimplePluginManager *lSPM)
+      : AnalyticalMorisawaCompact(lSPM, 0), m_AZCT(7) {}
+
+  /*! Three steps forward with the CoM at 0.8 m. */
+  void initialize() {
+    m_Tsingle = 0.78;
+    m_Tdble = 0.02;
+    SetNumberOfStepsInAdvance(3);
+    InitializeBasicVariables();
+
+    m_CTIP.CoMZ.assign(m_NumberOfIntervals, 0.8);
+    m_CTIP.ZMPZ.assign(m_NumberOfIntervals, 0.0);
+    const double ZMP[7] = {0.0, 0.1, 0.1, 0.3, 0.3, 0.4, 0.4};
+    m_CTIP.ZMPProfil.assign(ZMP, ZMP + 7);
+    m_CTIP.InitialCoM = 0.0;
+    m_CTIP.InitialCoMSpeed = 0.0;
+    m_CTIP.FinalCoMPos = 0.4;
+    BuildingTheZMatrix(m_CTIP.CoMZ, m_CTIP.ZMPZ);
+
+    m_AZCT.SetNumberOfIntervals(m_NumberOfIntervals);
+    m_AZCT.SetPolynomialDegrees(m_PolynomialDegrees);
+    buildPolynomials();
+  }
+
+  /*! Weights solution of the full system for the intervals DeltaTj. */
+  Eigen::VectorXd weights(const vector<double> &DeltaTj) {
+    m_DeltaTj = DeltaTj;
+    buildPolynomials();
+    BuildingTheZMatrix();
+    ComputeW(m_CTIP.InitialCoM, m_CTIP.InitialCoMSpeed, m_CTIP.ZMPProfil,
+             m_CTIP.FinalCoMPos, m_AZCT);
+    return m_Z.partialPivLu().solve(m_w);
+  }
+
+  void sensitivities(const vector<double> &DeltaTj, TimingSensitivities &aTS) {
+    m_DeltaTj = DeltaTj;
+    buildPolynomials();
+    ComputeTimingSensitivities(m_CTIP, m_AZCT, aTS);
+  }
+
+  /*! Adapt the timing and return the difference of the weights with
+    the solution of the full system. */
+  double adapt(vector<double> &NewDeltaTj, TimingSensitivities &aTS,
+               unsigned int NbOfNewtonIterations, double &Residual) {
+    Residual = AdaptStepTiming(NewDeltaTj, m_CTIP, m_AZCT, aTS,
+                               NbOfNewtonIterations);
+    Eigen::VectorXd y = m_y;
+    return (y - weights(NewDeltaTj)).cwiseAbs().maxCoeff();
+  }
+
+  const vector<double> &deltaTj() const { return m_DeltaTj; }
+
+protected:
+  void buildPolynomials() {
+    m_AZCT.SetStartingTimeIntervalsAndHeightVariation(m_DeltaTj, m_Omegaj);
+    for (int i = 1; i < m_NumberOfIntervals - 1; i++)
+      m_AZCT.Building3rdOrderPolynomial(i, m_CTIP.ZMPProfil[i - 1],
+                                        m_CTIP.ZMPProfil[i]);
+  }
+
+  CompactTrajectoryInstanceParameters m_CTIP;
+  AnalyticalZMPCOGTrajectory m_AZCT;
+};
+
+int main(int, char *[]) {
+  SimplePluginManager SPM;
+  TimingSensitivitiesTest aTest(&SPM);
+  aTest.initialize();
+  const vector<double> DeltaTj = aTest.deltaTj();
+
+  TimingSensitivities aTS;
+  aTest.sensitivities(DeltaTj, aTS);
+  double Scale = max(1.0, aTS.dYdT.cwiseAbs().maxCoeff());
+  const double h = 1e-6;
+  double MaxError = 0.0;
+  for (unsigned int j = 0; j < DeltaTj.size(); j++) {
+    vector<double> Plus = DeltaTj, Minus = DeltaTj;
+    Plus[j] += h;
+    Minus[j] -= h;
+    Eigen::VectorXd dY = (aTest.weights(Plus) - aTest.weights(Minus)) / (2 * h);
+    double Error = (dY - aTS.dYdT.col(j)).cwiseAbs().maxCoeff() / Scale;
+    if (Error > 1e-5)
+      cerr << "Interval " << j << ": error " << Error << endl;
+    MaxError = max(MaxError, Error);
+  }
+  printf("largest relative error of the sensitivities %.3e\n", MaxError);
+  if (!(MaxError < 1e-5)) {
+    cerr << "The sensitivities differ from the central differences." << endl;
+    return 1;
+  }
+
+  // A longer single support: the first order update is refined by the
+  // chord-Newton iterations up to the solution of the full system.
+  vector<double> NewDeltaTj = DeltaTj;
+  NewDeltaTj[2] += 0.05;
+  double FirstOrderResidual = 0.0, NewtonResidual = 0.0;
+  double FirstOrderError = aTest.adapt(NewDeltaTj, aTS, 0, FirstOrderResidual);
+  aTest.sensitivities(DeltaTj, aTS);
+  double NewtonError = aTest.adapt(NewDeltaTj, aTS, 10, NewtonResidual);
+  printf("first order: error %.3e, residual %.3e; newton: error %.3e, "
+         "residual %.3e\n",
+         FirstOrderError, FirstOrderResidual, NewtonError, NewtonResidual);
+  if (!(NewtonResidual < FirstOrderResidual) || !(NewtonError < 1e-8)) {
+    cerr << "The adapted timing does not converge to the full resolution."
+         << endl;
+    return 1;
+  }
+  return 0;
+}